@@ -12,15 +12,29 @@ set(LIB_BASE_CPP_SRC_FILES
     src/common/adapter_internal.cpp
     src/common/app_ble_gap.cpp
     src/common/ble_common.cpp
+    src/common/log_ring.cpp
+    src/common/metrics_exporter.cpp
     src/common/sd_rpc_impl.cpp
+    src/common/span_tracer.cpp
 )
 
 set(LIB_TRANSPORT_CPP_SRC_FILES 
+    src/common/transport/command_latencies.cpp
+    src/common/transport/event_filter.cpp
+    src/common/transport/event_notifier.cpp
+    src/common/transport/event_ring.cpp
+    src/common/transport/event_slab_pool.cpp
     src/common/transport/h5.cpp
+    src/common/transport/h5_stream_decoder.cpp
     src/common/transport/h5_transport.cpp
+    src/common/transport/latency_histogram.cpp
+    src/common/transport/rtt_estimator.cpp
     src/common/transport/serialization_transport.cpp
+    src/common/transport/serialized_event.cpp
+    src/common/transport/shared_io_context.cpp
     src/common/transport/slip.cpp
     src/common/transport/transport.cpp
+    src/common/transport/tx_buffer.cpp
     src/common/transport/uart_settings.cpp
     src/common/transport/uart_settings_boost.cpp
     src/common/transport/uart_transport.cpp
@@ -44,7 +44,25 @@
 #include "ble.h"
 #include "nrf_error.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
+
+// Number of idle command buffers kept by an adapter, one for each thread sending commands
+// concurrently
+constexpr size_t CommandBufferPoolSize = 4;
+
+/**
+ * @brief Buffers of a command sent by encode_decode, the command is encoded into txBuffer and the
+ * response is copied to rxBuffer.
+ */
+struct CommandBuffers
+{
+    std::shared_ptr<TxBuffer> txBuffer;
+    std::shared_ptr<std::vector<uint8_t>> rxBuffer;
+};
 
 class AdapterInternal
 {
@@ -56,22 +74,55 @@ class AdapterInternal
                   const sd_rpc_log_handler_t log_callback);
     uint32_t close();
     uint32_t logSeverityFilterSet(const sd_rpc_log_severity_t severity_filter);
+    uint32_t logDispatchSet(const sd_rpc_log_dispatch_t dispatch);
+    uint32_t eventBatchHandlerSet(const sd_rpc_evt_batch_handler_t batch_handler,
+                                  const uint32_t max_count, const uint32_t time_budget_us);
     static bool isInternalError(const uint32_t error_code);
 
     void statusHandler(const sd_rpc_app_status_t code, const std::string &error);
     void eventHandler(ble_evt_t *event);
+    void discardedEventHandler(ble_evt_t *event);
+    void eventBatchHandler(ble_evt_t *const *events, const uint32_t count);
     void logHandler(const sd_rpc_log_severity_t severity, const std::string &log_message);
 
+    // Take buffers for a command, idle buffers of earlier commands are reused. Returns false if
+    // new buffers can not be allocated.
+    bool acquireCommandBuffers(CommandBuffers &buffers) noexcept;
+    void releaseCommandBuffers(CommandBuffers &buffers) noexcept;
+
     SerializationTransport *transport;
 
+    // Number of the adapter in the order adapters are created, labels the metrics of the adapter
+    const uint32_t id;
+
   private:
+    // Pass a message logged on the log channel of the adapter to the log callback, called by the
+    // drain thread of LogRing::global
+    void deliverLog(const sd_rpc_log_severity_t severity, const std::string &log_message);
+
+    // Pass the messages logged before to the log callback and remove the log channel
+    void closeLogChannel() noexcept;
+
     sd_rpc_evt_handler_t eventCallback;
+    sd_rpc_evt_batch_handler_t eventBatchCallback;
     sd_rpc_status_handler_t statusCallback;
     sd_rpc_log_handler_t logCallback;
     sd_rpc_log_severity_t logSeverityFilter;
+    sd_rpc_log_dispatch_t logDispatch;
+
+    // Channel of LogRing::global the adapter and its transports log to while open with
+    // SD_RPC_LOG_DISPATCH_ASYNC, zero if the messages are passed to the log callback on the
+    // logging thread
+    std::atomic<uint32_t> logChannel;
 
     bool isOpen;
     std::mutex publicMethodMutex;
+
+    // Buffers are returned by encode_decode after the response is decoded. The transport layers
+    // may still refer to a buffer after a timeout or while the command is written, such buffers
+    // are not reused.
+    std::mutex commandBuffersMutex;
+    std::vector<CommandBuffers> idleCommandBuffers;
 };
 
 #endif // ADAPTER_INTERNAL_H__
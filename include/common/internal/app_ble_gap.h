@@ -179,16 +179,6 @@ uint32_t app_ble_gap_state_reset();
 
 #if NRF_SD_BLE_API_VERSION >= 6
 
-/**
- * @brief Data structure to store advertising set data
- */
-typedef struct
-{
-    uint8_t adv_handle;
-    uint8_t *buf1;
-    uint8_t *buf2;
-} adv_set_data_t;
-
 void app_ble_gap_set_adv_data_set(uint8_t adv_handle, uint8_t *buf1, uint8_t *buf2);
 
 /**
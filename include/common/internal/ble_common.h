@@ -38,14 +38,93 @@
 #define BLE_COMMON_IMPL_H__
 
 #include "adapter.h"
-#include <functional>
+#include "adapter_internal.h"
+#include <chrono>
 #include <stdint.h>
 
-typedef std::function<uint32_t(uint8_t *, uint32_t *)> encode_function_t;
-typedef std::function<uint32_t(uint8_t *, uint32_t, uint32_t *)> decode_function_t;
+/*
+ * Buffers of the adapter a command is encoded into and its response is received in, taken for
+ * the lifetime of the object and reused by later commands.
+ */
+class AdapterCommandBuffers
+{
+  public:
+    explicit AdapterCommandBuffers(adapter_t *adapter);
+    ~AdapterCommandBuffers();
+    AdapterCommandBuffers(const AdapterCommandBuffers &) = delete;
+    AdapterCommandBuffers &operator=(const AdapterCommandBuffers &) = delete;
+    AdapterCommandBuffers(AdapterCommandBuffers &&)                 = delete;
+    AdapterCommandBuffers &operator=(AdapterCommandBuffers &&) = delete;
+
+    bool isAcquired() const noexcept;
+
+    CommandBuffers buffers;
+
+  private:
+    AdapterInternal *adapterInternal;
+    bool acquired;
+};
+
+// Parts of encode_decode independent of the encoder and decoder. encode_decode_send reports an
+// encode error or sends the encoded command, encode_decode_result reports a decode error or
+// returns the result code of the response. Both record the time the codec took for opcode, from
+// start to end.
+uint32_t encode_decode_send(adapter_t *adapter, CommandBuffers &buffers,
+                            const uint32_t encode_err_code, const uint32_t length,
+                            const uint8_t opcode,
+                            const std::chrono::steady_clock::time_point encode_start,
+                            const std::chrono::steady_clock::time_point encode_end);
+uint32_t encode_decode_result(adapter_t *adapter, const uint32_t decode_err_code,
+                              const uint32_t result_code, const uint8_t opcode,
+                              const std::chrono::steady_clock::time_point decode_start,
+                              const std::chrono::steady_clock::time_point decode_end);
+
+/*
+ * Encode a command with encode_function, send it and decode the response with decode_function.
+ * The functions are typically lambdas capturing the arguments of the API call by reference, they
+ * are called directly and not copied.
+ *
+ * encode_function(uint8_t *buffer, uint32_t *length) -> uint32_t
+ * decode_function(uint8_t *buffer, uint32_t length, uint32_t *result_code) -> uint32_t
+ */
+template <typename EncodeFunction, typename DecodeFunction>
+uint32_t encode_decode(adapter_t *adapter, const EncodeFunction &encode_function,
+                       const DecodeFunction &decode_function)
+{
+    AdapterCommandBuffers command(adapter);
+
+    if (!command.isAcquired())
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    auto &tx_buffer         = *command.buffers.txBuffer;
+    auto tx_length          = static_cast<uint32_t>(tx_buffer.payloadCapacity());
+    const auto encode_start = std::chrono::steady_clock::now();
+    auto err_code           = encode_function(tx_buffer.payload(), &tx_length);
+    const auto encode_end   = std::chrono::steady_clock::now();
+
+    // The first byte of a command is its opcode
+    const auto opcode = tx_buffer.payload()[0];
+
+    err_code = encode_decode_send(adapter, command.buffers, err_code, tx_length, opcode,
+                                  encode_start, encode_end);
+
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    auto &rx_buffer         = *command.buffers.rxBuffer;
+    uint32_t result_code    = NRF_SUCCESS;
+    const auto decode_start = std::chrono::steady_clock::now();
+    const auto decode_err_code =
+        decode_function(rx_buffer.data(), static_cast<uint32_t>(rx_buffer.size()), &result_code);
+    const auto decode_end = std::chrono::steady_clock::now();
 
-uint32_t encode_decode(adapter_t *adapter, const encode_function_t &encode_function,
-                       const decode_function_t &decode_function);
+    return encode_decode_result(adapter, decode_err_code, result_code, opcode, decode_start,
+                                decode_end);
+}
 
 /*
  * We do not want to change the codecs provided by the SDK too much. The BLESecurityContext provides
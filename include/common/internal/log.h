@@ -38,51 +38,53 @@
 #ifndef NRF_LOG_H__
 #define NRF_LOG_H__
 
-#include <chrono>
+#include "log_ring.h"
+
 #include <fstream>
-#include <iomanip>
 #include <iostream>
-#include <mutex>
-#include <sstream>
 #include <string>
 
-// You should not use stdout/stderr on Windows since this will have a huge impact on
-// the application since this logger is not offloading the displaying of data
-// to a separate thread.
+// NRF_LOG logs a binary record of LogRing::global without taking a lock. The format string is a
+// literal with {} placeholders, see LogRing::registerFormat, the drain thread of the ring formats
+// the record with its arguments and writes it to the log stream.
 //
-// This stack overflow thread contains more info in regards to cmd.exe output:
-//   https://stackoverflow.com/questions/7404551/why-is-console-output-so-slow
+// NRF_LOG_SETUP in one translation unit adds a sink of the ring writing to stdout or to the file
+// NRF_LOG_FILENAME.
+
+// Sink of LogRing::global writing to nrfLogStream until the program exits
+struct NrfLogDrain
+{
+    explicit NrfLogDrain(std::ostream &stream)
+        : channel(0)
+    {
+        LogRing::global().addSink(stream, channel);
+    }
+
+    ~NrfLogDrain()
+    {
+        LogRing::global().removeSink(channel);
+    }
+
+    uint32_t channel;
+};
 
 #ifdef NRF_LOG_SETUP
 #ifndef NRF_LOG_FILENAME
 std::ostream &nrfLogStream(std::cout);
-std::mutex nrfLogMutex;
 #else
 std::fstream nrfLogStream(NRF_LOG_FILENAME, std::fstream::out | std::fstream::trunc);
-std::mutex nrfLogMutex;
 #endif
+
+NrfLogDrain nrfLogDrain(nrfLogStream);
 #else
 extern std::ostream &nrfLogStream;
-extern std::mutex nrfLogMutex;
+extern NrfLogDrain nrfLogDrain;
 #endif
 
 #ifndef NRF_LOG
-#define NRF_LOG(message)                                                                           \
-    do                                                                                             \
-    {                                                                                              \
-        auto timestamp = std::chrono::system_clock::now();                                         \
-        auto threadID  = std::this_thread::get_id();                                               \
-        std::unique_lock<std::mutex> lock(nrfLogMutex);                                            \
-        std::stringstream stream;                                                                  \
-        stream << message;                                                                         \
-        nrfLogStream << "@" << std::right << std::setfill('0') << std::setw(10) << std::dec        \
-                     << std::chrono::duration_cast<std::chrono::microseconds>(                     \
-                            timestamp.time_since_epoch())                                          \
-                            .count()                                                               \
-                     << " [" << std::setw(5) << threadID << "] "                                   \
-                     << "| " << message << std::endl                                               \
-                     << std::flush;                                                                \
-    } while (0);
+#define NRF_LOG(format, ...)                                                                       \
+    LogRing::global().push(nrfLogDrain.channel, SD_RPC_LOG_INFO, LOG_FORMAT_ID(format),            \
+                           ##__VA_ARGS__)
 #endif // NRF_LOG
 
 #endif // NRF_LOG_H__
@@ -0,0 +1,439 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include "sd_rpc_types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+/**@brief Largest number of arguments of a log record. */
+constexpr size_t LogRecordMaxArgs = 4;
+
+/**@brief Largest number of bytes of the text or bytes argument of a log record, longer arguments
+ * are truncated. */
+constexpr size_t LogRecordMaxBlobSize = 1024;
+
+/**@brief Default number of slots of a log ring, a record takes one slot and one more for each
+ * started 64 bytes of its text or bytes argument. */
+constexpr size_t LogRingDefaultCapacity = 4096;
+
+/**@brief Number of formats the format table holds. */
+constexpr size_t LogFormatTableSize = 1024;
+
+/**@brief Identifier of the format "{}", used for messages formatted by the caller. */
+constexpr uint16_t LogFormatText = 0;
+
+/**@brief Time the drain thread sleeps when the log ring is empty. */
+constexpr auto LogRingDrainInterval = std::chrono::milliseconds(5);
+
+/**@brief How an argument of a log record is formatted. */
+typedef enum {
+    LOG_ARG_SIGNED,
+    LOG_ARG_UNSIGNED,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_STRING, // Pointer to a string that outlives the record, typically a literal
+    LOG_ARG_TEXT,   // Text copied into the slots following the record, the value is its length
+    LOG_ARG_BYTES   // Bytes copied like text and formatted in hexadecimal
+} log_arg_type_t;
+
+/**@brief Text argument of a log record, the text is copied into the ring. */
+struct LogText
+{
+    const char *data;
+    size_t length;
+};
+
+/**@brief Bytes argument of a log record, the bytes are copied into the ring. */
+struct LogBytes
+{
+    const uint8_t *data;
+    size_t length;
+};
+
+/**
+ * @brief Fixed size binary log record, the message is only formatted by the drain thread.
+ *
+ * formatId identifies an entry of the format table, see LogRing::registerFormat. A record has at
+ * most one text or bytes argument, its content is kept in the slots following the record.
+ */
+struct LogRecord
+{
+    int64_t timestamp; // Microseconds since the epoch of std::chrono::system_clock, see ::pop
+    uint64_t args[LogRecordMaxArgs];
+    uint32_t thread;  // Index of the logging thread, in the order threads first log
+    uint32_t channel; // Sink the record is passed to, see LogRing::addSink
+    uint16_t formatId;
+    sd_rpc_log_severity_t severity;
+    uint8_t argCount;
+    uint8_t argTypes[LogRecordMaxArgs];
+    uint8_t blobSlots; // Number of slots holding the text or bytes argument
+};
+
+/**
+ * @brief Formats a record in place of the format string of its format table entry. blob is the
+ * text or bytes argument of the record, shorter than its length if truncated.
+ */
+typedef std::string (*log_formatter_t)(const LogRecord &record, const std::string &blob);
+
+typedef std::function<void(const LogRecord &record, const std::string &message)> log_ring_sink_t;
+
+/**
+ * @brief Bounded multiple producer, single consumer queue of binary log records.
+ *
+ * Logging a record claims the slots it needs with a compare and swap on the tail index, writes
+ * the record and publishes it through the sequence number of its first slot. A logging thread
+ * never waits or allocates: when the ring is full the record is dropped and counted.
+ *
+ * Each record is tagged with the channel of a sink. A drain thread, running while sinks are
+ * added, formats the records and passes them to the sink of their channel. Records of channels
+ * without a sink are discarded. Sinks must not add or remove sinks.
+ */
+class LogRing
+{
+  public:
+    /**@brief Create a ring of capacity slots, rounded up to a power of two. */
+    explicit LogRing(const size_t capacity = LogRingDefaultCapacity);
+    ~LogRing() noexcept;
+
+    LogRing(const LogRing &) = delete;
+    LogRing &operator=(const LogRing &) = delete;
+
+    /**@brief Ring used by the transports and NRF_LOG. */
+    static LogRing &global() noexcept;
+
+    /**
+     * @brief Add format to the format table shared by all rings, format must outlive the
+     * program. Placeholders {} in format are replaced by the arguments in order, {x} formats an
+     * integer argument in hexadecimal. If formatter is given it formats the records instead.
+     *
+     * @return Identifier of the format, LogFormatText if the table is full.
+     */
+    static uint16_t registerFormat(const char *format,
+                                   const log_formatter_t formatter = nullptr) noexcept;
+
+    /**
+     * @brief Log a record with up to LogRecordMaxArgs integer, enum, floating point, string,
+     * LogText or LogBytes arguments. Strings must outlive the record.
+     *
+     * @return false if the ring is full and the record is dropped.
+     */
+    template <typename... Args>
+    bool push(const uint32_t channel, const sd_rpc_log_severity_t severity,
+              const uint16_t formatId, const Args &... args) noexcept;
+
+    /**@brief Log a message formatted by the caller, the message is copied. */
+    bool pushText(const uint32_t channel, const sd_rpc_log_severity_t severity,
+                  const std::string &message) noexcept;
+
+    /**
+     * @brief Add a sink receiving the records logged on channel, starts the drain thread if it
+     * is not running.
+     */
+    uint32_t addSink(const log_ring_sink_t &sink, uint32_t &channel) noexcept;
+
+    /**
+     * @brief Add a sink writing one line per record to stream, the stream is flushed when the
+     * ring is empty.
+     */
+    uint32_t addSink(std::ostream &stream, uint32_t &channel) noexcept;
+
+    /**
+     * @brief Pass the records logged before to their sinks and remove the sink of channel. The
+     * drain thread is stopped with the last sink.
+     */
+    void removeSink(const uint32_t channel) noexcept;
+
+    /**@brief Wait until the records logged before are passed to their sinks. */
+    void flush() noexcept;
+
+    /**@brief Records dropped since the ring was created. */
+    uint64_t dropped() const noexcept;
+
+    /**
+     * @brief Take the oldest record and its text or bytes argument, consumer side. The time the
+     * record was logged is converted to system time. Returns false if the ring is empty.
+     */
+    bool pop(LogRecord &record, std::string &blob) noexcept;
+
+    /**@brief Format the message of a record. */
+    static std::string format(const LogRecord &record, const std::string &blob);
+
+    /**@brief Format a message like a record logged with the same arguments. */
+    template <typename... Args>
+    static std::string format(const uint16_t formatId, const Args &... args);
+
+  private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    struct Sink
+    {
+        log_ring_sink_t sink;
+        std::ostream *stream; // Flushed when the ring is empty
+    };
+
+    struct Blob
+    {
+        const void *data;
+        size_t length;
+    };
+
+    // Claim count slots at the tail and set the timestamp and thread of the record in the first,
+    // returns nullptr if the ring is full
+    LogRecord *claim(const size_t count, size_t &position) noexcept;
+    void publish(const size_t position, const Blob &blob, const size_t blobSize) noexcept;
+    static uint32_t threadIndex() noexcept;
+
+    // Convert the ticks a record was logged at to system time, consumer side
+    int64_t toMicroseconds(const int64_t recordTicks) noexcept;
+
+    template <typename... Args>
+    static constexpr size_t blobArgCount() noexcept
+    {
+        const bool blobs[] = {false, (std::is_same<Args, LogText>::value ||
+                                      std::is_same<Args, LogBytes>::value)...};
+        size_t count = 0;
+
+        for (const auto blob : blobs)
+        {
+            count += blob ? 1 : 0;
+        }
+
+        return count;
+    }
+
+    static Blob findBlob() noexcept
+    {
+        return {nullptr, 0};
+    }
+
+    template <typename... Rest>
+    static Blob findBlob(const LogText &text, const Rest &...) noexcept
+    {
+        return {text.data, text.length};
+    }
+
+    template <typename... Rest>
+    static Blob findBlob(const LogBytes &bytes, const Rest &...) noexcept
+    {
+        return {bytes.data, bytes.length};
+    }
+
+    template <typename T, typename... Rest>
+    static Blob findBlob(const T &, const Rest &... rest) noexcept
+    {
+        return findBlob(rest...);
+    }
+
+    static void setArg(LogRecord &record, const size_t index, const log_arg_type_t type,
+                       const uint64_t value) noexcept;
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+    setArg(LogRecord &record, const size_t index, const T value) noexcept
+    {
+        setArg(record, index, LOG_ARG_SIGNED, static_cast<uint64_t>(static_cast<int64_t>(value)));
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type
+    setArg(LogRecord &record, const size_t index, const T value) noexcept
+    {
+        setArg(record, index, LOG_ARG_UNSIGNED, static_cast<uint64_t>(value));
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_enum<T>::value>::type
+    setArg(LogRecord &record, const size_t index, const T value) noexcept
+    {
+        setArg(record, index, static_cast<typename std::underlying_type<T>::type>(value));
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value>::type
+    setArg(LogRecord &record, const size_t index, const T value) noexcept
+    {
+        const double doubleValue = value;
+        uint64_t bits;
+        static_assert(sizeof(bits) == sizeof(doubleValue), "double is not 64 bits");
+        std::memcpy(&bits, &doubleValue, sizeof(bits));
+        setArg(record, index, LOG_ARG_DOUBLE, bits);
+    }
+
+    static void setArg(LogRecord &record, const size_t index, const char *value) noexcept
+    {
+        setArg(record, index, LOG_ARG_STRING, reinterpret_cast<uintptr_t>(value));
+    }
+
+    static void setArg(LogRecord &record, const size_t index, const LogText &value) noexcept
+    {
+        setArg(record, index, LOG_ARG_TEXT, value.length);
+    }
+
+    static void setArg(LogRecord &record, const size_t index, const LogBytes &value) noexcept
+    {
+        setArg(record, index, LOG_ARG_BYTES, value.length);
+    }
+
+    static void setArgs(LogRecord &, const size_t) noexcept
+    {}
+
+    template <typename T, typename... Rest>
+    static void setArgs(LogRecord &record, const size_t index, const T &value,
+                        const Rest &... rest) noexcept
+    {
+        setArg(record, index, value);
+        setArgs(record, index + 1, rest...);
+    }
+
+    void startDrain();
+    void stopDrain() noexcept;
+    void drainRunner() noexcept;
+    bool drainRecords() noexcept;
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+
+    // Bytes of a text or bytes argument kept in the ring, at most half of the ring
+    size_t maxBlobSize;
+
+    // Position of the next slot to claim and the next slot to drain, on cache lines of their own
+    // since tail is written by the logging threads and head by the drain thread
+    alignas(64) std::atomic<size_t> tail;
+    alignas(64) size_t head;
+    std::atomic<uint64_t> droppedRecords;
+    uint64_t reportedDroppedRecords;
+
+    // Ticks and system time in nanoseconds when the ring was created and when last taken by the
+    // consumer, to convert the time stamps of records
+    const int64_t clockOriginTicks;
+    const int64_t clockOriginTime;
+    int64_t clockTicks;
+    int64_t clockTime;
+
+    // addSink and removeSink are serialized by sinkChangeMutex. The drain thread holds sinkMutex
+    // while it passes records to the sinks.
+    std::mutex sinkChangeMutex;
+    std::mutex sinkMutex;
+    std::map<uint32_t, Sink> sinks;
+    uint32_t nextChannel;
+
+    // drainedPosition is the head after the last pass of the drain thread, flush waits for it
+    // to pass the tail
+    std::thread drainThread;
+    std::mutex drainMutex;
+    std::condition_variable drainWakeup;
+    std::condition_variable drainDone;
+    bool draining;
+    bool flushRequested;
+    size_t drainedPosition;
+};
+
+template <typename... Args>
+bool LogRing::push(const uint32_t channel, const sd_rpc_log_severity_t severity,
+                   const uint16_t formatId, const Args &... args) noexcept
+{
+    static_assert(sizeof...(Args) <= LogRecordMaxArgs, "Too many log record arguments");
+    static_assert(blobArgCount<Args...>() <= 1, "More than one text or bytes argument");
+
+    const auto blob      = findBlob(args...);
+    const auto blobSize  = std::min(blob.length, maxBlobSize);
+    const auto blobSlots = (blobSize + sizeof(LogRecord) - 1) / sizeof(LogRecord);
+
+    size_t position;
+    const auto record = claim(1 + blobSlots, position);
+
+    if (record == nullptr)
+    {
+        return false;
+    }
+
+    record->channel   = channel;
+    record->severity  = severity;
+    record->formatId  = formatId;
+    record->argCount  = static_cast<uint8_t>(sizeof...(Args));
+    record->blobSlots = static_cast<uint8_t>(blobSlots);
+    setArgs(*record, 0, args...);
+    publish(position, blob, blobSize);
+    return true;
+}
+
+template <typename... Args>
+std::string LogRing::format(const uint16_t formatId, const Args &... args)
+{
+    static_assert(sizeof...(Args) <= LogRecordMaxArgs, "Too many log record arguments");
+    static_assert(blobArgCount<Args...>() <= 1, "More than one text or bytes argument");
+
+    LogRecord record = {};
+    record.formatId  = formatId;
+    record.argCount  = static_cast<uint8_t>(sizeof...(Args));
+    setArgs(record, 0, args...);
+
+    const auto blob = findBlob(args...);
+    const auto data = static_cast<const char *>(blob.data);
+    return format(record, std::string(data, data + blob.length));
+}
+
+/**
+ * @brief Identifier of the format string format, registered the first time the call site is run.
+ */
+#define LOG_FORMAT_ID(format)                                                                      \
+    ([]() noexcept {                                                                               \
+        static const uint16_t formatId = LogRing::registerFormat(format);                          \
+        return formatId;                                                                           \
+    }())
+
+#endif // LOG_RING_H
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include "adapter.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**@brief Prefix of the names of all metrics. */
+constexpr auto MetricsNamePrefix = "pc_ble_driver_";
+
+/**@brief Shortest interval between writes of the metrics file. */
+constexpr auto MetricsMinimumInterval = std::chrono::milliseconds(100);
+
+/**
+ * @brief Renders the statistics and command latencies of adapters in the OpenMetrics text format,
+ * on request or periodically to a file.
+ *
+ * Samples are labelled with the number of the adapter and its serial port. The statistics are
+ * read from relaxed atomic counters, rendering does not take locks used when commands are sent
+ * or events are received. Adapters must not be deleted while their metrics are written to a
+ * file.
+ */
+class MetricsExporter
+{
+  public:
+    MetricsExporter() noexcept;
+    ~MetricsExporter() noexcept;
+    MetricsExporter(const MetricsExporter &) = delete;
+    MetricsExporter &operator=(const MetricsExporter &) = delete;
+    MetricsExporter(MetricsExporter &&)                 = delete;
+    MetricsExporter &operator=(MetricsExporter &&) = delete;
+
+    /**@brief Exporter of sd_rpc_metrics_file_start. */
+    static MetricsExporter &global() noexcept;
+
+    /**@brief Metrics of adapters in the OpenMetrics text format, terminated by # EOF. */
+    static std::string render(const std::vector<adapter_t *> &adapters);
+
+    /**@brief Write the metrics of adapters to path now and then every interval. The file is
+     * replaced, a reader never sees a partly written file. */
+    uint32_t start(const std::vector<adapter_t *> &adapters, const std::string &path,
+                   const std::chrono::milliseconds interval) noexcept;
+    uint32_t stop() noexcept;
+
+  private:
+    static bool writeFile(const std::string &path, const std::string &text) noexcept;
+    void writerRunner() noexcept;
+
+    std::vector<adapter_t *> fileAdapters;
+    std::string filePath;
+    std::chrono::milliseconds fileInterval;
+
+    std::mutex writerMutex;
+    std::condition_variable writerStop;
+    std::thread writer;
+    bool isWriting;
+};
+
+#endif // METRICS_EXPORTER_H
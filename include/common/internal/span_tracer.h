@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPAN_TRACER_H
+#define SPAN_TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**@brief Number of spans each thread buffers until the flush thread writes them. */
+constexpr size_t SpanRingCapacity = 4096;
+
+/**@brief Interval of the flush thread writing buffered spans to the trace file. */
+constexpr auto SpanFlushInterval = std::chrono::milliseconds(20);
+
+/**@brief Tags set on a span, a bit mask in Span::tags. */
+enum SpanTag : uint8_t {
+    SPAN_TAG_OPCODE   = 0x01,
+    SPAN_TAG_EVENT_ID = 0x02,
+    SPAN_TAG_SEQ_NUM  = 0x04,
+    SPAN_TAG_ACK_NUM  = 0x08
+};
+
+/**@brief Completed span of work, written as a complete event of the Chrome trace format. */
+struct Span
+{
+    const char *name; // Literal naming the work
+    int64_t start;    // Nanoseconds since the epoch of std::chrono::steady_clock
+    int64_t duration; // Nanoseconds
+    uint32_t adapter; // AdapterInternal::id of the adapter doing the work
+    uint32_t thread;  // Index of the recording thread, in the order threads first record
+    uint16_t eventId;
+    uint8_t opcode;
+    uint8_t seqNum;
+    uint8_t ackNum;
+    uint8_t tags;
+};
+
+/**
+ * @brief Writes spans recorded across the transport layers to a Chrome trace JSON file, which
+ * chrome://tracing and the Perfetto UI open.
+ *
+ * Each recording thread buffers its spans in a single producer, single consumer ring of its own,
+ * recording never takes a lock after the first span of a thread. A flush thread writes the
+ * buffered spans every SpanFlushInterval. Spans recorded while a ring is full are dropped and
+ * counted. When not tracing, recording a span costs one relaxed atomic load.
+ */
+class SpanTracer
+{
+  public:
+    ~SpanTracer() noexcept;
+    SpanTracer(const SpanTracer &) = delete;
+    SpanTracer &operator=(const SpanTracer &) = delete;
+    SpanTracer(SpanTracer &&)                 = delete;
+    SpanTracer &operator=(SpanTracer &&) = delete;
+
+    /**@brief Tracer of sd_rpc_trace_start. */
+    static SpanTracer &global() noexcept;
+
+    static bool isTracing() noexcept
+    {
+        return tracing.load(std::memory_order_relaxed);
+    }
+
+    /**@brief Nanoseconds since the epoch of std::chrono::steady_clock. */
+    static int64_t timestamp(const std::chrono::steady_clock::time_point time) noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch())
+            .count();
+    }
+
+    /**@brief Span of work from start to end without tags. */
+    static Span span(const char *name, const uint32_t adapter,
+                     const std::chrono::steady_clock::time_point start,
+                     const std::chrono::steady_clock::time_point end) noexcept;
+
+    /**@brief Start writing spans to path, spans buffered before are discarded. */
+    uint32_t start(const std::string &path) noexcept;
+
+    /**@brief Write the buffered spans and complete the trace file. */
+    uint32_t stop() noexcept;
+
+    /**@brief Buffer a completed span in the ring of the calling thread. */
+    void record(Span &span) noexcept;
+
+    /**@brief Spans dropped since the tracer was created. */
+    uint64_t dropped() const noexcept;
+
+  private:
+    struct ThreadRing;
+
+    SpanTracer() noexcept;
+
+    ThreadRing &threadRing();
+    void flushRunner() noexcept;
+    void flush();
+    void writeSpan(const Span &span);
+
+    static std::atomic<bool> tracing;
+
+    // Rings of the threads that have recorded spans, a ring is removed when its thread has
+    // exited and its spans are written
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    std::mutex ringsMutex;
+    std::atomic<uint64_t> droppedSpans;
+
+    std::ofstream file;
+    bool firstSpan;
+
+    std::mutex flushMutex;
+    std::condition_variable flushStop;
+    std::thread flusher;
+};
+
+/**
+ * @brief Records a span from construction to destruction, when tracing at construction.
+ */
+class TraceSpan
+{
+  public:
+    TraceSpan(const char *name, const uint32_t adapter) noexcept
+    {
+        span.name = SpanTracer::isTracing() ? name : nullptr;
+        span.tags = 0;
+
+        if (span.name != nullptr)
+        {
+            span.adapter = adapter;
+            span.start   = SpanTracer::timestamp(std::chrono::steady_clock::now());
+        }
+    }
+
+    ~TraceSpan() noexcept
+    {
+        if (span.name != nullptr)
+        {
+            span.duration =
+                SpanTracer::timestamp(std::chrono::steady_clock::now()) - span.start;
+            SpanTracer::global().record(span);
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+    TraceSpan(TraceSpan &&)                 = delete;
+    TraceSpan &operator=(TraceSpan &&) = delete;
+
+    void opcode(const uint8_t opcode) noexcept
+    {
+        span.opcode = opcode;
+        span.tags |= SPAN_TAG_OPCODE;
+    }
+
+    void eventId(const uint16_t eventId) noexcept
+    {
+        span.eventId = eventId;
+        span.tags |= SPAN_TAG_EVENT_ID;
+    }
+
+    void seqNum(const uint8_t seqNum) noexcept
+    {
+        span.seqNum = seqNum;
+        span.tags |= SPAN_TAG_SEQ_NUM;
+    }
+
+    void ackNum(const uint8_t ackNum) noexcept
+    {
+        span.ackNum = ackNum;
+        span.tags |= SPAN_TAG_ACK_NUM;
+    }
+
+  private:
+    Span span;
+};
+
+#endif // SPAN_TRACER_H
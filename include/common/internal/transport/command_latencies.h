@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef COMMAND_LATENCIES_H
+#define COMMAND_LATENCIES_H
+
+#include "latency_histogram.h"
+#include "sd_rpc_types.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Serialization opcodes are one byte
+constexpr size_t CommandOpcodeCount = 256;
+
+/**
+ * @brief Latency histograms of each phase of commands, one set of histograms per serialization
+ * opcode.
+ *
+ * The histograms of an opcode are allocated when the first command with the opcode is recorded
+ * and kept until the object is destroyed, recording is wait free after that. Samples that can
+ * not be allocated for are not recorded.
+ */
+class CommandLatencies
+{
+  public:
+    CommandLatencies() noexcept;
+    ~CommandLatencies() noexcept;
+    CommandLatencies(const CommandLatencies &) = delete;
+    CommandLatencies &operator=(const CommandLatencies &) = delete;
+    CommandLatencies(CommandLatencies &&)                 = delete;
+    CommandLatencies &operator=(CommandLatencies &&) = delete;
+
+    void record(const uint8_t opcode, const sd_rpc_cmd_phase_t phase,
+                const std::chrono::nanoseconds duration) noexcept;
+
+    /**@brief Histogram of phase of the commands with opcode, nullptr if none is recorded. */
+    const LatencyHistogram *histogram(const uint8_t opcode,
+                                      const sd_rpc_cmd_phase_t phase) const noexcept;
+
+    /**@brief Reset all histograms, they stay allocated. */
+    void reset() noexcept;
+
+  private:
+    using OpcodeLatencies = std::array<LatencyHistogram, SD_RPC_CMD_PHASE_COUNT>;
+    std::array<std::atomic<OpcodeLatencies *>, CommandOpcodeCount> opcodes;
+};
+
+#endif // COMMAND_LATENCIES_H
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef EVENT_FILTER_H
+#define EVENT_FILTER_H
+
+#include "sd_rpc_types.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * @brief Decides which received events are discarded before they are decoded.
+ *
+ * Events are discarded by event ID, by connection handle, or by an application predicate over the
+ * peer address and RSSI of advertising reports. The filter runs on the thread receiving events
+ * and only reads the fields it needs from the serialized event. Without a filter set pass only
+ * reads one flag.
+ */
+class EventFilter
+{
+  public:
+    /**@brief Event IDs and connection handles the filter can be set for are below these. */
+    static constexpr size_t EventIdCount    = 256;
+    static constexpr size_t ConnHandleCount = 256;
+
+    EventFilter() noexcept;
+
+    EventFilter(const EventFilter &) = delete;
+    EventFilter &operator=(const EventFilter &) = delete;
+
+    /**@brief Discard events with eventId, or pass them again. */
+    uint32_t setEventId(const uint16_t eventId, const bool discard) noexcept;
+
+    /**@brief Discard events of the connection with connHandle, or pass them again. */
+    uint32_t setConnHandle(const uint16_t connHandle, const bool discard) noexcept;
+
+    /**
+     * @brief Pass advertising reports for which filter returns true, nullptr passes all reports.
+     *
+     * Waits until a running call of the previous filter returns.
+     */
+    void setAdvReportFilter(const sd_rpc_adv_report_filter_t filter, void *context) noexcept;
+
+    /**@brief False if the serialized event is to be discarded. */
+    bool pass(const uint8_t *event, const size_t length) noexcept;
+
+  private:
+    // Called with setMutex held
+    void updateActive() noexcept;
+
+    std::mutex setMutex;
+
+    std::array<std::atomic<bool>, EventIdCount> discardedEventIds;
+    std::array<std::atomic<bool>, ConnHandleCount> discardedConnHandles;
+    std::atomic<uint32_t> discardedCount;
+
+    // Held while the advertising report filter runs so that it is not replaced meanwhile
+    std::mutex advReportFilterMutex;
+    sd_rpc_adv_report_filter_t advReportFilter;
+    void *advReportFilterContext;
+    std::atomic<bool> advReportFilterSet;
+
+    // Set when any filter is set
+    std::atomic<bool> active;
+};
+
+#endif // EVENT_FILTER_H
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef EVENT_NOTIFIER_H
+#define EVENT_NOTIFIER_H
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief File descriptor that is readable while events wait to be taken by the application.
+ *
+ * An eventfd on Linux and a pipe on macOS, there is no descriptor on Windows. notify is called by
+ * the thread queueing events and only writes to the descriptor when it is not readable already.
+ * The thread taking events calls clear when it finds no more events, and checks for events once
+ * more afterwards since an event queued meanwhile may have found the descriptor readable.
+ */
+class EventNotifier
+{
+  public:
+    EventNotifier() noexcept;
+    ~EventNotifier() noexcept;
+
+    EventNotifier(const EventNotifier &) = delete;
+    EventNotifier &operator=(const EventNotifier &) = delete;
+
+    /**@brief Create the descriptor if not created already, does nothing on Windows. */
+    uint32_t open() noexcept;
+
+    /**@brief The descriptor to poll for readability, -1 if there is none. */
+    int fd() const noexcept;
+
+    /**@brief Make the descriptor readable. */
+    void notify() noexcept;
+
+    /**@brief Make the descriptor not readable. */
+    void clear() noexcept;
+
+  private:
+    // The same descriptor for an eventfd
+    int readFd;
+    int writeFd;
+
+    // Set while the descriptor is readable
+    std::atomic<bool> notified;
+};
+
+#endif // EVENT_NOTIFIER_H
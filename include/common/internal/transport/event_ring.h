@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Bounded single producer, single consumer queue of serialized events.
+ *
+ * The slots are allocated once and keep their capacity, pushing an event only copies it into the
+ * next free slot. Producer and consumer synchronize through the head and tail indexes and a state
+ * per slot. A thread waiting for data or space spins for a short while and then parks on a
+ * condition variable, the other side only takes the mutex to wake it when a thread is parked.
+ *
+ * Events are pushed to one of several lanes, each holding up to capacity events. The consumer
+ * takes events from the lane with the lowest index first. Events pushed with the same ordering
+ * key are still taken in the order they are pushed: before an event is taken from a lane, older
+ * events with the same key are taken from the lanes with higher indexes.
+ *
+ * When a lane is full the producer may drop, rewrite or flag events that are queued but not yet
+ * taken by the consumer. A dropped event keeps its slot until the consumer passes it, each lane has
+ * twice the requested number of slots so that dropping events makes room for new ones. The
+ * producer may also push to a reserve of slots beyond the capacity of a full lane, see
+ * tryBeginPush.
+ *
+ * beginPush/endPush/dropOldest/rewriteNewest/flagOldest/flagNewest must only be called from one
+ * thread at a time, the same applies to beginPop/endPop/clear.
+ */
+class EventRing
+{
+  public:
+    /**@brief Ordering key of events that may be taken in any order relative to other events. */
+    static constexpr uint32_t Unordered = UINT32_MAX;
+
+    /**
+     * @brief Create a ring with laneCount lanes holding capacity events each, and up to reserve
+     * more events each when pushed with tryBeginPush.
+     */
+    explicit EventRing(const size_t capacity, const size_t laneCount = 1,
+                       const size_t reserve = 0);
+
+    EventRing(const EventRing &) = delete;
+    EventRing &operator=(const EventRing &) = delete;
+
+    /**
+     * @brief Slot to write the next event of lane into, waits while the lane is full. With
+     * useReserve the lane is only full when the reserve is full as well.
+     *
+     * @return The slot, or nullptr if the ring is stopped.
+     */
+    std::vector<uint8_t> *beginPush(const size_t lane = 0, const bool useReserve = false) noexcept;
+
+    /**
+     * @brief Make the slot returned by beginPush available to the consumer.
+     *
+     * @param[in] orderingKey Events with the same key are taken in the order they are pushed.
+     * @param[in] flags       Passed to the consumer with the event, see flags().
+     */
+    void endPush(const uint32_t orderingKey = Unordered, const uint8_t flags = 0) noexcept;
+
+    /**
+     * @brief Like beginPush, but returns nullptr instead of waiting while the lane is full. With
+     * useReserve the lane is only full when the reserve is full as well.
+     */
+    std::vector<uint8_t> *tryBeginPush(const size_t lane = 0,
+                                       const bool useReserve = false) noexcept;
+
+    /**@brief True if beginPush would wait. */
+    bool full(const size_t lane = 0) const noexcept;
+
+    /**
+     * @brief Drop the oldest event queued in lane matching predicate(const std::vector<uint8_t> &).
+     *
+     * @return false if no queued event matches.
+     */
+    template <typename Predicate>
+    bool dropOldest(const Predicate &predicate, const size_t lane = 0);
+
+    /**
+     * @brief Call rewrite(std::vector<uint8_t> &) for the newest event queued in lane matching
+     * predicate(const std::vector<uint8_t> &), the consumer does not see the event until rewrite
+     * returns. The ordering key of the event is kept.
+     *
+     * @return false if no queued event matches.
+     */
+    template <typename Predicate, typename Rewrite>
+    bool rewriteNewest(const Predicate &predicate, const Rewrite &rewrite, const size_t lane = 0);
+
+    /**
+     * @brief Add flags to the oldest event queued in lane matching
+     * predicate(const std::vector<uint8_t> &) that does not have them yet. The event stays queued,
+     * the consumer gets the flags with it.
+     *
+     * @return false if no queued event matches.
+     */
+    template <typename Predicate>
+    bool flagOldest(const Predicate &predicate, const uint8_t flags, const size_t lane = 0);
+
+    /**@brief Like flagOldest, but for the newest matching event. */
+    template <typename Predicate>
+    bool flagNewest(const Predicate &predicate, const uint8_t flags, const size_t lane = 0);
+
+    /**
+     * @brief Next event to handle, waits while the ring is empty.
+     *
+     * @param[out] lane  Lane the event was pushed to, may be nullptr.
+     *
+     * @return The event, or nullptr if the ring is stopped.
+     */
+    std::vector<uint8_t> *beginPop(size_t *lane = nullptr) noexcept;
+
+    /**@brief Like beginPop, but returns nullptr instead of waiting while the ring is empty. */
+    std::vector<uint8_t> *tryBeginPop(size_t *lane = nullptr) noexcept;
+
+    /**@brief Like beginPop, but returns nullptr if no event is pushed before deadline. */
+    std::vector<uint8_t> *beginPopUntil(const std::chrono::steady_clock::time_point deadline,
+                                        size_t *lane = nullptr) noexcept;
+
+    /**@brief Flags pushed with the event returned by beginPop. */
+    uint8_t flags() const noexcept;
+
+    /**@brief Release the slot returned by beginPop to the producer. */
+    void endPop() noexcept;
+
+    /**@brief Discard all events in the ring, consumer side. */
+    void clear() noexcept;
+
+    /**@brief Wake up waiting threads and make the ring return nullptr instead of waiting. */
+    void stop() noexcept;
+
+    /**@brief Let the ring wait for data or space again after stop. */
+    void start() noexcept;
+
+    /**@brief Number of events each lane holds. */
+    size_t capacity() const noexcept;
+
+    /**@brief Number of events each lane holds beyond capacity when pushed to the reserve. */
+    size_t reserve() const noexcept;
+
+    size_t laneCount() const noexcept;
+
+    /**@brief Number of events in the ring, dropped events not included. */
+    size_t size() const noexcept;
+
+    /**@brief Largest number of events that has been in the ring at the same time. */
+    size_t highWaterMark() const noexcept;
+
+  private:
+    enum SlotState : uint8_t
+    {
+        SlotQueued,  // Written by the producer, not yet taken by the consumer
+        SlotBusy,    // Taken by the consumer, or being rewritten by the producer
+        SlotDropped, // Dropped by the producer or taken out of order, skipped by the consumer
+    };
+
+    struct Slot
+    {
+        std::vector<uint8_t> data;
+        std::atomic<uint8_t> state;
+        // Written by the producer before the slot is published
+        uint64_t sequenceNumber;
+        uint32_t orderingKey;
+        uint8_t flags;
+    };
+
+    // Producer and consumer indexes are kept on separate cache lines
+    static constexpr size_t CacheLineSize = 64;
+
+    struct Lane
+    {
+        std::unique_ptr<Slot[]> slots;
+        std::atomic<size_t> head; // Next slot to pop, written by the consumer
+        uint8_t headPadding[CacheLineSize - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t> tail; // Next slot to push, written by the producer
+        uint8_t tailPadding[CacheLineSize - sizeof(std::atomic<size_t>)];
+        // Events pushed and not dropped or popped
+        std::atomic<size_t> queued;
+    };
+
+    // Call function with each queued slot of lane from the oldest to the newest, or the reverse,
+    // until it returns true
+    template <typename Function>
+    bool forEachQueued(Lane &lane, const bool newestFirst, const Function &function);
+
+    template <typename Predicate>
+    bool flag(const Predicate &predicate, const uint8_t flags, const size_t lane,
+              const bool newestFirst);
+
+    // Oldest queued slot of a lane, passing dropped slots. Sets retry if the slot is being
+    // rewritten by the producer.
+    Slot *front(const size_t laneIndex, bool &retry) noexcept;
+
+    // Oldest queued slot in the lanes after laneIndex pushed before slot with the same ordering
+    // key, or nullptr. Sets retry if such a slot is being rewritten by the producer.
+    Slot *olderWithSameKey(const size_t laneIndex, const Slot &slot, size_t &olderLane,
+                           bool &retry) noexcept;
+
+    // Waits for an event until deadline, does not wait if deadline is TimePoint::min()
+    typedef std::chrono::steady_clock::time_point TimePoint;
+    std::vector<uint8_t> *pop(size_t *lane, const TimePoint deadline) noexcept;
+    bool empty() const noexcept;
+
+    // True if lane holds limit events, or has no free slot
+    bool full(const size_t lane, const size_t limit) const noexcept;
+
+    template <typename Predicate>
+    bool wait(const Predicate &ready, const TimePoint deadline = TimePoint::max()) noexcept;
+    void wake() noexcept;
+
+    const size_t maximumSize;
+    const size_t reserveSize;
+    const size_t lanesInRing;
+    const size_t slotCount;
+    const size_t mask;
+    std::unique_ptr<Lane[]> lanes;
+
+    // Producer state
+    size_t pushLane;
+    uint64_t nextSequenceNumber;
+
+    // Consumer state
+    Slot *popSlot;
+    size_t popLane;
+
+    std::atomic<size_t> highWater;
+    std::atomic<bool> stopped;
+
+    std::atomic<uint32_t> parked;
+    std::mutex parkMutex;
+    std::condition_variable parkCondition;
+};
+
+template <typename Function>
+bool EventRing::forEachQueued(Lane &lane, const bool newestFirst, const Function &function)
+{
+    // Slots before head may be reused by this thread only, slots from head to tail are stable
+    const auto first = lane.head.load(std::memory_order_acquire);
+    const auto last  = lane.tail.load(std::memory_order_relaxed);
+
+    for (size_t i = 0; i < last - first; i++)
+    {
+        auto &slot = lane.slots[(newestFirst ? last - 1 - i : first + i) & mask];
+
+        if (slot.state.load(std::memory_order_acquire) == SlotQueued && function(slot))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template <typename Predicate>
+bool EventRing::dropOldest(const Predicate &predicate, const size_t lane)
+{
+    auto &queue = lanes[lane];
+
+    return forEachQueued(queue, false, [&](Slot &slot) {
+        if (!predicate(static_cast<const std::vector<uint8_t> &>(slot.data)))
+        {
+            return false;
+        }
+
+        auto expected = static_cast<uint8_t>(SlotQueued);
+
+        // The consumer may have taken the event meanwhile
+        if (!slot.state.compare_exchange_strong(expected, SlotDropped))
+        {
+            return false;
+        }
+
+        queue.queued.fetch_sub(1);
+        return true;
+    });
+}
+
+template <typename Predicate, typename Rewrite>
+bool EventRing::rewriteNewest(const Predicate &predicate, const Rewrite &rewrite,
+                              const size_t lane)
+{
+    return forEachQueued(lanes[lane], true, [&](Slot &slot) {
+        if (!predicate(static_cast<const std::vector<uint8_t> &>(slot.data)))
+        {
+            return false;
+        }
+
+        auto expected = static_cast<uint8_t>(SlotQueued);
+
+        if (!slot.state.compare_exchange_strong(expected, SlotBusy))
+        {
+            return false;
+        }
+
+        try
+        {
+            rewrite(slot.data);
+        }
+        catch (...)
+        {
+            slot.state.store(SlotQueued, std::memory_order_release);
+            throw;
+        }
+
+        slot.state.store(SlotQueued, std::memory_order_release);
+        return true;
+    });
+}
+
+template <typename Predicate>
+bool EventRing::flagOldest(const Predicate &predicate, const uint8_t flags, const size_t lane)
+{
+    return flag(predicate, flags, lane, false);
+}
+
+template <typename Predicate>
+bool EventRing::flagNewest(const Predicate &predicate, const uint8_t flags, const size_t lane)
+{
+    return flag(predicate, flags, lane, true);
+}
+
+template <typename Predicate>
+bool EventRing::flag(const Predicate &predicate, const uint8_t flags, const size_t lane,
+                     const bool newestFirst)
+{
+    return forEachQueued(lanes[lane], newestFirst, [&](Slot &slot) {
+        if ((slot.flags & flags) == flags ||
+            !predicate(static_cast<const std::vector<uint8_t> &>(slot.data)))
+        {
+            return false;
+        }
+
+        auto expected = static_cast<uint8_t>(SlotQueued);
+
+        // The consumer reads the flags after taking the event
+        if (!slot.state.compare_exchange_strong(expected, SlotBusy))
+        {
+            return false;
+        }
+
+        slot.flags |= flags;
+        slot.state.store(SlotQueued, std::memory_order_release);
+        return true;
+    });
+}
+
+#endif // EVENT_RING_H
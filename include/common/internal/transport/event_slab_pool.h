@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef EVENT_SLAB_POOL_H
+#define EVENT_SLAB_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Fixed set of aligned buffers that events are decoded into.
+ *
+ * The event thread takes a slab for each event and puts it back after the event callback returns.
+ * The application may retain the slab of the event it is called with and release it later from
+ * any thread, one slab is always kept free so that retaining events never stops event decoding.
+ *
+ * A slab is handed out cleared. Only the bytes written by the previous decode are cleared again,
+ * which is usually a small part of the slab.
+ */
+class EventSlabPool
+{
+  public:
+    EventSlabPool(const size_t slabCount, const size_t slabSize);
+
+    EventSlabPool(const EventSlabPool &) = delete;
+    EventSlabPool &operator=(const EventSlabPool &) = delete;
+
+    size_t slabSize() const noexcept;
+    size_t slabCount() const noexcept;
+
+    /**@brief Take a cleared slab, nullptr if all slabs are in use. */
+    uint8_t *take() noexcept;
+
+    /**
+     * @brief Return a slab after use unless the application has retained it.
+     *
+     * @param[in] slab          Slab returned by take.
+     * @param[in] writtenLength Number of bytes from the start of the slab that may have been
+     *                          written, the slab size if unknown.
+     */
+    void put(uint8_t *slab, const size_t writtenLength) noexcept;
+
+    /**@brief Keep the slab containing data after put, see sd_rpc_evt_retain. */
+    uint32_t retain(const void *data) noexcept;
+
+    /**@brief Return a retained slab, see sd_rpc_evt_release. */
+    uint32_t release(const void *data) noexcept;
+
+    /**@brief Number of slabs retained by the application. */
+    size_t retained() const noexcept;
+
+  private:
+    struct SlabState
+    {
+        size_t dirtyLength;
+        bool taken;
+        bool retained;
+    };
+
+    // Index of the slab starting at data, -1 if data does not start a slab
+    ptrdiff_t indexOf(const void *data) const noexcept;
+
+    const size_t size;
+    std::unique_ptr<std::max_align_t[]> storage;
+    std::vector<SlabState> states;
+    std::vector<size_t> freeSlabs;
+    size_t retainedCount;
+    mutable std::mutex mutex;
+};
+
+#endif // EVENT_SLAB_POOL_H
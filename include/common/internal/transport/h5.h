@@ -38,10 +38,18 @@
 #ifndef H5_H
 #define H5_H
 
+#include "tx_buffer.h"
+
 #include <stdint.h>
 #include <vector>
 
 const uint32_t H5_HEADER_LENGTH = 4;
+const uint32_t H5_CRC_LENGTH    = 2;
+
+// Maximum length of a SLIP decoded H5 packet, 12 bit payload length
+const uint32_t H5_MAX_PACKET_LENGTH = H5_HEADER_LENGTH + 0xFFF + H5_CRC_LENGTH;
+
+const uint16_t H5_CRC16_INITIAL_VALUE = 0xFFFF;
 
 typedef enum {
     ACK_PACKET             = 0,
@@ -64,10 +72,26 @@ typedef enum {
     CONTROL_PKT_LAST                 = 10
 } control_pkt_type;
 
+uint16_t calculate_crc16_checksum(const uint8_t *start, const uint8_t *end,
+                                  uint16_t crc = H5_CRC16_INITIAL_VALUE);
+
+void h5_decode_header(const uint8_t *header, uint8_t *seq_num, uint8_t *ack_num,
+                      bool *crc_present, bool *reliable_packet, h5_pkt_type_t *packet_type,
+                      uint16_t *payload_length);
+bool h5_header_checksum_valid(const uint8_t *header);
+
 void h5_encode(const std::vector<uint8_t> &in_packet, std::vector<uint8_t> &out_packet,
                uint8_t seq_num, uint8_t ack_num, bool crc_present, bool reliable_packet,
                h5_pkt_type_t packet_type);
 
+void h5_encode(TxBuffer &packet, uint8_t seq_num, uint8_t ack_num, bool crc_present,
+               bool reliable_packet, h5_pkt_type_t packet_type);
+
+uint32_t h5_decode(const uint8_t *slip_dec_packet, size_t slip_dec_packet_length,
+                   const uint8_t **h5_dec_packet, uint8_t *seq_num, uint8_t *ack_num,
+                   bool *_data_integrity, uint16_t *_payload_length, uint8_t *_header_checksum,
+                   bool *reliable_packet, h5_pkt_type_t *packet_type);
+
 uint32_t h5_decode(const std::vector<uint8_t> &slip_dec_packet, std::vector<uint8_t> &h5_dec_packet,
                    uint8_t *seq_num, uint8_t *ack_num, bool *_data_integrity,
                    uint16_t *_payload_length, uint8_t *_header_checksum, bool *reliable_packet,
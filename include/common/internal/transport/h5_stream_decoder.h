@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef H5_STREAM_DECODER_H
+#define H5_STREAM_DECODER_H
+
+#include "h5.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief A SLIP decoded H5 packet emitted by H5StreamDecoder.
+ *
+ * errorCode is the same error code as returned by slip_decode and h5_decode for the packet. The
+ * header fields are valid when the packet is at least H5_HEADER_LENGTH long. payload and
+ * slipPayload refer to memory owned by the decoder and are only valid in the frame callback.
+ */
+struct H5Frame
+{
+    uint32_t errorCode;
+    uint8_t seqNum;
+    uint8_t ackNum;
+    bool crcPresent;
+    bool reliable;
+    h5_pkt_type_t type;
+    const uint8_t *payload;
+    uint16_t payloadLength;
+    const std::vector<uint8_t> *slipPayload;
+};
+
+typedef std::function<void(const H5Frame &frame)> h5_frame_cb_t;
+
+/**
+ * @brief Resumable decoder of a stream of SLIP encoded H5 packets.
+ *
+ * Data is fed in chunks of any size as received from the UART. Bytes are unescaped into a frame
+ * buffer that is reused between packets. The H5 header is parsed as soon as it is received and the
+ * CRC is updated with each chunk, so a packet is validated when its end delimiter arrives without
+ * another pass over the packet.
+ */
+class H5StreamDecoder
+{
+  public:
+    explicit H5StreamDecoder(const h5_frame_cb_t &frameCallback);
+
+    void decode(const uint8_t *data, const size_t length);
+    void reset();
+
+  private:
+    typedef enum {
+        STATE_WAIT_START, // Waiting for start of packet delimiter
+        STATE_PACKET,     // Receiving packet
+        STATE_ESCAPE,     // Received escape byte, waiting for escaped byte
+        STATE_DISCARD     // Invalid escape sequence, waiting for end of packet delimiter
+    } decoder_state_t;
+
+    void append(const uint8_t *start, const uint8_t *end);
+    void updateCrc();
+    void emitFrame(const uint32_t slipErrorCode);
+
+    h5_frame_cb_t frameCallback;
+    decoder_state_t state;
+
+    std::vector<uint8_t> frame;
+    bool oversized;
+
+    H5Frame header;
+    bool headerDecoded;
+    bool headerChecksumValid;
+
+    uint16_t crc;
+    size_t crcLength;
+};
+
+#endif // H5_STREAM_DECODER_H
@@ -48,7 +48,12 @@
 #include <vector>
 
 #include "h5.h"
+#include "h5_stream_decoder.h"
 #include "h5_transport_exit_criterias.h"
+#include "latency_histogram.h"
+#include "rtt_estimator.h"
+#include <array>
+#include <chrono>
 #include <map>
 #include <stdint.h>
 #include <thread>
@@ -75,22 +80,53 @@ constexpr uint8_t SyncConfigRspFirstByte  = 0x04;
 constexpr uint8_t SyncConfigRspSecondByte = 0x7B;
 constexpr uint8_t SyncConfigField         = 0x11;
 
+// Sliding window size is stored in the three least significant bits of the configuration field
+constexpr uint8_t SyncConfigSlidingWindowSizeMask = 0x07;
+constexpr uint8_t MinSlidingWindowSize            = 1;
+constexpr uint8_t MaxSlidingWindowSize            = 7;
+
+// Bounds for the retransmission timeout adapted to the measured round trip time. The upper bound
+// is raised to the configured retransmission interval if that is larger.
+constexpr auto MinRetransmissionTimeout = std::chrono::milliseconds(20);
+constexpr auto MaxRetransmissionTimeout = std::chrono::milliseconds(1000);
+
+// Runs with stateMachineMutex held each time the state machine is notified or the deadline of the
+// state passes. Returns the current state to stay in it, otherwise the next state.
 using state_action_t = std::function<h5_state_t()>;
 using payload_t      = std::vector<uint8_t>;
 
+// Invoked with NRF_SUCCESS when a reliable packet is acknowledged, with an error code when it is
+// not. Invoked without locks held, from the thread receiving packets or retransmitting them.
+typedef std::function<void(const uint32_t errorCode)> sent_cb_t;
+
 class H5Transport : public Transport
 {
   public:
     H5Transport() = delete;
-    H5Transport(UartTransport *nextTransportLayer, const uint32_t retransmission_interval);
+    H5Transport(UartTransport *nextTransportLayer, const uint32_t retransmission_interval,
+                const uint8_t sliding_window_size = MinSlidingWindowSize);
     ~H5Transport() noexcept override;
 
     uint32_t open(const status_cb_t &status_callback, const data_cb_t &data_callback,
                   const log_cb_t &log_callback) noexcept override;
     uint32_t close() noexcept override;
     uint32_t send(const std::vector<uint8_t> &data) noexcept override;
+    uint32_t send(const std::shared_ptr<TxBuffer> &buffer) noexcept override;
+
+    // Send a reliable packet without waiting for its acknowledgement, waits only for room in the
+    // sliding window. sentCallback is invoked when the packet is acknowledged or fails, unless
+    // an error code is returned.
+    virtual uint32_t sendAsync(const std::shared_ptr<TxBuffer> &buffer,
+                               const sent_cb_t &sentCallback) noexcept;
+
+    void getStats(sd_rpc_stats_t &stats) noexcept override;
+    std::string portName() const override;
+    void setLogSeverityFilter(const sd_rpc_log_severity_t severity) noexcept override;
+    void setTraceAdapter(const uint32_t adapter) noexcept override;
+    void setLogChannel(const uint32_t channel) noexcept override;
 
     h5_state_t state() const;
+    uint8_t slidingWindowSize() const;
 
     static bool isSyncPacket(const payload_t &packet, const uint8_t offset = 0);
     static bool isSyncResponsePacket(const payload_t &packet, const uint8_t offset = 0);
@@ -100,21 +136,24 @@ class H5Transport : public Transport
     static bool checkPattern(const payload_t &packet, const uint8_t offset,
                              const payload_t &pattern);
     static payload_t getPktPattern(const control_pkt_type);
+    static uint8_t syncConfigField(const uint8_t slidingWindowSize);
     static std::string stateToString(const h5_state_t state) noexcept;
     static std::string pktTypeToString(const h5_pkt_type_t pktType);
 
   private:
     void dataHandler(const uint8_t *data, const size_t length) noexcept;
     void statusHandler(const sd_rpc_app_status_t code, const std::string &error) noexcept;
-    void processPacket(const payload_t &packet);
+    void processPacket(const H5Frame &frame);
 
     void sendControlPacket(control_pkt_type type, const uint8_t ackNum = 0xff);
 
-    void incrementSeqNum();
+    // Set the negotiated sliding window size from a SYNC_CONFIG or SYNC_CONFIG_RESPONSE of the peer
+    void negotiateSlidingWindowSize(const payload_t &syncConfigPacket);
+
     void incrementAckNum();
+    void resetSequenceNumbers();
 
     Transport *nextTransportLayer;
-    std::vector<uint8_t> lastPacket;
 
     // Callbacks used by lower transports
     // These callbacks invoke upper callbacks
@@ -122,14 +161,16 @@ class H5Transport : public Transport
     data_cb_t dataCallback;
 
     // Variables used for reliable packets
+    //
+    // seqNum is the sequence number of the oldest reliable packet not yet acknowledged by the peer
     std::recursive_mutex seqNumMutex;
     uint8_t seqNum;
 
     std::recursive_mutex ackNumMutex;
     uint8_t ackNum;
 
-    bool c0Found;
-    std::vector<uint8_t> unprocessedData;
+    // Decoder of incoming SLIP encoded H5 packets
+    H5StreamDecoder rxDecoder;
 
     // Mutex controlling access to state machine variables in
     // the different state machine states
@@ -143,16 +184,77 @@ class H5Transport : public Transport
     std::mutex ackMutex;
     std::condition_variable ackReceived;
 
-    // Debugging related
+    // Retransmission timeout of reliable packets, protected by ackMutex. The estimate is copied
+    // to the atomics below when it changes, ::getStats reads the copy without taking ackMutex.
+    RttEstimator rttEstimator;
+    std::atomic<uint32_t> smoothedRttUs;
+    std::atomic<uint32_t> rttVariationUs;
+    std::atomic<uint32_t> retransmissionTimeoutUs;
+    void updateRttSnapshot() noexcept;
+
+    // Sliding window, reliable packets sent but not acknowledged yet (go-back-N)
+    struct OutstandingPacket
+    {
+        uint8_t seqNum;
+        std::shared_ptr<TxBuffer> slipPacket;
+        sent_cb_t sentCallback;
+        uint8_t transmissions;
+        std::chrono::steady_clock::time_point firstSent;
+        std::chrono::steady_clock::time_point lastSent;
+    };
+
+    // Requested sliding window size and the size negotiated with the peer in STATE_INITIALIZED
+    uint8_t requestedSlidingWindowSize;
+    uint8_t negotiatedSlidingWindowSize;
+
+    // Protected by ackMutex, a ring of window slots with the oldest packet at outstandingHead
+    std::array<OutstandingPacket, MaxSlidingWindowSize> outstandingPackets;
+    size_t outstandingHead;
+    size_t outstandingCount;
+    OutstandingPacket &outstandingPacket(const size_t index);
+    void retransmitOutstandingPackets();
+
+    // Remove all packets from the window, ackMutex must be held. Their callbacks are kept in
+    // failedSentCallbacks and invoked by ::completeFailedPackets, which must be called without
+    // the state machine locks held since a callback may send the next packet.
+    void failOutstandingPackets();
+    bool hasFailedPackets();
+    void completeFailedPackets();
+    std::vector<sent_cb_t> failedSentCallbacks;
+
+    // Packets are only accepted while retransmitting is set, protected by ackMutex. The state
+    // machine retransmits the packets of the window that time out in STATE_ACTIVE.
+    bool retransmitting;
+    void startRetransmission();
+    void stopRetransmission();
+
+    // Retransmit or fail the packets of the window if the oldest packet timed out. Returns false
+    // if the window is empty, otherwise deadline is set to the timeout of the oldest packet.
+    bool retransmitTimedOutPackets(std::chrono::steady_clock::time_point &deadline);
+
+    // Statistics, see ::getStats. Counters are updated with relaxed atomic operations, the
+    // packet counts are also shown in logged packets.
     std::atomic<uint32_t> incomingPacketCount;
     std::atomic<uint32_t> outgoingPacketCount;
     std::atomic<uint32_t> errorPacketCount;
-
+    std::atomic<uint32_t> slipErrorCount;
+    std::atomic<uint32_t> headerErrorCount;
+    std::atomic<uint32_t> crcErrorCount;
+    std::atomic<uint32_t> retransmissionCount;
+    std::atomic<uint32_t> resyncCount;
+    LatencyHistogram ackRtt;
+    void countPacketError(const uint32_t errorCode) noexcept;
+
+    // Counts the packet and logs it as a binary record if debug messages are logged, the record
+    // is formatted by formatPacket
+    void logPacket(const bool outgoing, const uint8_t *packet, const size_t length);
     void logPacket(const bool outgoing, const payload_t &packet);
+    static std::string formatPacket(const LogRecord &record, const std::string &packet);
     void logStateTransition(const h5_state_t from, const h5_state_t to) const;
     static std::string asHex(const payload_t &packet);
     static std::string hciPacketLinkControlToString(const payload_t &payload);
-    std::string h5PktToString(const bool out, const payload_t &h5Packet) const;
+    static std::string h5PktToString(const bool out, const uint32_t packetCount,
+                                     const uint32_t errorCount, const payload_t &h5Packet);
 
     // State machine related
     h5_state_t currentState;
@@ -160,6 +262,12 @@ class H5Transport : public Transport
 
     bool stateMachineReady;
 
+    // Protected by stateMachineMutex. stateEntered is cleared when a state is entered and set by
+    // its action, the action sets stateDeadline to when it is run again unless notified before.
+    bool stateEntered;
+    std::chrono::steady_clock::time_point stateDeadline;
+    uint8_t syncRetransmission;
+
     std::map<h5_state_t, state_action_t> stateActions;
     void setupStateMachine();
     void startStateMachine();
@@ -167,8 +275,27 @@ class H5Transport : public Transport
 
     std::map<h5_state_t, std::shared_ptr<ExitCriterias>> exitCriterias;
 
+    // Enter nextState, currentStateMutex and stateMachineMutex must be held. Returns false if
+    // nextState is terminal.
+    bool enterState(const h5_state_t nextState);
+
+    // Notify the state machine of a change of its exit criterias or sliding window
+    void notifyStateMachine();
+
     void stateMachineWorker() noexcept;
 
+    // Runs the state machine on the threads of the SharedIoContext instead of stateMachineThread
+    // when sharing is enabled. The state actions run on a strand and a timer runs them again at
+    // stateDeadline. Protected by stateMachineStepMutex, which is not held while other locks are
+    // taken.
+    struct SharedStateMachine;
+    std::unique_ptr<SharedStateMachine> sharedStateMachine;
+    std::mutex stateMachineStepMutex;
+    std::condition_variable stateMachineStepDone;
+    void scheduleStateMachineStep();
+    void runStateMachineStep() noexcept;
+    void armStateMachineTimer(const std::chrono::steady_clock::time_point deadline);
+
     // Mutex that allows threads to wait for a given state in the state machine
     std::mutex currentStateMutex;
     bool waitForState(h5_state_t state, std::chrono::milliseconds timeout);
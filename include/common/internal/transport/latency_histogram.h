@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Values are grouped by their power of two, each power of two is split in 2^SubBucketBits
+// buckets. The upper bound of a bucket is at most 12.5% above its values.
+constexpr uint32_t LatencyHistogramSubBucketBits = 3;
+constexpr uint32_t LatencyHistogramSubBuckets    = 1 << LatencyHistogramSubBucketBits;
+
+// Values of 2^LatencyHistogramMagnitudes nanoseconds (about 137 seconds) or more are counted
+// in the last bucket
+constexpr uint32_t LatencyHistogramMagnitudes = 37;
+constexpr size_t LatencyHistogramBucketCount =
+    (LatencyHistogramMagnitudes - LatencyHistogramSubBucketBits + 1) * LatencyHistogramSubBuckets;
+
+/**
+ * @brief Histogram of durations with log-linear buckets, in the style of HdrHistogram.
+ *
+ * Recording is wait free, it updates a few counters with relaxed atomic operations and may be
+ * done from any number of threads. Readers get approximate values while samples are recorded,
+ * a sample recorded during reset may be partly kept.
+ */
+class LatencyHistogram
+{
+  public:
+    LatencyHistogram() noexcept;
+
+    void record(const std::chrono::nanoseconds duration) noexcept;
+    void reset() noexcept;
+
+    uint64_t count() const noexcept;
+    std::chrono::nanoseconds min() const noexcept;
+    std::chrono::nanoseconds max() const noexcept;
+    std::chrono::nanoseconds mean() const noexcept;
+
+    /**@brief Smallest bucket bound that at least percentile percent of the samples are below,
+     * zero without samples. */
+    std::chrono::nanoseconds percentile(const double percentile) const noexcept;
+
+    /**@brief Buckets for exporting the histogram, the number of samples in bucket index and the
+     * largest value the bucket counts. */
+    uint64_t bucketCount(const size_t index) const noexcept;
+    static uint64_t bucketUpperBound(const size_t index) noexcept;
+    static size_t bucketIndex(const uint64_t value) noexcept;
+
+  private:
+    std::array<std::atomic<uint64_t>, LatencyHistogramBucketCount> buckets;
+    std::atomic<uint64_t> samples;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> minimum;
+    std::atomic<uint64_t> maximum;
+};
+
+/**@brief Duration in whole microseconds, limited to the range of uint32_t. */
+uint32_t toMicroseconds(const std::chrono::nanoseconds duration) noexcept;
+
+#endif // LATENCY_HISTOGRAM_H
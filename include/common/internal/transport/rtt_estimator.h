@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RTT_ESTIMATOR_H
+#define RTT_ESTIMATOR_H
+
+#include <chrono>
+
+/**
+ * @brief Retransmission timeout estimator as described in RFC 6298.
+ *
+ * Keeps a smoothed round trip time and round trip time variation from acknowledgement samples and
+ * derives the retransmission timeout from them. Only packets transmitted once may be sampled
+ * (Karn's rule), the timeout is instead doubled on each retransmission until a new sample arrives.
+ * The timeout is always kept within [minimum, maximum].
+ *
+ * The estimator is not thread safe.
+ */
+class RttEstimator
+{
+  public:
+    RttEstimator(const std::chrono::microseconds initialTimeout,
+                 const std::chrono::microseconds minimumTimeout,
+                 const std::chrono::microseconds maximumTimeout) noexcept;
+
+    /**@brief Update the estimate with the round trip time of a packet that was sent once. */
+    void addSample(const std::chrono::microseconds rtt) noexcept;
+
+    /**@brief Double the timeout after a retransmission. */
+    void backOff() noexcept;
+
+    /**@brief Forget all samples and return to the initial timeout. */
+    void reset() noexcept;
+
+    bool hasSample() const noexcept;
+    std::chrono::microseconds smoothedRtt() const noexcept;
+    std::chrono::microseconds rttVariation() const noexcept;
+    std::chrono::microseconds timeout() const noexcept;
+    std::chrono::microseconds maximumTimeout() const noexcept;
+
+  private:
+    std::chrono::microseconds clamp(const std::chrono::microseconds timeout) const noexcept;
+
+    const std::chrono::microseconds initial;
+    const std::chrono::microseconds minimum;
+    const std::chrono::microseconds maximum;
+
+    bool sampled;
+    std::chrono::microseconds srtt;
+    std::chrono::microseconds rttvar;
+    std::chrono::microseconds rto;
+};
+
+#endif // RTT_ESTIMATOR_H
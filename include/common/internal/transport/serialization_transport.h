@@ -38,24 +38,65 @@
 #ifndef SERIALIZATION_TRANSPORT_H
 #define SERIALIZATION_TRANSPORT_H
 
+#include "command_latencies.h"
+#include "event_filter.h"
+#include "event_notifier.h"
+#include "event_ring.h"
+#include "event_slab_pool.h"
 #include "h5_transport.h"
+#include "latency_histogram.h"
 #include "transport.h"
 
 #include "ble.h"
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <thread>
 
 #include <cstdint>
-#include <queue>
+#include <vector>
 
 typedef uint32_t (*transport_rsp_handler_t)(const uint8_t *p_buffer, uint16_t length);
 typedef std::function<void(ble_evt_t *p_ble_evt)> evt_cb_t;
+typedef std::function<void(ble_evt_t *const *pp_ble_evts, const uint32_t count)> evt_batch_cb_t;
+
+// Invoked with NRF_SUCCESS when the response is copied to the response buffer, an error code
+// otherwise. Invoked from the H5Transport thread, it must not block or call ::send.
+typedef std::function<void(const uint32_t errorCode)> rsp_cb_t;
 
 constexpr size_t MaxPossibleEventLength = 700;
 
+// Number of buffers for decoded events, all but one may be retained by the application
+constexpr size_t EventSlabCount = 16;
+
+// Largest number of events passed to an event batch callback at a time
+constexpr uint32_t EventBatchMaxCount = 256;
+
+// Default number of received events that may wait for the event thread
+constexpr size_t EventQueueCapacity = 1024;
+
+// Default handling of received events when the event queue is full. Dropping advertising reports
+// keeps a flood of reports from filling the reserve and pausing reading, which would hold up the
+// responses to commands called from the event callback.
+constexpr sd_rpc_evt_queue_overflow_t EventQueueDefaultOverflowPolicy =
+    SD_RPC_EVT_QUEUE_OVERFLOW_DROP_OLDEST_ADV_REPORT;
+
+// Number of events each lane of the event queue holds beyond its capacity for events received
+// while the lane is full and not dropped by the overflow policy
+constexpr size_t EventQueueOverflowReserve = 256;
+
+// Lanes of the event queue, events in the high priority lane are passed to the event callback
+// before events in the normal lane unless an older event of the same connection is queued
+constexpr size_t EventLaneHigh   = 0;
+constexpr size_t EventLaneNormal = 1;
+constexpr size_t EventLaneCount  = 2;
+
+// Minimum time between event queue overflow reports to the status callback
+constexpr auto EventQueueOverflowReportInterval = std::chrono::seconds(1);
+
 struct eventData_t
 {
     uint8_t *data;
@@ -82,40 +123,220 @@ class SerializationTransport
     SerializationTransport(H5Transport *dataLinkLayer, uint32_t response_timeout);
     ~SerializationTransport();
 
+    // discarded_event_callback is invoked instead of event_callback for events discarded by the
+    // event filter that are decoded since their decoders keep state, see eventFilter
     uint32_t open(const status_cb_t &status_callback, const evt_cb_t &event_callback,
-                  const log_cb_t &log_callback) noexcept;
+                  const log_cb_t &log_callback,
+                  const evt_cb_t &discarded_event_callback = nullptr) noexcept;
     uint32_t close() noexcept;
     uint32_t send(const std::vector<uint8_t> &cmdBuffer,
                   std::shared_ptr<std::vector<uint8_t>> rspBuffer,
                   serialization_pkt_type_t pktType = SERIALIZATION_COMMAND) noexcept;
 
+    // Send a command encoded in the payload of a TxBuffer, the command is not copied. The time
+    // until the command is acknowledged and until its response is received is recorded in
+    // commandLatencies for the opcode of the command.
+    uint32_t send(const std::shared_ptr<TxBuffer> &cmdBuffer,
+                  std::shared_ptr<std::vector<uint8_t>> rspBuffer,
+                  serialization_pkt_type_t pktType = SERIALIZATION_COMMAND) noexcept;
+
+    // Send a command without waiting for the response or the acknowledgement of the data link
+    // layer. Several commands may be outstanding, up to the sliding window size of the data link
+    // layer unacknowledged, responses are matched to commands in the order the commands are sent.
+    // Without rspBuffer responseCallback is invoked when the command is acknowledged.
+    uint32_t sendAsync(const std::vector<uint8_t> &cmdBuffer,
+                       std::shared_ptr<std::vector<uint8_t>> rspBuffer,
+                       const rsp_cb_t &responseCallback,
+                       serialization_pkt_type_t pktType = SERIALIZATION_COMMAND) noexcept;
+    uint32_t sendAsync(const std::shared_ptr<TxBuffer> &cmdBuffer,
+                       std::shared_ptr<std::vector<uint8_t>> rspBuffer,
+                       const rsp_cb_t &responseCallback,
+                       serialization_pkt_type_t pktType = SERIALIZATION_COMMAND) noexcept;
+
+    void getStats(sd_rpc_stats_t &stats) noexcept;
+
+    // Name of the serial port of the adapter
+    std::string portName() const;
+
+    // Latencies of the phases of commands sent with ::send, per opcode
+    CommandLatencies &commandLatencies() noexcept;
+
+    // Pass the log severity filter of the adapter to the layers below, they skip building
+    // messages that would be filtered out
+    void setLogSeverityFilter(const sd_rpc_log_severity_t severity) noexcept;
+
+    // Tag the spans recorded by this layer and the layers below with the number of the adapter
+    void setTraceAdapter(const uint32_t adapter) noexcept;
+
+    // Pass the channel of LogRing::global the adapter logs to to the layers below, they log
+    // binary records to it
+    void setLogChannel(const uint32_t channel) noexcept;
+
+    // Set capacity and overflow policy of the event queue, only while closed. Blocking is not
+    // supported when events are pulled.
+    uint32_t setEventQueueConfig(const size_t capacity,
+                                 const sd_rpc_evt_queue_overflow_t overflowPolicy) noexcept;
+
+    // Pass decoded events to callback instead of the event callback, up to maxCount events at a
+    // time and without delaying the first event of a batch by more than timeBudget. An empty
+    // callback passes events one at a time again. Only while closed.
+    uint32_t setEventBatchConfig(const evt_batch_cb_t &callback, const uint32_t maxCount,
+                                 const std::chrono::microseconds timeBudget) noexcept;
+
+    // Pass events to the event callback on the event thread or directly on the H5Transport
+    // thread, or keep them queued for getEvent, only while closed. While an event callback runs
+    // on the H5Transport thread no packets are received, so commands sent from the callback fail
+    // instead of waiting. Events are not pulled with a blocking overflow policy.
+    uint32_t setEventDispatch(const sd_rpc_evt_dispatch_t dispatch) noexcept;
+
+    // Decode the oldest queued event into event when events are pulled, waits up to timeout.
+    // eventLength is the size of event on input and the length of the decoded event on output.
+    uint32_t getEvent(ble_evt_t *event, uint32_t &eventLength,
+                      const std::chrono::milliseconds timeout) noexcept;
+
+    // Descriptor readable while events wait for getEvent
+    uint32_t getEventFd(int &fd) const noexcept;
+
+    // Queue events with ID eventId in the high priority or normal lane, only while closed
+    uint32_t setEventPriority(const uint16_t eventId,
+                              const sd_rpc_evt_priority_t priority) noexcept;
+
+    // Filter applied to received events before they are queued, may be changed while open
+    EventFilter &eventFilter() noexcept;
+
+    // Keep a decoded event after the event callback returns, see sd_rpc_evt_retain
+    uint32_t retainEvent(const ble_evt_t *event) noexcept;
+    uint32_t releaseEvent(const ble_evt_t *event) noexcept;
+
   private:
+    // Completion of a command sent with ::send, shared with the H5Transport thread since the
+    // response may be received after a timeout. Reused by the next command of the same thread.
+    // The response timeout starts when the command is acknowledged.
+    struct ResponseCompletion
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool acknowledged;
+        std::chrono::steady_clock::time_point acknowledgedAt;
+        bool completed;
+        uint32_t errorCode;
+    };
+
+    static std::shared_ptr<ResponseCompletion> acquireResponseCompletion();
+
+    uint32_t sendAsync(const std::shared_ptr<TxBuffer> &cmdBuffer,
+                       const std::shared_ptr<std::vector<uint8_t>> &rspBuffer,
+                       const rsp_cb_t &responseCallback,
+                       const std::shared_ptr<ResponseCompletion> &completion,
+                       serialization_pkt_type_t pktType, uint32_t &responseId) noexcept;
+
+    // Invoked by the data link layer when the command of a pending response is acknowledged or
+    // fails, a failed command is completed with the error code
+    void commandSent(const uint32_t responseId, const uint32_t errorCode);
+
     void readHandler(const uint8_t *data, const size_t length);
     void eventHandlingRunner() noexcept;
 
+    // Decode a serialized event into a slab. Returns nullptr if the event can not be decoded,
+    // otherwise eventLength is the number of bytes of the slab written.
+    ble_evt_t *decodeEvent(const uint8_t *data, const size_t length, uint32_t &eventLength);
+    void reportDecodeError(const uint32_t errCode);
+    void handleEventBatch(std::vector<uint8_t> *eventData);
+
     status_cb_t statusCallback;
     evt_cb_t eventCallback;
+    evt_cb_t discardedEventCallback;
     log_cb_t logCallback;
 
     data_cb_t dataCallback;
 
     std::shared_ptr<H5Transport> nextTransportLayer;
     uint32_t responseTimeout;
+    uint32_t traceAdapter;
 
-    bool responseReceived;
-    std::shared_ptr<std::vector<uint8_t>> responseBuffer;
+    // A pending response completes either completion or callback
+    struct PendingResponse
+    {
+        uint32_t id;
+        std::shared_ptr<std::vector<uint8_t>> buffer;
+        rsp_cb_t callback;
+        std::shared_ptr<ResponseCompletion> completion;
+        std::chrono::steady_clock::time_point sentAt;
+    };
 
+    // Mutex to keep the order of pendingResponses the same as the order commands are sent in, held
+    // until the data link layer has assigned a sequence number to the command
     std::mutex sendMutex;
 
+    // Only a few commands are outstanding, a vector keeps its capacity when responses are removed
+    // from the front while a deque frees and allocates blocks as it moves
     std::mutex responseMutex;
-    std::condition_variable responseWaitCondition;
+    std::vector<PendingResponse> pendingResponses;
+    uint32_t nextResponseId;
+    bool removePendingResponse(const uint32_t id);
+    void failPendingResponses(const uint32_t errorCode);
+    static void completePendingResponse(PendingResponse &pendingResponse,
+                                        const uint32_t errorCode);
+
+    // Time from sending a command until its response is received, in total and per phase of
+    // commands sent with ::send
+    LatencyHistogram commandLatency;
+    CommandLatencies latencies;
 
-    std::mutex eventMutex;
-    std::condition_variable eventWaitCondition;
+    // Events are passed from the H5Transport thread to eventThread through eventQueue. The slots
+    // of the queue keep their buffers, receiving an event does not allocate memory. eventLanes
+    // holds the lane of each event ID, events of a connection are ordered by connection handle.
     std::thread eventThread;
-    std::queue<std::vector<uint8_t>> eventQueue;
+    std::unique_ptr<EventRing> eventQueue;
+    std::array<uint8_t, 256> eventLanes;
+    void receiveEvent(const uint8_t *data, const size_t length);
+    void queueEvent(const uint8_t *data, const size_t length, const uint8_t flags);
     void drainEventQueue();
-    bool processEvents;
+    std::atomic<bool> processEvents;
+
+    // Events discarded by filter are not queued unless their decoders keep state, such events are
+    // queued with the discarded flag and passed to discardedEventCallback
+    EventFilter filter;
+    std::atomic<uint32_t> filteredEvents;
+    std::atomic<uint32_t> filteredAdvReports;
+
+    // Handling of received events when eventQueue is full, only used by the H5Transport thread
+    // except for the counters. Events that are not dropped are pushed to the reserve of the full
+    // lane, when the reserve is full as well the H5Transport thread waits for room. Only
+    // advertising reports are dropped, and only by the drop and coalesce policies. Reports whose
+    // decoders keep state are flagged as discarded instead of dropped, see decoderKeepsState.
+    // When events are pulled the H5Transport thread never waits, events finding the reserve full
+    // are lost and reported each time with reportLostEvent.
+    sd_rpc_evt_queue_overflow_t eventQueueOverflowPolicy;
+    std::atomic<uint32_t> droppedEvents;
+    std::atomic<uint32_t> coalescedEvents;
+    std::atomic<uint32_t> lostEvents;
+    std::chrono::steady_clock::time_point lastOverflowReport;
+    void reportEventQueueOverflow();
+    void reportLostEvent(const uint16_t eventId);
+
+    // Events passed to the event callback on the H5Transport thread skip eventQueue, except
+    // events discarded by filter since their callback sends commands. inlineDispatchThread is
+    // the H5Transport thread while it runs an event callback, commands sent from that thread
+    // would wait for a response the thread can not receive.
+    sd_rpc_evt_dispatch_t eventDispatch;
+    std::atomic<std::thread::id> inlineDispatchThread;
+    void dispatchEvent(const uint8_t *data, const size_t length);
+    bool isInlineDispatchThread() const noexcept;
+
+    // Events pulled by the application are taken from eventQueue by one thread at a time
+    std::mutex pullMutex;
+    EventNotifier eventNotifier;
+
+    // Buffers events are decoded into, one more for each event of a batch
+    std::unique_ptr<EventSlabPool> eventSlabs;
+
+    // Passing events in batches, only used by eventThread while open
+    evt_batch_cb_t eventBatchCallback;
+    uint32_t eventBatchMaxCount;
+    std::chrono::microseconds eventBatchTimeBudget;
+    std::vector<ble_evt_t *> eventBatch;
+    std::vector<uint32_t> eventBatchLengths;
 
     // Use recursive mutex since the mutex may be acquired recursively in the same thread
     // in the case of ::eventHandlingRunner thread calling a application callback that
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SERIALIZED_EVENT_H
+#define SERIALIZED_EVENT_H
+
+#include "ble.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Access to fields of serialized events without decoding them.
+ *
+ * The functions take an event as received from the connectivity device, starting with the event
+ * ID at SER_EVT_ID_POS. They are used to classify and filter events before they are queued.
+ */
+
+/**@brief Length of the peer address in a serialized advertising report, address type included. */
+constexpr size_t SerializedAdvReportAddressLength = 7;
+
+/**@brief Event ID of a serialized event, 0 if the event is too short. */
+uint16_t serialized_event_id(const uint8_t *event, const size_t length);
+
+/**
+ * @brief Connection handle of a serialized event.
+ *
+ * All BLE events are serialized with the connection handle first after the event ID.
+ *
+ * @return false if the event is too short.
+ */
+bool serialized_event_conn_handle(const uint8_t *event, const size_t length,
+                                  uint16_t *conn_handle);
+
+/**@brief True if the serialized event is a BLE_GAP_EVT_ADV_REPORT. */
+bool serialized_event_is_adv_report(const uint8_t *event, const size_t length);
+
+/**
+ * @brief Peer address and RSSI of a serialized advertising report.
+ *
+ * @param[out] address  Points to SerializedAdvReportAddressLength bytes in the event, the address
+ *                      type followed by the address.
+ *
+ * @return false if the event is not an advertising report or is too short.
+ */
+bool serialized_adv_report_peer(const uint8_t *event, const size_t length,
+                                const uint8_t **address, int8_t *rssi);
+
+/**@brief Peer address and RSSI of a serialized advertising report, decoded into peer_addr.
+ *
+ * @return false if the event is not an advertising report or is too short.
+ */
+bool serialized_adv_report_peer_addr(const uint8_t *event, const size_t length,
+                                     ble_gap_addr_t *peer_addr, int8_t *rssi);
+
+/**
+ * @brief True if two serialized advertising reports are of the same type and from the same peer,
+ * the later report then supersedes the earlier one.
+ */
+bool serialized_adv_report_same_source(const uint8_t *event, const size_t length,
+                                       const uint8_t *other, const size_t otherLength);
+
+#endif // SERIALIZED_EVENT_H
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef SHARED_IO_CONTEXT_H
+#define SHARED_IO_CONTEXT_H
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <asio.hpp>
+
+/**
+ * @brief io_context run by a pool of threads, shared by the serial ports and H5 state machines of
+ * all adapters opened while it is enabled
+ *
+ * Each pool thread keeps the io_context alive until it returns from io_context::run. The last
+ * user may release the context from a completion handler, the pool thread running the handler is
+ * then detached and destroys the io_context when it leaves run.
+ */
+class SharedIoContext
+{
+  public:
+    explicit SharedIoContext(const uint32_t threadCount);
+    ~SharedIoContext() noexcept;
+
+    SharedIoContext(const SharedIoContext &) = delete;
+    SharedIoContext &operator=(const SharedIoContext &) = delete;
+
+    asio::io_context &context() noexcept;
+
+    /**
+     * @brief Returns the context adapters opened now run on, nullptr if sharing is disabled.
+     */
+    static std::shared_ptr<SharedIoContext> current();
+
+    /**
+     * @brief Replaces the current context with one served by threadCount threads, zero disables
+     * sharing. Users of the previous context keep it and its threads until they release it.
+     */
+    static void setThreadCount(const uint32_t threadCount);
+
+  private:
+    struct State;
+
+    static void run(State &state) noexcept;
+
+    std::shared_ptr<State> state;
+    std::vector<std::thread> threads;
+};
+
+#endif // SHARED_IO_CONTEXT_H
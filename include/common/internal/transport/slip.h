@@ -38,10 +38,28 @@
 #ifndef SLIP_H
 #define SLIP_H
 
+#include "tx_buffer.h"
+
+#include <cstddef>
 #include <stdint.h>
 #include <vector>
 
+/**
+ * @brief Returns the length of packet after SLIP encoding, including both frame delimiters.
+ */
+size_t slip_encoded_length(const uint8_t *packet, size_t length);
+
+/**
+ * @brief SLIP encodes length bytes from in_packet into out_packet.
+ *
+ * out_packet must hold slip_encoded_length(in_packet, length) bytes. It may overlap in_packet if it
+ * starts at least slip_encoded_length(in_packet, length) - length - 1 bytes before it.
+ * Returns a pointer past the last byte written.
+ */
+uint8_t *slip_encode(const uint8_t *in_packet, size_t length, uint8_t *out_packet);
+
 void slip_encode(const std::vector<uint8_t> &in_packet, std::vector<uint8_t> &out_packet);
+void slip_encode(TxBuffer &packet);
 uint32_t slip_decode(const std::vector<uint8_t> &packet, std::vector<uint8_t> &out_packet);
 
 #endif
@@ -38,11 +38,15 @@
 #ifndef TRANSPORT_H
 #define TRANSPORT_H
 
+#include "log_ring.h"
 #include "sd_rpc_types.h"
+#include "tx_buffer.h"
 
+#include <atomic>
 #include <cstdint>
 #include <exception>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -61,10 +65,39 @@ class Transport
 
     virtual uint32_t send(const std::vector<uint8_t> &data) noexcept = 0;
 
+    // Send a packet prepared in a TxBuffer. The transport takes ownership of the buffer and may
+    // add headers and trailers to it in place. The default implementation copies the packet.
+    virtual uint32_t send(const std::shared_ptr<TxBuffer> &buffer) noexcept;
+
+    // Add the statistics maintained by this layer, and the layers below it, to stats.
+    virtual void getStats(sd_rpc_stats_t &stats) noexcept;
+
+    // Name of the port the lowest layer communicates on, empty if it has none
+    virtual std::string portName() const;
+
+    // Messages less severe than severity are not logged. The filter is passed on to the layers
+    // below, which check it with ::isLogged before building a message.
+    virtual void setLogSeverityFilter(const sd_rpc_log_severity_t severity) noexcept;
+    bool isLogged(const sd_rpc_log_severity_t severity) const noexcept;
+
+    // Number of the adapter the spans recorded by this layer are tagged with, see SpanTracer. Set
+    // before the transport is opened and passed on to the layers below.
+    virtual void setTraceAdapter(const uint32_t adapter) noexcept;
+
+    // Channel of LogRing::global the records logged with ::logRecord are passed to, zero to
+    // format them on the logging thread and pass them to the log callback. Passed on to the
+    // layers below.
+    virtual void setLogChannel(const uint32_t channel) noexcept;
+
     void log(const sd_rpc_log_severity_t severity, const std::string &message) const noexcept;
     void log(const sd_rpc_log_severity_t severity, const std::string &message,
              const std::exception &ex) const noexcept;
 
+    // Log a binary record of LogRing, the message is formatted by the drain thread of the ring
+    template <typename... Args>
+    void logRecord(const sd_rpc_log_severity_t severity, const uint16_t formatId,
+                   const Args &... args) const noexcept;
+
     void status(const sd_rpc_app_status_t code, const std::string &message) const noexcept;
     void status(const sd_rpc_app_status_t code, const std::string &message,
                 const std::exception &ex) const noexcept;
@@ -75,6 +108,35 @@ class Transport
     status_cb_t upperStatusCallback;
     data_cb_t upperDataCallback;
     log_cb_t upperLogCallback;
+
+    std::atomic<sd_rpc_log_severity_t> logSeverityFilter;
+    uint32_t traceAdapter;
+    std::atomic<uint32_t> logChannel;
 };
 
+template <typename... Args>
+void Transport::logRecord(const sd_rpc_log_severity_t severity, const uint16_t formatId,
+                          const Args &... args) const noexcept
+{
+    if (!isLogged(severity))
+    {
+        return;
+    }
+
+    const auto channel = logChannel.load(std::memory_order_relaxed);
+
+    if (channel != 0)
+    {
+        LogRing::global().push(channel, severity, formatId, args...);
+        return;
+    }
+
+    try
+    {
+        log(severity, LogRing::format(formatId, args...));
+    }
+    catch (const std::exception &)
+    {}
+}
+
 #endif // TRANSPORT_H
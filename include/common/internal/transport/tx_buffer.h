@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TX_BUFFER_H
+#define TX_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Room reserved in front of the payload for the serialization packet type, the H5 header
+ * and the SLIP start delimiter.
+ */
+constexpr size_t TxBufferHeadroom = 8;
+
+/**
+ * @brief Buffer for an outgoing packet with room for headers and trailers added by the transport
+ * layers.
+ *
+ * The payload is written by the encoder at an offset into the buffer. Each transport layer
+ * prepends its header into the headroom and appends its trailer into the tailroom, the packet is
+ * therefore not copied when passed down the layers. The tailroom is large enough for the H5 CRC
+ * and for SLIP escaping of every byte in the packet.
+ *
+ * A layer may modify the buffer until it is passed to the next layer, after that the buffer is
+ * read only.
+ */
+class TxBuffer
+{
+  public:
+    explicit TxBuffer(const size_t payloadCapacity);
+
+    /**@brief Start of the payload area and the number of bytes that fits in it. */
+    uint8_t *payload() noexcept;
+    size_t payloadCapacity() const noexcept;
+
+    /**@brief Set the length of the payload written to ::payload, discarding headers and trailers. */
+    void setPayloadLength(const size_t length);
+
+    /**@brief Extend the packet into the headroom, returns pointer to the new start of the packet. */
+    uint8_t *prepend(const size_t length);
+
+    /**@brief Extend the packet into the tailroom, returns pointer to the appended bytes. */
+    uint8_t *append(const size_t length);
+
+    uint8_t *data() noexcept;
+    const uint8_t *data() const noexcept;
+    size_t size() const noexcept;
+
+    size_t headroom() const noexcept;
+    size_t tailroom() const noexcept;
+
+  private:
+    std::vector<uint8_t> storage;
+    size_t capacity;
+    size_t begin;
+    size_t end;
+};
+
+#endif // TX_BUFFER_H
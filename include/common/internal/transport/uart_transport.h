@@ -71,7 +71,8 @@ class UartTransport : public Transport
                   const log_cb_t &log_callback) noexcept override;
 
     /**
-     *@brief Closes the serial port service.
+     *@brief Closes the serial port service. On the shared I/O threads it may be called from a
+     * callback of this transport, the serial port is then released after the callback returns.
      */
     uint32_t close() noexcept override;
 
@@ -80,6 +81,39 @@ class UartTransport : public Transport
      */
     uint32_t send(const std::vector<uint8_t> &data) noexcept override;
 
+    /**
+     *@brief sends a packet to serial port to write without copying it.
+     */
+    uint32_t send(const std::shared_ptr<TxBuffer> &buffer) noexcept override;
+
+    /**
+     *@brief Adds the number of bytes written to and read from the serial port to stats.
+     */
+    void getStats(sd_rpc_stats_t &stats) noexcept override;
+
+    /**
+     *@brief Returns the name of the serial port.
+     */
+    std::string portName() const override;
+
+    /**
+     *@brief Sets the log severity filter of the serial port I/O.
+     */
+    void setLogSeverityFilter(const sd_rpc_log_severity_t severity) noexcept override;
+
+    /**
+     *@brief Sets the adapter number the spans of serial port writes are tagged with.
+     */
+    void setTraceAdapter(const uint32_t adapter) noexcept override;
+
+    /**
+     *@brief Runs the serial port I/O of transports opened after this call on one io_context
+     * shared by all of them and served by threadCount threads, see SharedIoContext. The H5
+     * transports on top run their state machines on the same context. Zero returns to one I/O
+     * thread per transport, which is the default.
+     */
+    static uint32_t setSharedIoThreadCount(uint32_t threadCount) noexcept;
+
   private:
     struct impl;
     std::unique_ptr<impl> pimpl;
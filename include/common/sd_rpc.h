@@ -86,6 +86,19 @@ SD_RPC_API physical_layer_t *sd_rpc_physical_layer_create_uart(const char * port
  */
 SD_RPC_API data_link_layer_t *sd_rpc_data_link_layer_create_bt_three_wire(physical_layer_t *physical_layer, uint32_t retransmission_interval);
 
+/**@brief Create a new data link layer with a sliding window of unacknowledged reliable packets.
+ *
+ * The window size is negotiated with the connectivity device during link establishment. Devices
+ * that do not support a sliding window fall back to a window size of 1 (stop-and-wait).
+ *
+ * @param[in]  physical_layer  The physical layer to use with this data link layer.
+ * @param[in]  retransmission_interval  Initial retransmission interval of the data link layer.
+ * @param[in]  window_size  Maximum number of unacknowledged reliable packets, 1 to 7.
+ *
+ * @retval The data link layer or NULL.
+ */
+SD_RPC_API data_link_layer_t *sd_rpc_data_link_layer_create_bt_three_wire_window(physical_layer_t *physical_layer, uint32_t retransmission_interval, uint8_t window_size);
+
 /**@brief Create a new transport layer.
  *
  * @param[in]  data_link_layer  The data linkk layer to use with this transport.
@@ -115,6 +128,9 @@ SD_RPC_API void sd_rpc_adapter_delete(adapter_t *adapter);
  * @note This function must be called prior to the sd_ble_* API commands.
  *       The serial port will be attempted opened with the configured serial port settings.
  *
+ * @note log_handler is called on the thread logging the message, unless set otherwise with
+ *       @ref sd_rpc_log_handler_dispatch_set.
+ *
  * @param[in]  adapter  The transport adapter.
  * @param[in]  status_handler  The status handler callback.
  * @param[in]  evt_handler  The event handler callback.
@@ -148,6 +164,29 @@ SD_RPC_API uint32_t sd_rpc_close(adapter_t *adapter);
  */
 SD_RPC_API uint32_t sd_rpc_log_handler_severity_filter_set(adapter_t *adapter, sd_rpc_log_severity_t severity_filter);
 
+/**@brief Set the thread log messages are passed to the log handler on.
+ *
+ * By default log_handler of @ref sd_rpc_open is called on the thread logging the message, which
+ * may be a thread of the driver reading from or writing to the connectivity device. With
+ * SD_RPC_LOG_DISPATCH_ASYNC the driver threads only copy a binary record of each message, a
+ * logging thread shared by all adapters formats the messages of an adapter and passes them in
+ * order. Messages logged before @ref sd_rpc_close returns are passed before it returns. The log
+ * handler must then not open or close adapters. Messages are dropped while the records of all
+ * adapters fill the log ring.
+ *
+ * @note Must be called before @ref sd_rpc_open.
+ *
+ * @param[in]  adapter   The transport adapter.
+ * @param[in]  dispatch  The thread to pass log messages on.
+ *
+ * @retval NRF_SUCCESS              The dispatch mode is set.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter is not valid or dispatch is not one of the values in
+ *                                  sd_rpc_log_dispatch_t.
+ * @retval NRF_ERROR_INVALID_STATE  The adapter is open.
+ */
+SD_RPC_API uint32_t sd_rpc_log_handler_dispatch_set(adapter_t *adapter,
+                                                    sd_rpc_log_dispatch_t dispatch);
+
 /**@brief Reset the connectivity chip.
  *
  * @param[in]  adapter  The transport adapter.
@@ -158,6 +197,434 @@ SD_RPC_API uint32_t sd_rpc_log_handler_severity_filter_set(adapter_t *adapter, s
  */
 SD_RPC_API uint32_t sd_rpc_conn_reset(adapter_t *adapter, sd_rpc_reset_t reset_mode);
 
+/**@brief Get statistics of the link to the connectivity device.
+ *
+ * The statistics are always collected, they are counted with relaxed atomic operations. Values
+ * taken while commands and events are passed may be a few samples apart from each other.
+ *
+ * @param[in]  adapter  The transport adapter.
+ * @param[out] p_stats  Pointer to the statistics to fill in.
+ *
+ * @retval NRF_SUCCESS              p_stats is filled in.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter or p_stats is not valid.
+ */
+SD_RPC_API uint32_t sd_rpc_stats_get(adapter_t *adapter, sd_rpc_stats_t *p_stats);
+
+/**@brief Get how long a phase of the commands with a serialization opcode takes.
+ *
+ * The duration of each phase of every command sent by the sd_ble_* functions is counted in a
+ * histogram of the opcode of the command, e.g. SD_BLE_GATTS_SERVICE_ADD. The histograms are
+ * always collected, like the statistics of @ref sd_rpc_stats_get.
+ *
+ * @param[in]  adapter    The transport adapter.
+ * @param[in]  opcode     The serialization opcode of the commands.
+ * @param[in]  phase      The phase of the commands.
+ * @param[out] p_latency  Pointer to the summary to fill in.
+ *
+ * @retval NRF_SUCCESS              p_latency is filled in.
+ * @retval NRF_ERROR_NOT_FOUND      No command with opcode has been sent.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter or p_latency is not valid or phase is not one of the
+ *                                  values in sd_rpc_cmd_phase_t.
+ */
+SD_RPC_API uint32_t sd_rpc_cmd_latency_get(adapter_t *adapter, uint8_t opcode,
+                                           sd_rpc_cmd_phase_t phase, sd_rpc_latency_t *p_latency);
+
+/**@brief Get the histogram of a phase of the commands with a serialization opcode.
+ *
+ * Only buckets that have counted a duration are returned, in order of their bounds. The buckets
+ * are log-linear, the upper bound of a bucket is at most 12.5% above its lower bound.
+ *
+ * @param[in]     adapter         The transport adapter.
+ * @param[in]     opcode          The serialization opcode of the commands.
+ * @param[in]     phase           The phase of the commands.
+ * @param[out]    p_buckets       Array of buckets to fill in.
+ * @param[in,out] p_bucket_count  Length of p_buckets on input, number of buckets returned on
+ *                                output.
+ *
+ * @retval NRF_SUCCESS              p_buckets is filled in.
+ * @retval NRF_ERROR_NOT_FOUND      No command with opcode has been sent.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter, p_buckets or p_bucket_count is not valid or phase is
+ *                                  not one of the values in sd_rpc_cmd_phase_t.
+ * @retval NRF_ERROR_DATA_SIZE      p_buckets is too short, p_bucket_count is set to the number of
+ *                                  buckets to return.
+ */
+SD_RPC_API uint32_t sd_rpc_cmd_latency_buckets_get(adapter_t *adapter, uint8_t opcode,
+                                                   sd_rpc_cmd_phase_t phase,
+                                                   sd_rpc_latency_bucket_t *p_buckets,
+                                                   uint32_t *p_bucket_count);
+
+/**@brief Forget the durations counted for all opcodes and phases.
+ *
+ * May be called while commands are sent, durations of commands sent at the same time may still
+ * be counted partly.
+ *
+ * @param[in]  adapter  The transport adapter.
+ *
+ * @retval NRF_SUCCESS              The histograms are reset.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter is not valid.
+ */
+SD_RPC_API uint32_t sd_rpc_cmd_latency_reset(adapter_t *adapter);
+
+/**@brief Write the statistics and command latencies of adapters in the OpenMetrics text format.
+ *
+ * Counters of @ref sd_rpc_stats_t, command latency summaries and a summary for each phase of
+ * the opcodes that have been sent are written, with metric names prefixed by pc_ble_driver_ and
+ * samples labelled with the adapter number and serial port, e.g.
+ * pc_ble_driver_h5_retransmissions_total{adapter="0",port="COM3"} 2. The text can be served
+ * to Prometheus as is. Writing does not take locks used when commands are sent or events are
+ * received.
+ *
+ * @param[in]     adapters       Array of the transport adapters to write the metrics of.
+ * @param[in]     adapter_count  Length of adapters.
+ * @param[out]    p_buffer       Buffer to write the NUL terminated text to.
+ * @param[in,out] p_length       Length of p_buffer on input, length of the text including the
+ *                               terminating NUL on output.
+ *
+ * @retval NRF_SUCCESS              The text is written to p_buffer.
+ * @retval NRF_ERROR_INVALID_PARAM  adapters, an adapter, p_buffer or p_length is not valid.
+ * @retval NRF_ERROR_DATA_SIZE      p_buffer is too short, p_length is set to the length needed.
+ * @retval NRF_ERROR_NO_MEM         Not enough memory to render the text.
+ */
+SD_RPC_API uint32_t sd_rpc_metrics_write(adapter_t *const *adapters, uint32_t adapter_count,
+                                         char *p_buffer, uint32_t *p_length);
+
+/**@brief Write the metrics of adapters to a file now and then periodically.
+ *
+ * The text of @ref sd_rpc_metrics_write is written to a temporary file next to path that then
+ * replaces path, e.g. for the textfile collector of the Prometheus node exporter. Only one file
+ * is written at a time.
+ *
+ * @note The adapters must not be deleted before @ref sd_rpc_metrics_file_stop is called.
+ *
+ * @param[in]  adapters       Array of the transport adapters to write the metrics of.
+ * @param[in]  adapter_count  Length of adapters.
+ * @param[in]  path           Path of the file to write.
+ * @param[in]  interval_ms    Milliseconds between writes, intervals below 100 are raised to 100.
+ *
+ * @retval NRF_SUCCESS              The file is written and is written again every interval.
+ * @retval NRF_ERROR_INVALID_PARAM  adapters, an adapter or path is not valid or path can not be
+ *                                  written.
+ * @retval NRF_ERROR_INVALID_STATE  A file is already written.
+ * @retval NRF_ERROR_NO_MEM         Not enough memory to start writing.
+ */
+SD_RPC_API uint32_t sd_rpc_metrics_file_start(adapter_t *const *adapters, uint32_t adapter_count,
+                                              const char *path, uint32_t interval_ms);
+
+/**@brief Stop writing the metrics file started by @ref sd_rpc_metrics_file_start.
+ *
+ * @retval NRF_SUCCESS              The file is no longer written.
+ * @retval NRF_ERROR_INVALID_STATE  No file is written.
+ */
+SD_RPC_API uint32_t sd_rpc_metrics_file_stop(void);
+
+/**@brief Start writing a timeline of the work done by all adapters to a trace file.
+ *
+ * The file is in the Chrome trace JSON format, it can be opened in chrome://tracing or the
+ * Perfetto UI. Each command and event is traced as spans on the threads doing the work: encode,
+ * h5_send, uart_write, h5_ack, response_wait and decode for commands, event_enqueue,
+ * event_decode and event_callback for events. Spans are tagged with the adapter number and, when
+ * known, the serialization opcode, the event ID and the H5 sequence and acknowledgement numbers.
+ *
+ * Spans are buffered per thread and written to the file periodically by a background thread.
+ * Spans recorded while the buffer of a thread is full are dropped, the number dropped is written
+ * at the end of the file. When not tracing, the cost of a span is one atomic load.
+ *
+ * @param[in]  path  Path of the file to write.
+ *
+ * @retval NRF_SUCCESS              Spans are written to the file.
+ * @retval NRF_ERROR_INVALID_PARAM  path is not valid or can not be written.
+ * @retval NRF_ERROR_INVALID_STATE  A trace is already written.
+ * @retval NRF_ERROR_NO_MEM         Not enough memory to start tracing.
+ */
+SD_RPC_API uint32_t sd_rpc_trace_start(const char *path);
+
+/**@brief Write the buffered spans and complete the trace file of @ref sd_rpc_trace_start.
+ *
+ * @retval NRF_SUCCESS              The trace file is complete.
+ * @retval NRF_ERROR_INVALID_STATE  No trace is written.
+ */
+SD_RPC_API uint32_t sd_rpc_trace_stop(void);
+
+/**@brief Configure the queue of events received and not yet passed to the event handler.
+ *
+ * By default up to 1024 events are queued. When the queue is full the oldest queued advertising
+ * report is dropped, other events are kept in a reserve of up to 256 more events of each
+ * priority. Only while the reserve is full as well does reading from the connectivity device
+ * pause until the event handler makes room. A flood of advertising reports while the event
+ * handler is slow therefore does not hold up connection related events or the responses to
+ * commands, and no other events are ever dropped. The memory used by the queue is bounded by all
+ * policies. Overflows are counted in @ref sd_rpc_stats_t and reported
+ * to the status handler with EVENT_QUEUE_OVERFLOW, at most once per second.
+ *
+ * @note Must be called before @ref sd_rpc_open.
+ *
+ * @param[in]  adapter          The transport adapter.
+ * @param[in]  capacity         Maximum number of queued events of each priority, see
+ *                              @ref sd_rpc_evt_priority_set.
+ * @param[in]  overflow_policy  What to do with a received event when the queue is full.
+ *
+ * @retval NRF_SUCCESS              The configuration is applied.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter is not valid, capacity is 0 or overflow_policy is not
+ *                                  one of the values in sd_rpc_evt_queue_overflow_t.
+ * @retval NRF_ERROR_INVALID_STATE  The adapter is open, or overflow_policy is
+ *                                  SD_RPC_EVT_QUEUE_OVERFLOW_BLOCK and events are pulled.
+ */
+SD_RPC_API uint32_t sd_rpc_evt_queue_config_set(adapter_t *adapter, uint32_t capacity,
+                                                sd_rpc_evt_queue_overflow_t overflow_policy);
+
+/**@brief Pass received events to the application in batches.
+ *
+ * Instead of calling the event handler given to @ref sd_rpc_open once per event, the adapter
+ * calls batch_handler with the events that are received and not yet handled, in the order they
+ * are received. A batch holds up to max_count events. Decoding more events for a batch stops when
+ * time_budget_us has passed since the first event of the batch was taken, the adapter does not
+ * wait for more events to fill a batch.
+ *
+ * The events are valid until batch_handler returns, unless retained with
+ * @ref sd_rpc_evt_retain.
+ *
+ * @note Must be called before @ref sd_rpc_open, while no events are retained.
+ *
+ * @param[in]  adapter         The transport adapter.
+ * @param[in]  batch_handler   The batch handler, NULL passes events to the event handler again.
+ * @param[in]  max_count       Maximum number of events in a batch, 1 to 256.
+ * @param[in]  time_budget_us  Maximum time in microseconds spent decoding the events of a batch.
+ *
+ * @retval NRF_SUCCESS              The batch handler is set.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter is not valid or max_count is out of range.
+ * @retval NRF_ERROR_INVALID_STATE  The adapter is open or events are retained.
+ * @retval NRF_ERROR_NO_MEM         Not enough memory for the events of a batch.
+ */
+SD_RPC_API uint32_t sd_rpc_evt_batch_handler_set(adapter_t *adapter,
+                                                 sd_rpc_evt_batch_handler_t batch_handler,
+                                                 uint32_t max_count, uint32_t time_budget_us);
+
+/**@brief Set the priority of received events with an event ID.
+ *
+ * Received events wait in the event queue until the event handler has handled the events before
+ * them. Events of high priority are passed to the event handler before queued events of normal
+ * priority, so that connection and security procedures are not delayed by advertising reports
+ * during scanning. Events of the same connection are always passed in the order received.
+ *
+ * By default connection, disconnection, connection parameter and security related GAP events,
+ * GATTS authorization, system attribute and MTU exchange requests, and user memory requests
+ * have high priority, all other events normal priority. High and normal priority events are
+ * queued separately, each up to the capacity set with @ref sd_rpc_evt_queue_config_set.
+ *
+ * @note Must be called before @ref sd_rpc_open.
+ *
+ * @param[in]  adapter   The transport adapter.
+ * @param[in]  evt_id    The event ID, e.g. BLE_GAP_EVT_ADV_REPORT.
+ * @param[in]  priority  The priority of the events.
+ *
+ * @retval NRF_SUCCESS              The priority is set.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter is not valid, evt_id is not a BLE event ID or priority
+ *                                  is not one of the values in sd_rpc_evt_priority_t.
+ * @retval NRF_ERROR_INVALID_STATE  The adapter is open.
+ */
+SD_RPC_API uint32_t sd_rpc_evt_priority_set(adapter_t *adapter, uint16_t evt_id,
+                                            sd_rpc_evt_priority_t priority);
+
+/**@brief Set the thread received events are passed to the event handler on.
+ *
+ * By default received events are queued and passed to the event handler on the event thread of
+ * the adapter. Passing events on the thread reading from the connectivity device instead saves
+ * the queueing and a thread wakeup per event, which lowers the latency of each event.
+ *
+ * While an event handler runs on the reading thread no more data is read from the connectivity
+ * device, so neither responses nor acknowledgements of commands are received. The event handler
+ * must therefore not call functions that send to the connectivity device, such as the sd_ble_*
+ * functions, @ref sd_rpc_conn_reset or @ref sd_rpc_close. Such calls return an error instead of
+ * waiting, commands have to be sent from another thread of the application. Events are not
+ * queued, so the event queue configuration and priorities do not apply, and the event handler
+ * must return quickly to not hold up the link to the connectivity device. A batch handler set
+ * with @ref sd_rpc_evt_batch_handler_set is passed one event at a time. No locks of the link are
+ * held while the event handler runs, so the link keeps retransmitting unacknowledged packets.
+ * With @ref sd_rpc_shared_io_thread_count_set the reading thread is one of the shared threads.
+ *
+ * Pulling events lets an application take events with @ref sd_rpc_evt_get on a thread of its own,
+ * for example from an event loop polling the descriptor from @ref sd_rpc_evt_fd_get. The thread
+ * pulling events usually sends the commands as well, so reading never waits for room in the event
+ * queue while events are pulled, SD_RPC_EVT_QUEUE_OVERFLOW_BLOCK is not supported. Advertising
+ * reports are dropped as by the overflow policy. Other events received while the queue and its
+ * reserve are full are lost, they are counted in event_queue_lost of @ref sd_rpc_stats_t and each
+ * is reported to the status handler with EVENT_QUEUE_OVERFLOW.
+ *
+ * @note Must be called before @ref sd_rpc_open.
+ *
+ * @param[in]  adapter   The transport adapter.
+ * @param[in]  dispatch  The thread to pass events on.
+ *
+ * @retval NRF_SUCCESS              The dispatch mode is set.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter is not valid or dispatch is not one of the values in
+ *                                  sd_rpc_evt_dispatch_t.
+ * @retval NRF_ERROR_INVALID_STATE  The adapter is open, or dispatch is SD_RPC_EVT_DISPATCH_PULL
+ *                                  and the overflow policy of the event queue is
+ *                                  SD_RPC_EVT_QUEUE_OVERFLOW_BLOCK.
+ */
+SD_RPC_API uint32_t sd_rpc_evt_dispatch_set(adapter_t *adapter, sd_rpc_evt_dispatch_t dispatch);
+
+/**@brief Take the oldest received event when events are pulled.
+ *
+ * Decodes the event directly into the memory of the caller, waiting up to timeout_ms for an event
+ * if none is queued. Only one thread at a time takes events, other callers wait. Events of high
+ * priority are taken first as described for @ref sd_rpc_evt_priority_set.
+ *
+ * @note Only available after @ref sd_rpc_evt_dispatch_set with SD_RPC_EVT_DISPATCH_PULL.
+ *
+ * @param[in]     adapter     The transport adapter.
+ * @param[out]    p_dest      Buffer for the event, aligned as a ble_evt_t.
+ * @param[in,out] p_len       Size of p_dest on input, length of the event on output. The buffer
+ *                            must hold the longest event the adapter decodes, otherwise p_len is
+ *                            set to the size needed.
+ * @param[in]     timeout_ms  Time to wait for an event, 0 returns at once.
+ *
+ * @retval NRF_SUCCESS              An event is written to p_dest.
+ * @retval NRF_ERROR_NOT_FOUND      No event was received within timeout_ms.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter, p_dest or p_len is not valid.
+ * @retval NRF_ERROR_DATA_SIZE      p_dest is too small, p_len is set to the size needed.
+ * @retval NRF_ERROR_INVALID_STATE  The adapter is not open or events are not pulled.
+ */
+SD_RPC_API uint32_t sd_rpc_evt_get(adapter_t *adapter, uint8_t *p_dest, uint16_t *p_len,
+                                   uint32_t timeout_ms);
+
+/**@brief Get a file descriptor that is readable while events wait to be taken.
+ *
+ * The descriptor becomes readable when an event is queued. It is made not readable by
+ * @ref sd_rpc_evt_get when no more events are queued, call @ref sd_rpc_evt_get until it returns
+ * NRF_ERROR_NOT_FOUND each time the descriptor is readable. The descriptor is an eventfd on Linux
+ * and the read end of a pipe on macOS. It is owned by the adapter and stays valid until the
+ * adapter is deleted, the application must not read from or close it.
+ *
+ * @note Only available after @ref sd_rpc_evt_dispatch_set with SD_RPC_EVT_DISPATCH_PULL.
+ *
+ * @param[in]  adapter  The transport adapter.
+ * @param[out] p_fd     The file descriptor.
+ *
+ * @retval NRF_SUCCESS              p_fd is set.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter or p_fd is not valid.
+ * @retval NRF_ERROR_INVALID_STATE  Events are not pulled.
+ * @retval NRF_ERROR_NOT_SUPPORTED  There are no file descriptors for events on this platform.
+ */
+SD_RPC_API uint32_t sd_rpc_evt_fd_get(adapter_t *adapter, int *p_fd);
+
+/**@brief Discard received events with an event ID before they are decoded.
+ *
+ * Discarded events are not queued, decoded or passed to the event handler. The event filter may
+ * be changed while the adapter is open, it applies to events received after the call. Events
+ * discarded by the filter are counted in @ref sd_rpc_stats_t.
+ *
+ * @note Events that update state kept by the driver, like @ref BLE_GAP_EVT_AUTH_STATUS, are
+ *       still decoded when discarded but not passed to the event handler. With SoftDevice API
+ *       version 6 this includes advertising reports: the SoftDevice pauses scanning after each
+ *       complete report until the scan buffer is handed back, so the driver queues and decodes
+ *       every discarded report and calls @ref sd_ble_gap_scan_start for it from the event
+ *       thread. Filtering advertising reports then saves the application callback but still
+ *       costs one command round trip to the connectivity device per report, the same as an
+ *       application resuming scanning itself. These reports are counted separately in
+ *       @ref sd_rpc_stats_t.event_filtered_adv_reports.
+ *
+ * @param[in]  adapter  The transport adapter.
+ * @param[in]  evt_id   The event ID, e.g. BLE_GAP_EVT_RSSI_CHANGED.
+ * @param[in]  discard  Non-zero to discard the events, zero to pass them again.
+ *
+ * @retval NRF_SUCCESS              The filter is updated.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter is not valid or evt_id is not a BLE event ID.
+ */
+SD_RPC_API uint32_t sd_rpc_evt_filter_id_set(adapter_t *adapter, uint16_t evt_id,
+                                             uint8_t discard);
+
+/**@brief Discard received events of a connection before they are decoded.
+ *
+ * See @ref sd_rpc_evt_filter_id_set.
+ *
+ * @param[in]  adapter      The transport adapter.
+ * @param[in]  conn_handle  The connection handle.
+ * @param[in]  discard      Non-zero to discard the events, zero to pass them again.
+ *
+ * @retval NRF_SUCCESS              The filter is updated.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter is not valid or conn_handle is larger than 255.
+ */
+SD_RPC_API uint32_t sd_rpc_evt_filter_conn_handle_set(adapter_t *adapter, uint16_t conn_handle,
+                                                      uint8_t discard);
+
+/**@brief Discard received advertising reports before they are decoded.
+ *
+ * filter is called with the peer address and RSSI of each received advertising report, reports
+ * for which it returns zero are discarded. See @ref sd_rpc_evt_filter_id_set.
+ *
+ * @note filter is called from the thread reading from the connectivity device. It must return
+ *       quickly and must not call functions of this API.
+ *
+ * @note With SoftDevice API version 6 discarded reports are still decoded and scanning is
+ *       resumed for each of them, see @ref sd_rpc_evt_filter_id_set.
+ *
+ * @param[in]  adapter    The transport adapter.
+ * @param[in]  filter     The filter, NULL passes all advertising reports.
+ * @param[in]  p_context  Passed to filter.
+ *
+ * @retval NRF_SUCCESS              The filter is set. A previous filter is no longer called.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter is not valid.
+ */
+SD_RPC_API uint32_t sd_rpc_evt_filter_adv_report_set(adapter_t *adapter,
+                                                     sd_rpc_adv_report_filter_t filter,
+                                                     void *p_context);
+
+/**@brief Keep an event after the event handler returns.
+ *
+ * Events passed to the event handler are decoded into buffers owned by the adapter and reused
+ * when the handler returns. Calling this function from the event handler with the event it was
+ * called with keeps the event valid until it is released with @ref sd_rpc_evt_release, without
+ * copying it. Up to 15 events can be retained at the same time.
+ *
+ * @note Retained events must be released before the adapter is deleted.
+ *
+ * @param[in]  adapter    The transport adapter.
+ * @param[in]  p_ble_evt  The event passed to the event handler.
+ *
+ * @retval NRF_SUCCESS              The event is retained.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter is not valid or p_ble_evt is not an event of this
+ *                                  adapter.
+ * @retval NRF_ERROR_INVALID_STATE  p_ble_evt is not the event being handled or already retained.
+ * @retval NRF_ERROR_NO_MEM         Too many events are retained.
+ */
+SD_RPC_API uint32_t sd_rpc_evt_retain(adapter_t *adapter, const ble_evt_t *p_ble_evt);
+
+/**@brief Release an event retained with @ref sd_rpc_evt_retain.
+ *
+ * May be called from any thread. The event must not be accessed after it is released.
+ *
+ * @param[in]  adapter    The transport adapter.
+ * @param[in]  p_ble_evt  The retained event.
+ *
+ * @retval NRF_SUCCESS              The event is released.
+ * @retval NRF_ERROR_INVALID_PARAM  adapter is not valid or p_ble_evt is not an event of this
+ *                                  adapter.
+ * @retval NRF_ERROR_INVALID_STATE  p_ble_evt is not retained.
+ */
+SD_RPC_API uint32_t sd_rpc_evt_release(adapter_t *adapter, const ble_evt_t *p_ble_evt);
+
+/**@brief Share serial port I/O and link layer threads between adapters.
+ *
+ * By default every adapter runs the I/O of its serial port and the state machine of its H5 link,
+ * which also retransmits unacknowledged packets, on a thread each. When thread_count is not zero,
+ * adapters opened after this call run both on one shared pool of thread_count threads instead.
+ * Setting thread_count to zero restores the threads per adapter for adapters opened later.
+ * Adapters already open are not affected. Events are dispatched on a thread per adapter in
+ * either case, unless passed on the reading thread with @ref sd_rpc_evt_dispatch_set.
+ *
+ * @note The serial port handlers of an adapter never run concurrently, nor do the state machine
+ *       steps of an adapter, but handlers of different adapters may. Status callbacks of the link
+ *       run on the shared threads. Do not block in callbacks for long, it delays other adapters
+ *       served by the same thread.
+ *
+ * @param[in]  thread_count  Number of threads in the shared pool, 0 to disable sharing.
+ *
+ * @retval NRF_SUCCESS  The setting is applied to adapters opened from now on.
+ * @retval NRF_ERROR_SD_RPC_SERIAL_PORT_INTERNAL_ERROR  The thread pool could not be started.
+ */
+SD_RPC_API uint32_t sd_rpc_shared_io_thread_count_set(uint32_t thread_count);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
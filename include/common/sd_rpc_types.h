@@ -71,7 +71,8 @@ typedef enum {
     PKT_SEND_ERROR,
     IO_RESOURCES_UNAVAILABLE,
     RESET_PERFORMED,
-    CONNECTION_ACTIVE
+    CONNECTION_ACTIVE,
+    EVENT_QUEUE_OVERFLOW
 } sd_rpc_app_status_t;
 
 /**@brief Levels of severity that a log message can be associated with. */
@@ -96,6 +97,171 @@ typedef enum {
     SOFT_RESET, /** Reset transport and SoftDevice related states only. */
 } sd_rpc_reset_t;
 
+/**@brief What to do with a received event when the event queue is full, see
+ * @ref sd_rpc_evt_queue_config_set. */
+typedef enum {
+    /** Stop reading from the connectivity device until there is room, no events are lost.
+     * Responses are not read either: a command called from the event handler while the queue is
+     * full fails when its response times out. Only safe if the event handler calls no commands,
+     * not supported when events are pulled. */
+    SD_RPC_EVT_QUEUE_OVERFLOW_BLOCK,
+    /** Drop the oldest queued advertising report, or the received report if none is queued.
+     * Other events are never dropped, they are kept as with SD_RPC_EVT_QUEUE_OVERFLOW_SPILL. See
+     * SD_RPC_EVT_QUEUE_OVERFLOW_COALESCE_ADV_REPORT for SoftDevice API version 6. The default. */
+    SD_RPC_EVT_QUEUE_OVERFLOW_DROP_OLDEST_ADV_REPORT,
+    /** Replace a queued advertising report of the same type from the same peer with the new
+     * report, otherwise drop the oldest queued advertising report. Other events are never
+     * dropped, they are kept as with SD_RPC_EVT_QUEUE_OVERFLOW_SPILL.
+     *
+     * With SoftDevice API version 6 dropped and replaced reports are still decoded and scanning
+     * is resumed for them as for reports discarded by the event filter, they are not passed to
+     * the event handler. They keep their place in the queue until then, so reading from the
+     * connectivity device may pause as with SD_RPC_EVT_QUEUE_OVERFLOW_SPILL. */
+    SD_RPC_EVT_QUEUE_OVERFLOW_COALESCE_ADV_REPORT,
+    /** Queue the event in a reserve of 256 events beyond the capacity of the queue, reading from
+     * the connectivity device continues. While the reserve is full as well reading pauses until
+     * there is room, no events are lost. A flood of advertising reports may then pause reading
+     * and hold up the responses to commands called from the event handler. Reading does not
+     * pause when events are pulled, see @ref sd_rpc_evt_dispatch_set. */
+    SD_RPC_EVT_QUEUE_OVERFLOW_SPILL
+} sd_rpc_evt_queue_overflow_t;
+
+/**@brief Priority of received events with a given event ID, see @ref sd_rpc_evt_priority_set. */
+typedef enum {
+    /** Passed to the event handler in the order received. */
+    SD_RPC_EVT_PRIORITY_NORMAL,
+    /** Passed to the event handler before queued events of normal priority, except older events
+     * of the same connection. */
+    SD_RPC_EVT_PRIORITY_HIGH
+} sd_rpc_evt_priority_t;
+
+/**@brief Thread received events are passed to the event handler on, see
+ * @ref sd_rpc_evt_dispatch_set. */
+typedef enum {
+    /** Events are queued and passed to the event handler on the event thread of the adapter. */
+    SD_RPC_EVT_DISPATCH_EVENT_THREAD,
+    /** Events are passed to the event handler on the thread reading from the connectivity device,
+     * as soon as they are received. */
+    SD_RPC_EVT_DISPATCH_INLINE,
+    /** Events are queued until the application takes them with @ref sd_rpc_evt_get, the event
+     * handler is not called. */
+    SD_RPC_EVT_DISPATCH_PULL
+} sd_rpc_evt_dispatch_t;
+
+/**@brief Thread log messages are passed to the log handler on, see
+ * @ref sd_rpc_log_handler_dispatch_set. */
+typedef enum {
+    /** Messages are passed to the log handler on the thread logging them. */
+    SD_RPC_LOG_DISPATCH_SYNC,
+    /** Messages are recorded without a lock and passed to the log handler on a logging thread
+     * shared by all adapters. */
+    SD_RPC_LOG_DISPATCH_ASYNC
+} sd_rpc_log_dispatch_t;
+
+/**@brief Statistics of the link to the connectivity device, see @ref sd_rpc_stats_get.
+ *
+ * Durations are in microseconds. Link and command counters are kept from the creation of the
+ * adapter, event queue counters from when it was last opened.
+ */
+typedef struct
+{
+    /** Smoothed round trip time of reliable H5 packets, 0 before the first acknowledgement. */
+    uint32_t h5_rtt_smoothed_us;
+    /** Round trip time variation of reliable H5 packets. */
+    uint32_t h5_rtt_variation_us;
+    /** Current retransmission timeout of reliable H5 packets. */
+    uint32_t h5_rto_us;
+    /** Number of received events waiting to be passed to the application. */
+    uint32_t event_queue_depth;
+    /** Largest number of received events that have been waiting at the same time. */
+    uint32_t event_queue_high_water;
+    /** Number of events dropped because the event queue was full. */
+    uint32_t event_queue_dropped;
+    /** Number of advertising reports merged into a queued report because the queue was full. */
+    uint32_t event_queue_coalesced;
+    /** Number of events other than advertising reports lost because the queue and its reserve
+     * were full while events are pulled, see @ref sd_rpc_evt_dispatch_set. Also counted in
+     * event_queue_dropped. */
+    uint32_t event_queue_lost;
+    /** Number of events discarded by the event filter. */
+    uint32_t event_filtered;
+    /** Number of the discarded events that were advertising reports still decoded for the driver
+     *  to resume scanning, only with SoftDevice API version 6. */
+    uint32_t event_filtered_adv_reports;
+    /** Number of bytes written to the serial port. */
+    uint64_t tx_bytes;
+    /** Number of bytes read from the serial port. */
+    uint64_t rx_bytes;
+    /** Number of H5 packets sent, including link control packets and retransmissions. */
+    uint32_t h5_tx_packets;
+    /** Number of H5 packets received, including packets with errors. */
+    uint32_t h5_rx_packets;
+    /** Number of reliable H5 packets sent again since they were not acknowledged in time. */
+    uint32_t h5_retransmissions;
+    /** Number of received packets with invalid SLIP encoding. */
+    uint32_t h5_slip_errors;
+    /** Number of received packets with an invalid H5 header or header checksum. */
+    uint32_t h5_header_errors;
+    /** Number of received packets with an invalid CRC. */
+    uint32_t h5_crc_errors;
+    /** Number of times the link was synchronized again after the peer was reset or lost track
+     * of the sequence numbers. */
+    uint32_t h5_resyncs;
+    /** Shortest, average and longest time from sending a reliable H5 packet until it is
+     * acknowledged. Only packets acknowledged without retransmission are measured. */
+    uint32_t h5_ack_rtt_min_us;
+    uint32_t h5_ack_rtt_avg_us;
+    uint32_t h5_ack_rtt_max_us;
+    /** Number of commands that have received a response. */
+    uint32_t command_count;
+    /** Time from sending a command until its response is received. Percentiles have a
+     * resolution of 12.5%. */
+    uint32_t command_latency_p50_us;
+    uint32_t command_latency_p90_us;
+    uint32_t command_latency_p99_us;
+    uint32_t command_latency_max_us;
+} sd_rpc_stats_t;
+
+/**@brief Phases of a command sent by an sd_ble_* function, see @ref sd_rpc_cmd_latency_get. */
+typedef enum {
+    /** Encoding the arguments of the function into a command. */
+    SD_RPC_CMD_PHASE_ENCODE,
+    /** Sending the command until the connectivity device acknowledges it, including waiting for
+     * room in the H5 sliding window and retransmissions. */
+    SD_RPC_CMD_PHASE_WIRE,
+    /** Waiting for the response after the command is acknowledged. */
+    SD_RPC_CMD_PHASE_RESPONSE,
+    /** Decoding the response into the arguments of the function. */
+    SD_RPC_CMD_PHASE_DECODE,
+    SD_RPC_CMD_PHASE_COUNT
+} sd_rpc_cmd_phase_t;
+
+/**@brief Summary of the durations of a command phase, see @ref sd_rpc_cmd_latency_get.
+ *
+ * Durations are in nanoseconds. Percentiles have a resolution of 12.5%.
+ */
+typedef struct
+{
+    uint64_t count;
+    uint64_t min_ns;
+    uint64_t mean_ns;
+    uint64_t max_ns;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+} sd_rpc_latency_t;
+
+/**@brief Bucket of a latency histogram, see @ref sd_rpc_cmd_latency_buckets_get. */
+typedef struct
+{
+    /** Smallest and largest duration counted in the bucket, in nanoseconds. */
+    uint64_t lower_bound_ns;
+    uint64_t upper_bound_ns;
+    /** Number of durations counted in the bucket. */
+    uint64_t count;
+} sd_rpc_latency_bucket_t;
+
 /**@bref Error codes for SD_RPC related errors */
 #define NRF_ERROR_SD_RPC_BASE_NUM (NRF_ERROR_BASE_NUM + 0x8000)
 
@@ -134,9 +300,17 @@ typedef enum {
 typedef void (*sd_rpc_status_handler_t)(adapter_t *adapter, sd_rpc_app_status_t code,
                                         const char *message);
 typedef void (*sd_rpc_evt_handler_t)(adapter_t *adapter, ble_evt_t *p_ble_evt);
+typedef void (*sd_rpc_evt_batch_handler_t)(adapter_t *adapter, ble_evt_t *const *pp_ble_evts,
+                                           uint32_t evt_count);
 typedef void (*sd_rpc_log_handler_t)(adapter_t *adapter, sd_rpc_log_severity_t severity,
                                      const char *log_message);
 
+/**@brief Function pointer type for advertising report filters, see
+ * @ref sd_rpc_evt_filter_adv_report_set. Returns non-zero to pass the report to the event
+ * handler. */
+typedef uint8_t (*sd_rpc_adv_report_filter_t)(const ble_gap_addr_t *p_peer_addr, int8_t rssi,
+                                              void *p_context);
+
 #ifdef __cplusplus
 }
 #endif
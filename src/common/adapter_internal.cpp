@@ -38,22 +38,39 @@
 #include "adapter_internal.h"
 
 #include "adapter.h"
+#include "log_ring.h"
 #include "nrf_error.h"
+#include "ser_config.h"
 #include "serialization_transport.h"
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <string>
 
+namespace {
+std::atomic<uint32_t> nextAdapterId(0);
+} // namespace
+
 AdapterInternal::AdapterInternal(SerializationTransport *_transport)
     : transport(_transport)
+    , id(nextAdapterId.fetch_add(1, std::memory_order_relaxed))
     , eventCallback(nullptr)
+    , eventBatchCallback(nullptr)
     , statusCallback(nullptr)
     , logCallback(nullptr)
     , logSeverityFilter(SD_RPC_LOG_TRACE)
+    , logDispatch(SD_RPC_LOG_DISPATCH_SYNC)
+    , logChannel(0)
     , isOpen(false)
-{}
+{
+    idleCommandBuffers.reserve(CommandBufferPoolSize);
+    transport->setTraceAdapter(id);
+}
 
 AdapterInternal::~AdapterInternal()
 {
+    closeLogChannel();
     delete transport;
 }
 
@@ -80,7 +97,26 @@ uint32_t AdapterInternal::open(const sd_rpc_status_handler_t status_callback,
         std::bind(&AdapterInternal::eventHandler, this, std::placeholders::_1);
     const auto boundLogHandler =
         std::bind(&AdapterInternal::logHandler, this, std::placeholders::_1, std::placeholders::_2);
-    return transport->open(boundStatusHandler, boundEventHandler, boundLogHandler);
+    const auto boundDiscardedEventHandler =
+        std::bind(&AdapterInternal::discardedEventHandler, this, std::placeholders::_1);
+
+    // Asynchronous messages are formatted and passed to the log callback by the drain thread of
+    // the log ring, they are logged on the calling thread if the channel can not be added
+    uint32_t channel = 0;
+
+    if (logDispatch == SD_RPC_LOG_DISPATCH_ASYNC && logChannel == 0 &&
+        LogRing::global().addSink(
+            [this](const LogRecord &record, const std::string &message) {
+                deliverLog(record.severity, message);
+            },
+            channel) == NRF_SUCCESS)
+    {
+        logChannel = channel;
+        transport->setLogChannel(channel);
+    }
+
+    return transport->open(boundStatusHandler, boundEventHandler, boundLogHandler,
+                           boundDiscardedEventHandler);
 }
 
 uint32_t AdapterInternal::close()
@@ -94,7 +130,9 @@ uint32_t AdapterInternal::close()
 
     isOpen = false;
 
-    return transport->close();
+    const auto errorCode = transport->close();
+    closeLogChannel();
+    return errorCode;
 }
 
 void AdapterInternal::statusHandler(const sd_rpc_app_status_t code, const std::string &message)
@@ -110,7 +148,7 @@ void AdapterInternal::statusHandler(const sd_rpc_app_status_t code, const std::s
 
 void AdapterInternal::eventHandler(ble_evt_t *event)
 {
-    // Event Thread
+    // Event Thread, or H5Transport thread when dispatching inline
     adapter_t adapter = {};
     adapter.internal  = static_cast<void *>(this);
 
@@ -120,19 +158,88 @@ void AdapterInternal::eventHandler(ble_evt_t *event)
     }
 }
 
+void AdapterInternal::eventBatchHandler(ble_evt_t *const *events, const uint32_t count)
+{
+    // Event Thread, or H5Transport thread when dispatching inline
+    adapter_t adapter = {};
+    adapter.internal  = static_cast<void *>(this);
+
+    if (eventBatchCallback != nullptr)
+    {
+        eventBatchCallback(&adapter, events, count);
+    }
+}
+
+void AdapterInternal::discardedEventHandler(ble_evt_t *event)
+{
+    // Event Thread
+#if NRF_SD_BLE_API_VERSION >= 6 && !defined(S112)
+    // The SoftDevice pauses scanning after each complete advertising report. Resume scanning for
+    // reports discarded by the event filter as the application would for reports it ignores.
+    if (event->header.evt_id == BLE_GAP_EVT_ADV_REPORT &&
+        event->evt.gap_evt.params.adv_report.type.status !=
+            BLE_GAP_ADV_DATA_STATUS_INCOMPLETE_MORE_DATA)
+    {
+        adapter_t adapter = {};
+        adapter.internal  = static_cast<void *>(this);
+
+        const auto errCode =
+            sd_ble_gap_scan_start(&adapter, nullptr, &event->evt.gap_evt.params.adv_report.data);
+
+        if (errCode != NRF_SUCCESS)
+        {
+            logHandler(SD_RPC_LOG_WARNING, "Failed to resume scanning after a discarded "
+                                           "advertising report, error code " +
+                                               std::to_string(errCode) + ".");
+        }
+    }
+#else
+    (void)event;
+#endif
+}
+
 void AdapterInternal::logHandler(const sd_rpc_log_severity_t severity,
                                  const std::string &log_message)
+{
+    if (static_cast<uint32_t>(severity) < static_cast<uint32_t>(logSeverityFilter))
+    {
+        return;
+    }
+
+    const auto channel = logChannel.load(std::memory_order_relaxed);
+
+    if (channel != 0)
+    {
+        LogRing::global().pushText(channel, severity, log_message);
+        return;
+    }
+
+    deliverLog(severity, log_message);
+}
+
+void AdapterInternal::deliverLog(const sd_rpc_log_severity_t severity,
+                                 const std::string &log_message)
 {
     adapter_t adapter = {};
     adapter.internal  = static_cast<void *>(this);
 
-    if (logCallback != nullptr &&
-        (static_cast<uint32_t>(severity) >= static_cast<uint32_t>(logSeverityFilter)))
+    if (logCallback != nullptr)
     {
         logCallback(&adapter, severity, log_message.c_str());
     }
 }
 
+void AdapterInternal::closeLogChannel() noexcept
+{
+    const auto channel = logChannel.exchange(0);
+
+    if (channel != 0)
+    {
+        transport->setLogChannel(0);
+        LogRing::global().removeSink(channel);
+    }
+}
+
 bool AdapterInternal::isInternalError(const uint32_t error_code)
 {
     return error_code != NRF_SUCCESS;
@@ -142,5 +249,120 @@ uint32_t AdapterInternal::logSeverityFilterSet(const sd_rpc_log_severity_t sever
 {
     std::lock_guard<std::mutex> lck(publicMethodMutex);
     logSeverityFilter = severity_filter;
+    transport->setLogSeverityFilter(severity_filter);
+    return NRF_SUCCESS;
+}
+
+uint32_t AdapterInternal::logDispatchSet(const sd_rpc_log_dispatch_t dispatch)
+{
+    std::lock_guard<std::mutex> lck(publicMethodMutex);
+
+    if (isOpen)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    logDispatch = dispatch;
     return NRF_SUCCESS;
 }
+
+uint32_t AdapterInternal::eventBatchHandlerSet(const sd_rpc_evt_batch_handler_t batch_handler,
+                                               const uint32_t max_count,
+                                               const uint32_t time_budget_us)
+{
+    std::lock_guard<std::mutex> lck(publicMethodMutex);
+
+    if (isOpen)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    evt_batch_cb_t boundEventBatchHandler = nullptr;
+
+    if (batch_handler != nullptr)
+    {
+        boundEventBatchHandler = std::bind(&AdapterInternal::eventBatchHandler, this,
+                                           std::placeholders::_1, std::placeholders::_2);
+    }
+
+    const auto errCode = transport->setEventBatchConfig(
+        boundEventBatchHandler, max_count, std::chrono::microseconds(time_budget_us));
+
+    if (errCode == NRF_SUCCESS)
+    {
+        eventBatchCallback = batch_handler;
+    }
+
+    return errCode;
+}
+
+bool AdapterInternal::acquireCommandBuffers(CommandBuffers &buffers) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lck(commandBuffersMutex);
+
+        // The serial port may still be writing the command of an idle buffer, such buffers stay
+        // idle and new buffers are allocated if all are written
+        const auto idle = std::find_if(idleCommandBuffers.rbegin(), idleCommandBuffers.rend(),
+                                       [](const CommandBuffers &idleBuffers) {
+                                           return idleBuffers.txBuffer.use_count() <= 1;
+                                       });
+
+        if (idle != idleCommandBuffers.rend())
+        {
+            buffers = std::move(*idle);
+            idleCommandBuffers.erase(std::next(idle).base());
+        }
+    }
+
+    try
+    {
+        if (!buffers.txBuffer)
+        {
+            buffers.txBuffer = std::make_shared<TxBuffer>(SER_HAL_TRANSPORT_MAX_PKT_SIZE);
+        }
+
+        if (!buffers.rxBuffer)
+        {
+            buffers.rxBuffer =
+                std::make_shared<std::vector<uint8_t>>(SER_HAL_TRANSPORT_MAX_PKT_SIZE);
+        }
+    }
+    catch (const std::bad_alloc &)
+    {
+        return false;
+    }
+
+    // The response is copied to the start of rxBuffer and the buffer is shrunk to its length,
+    // growing it again stays within its capacity
+    buffers.rxBuffer->resize(SER_HAL_TRANSPORT_MAX_PKT_SIZE);
+    return true;
+}
+
+void AdapterInternal::releaseCommandBuffers(CommandBuffers &buffers) noexcept
+{
+    // A transport layer still referring to a response buffer after a failed command may write to
+    // it. A command buffer is only read by the transport layers, it is kept until it is acquired.
+    if (buffers.rxBuffer.use_count() > 1)
+    {
+        buffers.rxBuffer.reset();
+    }
+
+    std::lock_guard<std::mutex> lck(commandBuffersMutex);
+
+    if (idleCommandBuffers.size() < CommandBufferPoolSize)
+    {
+        idleCommandBuffers.push_back(std::move(buffers));
+        return;
+    }
+
+    // Replace an idle buffer a transport layer still refers to
+    const auto idle = std::find_if(
+        idleCommandBuffers.begin(), idleCommandBuffers.end(),
+        [](const CommandBuffers &idleBuffers) { return idleBuffers.txBuffer.use_count() > 1; });
+
+    if (idle != idleCommandBuffers.end())
+    {
+        *idle = std::move(buffers);
+    }
+}
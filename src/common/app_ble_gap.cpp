@@ -82,6 +82,10 @@ typedef struct
     int scan_data_id{0};
     ble_data_item_t m_ble_data_pool[APP_BLE_GAP_ADV_BUF_COUNT]{};
 #endif // NRF_SD_BLE_API_VERSION >= 6
+
+    // Mutexes that serialize encoding/decoding for this adapter, one per codec context
+    std::mutex request_reply_codec_mutex;
+    std::mutex event_codec_mutex;
 } adapter_ble_gap_state_t;
 
 /**
@@ -89,12 +93,20 @@ typedef struct
  */
 static std::map<void *, std::shared_ptr<adapter_ble_gap_state_t>> adapters_gap_state;
 
+/**
+ * @brief Mutex that protects adapters_gap_state, the GAP states themselves are protected by the
+ * codec mutexes in each state
+ */
+static std::mutex adapters_gap_state_mutex;
+
 /**
  * @brief This structure keeps information related to an adapter key
  *
  * An adapter key is used to tell the codecs what adapter_ble_gap_state_t to
  * use during encoding and decoding.
  *
+ * The codec contexts are thread local. Each thread encoding or decoding sets the adapter it works
+ * on, codecs for different adapters can therefore run in parallel.
  */
 typedef struct
 {
@@ -105,30 +117,37 @@ typedef struct
     void *adapter_id{nullptr};
 
     /**
-     * @brief Mutex that protects changing the adapter GAP state while encoding/decoding is in
-     * progress
+     * @brief GAP state of adapter_id, kept alive while the codec context is set
      */
-    std::mutex codec_mutex;
+    std::shared_ptr<adapter_ble_gap_state_t> gap_state;
 
     /**
-     * @brief Mutex that protectes the adapter_id
-     *
+     * @brief Lock on the codec mutex of gap_state, held while the codec context is set
      */
-    std::mutex adapter_id_mutex;
+    std::unique_lock<std::mutex> codec_lock;
 } adapter_codec_context_t;
 
 /**
  * @brief Adapter key used for encoding/decoding request reply commands
  */
-static adapter_codec_context_t current_request_reply_context;
+static thread_local adapter_codec_context_t current_request_reply_context;
 
 /**
  * @brief Adapter key used for decoding events
  */
-static adapter_codec_context_t current_event_context;
+static thread_local adapter_codec_context_t current_event_context;
+
+static adapter_codec_context_t &
+app_ble_gap_codec_context(const app_ble_gap_adapter_codec_context_t codec_context)
+{
+    return codec_context == EVENT_CODEC_CONTEXT ? current_event_context
+                                                : current_request_reply_context;
+}
 
 uint32_t app_ble_gap_state_create(void *adapter_id)
 {
+    std::lock_guard<std::mutex> lck(adapters_gap_state_mutex);
+
     if (adapters_gap_state.count(adapter_id) == 1)
     {
         return NRF_ERROR_SD_RPC_INVALID_STATE;
@@ -141,357 +160,293 @@ uint32_t app_ble_gap_state_create(void *adapter_id)
 
 uint32_t app_ble_gap_state_delete(void *adapter_id)
 {
+    std::lock_guard<std::mutex> lck(adapters_gap_state_mutex);
+
+    // Codec contexts still using the state keep it alive until they are unset
     if (adapters_gap_state.erase(adapter_id) != 1)
     {
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    // TODO: if this key is used in request_reply_key
-    // TODO: or event_key, remove them from the keys
-    // TODO: and unlock any keys
-
     return NRF_SUCCESS;
 }
 
 void app_ble_gap_set_current_adapter_id(void *adapter_id,
                                         const app_ble_gap_adapter_codec_context_t key_type)
 {
-    if (key_type == EVENT_CODEC_CONTEXT)
+    auto &context = app_ble_gap_codec_context(key_type);
+
     {
-        current_event_context.codec_mutex.lock();
-        std::unique_lock<std::mutex> lck(current_event_context.adapter_id_mutex);
-        current_event_context.adapter_id = adapter_id;
+        std::lock_guard<std::mutex> lck(adapters_gap_state_mutex);
+        const auto gap_state = adapters_gap_state.find(adapter_id);
+
+        if (gap_state != adapters_gap_state.end())
+        {
+            context.gap_state = gap_state->second;
+        }
     }
-    else if (key_type == REQUEST_REPLY_CODEC_CONTEXT)
+
+    // The codec functions report an error if the adapter has no GAP state
+    if (context.gap_state)
     {
-        current_request_reply_context.codec_mutex.lock();
-        std::unique_lock<std::mutex> lck(current_request_reply_context.adapter_id_mutex);
-        current_request_reply_context.adapter_id = adapter_id;
+        context.codec_lock = std::unique_lock<std::mutex>(
+            key_type == EVENT_CODEC_CONTEXT ? context.gap_state->event_codec_mutex
+                                            : context.gap_state->request_reply_codec_mutex);
     }
+
+    context.adapter_id = adapter_id;
 }
 
 void app_ble_gap_unset_current_adapter_id(const app_ble_gap_adapter_codec_context_t key_type)
 {
-    if (key_type == EVENT_CODEC_CONTEXT)
-    {
-        current_event_context.codec_mutex.unlock();
-        std::unique_lock<std::mutex> lck(current_event_context.adapter_id_mutex);
-        current_event_context.adapter_id = nullptr;
-    }
-    else if (key_type == REQUEST_REPLY_CODEC_CONTEXT)
+    auto &context = app_ble_gap_codec_context(key_type);
+
+    if (context.codec_lock.owns_lock())
     {
-        current_request_reply_context.codec_mutex.unlock();
-        std::unique_lock<std::mutex> lck(current_request_reply_context.adapter_id_mutex);
-        current_request_reply_context.adapter_id = nullptr;
+        context.codec_lock.unlock();
     }
+
+    context.gap_state.reset();
+    context.adapter_id = nullptr;
 }
 
 /**
  * @brief Check if adapter_id is set for current_*_context.
- *
- * This function expects that caller has locked access to current_*_context.adapter_id
- *
  */
 uint32_t
 app_ble_gap_check_current_adapter_set(const app_ble_gap_adapter_codec_context_t codec_context)
 {
-    if (codec_context == EVENT_CODEC_CONTEXT)
-    {
-        return current_event_context.adapter_id != nullptr;
-    }
-    else if (codec_context == REQUEST_REPLY_CODEC_CONTEXT)
-    {
-        return current_request_reply_context.adapter_id != nullptr;
-    }
-
-    return false;
+    return app_ble_gap_codec_context(codec_context).adapter_id != nullptr;
 }
 
 uint32_t app_ble_gap_sec_keys_storage_create(uint16_t conn_handle, uint32_t *p_index)
 {
-    std::unique_lock<std::mutex> lck(current_request_reply_context.adapter_id_mutex);
-
     if (!app_ble_gap_check_current_adapter_set(REQUEST_REPLY_CODEC_CONTEXT))
     {
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    const auto adapter_id = current_request_reply_context.adapter_id;
+    const auto &context = current_request_reply_context;
 
-    try
+    if (!context.gap_state)
     {
-        const auto gap_state = adapters_gap_state.at(adapter_id);
-
-        // Assumption: conn_handle is always starting from 0 and up to SER_MAX_CONNECTIONS (not
-        // including)
-        for (auto i = 0; i < SER_MAX_CONNECTIONS; i++)
-        {
-            auto &keys = gap_state->app_keys_table[i];
-
-            if (!keys.conn_active)
-            {
-                keys.conn_active = 1;
-                keys.conn_handle = conn_handle;
-                *p_index         = i;
-                return NRF_SUCCESS;
-            }
-        }
-    }
-    catch (const std::out_of_range &)
-    {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
+        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(context.adapter_id)
                   << " not found in adapters_gap_state."
                   << "\n";
-
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
+    // Assumption: conn_handle is always starting from 0 and up to SER_MAX_CONNECTIONS (not
+    // including)
+    for (auto i = 0; i < SER_MAX_CONNECTIONS; i++)
+    {
+        auto &keys = context.gap_state->app_keys_table[i];
+
+        if (!keys.conn_active)
+        {
+            keys.conn_active = 1;
+            keys.conn_handle = conn_handle;
+            *p_index         = i;
+            return NRF_SUCCESS;
+        }
+    }
+
     return NRF_ERROR_NO_MEM;
 }
 
 uint32_t app_ble_gap_sec_keys_storage_destroy(const uint16_t conn_handle)
 {
-    std::unique_lock<std::mutex> lck(current_event_context.adapter_id_mutex);
-
     if (!app_ble_gap_check_current_adapter_set(EVENT_CODEC_CONTEXT))
     {
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    const auto adapter_id = current_event_context.adapter_id;
+    const auto &context = current_event_context;
 
-    try
+    if (!context.gap_state)
     {
-        const auto gap_state = adapters_gap_state.at(adapter_id);
+        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(context.adapter_id)
+                  << " not found in adapters_gap_state."
+                  << "\n";
+        return NRF_ERROR_SD_RPC_INVALID_STATE;
+    }
 
-        for (auto &keys : gap_state->app_keys_table)
+    for (auto &keys : context.gap_state->app_keys_table)
+    {
+        if (keys.conn_handle == conn_handle)
         {
-            if (keys.conn_handle == conn_handle)
-            {
-                keys.conn_active = 0;
-                return NRF_SUCCESS;
-            }
+            keys.conn_active = 0;
+            return NRF_SUCCESS;
         }
-
-        return NRF_ERROR_NO_MEM;
     }
-    catch (const std::out_of_range &)
-    {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
-                  << " not found in adapters_gap_state."
-                  << "\n";
 
-        return NRF_ERROR_SD_RPC_INVALID_STATE;
-    }
+    return NRF_ERROR_NO_MEM;
 }
 
 uint32_t app_ble_gap_sec_keys_find(const uint16_t conn_handle, uint32_t *p_index)
 {
-    std::unique_lock<std::mutex> lck(current_event_context.adapter_id_mutex);
-
     if (!app_ble_gap_check_current_adapter_set(EVENT_CODEC_CONTEXT))
     {
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    const auto adapter_id = current_event_context.adapter_id;
+    const auto &context = current_event_context;
 
-    try
+    if (!context.gap_state)
     {
-        const auto gap_state = adapters_gap_state.at(adapter_id);
+        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(context.adapter_id)
+                  << " not found in adapters_gap_state."
+                  << "\n";
+        return NRF_ERROR_SD_RPC_INVALID_STATE;
+    }
 
-        for (auto i = 0; i < SER_MAX_CONNECTIONS; i++)
+    for (auto i = 0; i < SER_MAX_CONNECTIONS; i++)
+    {
+        auto &keys = context.gap_state->app_keys_table[i];
+        if ((keys.conn_handle == conn_handle) && (keys.conn_active == 1))
         {
-            auto &keys = gap_state->app_keys_table[i];
-            if ((keys.conn_handle == conn_handle) && (keys.conn_active == 1))
-            {
-                *p_index = i;
-                return NRF_SUCCESS;
-            }
+            *p_index = i;
+            return NRF_SUCCESS;
         }
-
-        return NRF_ERROR_NOT_FOUND;
     }
-    catch (const std::out_of_range &)
-    {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
-                  << " not found in adapters_gap_state."
-                  << "\n";
 
-        return NRF_ERROR_SD_RPC_INVALID_STATE;
-    }
+    return NRF_ERROR_NOT_FOUND;
 }
 
 uint32_t app_ble_gap_sec_keys_get(const uint32_t index, ble_gap_sec_keyset_t **keyset)
 {
-    std::unique_lock<std::mutex> lck(current_event_context.adapter_id_mutex);
-
     if (!app_ble_gap_check_current_adapter_set(EVENT_CODEC_CONTEXT))
     {
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    const auto adapter_id = current_event_context.adapter_id;
+    const auto &context = current_event_context;
 
-    try
+    if (!context.gap_state)
     {
-        const auto gap_state = adapters_gap_state.at(adapter_id);
-        *keyset              = &(gap_state->app_keys_table[index].keyset);
-        return NRF_SUCCESS;
-    }
-    catch (const std::out_of_range &)
-    {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
+        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(context.adapter_id)
                   << " not found in adapters_gap_state."
                   << "\n";
-
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
+
+    *keyset = &(context.gap_state->app_keys_table[index].keyset);
+    return NRF_SUCCESS;
 }
 
 uint32_t app_ble_gap_sec_keys_update(const uint32_t index, const ble_gap_sec_keyset_t *keyset)
 {
-    std::unique_lock<std::mutex> lck(current_request_reply_context.adapter_id_mutex);
-
     if (!app_ble_gap_check_current_adapter_set(REQUEST_REPLY_CODEC_CONTEXT))
     {
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    const auto adapter_id = current_request_reply_context.adapter_id;
+    const auto &context = current_request_reply_context;
 
-    try
-    {
-        const auto gap_state = adapters_gap_state.at(adapter_id);
-        std::memcpy(&(gap_state->app_keys_table[index].keyset), keyset,
-                    sizeof(ble_gap_sec_keyset_t));
-        return NRF_SUCCESS;
-    }
-    catch (const std::out_of_range &)
+    if (!context.gap_state)
     {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
+        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(context.adapter_id)
                   << " not found in adapters_gap_state."
                   << "\n";
-
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
+
+    std::memcpy(&(context.gap_state->app_keys_table[index].keyset), keyset,
+                sizeof(ble_gap_sec_keyset_t));
+    return NRF_SUCCESS;
 }
 
 uint32_t app_ble_gap_state_reset()
 {
-    std::unique_lock<std::mutex> lck(current_request_reply_context.adapter_id_mutex);
-
     if (!app_ble_gap_check_current_adapter_set(REQUEST_REPLY_CODEC_CONTEXT))
     {
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    const auto adapter_id = current_request_reply_context.adapter_id;
+    const auto &context = current_request_reply_context;
 
-    try
+    if (!context.gap_state)
     {
-        const auto gap_state = adapters_gap_state.at(adapter_id);
+        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(context.adapter_id)
+                  << " not found in adapters_gap_state."
+                  << "\n";
+        return NRF_ERROR_SD_RPC_INVALID_STATE;
+    }
 
-        for (auto &keyset : gap_state->app_keys_table)
-        {
-            keyset.conn_active = false;
-        }
+    for (auto &keyset : context.gap_state->app_keys_table)
+    {
+        keyset.conn_active = false;
+    }
 
 #if NRF_SD_BLE_API_VERSION >= 6
-        for (auto &adv_set : gap_state->adv_sets)
-        {
-            adv_set.active = false;
-        }
-
-        gap_state->scan_data = {nullptr, 0};
-#endif // NRF_SD_BLE_API_VERSION >= 6
-    }
-    catch (const std::out_of_range &)
+    for (auto &adv_set : context.gap_state->adv_sets)
     {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
-                  << " not found in adapters_gap_state."
-                  << "\n";
-
-        return NRF_ERROR_SD_RPC_INVALID_STATE;
+        adv_set.active = false;
     }
 
+    context.gap_state->scan_data = {nullptr, 0};
+#endif // NRF_SD_BLE_API_VERSION >= 6
+
     return NRF_SUCCESS;
 }
 
 #if NRF_SD_BLE_API_VERSION >= 6
-static adv_set_data_t adv_set_data[] = {{BLE_GAP_ADV_SET_HANDLE_NOT_SET, nullptr, nullptr}};
-
 uint32_t app_ble_gap_scan_data_set(ble_data_t const *p_data)
 {
-    std::unique_lock<std::mutex> lck(current_request_reply_context.adapter_id_mutex);
-
     if (!app_ble_gap_check_current_adapter_set(REQUEST_REPLY_CODEC_CONTEXT))
     {
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    auto adapter_id = current_request_reply_context.adapter_id;
-
-    try
-    {
-        const auto gap_state = adapters_gap_state.at(current_request_reply_context.adapter_id);
-
-        if (gap_state->scan_data.p_data != nullptr)
-        {
-            return NRF_ERROR_BUSY;
-        }
+    const auto &context = current_request_reply_context;
 
-        memcpy(&(gap_state->scan_data), p_data, sizeof(ble_data_t));
-        return NRF_SUCCESS;
-    }
-    catch (const std::out_of_range &)
+    if (!context.gap_state)
     {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
+        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(context.adapter_id)
                   << " not found in adapters_gap_state."
                   << "\n";
-
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
+
+    if (context.gap_state->scan_data.p_data != nullptr)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    memcpy(&(context.gap_state->scan_data), p_data, sizeof(ble_data_t));
+    return NRF_SUCCESS;
 }
 
 uint32_t app_ble_gap_scan_data_fetch_clear(ble_data_t *p_data)
 {
-    std::unique_lock<std::mutex> lck(current_event_context.adapter_id_mutex);
-
     if (!app_ble_gap_check_current_adapter_set(EVENT_CODEC_CONTEXT))
     {
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    auto adapter_id = current_event_context.adapter_id;
+    const auto &context = current_event_context;
 
-    try
+    if (!context.gap_state)
     {
-        const auto gap_state = adapters_gap_state.at(adapter_id);
-        std::memcpy(p_data, &(gap_state->scan_data), sizeof(ble_data_t));
-
-        if (gap_state->scan_data.p_data != nullptr)
-        {
-            gap_state->scan_data.p_data = nullptr;
-            return NRF_SUCCESS;
-        }
-
-        return NRF_ERROR_NOT_FOUND;
-    }
-    catch (const std::out_of_range &)
-    {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
+        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(context.adapter_id)
                   << " not found in adapters_gap_state."
                   << "\n";
-
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
+
+    std::memcpy(p_data, &(context.gap_state->scan_data), sizeof(ble_data_t));
+
+    if (context.gap_state->scan_data.p_data != nullptr)
+    {
+        context.gap_state->scan_data.p_data = nullptr;
+        return NRF_SUCCESS;
+    }
+
+    return NRF_ERROR_NOT_FOUND;
 }
 
 int app_ble_gap_adv_buf_register(void *p_buf)
 {
-    std::unique_lock<std::mutex> lck(current_request_reply_context.adapter_id_mutex);
-
     if (!app_ble_gap_check_current_adapter_set(REQUEST_REPLY_CODEC_CONTEXT))
     {
         std::cerr << __FUNCTION__
@@ -506,38 +461,33 @@ int app_ble_gap_adv_buf_register(void *p_buf)
         return 0;
     }
 
-    auto adapter_id = current_request_reply_context.adapter_id;
+    const auto &context = current_request_reply_context;
 
-    try
+    if (!context.gap_state)
     {
-        const auto gap_state = adapters_gap_state.at(adapter_id);
+        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(context.adapter_id)
+                  << " not found in adapters_gap_state."
+                  << "\n";
+        return -1;
+    }
 
-        auto id = 1;
+    auto id = 1;
 
-        // Find available location in ble_gap_adv_buf_addr for
-        // store this new buffer pointer.
-        for (auto &item : gap_state->m_ble_data_pool)
+    // Find available location in ble_gap_adv_buf_addr for
+    // store this new buffer pointer.
+    for (auto &item : context.gap_state->m_ble_data_pool)
+    {
+        if (item.state == BLE_DATA_BUF_FREE)
         {
-            if (item.state == BLE_DATA_BUF_FREE)
-            {
-                item.buf   = p_buf;
-                item.id    = id;
-                item.state = BLE_DATA_BUF_IN_USE;
-                return id;
-            }
-            id++;
+            item.buf   = p_buf;
+            item.id    = id;
+            item.state = BLE_DATA_BUF_IN_USE;
+            return id;
         }
-
-        return -1;
+        id++;
     }
-    catch (const std::out_of_range &)
-    {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
-                  << " not found in adapters_gap_state."
-                  << "\n";
 
-        return -1;
-    }
+    return -1;
 }
 
 int app_ble_gap_adv_buf_addr_unregister(void *p_buf)
@@ -556,48 +506,39 @@ int app_ble_gap_adv_buf_addr_unregister(void *p_buf)
         return 0;
     }
 
-    auto adapter_id = current_request_reply_context.adapter_id;
+    const auto &context = current_request_reply_context;
 
-    try
+    if (!context.gap_state)
     {
-        const auto gap_state = adapters_gap_state.at(adapter_id);
+        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(context.adapter_id)
+                  << " not found in adapters_gap_state."
+                  << "\n";
+        return -1;
+    }
 
-        auto id = 1;
+    auto id = 1;
 
-        // Find available location in ble_gap_adv_buf_addr for
-        // store this new buffer pointer.
-        for (auto &item : gap_state->m_ble_data_pool)
+    // Find available location in ble_gap_adv_buf_addr for
+    // store this new buffer pointer.
+    for (auto &item : context.gap_state->m_ble_data_pool)
+    {
+        if ((item.buf == p_buf) &&
+            ((item.state == BLE_DATA_BUF_IN_USE) || (item.state == BLE_DATA_BUF_LAST_DIRTY)))
         {
-            if ((item.buf == p_buf) &&
-                ((item.state == BLE_DATA_BUF_IN_USE) || (item.state == BLE_DATA_BUF_LAST_DIRTY)))
-            {
-                item.buf   = nullptr;
-                item.state = BLE_DATA_BUF_FREE;
-                item.id    = 0;
-
-                return id;
-            }
-            id++;
-        }
+            item.buf   = nullptr;
+            item.state = BLE_DATA_BUF_FREE;
+            item.id    = 0;
 
-        return -1;
+            return id;
+        }
+        id++;
     }
-    catch (const std::out_of_range &)
-    {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
-                  << " not found in adapters_gap_state."
-                  << "\n";
 
-        return -1;
-    }
+    return -1;
 }
 
 void *app_ble_gap_adv_buf_unregister(const int id, const bool event_context)
 {
-    std::unique_lock<std::mutex> lck(event_context
-                                         ? current_event_context.adapter_id_mutex
-                                         : current_request_reply_context.adapter_id_mutex);
-
     if (!app_ble_gap_check_current_adapter_set(event_context ? EVENT_CODEC_CONTEXT
                                                              : REQUEST_REPLY_CODEC_CONTEXT))
     {
@@ -609,166 +550,143 @@ void *app_ble_gap_adv_buf_unregister(const int id, const bool event_context)
         return nullptr;
     }
 
-    void *ret = nullptr;
-    auto adapter_id =
-        event_context ? current_event_context.adapter_id : current_request_reply_context.adapter_id;
+    const auto &context = event_context ? current_event_context : current_request_reply_context;
 
-    try
+    if (!context.gap_state)
     {
-        const auto gap_state = adapters_gap_state.at(adapter_id);
-
-        ret = gap_state->m_ble_data_pool[id - 1].buf;
-
-        gap_state->m_ble_data_pool[id - 1].buf   = nullptr;
-        gap_state->m_ble_data_pool[id - 1].id    = 0;
-        gap_state->m_ble_data_pool[id - 1].state = BLE_DATA_BUF_FREE;
-    }
-    catch (const std::out_of_range &)
-    {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
+        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(context.adapter_id)
                   << " not found in adapters_gap_state."
                   << "\n";
+        return nullptr;
     }
 
+    auto &item = context.gap_state->m_ble_data_pool[id - 1];
+    const auto ret = item.buf;
+
+    item.buf   = nullptr;
+    item.id    = 0;
+    item.state = BLE_DATA_BUF_FREE;
+
     return ret;
 }
 
-static void app_ble_gap_ble_data_mark_dirty(uint8_t *p_buf)
+static void app_ble_gap_ble_data_mark_dirty(adapter_ble_gap_state_t &gap_state, uint8_t *p_buf)
 {
-    auto adapter_id = current_request_reply_context.adapter_id;
-
-    try
+    for (auto &item : gap_state.m_ble_data_pool)
     {
-        const auto gap_state = adapters_gap_state.at(adapter_id);
-
-        for (auto &item : gap_state->m_ble_data_pool)
+        if ((item.buf == p_buf) && (item.state == BLE_DATA_BUF_IN_USE))
         {
-            if ((item.buf == p_buf) && (item.state == BLE_DATA_BUF_IN_USE))
-            {
-                item.state = BLE_DATA_BUF_LAST_DIRTY;
-            }
+            item.state = BLE_DATA_BUF_LAST_DIRTY;
         }
     }
-    catch (const std::out_of_range &)
-    {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
-                  << " not found in adapters_gap_state."
-                  << "\n";
-    }
 }
 
-static void app_ble_gap_ble_adv_data_mark_dirty(uint8_t *p_buf1, uint8_t *p_buf2)
+static void app_ble_gap_ble_adv_data_mark_dirty(adapter_ble_gap_state_t &gap_state,
+                                                uint8_t *p_buf1, uint8_t *p_buf2)
 {
-    auto adapter_id = current_request_reply_context.adapter_id;
-
-    try
+    for (auto &item : gap_state.m_ble_data_pool)
     {
-        const auto gap_state = adapters_gap_state.at(adapter_id);
-
-        for (auto &item : gap_state->m_ble_data_pool)
+        if (item.state == BLE_DATA_BUF_LAST_DIRTY)
         {
-            if (item.state == BLE_DATA_BUF_LAST_DIRTY)
-            {
-                app_ble_gap_adv_buf_addr_unregister(item.buf);
-            }
+            app_ble_gap_adv_buf_addr_unregister(item.buf);
         }
+    }
+
+    app_ble_gap_ble_data_mark_dirty(gap_state, p_buf1);
+    app_ble_gap_ble_data_mark_dirty(gap_state, p_buf2);
+}
 
-        app_ble_gap_ble_data_mark_dirty(p_buf1);
-        app_ble_gap_ble_data_mark_dirty(p_buf2);
+void app_ble_gap_set_adv_data_set(uint8_t adv_handle, uint8_t *buf1, uint8_t *buf2)
+{
+    if (!app_ble_gap_check_current_adapter_set(REQUEST_REPLY_CODEC_CONTEXT))
+    {
+        return;
     }
-    catch (const std::out_of_range &)
+
+    const auto &context = current_request_reply_context;
+
+    if (!context.gap_state)
     {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
+        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(context.adapter_id)
                   << " not found in adapters_gap_state."
                   << "\n";
+        return;
     }
-}
-
-void app_ble_gap_set_adv_data_set(uint8_t adv_handle, uint8_t *buf1, uint8_t *buf2)
-{
-    std::unique_lock<std::mutex> lck(current_request_reply_context.adapter_id_mutex);
 
     if (adv_handle == BLE_GAP_ADV_SET_HANDLE_NOT_SET)
     {
         adv_handle = BLE_GAP_ADV_SET_COUNT_MAX - 1;
     }
 
-    app_ble_gap_ble_adv_data_mark_dirty(adv_set_data[adv_handle].buf1,
-                                        adv_set_data[adv_handle].buf2);
+    auto &adv_set = context.gap_state->adv_sets[adv_handle];
+
+    app_ble_gap_ble_adv_data_mark_dirty(*context.gap_state, adv_set.p_adv_data,
+                                        adv_set.p_scan_rsp_data);
 
-    adv_set_data[adv_handle].buf1 = buf1;
-    adv_set_data[adv_handle].buf2 = buf2;
+    adv_set.adv_handle      = adv_handle;
+    adv_set.p_adv_data      = buf1;
+    adv_set.p_scan_rsp_data = buf2;
 }
 
 // Update the adapter gap state scan_data_id variable based on pointer received???
 void app_ble_gap_scan_data_set(const uint8_t *p_scan_data)
 {
-    std::unique_lock<std::mutex> lck(current_request_reply_context.adapter_id_mutex);
-
     if (!app_ble_gap_check_current_adapter_set(REQUEST_REPLY_CODEC_CONTEXT))
     {
         return;
     }
 
     // Find location for scan_data
-    auto adapter_id = current_request_reply_context.adapter_id;
+    const auto &context = current_request_reply_context;
 
-    try
+    if (!context.gap_state)
     {
-        const auto gap_state = adapters_gap_state.at(adapter_id);
+        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(context.adapter_id)
+                  << " not found in adapters_gap_state."
+                  << "\n";
+        return;
+    }
 
-        auto id = 0;
+    auto id = 0;
 
-        // Check if ptr to scan data is already registered???
-        for (auto &item : gap_state->m_ble_data_pool)
+    // Check if ptr to scan data is already registered???
+    for (auto &item : context.gap_state->m_ble_data_pool)
+    {
+        if (item.buf == p_scan_data)
         {
-            if (item.buf == p_scan_data)
-            {
-                gap_state->scan_data_id = id + 1;
-                return;
-            }
-            id++;
+            context.gap_state->scan_data_id = id + 1;
+            return;
         }
-
-        gap_state->scan_data_id = 0;
-    }
-    catch (const std::out_of_range &)
-    {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
-                  << " not found in adapters_gap_state."
-                  << "\n";
+        id++;
     }
+
+    context.gap_state->scan_data_id = 0;
 }
 
 void app_ble_gap_scan_data_unset(bool free)
 {
-    std::unique_lock<std::mutex> lck(current_request_reply_context.adapter_id_mutex);
-
     if (!app_ble_gap_check_current_adapter_set(REQUEST_REPLY_CODEC_CONTEXT))
     {
         return;
     }
 
-    auto adapter_id = current_request_reply_context.adapter_id;
+    const auto &context = current_request_reply_context;
 
-    try
+    if (!context.gap_state)
     {
-        const auto gap_state = adapters_gap_state.at(adapter_id);
+        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(context.adapter_id)
+                  << " not found in adapters_gap_state."
+                  << "\n";
+        return;
+    }
 
-        if (gap_state->scan_data_id)
+    if (context.gap_state->scan_data_id)
+    {
+        if (free)
         {
-            if (free)
-            {
-                app_ble_gap_adv_buf_unregister(gap_state->scan_data_id, false);
-            }
-            gap_state->scan_data_id = 0;
+            app_ble_gap_adv_buf_unregister(context.gap_state->scan_data_id, false);
         }
-    }
-    catch (const std::out_of_range &)
-    {
-        std::cerr << __FUNCTION__ << ": adapter_id " << static_cast<void *>(adapter_id)
-                  << " not found in adapters_gap_state."
-                  << "\n";
+        context.gap_state->scan_data_id = 0;
     }
 }
 
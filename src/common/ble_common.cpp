@@ -43,7 +43,22 @@
 #include "adapter_internal.h"
 #include "app_ble_gap.h"
 #include "nrf_error.h"
-#include "ser_config.h"
+#include "span_tracer.h"
+
+namespace {
+void record_codec_span(const char *name, const uint32_t adapter_id, const uint8_t opcode,
+                       const std::chrono::steady_clock::time_point start,
+                       const std::chrono::steady_clock::time_point end) noexcept
+{
+    if (SpanTracer::isTracing())
+    {
+        auto span   = SpanTracer::span(name, adapter_id, start, end);
+        span.opcode = opcode;
+        span.tags   = SPAN_TAG_OPCODE;
+        SpanTracer::global().record(span);
+    }
+}
+} // namespace
 
 // AdapterRequestReplyCodecContext
 
@@ -67,37 +82,52 @@ EventCodecContext::~EventCodecContext()
     app_ble_gap_unset_current_adapter_id(EVENT_CODEC_CONTEXT);
 }
 
-uint32_t encode_decode(adapter_t *adapter, const encode_function_t &encode_function,
-                       const decode_function_t &decode_function)
-{
-    std::stringstream error_message;
-    auto _adapter = static_cast<AdapterInternal *>(adapter->internal);
+AdapterCommandBuffers::AdapterCommandBuffers(adapter_t *adapter)
+    : adapterInternal(static_cast<AdapterInternal *>(adapter->internal))
+    , acquired(adapterInternal->acquireCommandBuffers(buffers))
+{}
 
-    // Create rx_buffer
-    std::shared_ptr<std::vector<uint8_t>> rx_buffer;
-
-    if (decode_function)
+AdapterCommandBuffers::~AdapterCommandBuffers()
+{
+    if (acquired)
     {
-        rx_buffer = std::make_shared<std::vector<uint8_t>>(SER_HAL_TRANSPORT_MAX_PKT_SIZE);
+        adapterInternal->releaseCommandBuffers(buffers);
     }
+}
 
-    // Create tx_buffer
-    uint32_t tx_buffer_length = SER_HAL_TRANSPORT_MAX_PKT_SIZE;
-    std::vector<uint8_t> tx_buffer(tx_buffer_length);
-    auto err_code = encode_function(tx_buffer.data(), &tx_buffer_length);
-    tx_buffer.resize(tx_buffer_length);
+bool AdapterCommandBuffers::isAcquired() const noexcept
+{
+    return acquired;
+}
 
-    if (AdapterInternal::isInternalError(err_code))
+uint32_t encode_decode_send(adapter_t *adapter, CommandBuffers &buffers,
+                            const uint32_t encode_err_code, const uint32_t length,
+                            const uint8_t opcode,
+                            const std::chrono::steady_clock::time_point encode_start,
+                            const std::chrono::steady_clock::time_point encode_end)
+{
+    auto _adapter = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (AdapterInternal::isInternalError(encode_err_code))
     {
-        error_message << "Not able to encode packet. Code: 0x" << std::hex << err_code;
+        std::stringstream error_message;
+        error_message << "Not able to encode packet. Code: 0x" << std::hex << encode_err_code;
         _adapter->statusHandler(PKT_ENCODE_ERROR, error_message.str());
         return NRF_ERROR_SD_RPC_ENCODE;
     }
 
-    err_code = _adapter->transport->send(tx_buffer, rx_buffer);
+    _adapter->transport->commandLatencies().record(opcode, SD_RPC_CMD_PHASE_ENCODE,
+                                                   encode_end - encode_start);
+    record_codec_span("encode", _adapter->id, opcode, encode_start, encode_end);
+
+    // The command is encoded directly into the buffer written to the UART
+    buffers.txBuffer->setPayloadLength(length);
+
+    const auto err_code = _adapter->transport->send(buffers.txBuffer, buffers.rxBuffer);
 
     if (AdapterInternal::isInternalError(err_code))
     {
+        std::stringstream error_message;
         error_message << "Error sending packet to target. Code: 0x" << std::hex << err_code;
         _adapter->statusHandler(PKT_SEND_ERROR, error_message.str());
 
@@ -112,20 +142,27 @@ uint32_t encode_decode(adapter_t *adapter, const encode_function_t &encode_funct
         }
     }
 
-    uint32_t result_code = NRF_SUCCESS;
+    return NRF_SUCCESS;
+}
 
-    if (decode_function)
-    {
-        err_code = decode_function(rx_buffer->data(), static_cast<uint32_t>(rx_buffer->size()),
-                                   &result_code);
-    }
+uint32_t encode_decode_result(adapter_t *adapter, const uint32_t decode_err_code,
+                              const uint32_t result_code, const uint8_t opcode,
+                              const std::chrono::steady_clock::time_point decode_start,
+                              const std::chrono::steady_clock::time_point decode_end)
+{
+    auto _adapter = static_cast<AdapterInternal *>(adapter->internal);
 
-    if (AdapterInternal::isInternalError(err_code))
+    if (AdapterInternal::isInternalError(decode_err_code))
     {
-        error_message << "Not able to decode packet. Code 0x" << std::hex << err_code;
+        std::stringstream error_message;
+        error_message << "Not able to decode packet. Code 0x" << std::hex << decode_err_code;
         _adapter->statusHandler(PKT_DECODE_ERROR, error_message.str());
         return NRF_ERROR_SD_RPC_DECODE;
     }
 
+    _adapter->transport->commandLatencies().record(opcode, SD_RPC_CMD_PHASE_DECODE,
+                                                   decode_end - decode_start);
+    record_codec_span("decode", _adapter->id, opcode, decode_start, decode_end);
+
     return result_code;
 }
@@ -0,0 +1,612 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "log_ring.h"
+
+#include "nrf_error.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <iomanip>
+#include <new>
+#include <utility>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define LOG_RING_TSC
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace {
+size_t roundUpToPowerOfTwo(const size_t value)
+{
+    size_t result = 1;
+
+    while (result < value)
+    {
+        result <<= 1;
+    }
+
+    return result;
+}
+
+std::atomic<uint32_t> nextThreadIndex(0);
+
+struct LogFormat
+{
+    const char *format;
+    log_formatter_t formatter;
+};
+
+// Entries are written before their identifier is returned, the identifier reaches the drain
+// thread through the release store publishing a record
+LogFormat formatTable[LogFormatTableSize] = {{"{}", nullptr}};
+std::atomic<size_t> formatCount(1);
+
+const LogFormat &formatOf(const uint16_t formatId) noexcept
+{
+    return formatTable[formatId < LogFormatTableSize ? formatId : LogFormatText];
+}
+
+void appendHex(std::string &message, const std::string &bytes)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    for (const auto byte : bytes)
+    {
+        const auto value = static_cast<uint8_t>(byte);
+        message += digits[value >> 4];
+        message += digits[value & 0x0f];
+        message += ' ';
+    }
+}
+
+int64_t now() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+// Time stamp of a record when it is logged. Reading the time stamp counter costs a fraction of
+// reading the system clock, the ticks are converted to system time when the record is taken.
+int64_t ticks() noexcept
+{
+#ifdef LOG_RING_TSC
+    return static_cast<int64_t>(__rdtsc());
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+int64_t nowNanoseconds() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+} // namespace
+
+LogRing::LogRing(const size_t capacity)
+    : slots(new Slot[roundUpToPowerOfTwo(capacity)])
+    , mask(roundUpToPowerOfTwo(capacity) - 1)
+    , maxBlobSize(std::min(LogRecordMaxBlobSize, (mask + 1) / 2 * sizeof(LogRecord)))
+    , tail(0)
+    , head(0)
+    , droppedRecords(0)
+    , reportedDroppedRecords(0)
+    , clockOriginTicks(ticks())
+    , clockOriginTime(nowNanoseconds())
+    , clockTicks(clockOriginTicks)
+    , clockTime(clockOriginTime)
+    , nextChannel(1)
+    , draining(false)
+    , flushRequested(false)
+    , drainedPosition(0)
+{
+    for (size_t i = 0; i <= mask; i++)
+    {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+LogRing::~LogRing() noexcept
+{
+    stopDrain();
+}
+
+LogRing &LogRing::global() noexcept
+{
+    static LogRing ring;
+    return ring;
+}
+
+uint16_t LogRing::registerFormat(const char *format, const log_formatter_t formatter) noexcept
+{
+    const auto formatId = formatCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (formatId >= LogFormatTableSize)
+    {
+        return LogFormatText;
+    }
+
+    formatTable[formatId] = {format, formatter};
+    return static_cast<uint16_t>(formatId);
+}
+
+uint32_t LogRing::threadIndex() noexcept
+{
+    // Constant initialized, the index is not guarded by a check for dynamic initialization
+    thread_local uint32_t index = UINT32_MAX;
+
+    if (index == UINT32_MAX)
+    {
+        index = nextThreadIndex++;
+    }
+
+    return index;
+}
+
+LogRecord *LogRing::claim(const size_t count, size_t &position) noexcept
+{
+    position = tail.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        // The slots are drained in order, the other slots are free if the last one is
+        const auto last     = position + count - 1;
+        const auto sequence = slots[last & mask].sequence.load(std::memory_order_acquire);
+        const auto lag      = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(last);
+
+        if (lag == 0)
+        {
+            // The slots are free, claim them unless another thread did first
+            if (tail.compare_exchange_weak(position, position + count,
+                                           std::memory_order_relaxed))
+            {
+                auto &record     = slots[position & mask].record;
+                record.timestamp = ticks();
+                record.thread    = threadIndex();
+                return &record;
+            }
+        }
+        else if (lag < 0)
+        {
+            // The slot a full ring ago is not drained yet
+            droppedRecords.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        else
+        {
+            position = tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void LogRing::publish(const size_t position, const Blob &blob, const size_t blobSize) noexcept
+{
+    auto data = static_cast<const uint8_t *>(blob.data);
+
+    for (size_t copied = 0, slot = position + 1; copied < blobSize; slot++)
+    {
+        const auto chunk = std::min(blobSize - copied, sizeof(LogRecord));
+        std::memcpy(&slots[slot & mask].record, data + copied, chunk);
+        copied += chunk;
+    }
+
+    // Only the first slot is published, the drain thread takes the others with it
+    slots[position & mask].sequence.store(position + 1, std::memory_order_release);
+}
+
+void LogRing::setArg(LogRecord &record, const size_t index, const log_arg_type_t type,
+                     const uint64_t value) noexcept
+{
+    record.args[index]     = value;
+    record.argTypes[index] = static_cast<uint8_t>(type);
+}
+
+bool LogRing::pushText(const uint32_t channel, const sd_rpc_log_severity_t severity,
+                       const std::string &message) noexcept
+{
+    return push(channel, severity, LogFormatText, LogText{message.data(), message.size()});
+}
+
+bool LogRing::pop(LogRecord &record, std::string &blob) noexcept
+{
+    auto &slot = slots[head & mask];
+
+    if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+    {
+        return false;
+    }
+
+    record           = slot.record;
+    record.timestamp = toMicroseconds(record.timestamp);
+    blob.clear();
+
+    uint64_t blobLength = 0;
+
+    for (size_t i = 0; i < record.argCount; i++)
+    {
+        if (record.argTypes[i] == LOG_ARG_TEXT || record.argTypes[i] == LOG_ARG_BYTES)
+        {
+            blobLength = record.args[i];
+        }
+    }
+
+    const auto blobSize = static_cast<size_t>(std::min<uint64_t>(blobLength, maxBlobSize));
+
+    try
+    {
+        for (size_t copied = 0, i = 1; copied < blobSize; i++)
+        {
+            const auto chunk = std::min(blobSize - copied, sizeof(LogRecord));
+            const auto data  = reinterpret_cast<const char *>(&slots[(head + i) & mask].record);
+            blob.append(data, chunk);
+            copied += chunk;
+        }
+    }
+    catch (const std::bad_alloc &)
+    {
+        blob.clear();
+    }
+
+    // The slots are free again for the positions a full ring later
+    for (size_t i = 0; i <= record.blobSlots; i++)
+    {
+        slots[(head + i) & mask].sequence.store(head + i + mask + 1, std::memory_order_release);
+    }
+
+    head += 1 + record.blobSlots;
+    return true;
+}
+
+int64_t LogRing::toMicroseconds(const int64_t recordTicks) noexcept
+{
+    if (recordTicks > clockTicks)
+    {
+        clockTicks = ticks();
+        clockTime  = nowNanoseconds();
+    }
+
+    // The rate of the ticks is measured from the creation of the ring until the last time taken,
+    // a record logged in between is converted with an error of about the resolution of the clocks
+    const auto elapsedTicks = clockTicks - clockOriginTicks;
+    const auto rate =
+        elapsedTicks > 0 ? static_cast<double>(clockTime - clockOriginTime) / elapsedTicks : 0.0;
+    const auto elapsed = static_cast<int64_t>((recordTicks - clockOriginTicks) * rate);
+
+    return (clockOriginTime + elapsed) / 1000;
+}
+
+uint64_t LogRing::dropped() const noexcept
+{
+    return droppedRecords.load(std::memory_order_relaxed);
+}
+
+std::string LogRing::format(const LogRecord &record, const std::string &blob)
+{
+    const auto &entry = formatOf(record.formatId);
+
+    if (entry.formatter != nullptr)
+    {
+        return entry.formatter(record, blob);
+    }
+
+    std::string message;
+    size_t argIndex = 0;
+
+    for (auto p = entry.format; *p != '\0'; p++)
+    {
+        const auto hex         = std::strncmp(p, "{x}", 3) == 0;
+        const auto placeholder = hex || std::strncmp(p, "{}", 2) == 0;
+
+        if (!placeholder || argIndex >= record.argCount)
+        {
+            message += *p;
+            continue;
+        }
+
+        const auto value = record.args[argIndex];
+        char number[32];
+
+        switch (record.argTypes[argIndex])
+        {
+            case LOG_ARG_SIGNED:
+                std::snprintf(number, sizeof(number), hex ? "%" PRIx64 : "%" PRId64,
+                              static_cast<int64_t>(value));
+                message += number;
+                break;
+            case LOG_ARG_UNSIGNED:
+                std::snprintf(number, sizeof(number), hex ? "%" PRIx64 : "%" PRIu64, value);
+                message += number;
+                break;
+            case LOG_ARG_DOUBLE:
+            {
+                double doubleValue;
+                std::memcpy(&doubleValue, &value, sizeof(doubleValue));
+                std::snprintf(number, sizeof(number), "%g", doubleValue);
+                message += number;
+                break;
+            }
+            case LOG_ARG_STRING:
+                message += reinterpret_cast<const char *>(value);
+                break;
+            case LOG_ARG_TEXT:
+                message += blob;
+                break;
+            case LOG_ARG_BYTES:
+                appendHex(message, blob);
+                break;
+            default:
+                break;
+        }
+
+        if ((record.argTypes[argIndex] == LOG_ARG_TEXT ||
+             record.argTypes[argIndex] == LOG_ARG_BYTES) &&
+            blob.size() < value)
+        {
+            message += "...";
+        }
+
+        argIndex++;
+        p += hex ? 2 : 1;
+    }
+
+    return message;
+}
+
+uint32_t LogRing::addSink(const log_ring_sink_t &sink, uint32_t &channel) noexcept
+{
+    std::lock_guard<std::mutex> changeLck(sinkChangeMutex);
+
+    try
+    {
+        {
+            std::lock_guard<std::mutex> sinkLck(sinkMutex);
+            channel        = nextChannel++;
+            sinks[channel] = {sink, nullptr};
+        }
+
+        startDrain();
+    }
+    catch (const std::exception &)
+    {
+        std::lock_guard<std::mutex> sinkLck(sinkMutex);
+        sinks.erase(channel);
+        channel = 0;
+        return NRF_ERROR_INTERNAL;
+    }
+
+    return NRF_SUCCESS;
+}
+
+uint32_t LogRing::addSink(std::ostream &stream, uint32_t &channel) noexcept
+{
+    const auto errorCode = addSink(
+        [&stream](const LogRecord &record, const std::string &message) {
+            stream << "@" << std::right << std::setfill('0') << std::setw(10) << record.timestamp
+                   << " [" << std::setfill(' ') << std::setw(5) << record.thread << "] "
+                   << "| " << message << '\n';
+        },
+        channel);
+
+    if (errorCode == NRF_SUCCESS)
+    {
+        std::lock_guard<std::mutex> sinkLck(sinkMutex);
+        sinks[channel].stream = &stream;
+    }
+
+    return errorCode;
+}
+
+void LogRing::removeSink(const uint32_t channel) noexcept
+{
+    std::lock_guard<std::mutex> changeLck(sinkChangeMutex);
+
+    flush();
+
+    auto lastSink = false;
+
+    {
+        std::lock_guard<std::mutex> sinkLck(sinkMutex);
+        sinks.erase(channel);
+        lastSink = sinks.empty();
+    }
+
+    if (lastSink)
+    {
+        stopDrain();
+    }
+}
+
+void LogRing::flush() noexcept
+{
+    const auto position = tail.load(std::memory_order_acquire);
+
+    std::unique_lock<std::mutex> lck(drainMutex);
+
+    if (!draining)
+    {
+        return;
+    }
+
+    flushRequested = true;
+    drainWakeup.notify_all();
+    drainDone.wait(lck, [this, position] { return !draining || drainedPosition >= position; });
+}
+
+void LogRing::startDrain()
+{
+    std::lock_guard<std::mutex> lck(drainMutex);
+
+    if (draining)
+    {
+        return;
+    }
+
+    drainThread = std::thread([this] { drainRunner(); });
+    draining    = true;
+}
+
+void LogRing::stopDrain() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lck(drainMutex);
+
+        if (!draining)
+        {
+            return;
+        }
+
+        draining = false;
+    }
+
+    drainWakeup.notify_all();
+    drainDone.notify_all();
+
+    if (drainThread.joinable())
+    {
+        drainThread.join();
+    }
+}
+
+void LogRing::drainRunner() noexcept
+{
+    std::unique_lock<std::mutex> lck(drainMutex);
+
+    while (draining)
+    {
+        lck.unlock();
+        const auto drained = drainRecords();
+        lck.lock();
+
+        drainedPosition = head;
+        drainDone.notify_all();
+
+        // Only sleep once the ring is empty
+        if (!drained)
+        {
+            drainWakeup.wait_for(lck, LogRingDrainInterval,
+                                 [this] { return !draining || flushRequested; });
+            flushRequested = false;
+        }
+    }
+}
+
+bool LogRing::drainRecords() noexcept
+{
+    std::lock_guard<std::mutex> sinkLck(sinkMutex);
+
+    LogRecord record;
+    std::string blob;
+    auto drained = false;
+
+    // At most a full ring in each pass, flush and removeSink wait for the end of a pass
+    const auto end = head + mask + 1;
+
+    while (head < end && pop(record, blob))
+    {
+        const auto sink = sinks.find(record.channel);
+
+        if (sink == sinks.end())
+        {
+            continue;
+        }
+
+        try
+        {
+            sink->second.sink(record, format(record, blob));
+        }
+        catch (const std::exception &)
+        {}
+
+        drained = true;
+    }
+
+    const auto droppedNow = dropped();
+
+    if (droppedNow != reportedDroppedRecords)
+    {
+        static const auto droppedFormat = LOG_FORMAT_ID("{} log records dropped");
+
+        LogRecord dropRecord = {};
+        dropRecord.timestamp = now();
+        dropRecord.thread    = threadIndex();
+        dropRecord.formatId  = droppedFormat;
+        dropRecord.severity  = SD_RPC_LOG_WARNING;
+        dropRecord.argCount  = 1;
+        setArg(dropRecord, 0, LOG_ARG_UNSIGNED, droppedNow - reportedDroppedRecords);
+
+        for (auto &sink : sinks)
+        {
+            try
+            {
+                dropRecord.channel = sink.first;
+                sink.second.sink(dropRecord, format(dropRecord, std::string()));
+            }
+            catch (const std::exception &)
+            {}
+        }
+
+        reportedDroppedRecords = droppedNow;
+        drained                = true;
+    }
+
+    if (!drained)
+    {
+        return false;
+    }
+
+    for (auto &sink : sinks)
+    {
+        if (sink.second.stream != nullptr)
+        {
+            try
+            {
+                sink.second.stream->flush();
+            }
+            catch (const std::exception &)
+            {}
+        }
+    }
+
+    return true;
+}
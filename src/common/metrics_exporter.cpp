@@ -0,0 +1,436 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "metrics_exporter.h"
+
+#include "adapter_internal.h"
+#include "command_latencies.h"
+#include "nrf_error.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+struct AdapterMetrics
+{
+    // Labels identifying the adapter in each of its samples
+    std::string labels;
+    sd_rpc_stats_t stats;
+    const CommandLatencies *latencies;
+};
+
+const char *const PhaseNames[SD_RPC_CMD_PHASE_COUNT] = {"encode", "wire", "response", "decode"};
+
+const double PhaseQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+std::string escapeLabelValue(const std::string &value)
+{
+    std::string escaped;
+
+    for (const auto character : value)
+    {
+        switch (character)
+        {
+            case '\\':
+                escaped += "\\\\";
+                break;
+            case '"':
+                escaped += "\\\"";
+                break;
+            case '\n':
+                escaped += "\\n";
+                break;
+            default:
+                escaped += character;
+                break;
+        }
+    }
+
+    return escaped;
+}
+
+double toSeconds(const std::chrono::nanoseconds duration)
+{
+    return std::chrono::duration<double>(duration).count();
+}
+
+double microsecondsToSeconds(const uint32_t microseconds)
+{
+    return microseconds / 1e6;
+}
+
+// Writes a metric family with the samples of all adapters, the samples of a family must not be
+// interleaved with samples of other families. samples is called for each adapter with a function
+// writing one sample: sample(suffix, labels, value).
+template <typename Samples>
+void writeFamily(std::ostream &out, const std::vector<AdapterMetrics> &adapters, const char *name,
+                 const char *type, const char *help, const Samples &samples)
+{
+    out << "# TYPE " << MetricsNamePrefix << name << ' ' << type << '\n';
+    out << "# HELP " << MetricsNamePrefix << name << ' ' << help << '\n';
+
+    for (const auto &adapter : adapters)
+    {
+        samples(adapter, [&out, &adapter, name](const char *suffix, const std::string &labels,
+                                                const auto value) {
+            out << MetricsNamePrefix << name << suffix << '{' << adapter.labels << labels << "} "
+                << value << '\n';
+        });
+    }
+}
+
+template <typename Field>
+void writeCounter(std::ostream &out, const std::vector<AdapterMetrics> &adapters, const char *name,
+                  const char *help, Field sd_rpc_stats_t::*field)
+{
+    writeFamily(out, adapters, name, "counter", help,
+                [field](const AdapterMetrics &adapter, const auto &sample) {
+                    sample("_total", "", adapter.stats.*field);
+                });
+}
+
+template <typename Field>
+void writeGauge(std::ostream &out, const std::vector<AdapterMetrics> &adapters, const char *name,
+                const char *help, Field sd_rpc_stats_t::*field)
+{
+    writeFamily(out, adapters, name, "gauge", help,
+                [field](const AdapterMetrics &adapter, const auto &sample) {
+                    sample("", "", adapter.stats.*field);
+                });
+}
+
+// Gauge of a duration in microseconds, exported in seconds
+void writeDurationGauge(std::ostream &out, const std::vector<AdapterMetrics> &adapters,
+                        const char *name, const char *help, uint32_t sd_rpc_stats_t::*field)
+{
+    writeFamily(out, adapters, name, "gauge", help,
+                [field](const AdapterMetrics &adapter, const auto &sample) {
+                    sample("", "", microsecondsToSeconds(adapter.stats.*field));
+                });
+}
+
+void writeLinkMetrics(std::ostream &out, const std::vector<AdapterMetrics> &adapters)
+{
+    writeFamily(out, adapters, "uart_bytes", "counter",
+                "Bytes written to and read from the serial port.",
+                [](const AdapterMetrics &adapter, const auto &sample) {
+                    sample("_total", ",direction=\"tx\"", adapter.stats.tx_bytes);
+                    sample("_total", ",direction=\"rx\"", adapter.stats.rx_bytes);
+                });
+
+    writeFamily(out, adapters, "h5_packets", "counter",
+                "H5 packets sent and received, including link control packets.",
+                [](const AdapterMetrics &adapter, const auto &sample) {
+                    sample("_total", ",direction=\"tx\"", adapter.stats.h5_tx_packets);
+                    sample("_total", ",direction=\"rx\"", adapter.stats.h5_rx_packets);
+                });
+
+    writeCounter(out, adapters, "h5_retransmissions",
+                 "Reliable H5 packets sent again since they were not acknowledged in time.",
+                 &sd_rpc_stats_t::h5_retransmissions);
+
+    writeFamily(out, adapters, "h5_errors", "counter", "Received H5 packets with errors.",
+                [](const AdapterMetrics &adapter, const auto &sample) {
+                    sample("_total", ",type=\"slip\"", adapter.stats.h5_slip_errors);
+                    sample("_total", ",type=\"header\"", adapter.stats.h5_header_errors);
+                    sample("_total", ",type=\"crc\"", adapter.stats.h5_crc_errors);
+                });
+
+    writeCounter(out, adapters, "h5_resyncs", "Times the H5 link was synchronized again.",
+                 &sd_rpc_stats_t::h5_resyncs);
+
+    writeDurationGauge(out, adapters, "h5_rtt_smoothed_seconds",
+                       "Smoothed round trip time of reliable H5 packets.",
+                       &sd_rpc_stats_t::h5_rtt_smoothed_us);
+    writeDurationGauge(out, adapters, "h5_rtt_variation_seconds",
+                       "Variation of the round trip time of reliable H5 packets.",
+                       &sd_rpc_stats_t::h5_rtt_variation_us);
+    writeDurationGauge(out, adapters, "h5_rto_seconds",
+                       "Retransmission timeout of reliable H5 packets.",
+                       &sd_rpc_stats_t::h5_rto_us);
+    writeDurationGauge(out, adapters, "h5_ack_rtt_min_seconds",
+                       "Shortest time until a reliable H5 packet is acknowledged.",
+                       &sd_rpc_stats_t::h5_ack_rtt_min_us);
+    writeDurationGauge(out, adapters, "h5_ack_rtt_avg_seconds",
+                       "Average time until a reliable H5 packet is acknowledged.",
+                       &sd_rpc_stats_t::h5_ack_rtt_avg_us);
+    writeDurationGauge(out, adapters, "h5_ack_rtt_max_seconds",
+                       "Longest time until a reliable H5 packet is acknowledged.",
+                       &sd_rpc_stats_t::h5_ack_rtt_max_us);
+}
+
+void writeEventMetrics(std::ostream &out, const std::vector<AdapterMetrics> &adapters)
+{
+    writeGauge(out, adapters, "event_queue_depth",
+               "Received events waiting to be passed to the application.",
+               &sd_rpc_stats_t::event_queue_depth);
+    writeGauge(out, adapters, "event_queue_high_water",
+               "Largest number of received events that have been waiting at the same time.",
+               &sd_rpc_stats_t::event_queue_high_water);
+    writeCounter(out, adapters, "events_dropped", "Events dropped since the event queue was full.",
+                 &sd_rpc_stats_t::event_queue_dropped);
+    writeCounter(out, adapters, "events_coalesced",
+                 "Advertising reports merged into a queued report since the event queue was full.",
+                 &sd_rpc_stats_t::event_queue_coalesced);
+    writeCounter(out, adapters, "events_lost",
+                 "Events other than advertising reports dropped while events are pulled.",
+                 &sd_rpc_stats_t::event_queue_lost);
+    writeCounter(out, adapters, "events_filtered", "Events discarded by the event filter.",
+                 &sd_rpc_stats_t::event_filtered);
+    writeCounter(out, adapters, "events_filtered_adv_reports",
+                 "Discarded advertising reports still decoded to resume scanning.",
+                 &sd_rpc_stats_t::event_filtered_adv_reports);
+}
+
+void writeCommandMetrics(std::ostream &out, const std::vector<AdapterMetrics> &adapters)
+{
+    writeFamily(out, adapters, "command_latency_seconds", "summary",
+                "Time from sending a command until its response is received.",
+                [](const AdapterMetrics &adapter, const auto &sample) {
+                    const auto &stats = adapter.stats;
+                    sample("", ",quantile=\"0.5\"",
+                           microsecondsToSeconds(stats.command_latency_p50_us));
+                    sample("", ",quantile=\"0.9\"",
+                           microsecondsToSeconds(stats.command_latency_p90_us));
+                    sample("", ",quantile=\"0.99\"",
+                           microsecondsToSeconds(stats.command_latency_p99_us));
+                    sample("_count", "", stats.command_count);
+                });
+
+    writeDurationGauge(out, adapters, "command_latency_max_seconds",
+                       "Longest time from sending a command until its response is received.",
+                       &sd_rpc_stats_t::command_latency_max_us);
+
+    writeFamily(
+        out, adapters, "command_phase_latency_seconds", "summary",
+        "Time taken by each phase of the commands with a serialization opcode.",
+        [](const AdapterMetrics &adapter, const auto &sample) {
+            for (size_t opcode = 0; opcode < CommandOpcodeCount; opcode++)
+            {
+                for (auto phase = 0; phase < SD_RPC_CMD_PHASE_COUNT; phase++)
+                {
+                    const auto histogram = adapter.latencies->histogram(
+                        static_cast<uint8_t>(opcode), static_cast<sd_rpc_cmd_phase_t>(phase));
+                    const auto count = histogram != nullptr ? histogram->count() : 0;
+
+                    if (count == 0)
+                    {
+                        continue;
+                    }
+
+                    std::stringstream labels;
+                    labels << ",opcode=\"0x" << std::hex << std::setw(2) << std::setfill('0')
+                           << opcode << "\",phase=\"" << PhaseNames[phase] << '"';
+
+                    for (const auto quantile : PhaseQuantiles)
+                    {
+                        std::stringstream quantileLabels;
+                        quantileLabels << labels.str() << ",quantile=\"" << quantile << '"';
+                        sample("", quantileLabels.str(),
+                               toSeconds(histogram->percentile(quantile * 100)));
+                    }
+
+                    sample("_sum", labels.str(), toSeconds(histogram->mean() * count));
+                    sample("_count", labels.str(), count);
+                }
+            }
+        });
+}
+} // namespace
+
+MetricsExporter::MetricsExporter() noexcept
+    : fileInterval(0)
+    , isWriting(false)
+{}
+
+MetricsExporter::~MetricsExporter() noexcept
+{
+    stop();
+}
+
+MetricsExporter &MetricsExporter::global() noexcept
+{
+    static MetricsExporter exporter;
+    return exporter;
+}
+
+std::string MetricsExporter::render(const std::vector<adapter_t *> &adapters)
+{
+    // Take a snapshot of each adapter first, the families are written adapter by adapter
+    std::vector<AdapterMetrics> metrics;
+    metrics.reserve(adapters.size());
+
+    for (const auto adapter : adapters)
+    {
+        const auto adapterInternal = static_cast<AdapterInternal *>(adapter->internal);
+
+        std::stringstream labels;
+        labels << "adapter=\"" << adapterInternal->id << "\",port=\""
+               << escapeLabelValue(adapterInternal->transport->portName()) << '"';
+
+        AdapterMetrics adapterMetrics;
+        adapterMetrics.labels = labels.str();
+        adapterMetrics.stats  = {};
+        adapterInternal->transport->getStats(adapterMetrics.stats);
+        adapterMetrics.latencies = &adapterInternal->transport->commandLatencies();
+
+        metrics.push_back(adapterMetrics);
+    }
+
+    std::stringstream out;
+    out << std::setprecision(9);
+
+    writeLinkMetrics(out, metrics);
+    writeEventMetrics(out, metrics);
+    writeCommandMetrics(out, metrics);
+
+    out << "# EOF\n";
+    return out.str();
+}
+
+uint32_t MetricsExporter::start(const std::vector<adapter_t *> &adapters, const std::string &path,
+                                const std::chrono::milliseconds interval) noexcept
+{
+    std::lock_guard<std::mutex> writerLock(writerMutex);
+
+    if (isWriting)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    try
+    {
+        fileAdapters = adapters;
+        filePath     = path;
+        fileInterval = std::max(interval, MetricsMinimumInterval);
+
+        // Report a path that can not be written to the caller
+        if (!writeFile(filePath, render(fileAdapters)))
+        {
+            return NRF_ERROR_INVALID_PARAM;
+        }
+
+        writer    = std::thread([this] { writerRunner(); });
+        isWriting = true;
+    }
+    catch (const std::exception &)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    return NRF_SUCCESS;
+}
+
+uint32_t MetricsExporter::stop() noexcept
+{
+    {
+        std::lock_guard<std::mutex> writerLock(writerMutex);
+
+        if (!isWriting)
+        {
+            return NRF_ERROR_INVALID_STATE;
+        }
+
+        isWriting = false;
+    }
+
+    writerStop.notify_all();
+
+    if (writer.joinable())
+    {
+        writer.join();
+    }
+
+    return NRF_SUCCESS;
+}
+
+void MetricsExporter::writerRunner() noexcept
+{
+    std::unique_lock<std::mutex> writerLock(writerMutex);
+
+    while (!writerStop.wait_for(writerLock, fileInterval, [this] { return !isWriting; }))
+    {
+        // The adapters, path and interval do not change while writing
+        writerLock.unlock();
+
+        try
+        {
+            writeFile(filePath, render(fileAdapters));
+        }
+        catch (const std::exception &)
+        {
+            // Try again at the next interval
+        }
+
+        writerLock.lock();
+    }
+}
+
+bool MetricsExporter::writeFile(const std::string &path, const std::string &text) noexcept
+{
+    try
+    {
+        const auto temporaryPath = path + ".tmp";
+
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            file << text;
+            file.flush();
+
+            if (!file)
+            {
+                return false;
+            }
+        }
+
+        if (std::rename(temporaryPath.c_str(), path.c_str()) == 0)
+        {
+            return true;
+        }
+
+        // Renaming does not replace an existing file on Windows
+        std::remove(path.c_str());
+        return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
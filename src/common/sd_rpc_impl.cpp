@@ -41,12 +41,16 @@
 #include "app_ble_gap.h"
 #include "ble_common.h"
 #include "h5_transport.h"
+#include "metrics_exporter.h"
 #include "serial_port_enum.h"
 #include "serialization_transport.h"
+#include "span_tracer.h"
 #include "uart_settings_boost.h"
 #include "uart_transport.h"
 
 #include <cstdlib>
+#include <cstring>
+#include <vector>
 
 uint32_t sd_rpc_serial_port_enum(sd_rpc_serial_port_desc_t serial_port_descs[], uint32_t *size)
 {
@@ -126,6 +130,16 @@ data_link_layer_t *sd_rpc_data_link_layer_create_bt_three_wire(physical_layer_t
     return dataLinkLayer;
 }
 
+data_link_layer_t *sd_rpc_data_link_layer_create_bt_three_wire_window(
+    physical_layer_t *physical_layer, uint32_t retransmission_interval, uint8_t window_size)
+{
+    const auto dataLinkLayer = static_cast<data_link_layer_t *>(malloc(sizeof(data_link_layer_t)));
+    const auto physicalLayer = static_cast<UartTransport *>(physical_layer->internal);
+    const auto h5            = new H5Transport(physicalLayer, retransmission_interval, window_size);
+    dataLinkLayer->internal  = static_cast<void *>(h5);
+    return dataLinkLayer;
+}
+
 transport_layer_t *sd_rpc_transport_layer_create(data_link_layer_t *data_link_layer,
                                                  uint32_t response_timeout)
 {
@@ -209,6 +223,18 @@ uint32_t sd_rpc_log_handler_severity_filter_set(adapter_t *adapter,
     return adapterLayer->logSeverityFilterSet(severity_filter);
 }
 
+uint32_t sd_rpc_log_handler_dispatch_set(adapter_t *adapter, sd_rpc_log_dispatch_t dispatch)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr || dispatch > SD_RPC_LOG_DISPATCH_ASYNC)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    return adapterLayer->logDispatchSet(dispatch);
+}
+
 uint32_t sd_rpc_conn_reset(adapter_t *adapter, sd_rpc_reset_t reset_mode)
 {
     auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
@@ -224,3 +250,377 @@ uint32_t sd_rpc_conn_reset(adapter_t *adapter, sd_rpc_reset_t reset_mode)
 
     return adapterLayer->transport->send(tx_buffer, nullptr, SERIALIZATION_RESET_CMD);
 }
+
+uint32_t sd_rpc_stats_get(adapter_t *adapter, sd_rpc_stats_t *p_stats)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr || p_stats == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    std::memset(p_stats, 0, sizeof(sd_rpc_stats_t));
+    adapterLayer->transport->getStats(*p_stats);
+
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_rpc_cmd_latency_get(adapter_t *adapter, uint8_t opcode, sd_rpc_cmd_phase_t phase,
+                                sd_rpc_latency_t *p_latency)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr || p_latency == nullptr || phase >= SD_RPC_CMD_PHASE_COUNT)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    const auto histogram = adapterLayer->transport->commandLatencies().histogram(opcode, phase);
+
+    if (histogram == nullptr)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    p_latency->count   = histogram->count();
+    p_latency->min_ns  = static_cast<uint64_t>(histogram->min().count());
+    p_latency->mean_ns = static_cast<uint64_t>(histogram->mean().count());
+    p_latency->max_ns  = static_cast<uint64_t>(histogram->max().count());
+    p_latency->p50_ns  = static_cast<uint64_t>(histogram->percentile(50).count());
+    p_latency->p90_ns  = static_cast<uint64_t>(histogram->percentile(90).count());
+    p_latency->p99_ns  = static_cast<uint64_t>(histogram->percentile(99).count());
+    p_latency->p999_ns = static_cast<uint64_t>(histogram->percentile(99.9).count());
+
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_rpc_cmd_latency_buckets_get(adapter_t *adapter, uint8_t opcode,
+                                        sd_rpc_cmd_phase_t phase,
+                                        sd_rpc_latency_bucket_t *p_buckets,
+                                        uint32_t *p_bucket_count)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr || p_buckets == nullptr || p_bucket_count == nullptr ||
+        phase >= SD_RPC_CMD_PHASE_COUNT)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    const auto histogram = adapterLayer->transport->commandLatencies().histogram(opcode, phase);
+
+    if (histogram == nullptr)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+
+    uint32_t bucketCount = 0;
+    uint64_t lowerBound  = 0;
+
+    for (size_t index = 0; index < LatencyHistogramBucketCount; index++)
+    {
+        const auto count      = histogram->bucketCount(index);
+        const auto upperBound = LatencyHistogram::bucketUpperBound(index);
+
+        if (count > 0)
+        {
+            if (bucketCount < *p_bucket_count)
+            {
+                p_buckets[bucketCount].lower_bound_ns = lowerBound;
+                p_buckets[bucketCount].upper_bound_ns = upperBound;
+                p_buckets[bucketCount].count          = count;
+            }
+
+            bucketCount++;
+        }
+
+        lowerBound = upperBound + 1;
+    }
+
+    const auto errCode = bucketCount > *p_bucket_count ? NRF_ERROR_DATA_SIZE : NRF_SUCCESS;
+    *p_bucket_count    = bucketCount;
+
+    return errCode;
+}
+
+uint32_t sd_rpc_cmd_latency_reset(adapter_t *adapter)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    adapterLayer->transport->commandLatencies().reset();
+
+    return NRF_SUCCESS;
+}
+
+namespace {
+bool toAdapterList(adapter_t *const *adapters, const uint32_t adapter_count,
+                   std::vector<adapter_t *> &adapterList)
+{
+    if (adapters == nullptr && adapter_count > 0)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < adapter_count; i++)
+    {
+        if (adapters[i] == nullptr || adapters[i]->internal == nullptr)
+        {
+            return false;
+        }
+
+        adapterList.push_back(adapters[i]);
+    }
+
+    return true;
+}
+} // namespace
+
+uint32_t sd_rpc_metrics_write(adapter_t *const *adapters, uint32_t adapter_count, char *p_buffer,
+                              uint32_t *p_length)
+{
+    if (p_buffer == nullptr || p_length == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    try
+    {
+        std::vector<adapter_t *> adapterList;
+
+        if (!toAdapterList(adapters, adapter_count, adapterList))
+        {
+            return NRF_ERROR_INVALID_PARAM;
+        }
+
+        const auto text   = MetricsExporter::render(adapterList);
+        const auto length = static_cast<uint32_t>(text.size() + 1);
+
+        if (length > *p_length)
+        {
+            *p_length = length;
+            return NRF_ERROR_DATA_SIZE;
+        }
+
+        std::memcpy(p_buffer, text.c_str(), length);
+        *p_length = length;
+    }
+    catch (const std::bad_alloc &)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_rpc_metrics_file_start(adapter_t *const *adapters, uint32_t adapter_count,
+                                   const char *path, uint32_t interval_ms)
+{
+    if (path == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    try
+    {
+        std::vector<adapter_t *> adapterList;
+
+        if (!toAdapterList(adapters, adapter_count, adapterList))
+        {
+            return NRF_ERROR_INVALID_PARAM;
+        }
+
+        return MetricsExporter::global().start(adapterList, path,
+                                               std::chrono::milliseconds(interval_ms));
+    }
+    catch (const std::bad_alloc &)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+}
+
+uint32_t sd_rpc_metrics_file_stop(void)
+{
+    return MetricsExporter::global().stop();
+}
+
+uint32_t sd_rpc_trace_start(const char *path)
+{
+    if (path == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    try
+    {
+        return SpanTracer::global().start(path);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+}
+
+uint32_t sd_rpc_trace_stop(void)
+{
+    return SpanTracer::global().stop();
+}
+
+uint32_t sd_rpc_evt_queue_config_set(adapter_t *adapter, uint32_t capacity,
+                                     sd_rpc_evt_queue_overflow_t overflow_policy)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr || capacity == 0 ||
+        overflow_policy > SD_RPC_EVT_QUEUE_OVERFLOW_SPILL)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    return adapterLayer->transport->setEventQueueConfig(capacity, overflow_policy);
+}
+
+uint32_t sd_rpc_evt_batch_handler_set(adapter_t *adapter,
+                                      sd_rpc_evt_batch_handler_t batch_handler, uint32_t max_count,
+                                      uint32_t time_budget_us)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    return adapterLayer->eventBatchHandlerSet(batch_handler, max_count, time_budget_us);
+}
+
+uint32_t sd_rpc_evt_priority_set(adapter_t *adapter, uint16_t evt_id,
+                                 sd_rpc_evt_priority_t priority)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr || priority > SD_RPC_EVT_PRIORITY_HIGH)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    return adapterLayer->transport->setEventPriority(evt_id, priority);
+}
+
+uint32_t sd_rpc_evt_dispatch_set(adapter_t *adapter, sd_rpc_evt_dispatch_t dispatch)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr || dispatch > SD_RPC_EVT_DISPATCH_PULL)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    return adapterLayer->transport->setEventDispatch(dispatch);
+}
+
+uint32_t sd_rpc_evt_get(adapter_t *adapter, uint8_t *p_dest, uint16_t *p_len, uint32_t timeout_ms)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr || p_dest == nullptr || p_len == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    uint32_t length    = *p_len;
+    const auto errCode = adapterLayer->transport->getEvent(
+        reinterpret_cast<ble_evt_t *>(p_dest), length, std::chrono::milliseconds(timeout_ms));
+
+    if (errCode == NRF_SUCCESS || errCode == NRF_ERROR_DATA_SIZE)
+    {
+        *p_len = static_cast<uint16_t>(length);
+    }
+
+    return errCode;
+}
+
+uint32_t sd_rpc_evt_fd_get(adapter_t *adapter, int *p_fd)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr || p_fd == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    return adapterLayer->transport->getEventFd(*p_fd);
+}
+
+uint32_t sd_rpc_evt_filter_id_set(adapter_t *adapter, uint16_t evt_id, uint8_t discard)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    return adapterLayer->transport->eventFilter().setEventId(evt_id, discard != 0);
+}
+
+uint32_t sd_rpc_evt_filter_conn_handle_set(adapter_t *adapter, uint16_t conn_handle,
+                                           uint8_t discard)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    return adapterLayer->transport->eventFilter().setConnHandle(conn_handle, discard != 0);
+}
+
+uint32_t sd_rpc_evt_filter_adv_report_set(adapter_t *adapter, sd_rpc_adv_report_filter_t filter,
+                                          void *p_context)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    adapterLayer->transport->eventFilter().setAdvReportFilter(filter, p_context);
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_rpc_evt_retain(adapter_t *adapter, const ble_evt_t *p_ble_evt)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr || p_ble_evt == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    return adapterLayer->transport->retainEvent(p_ble_evt);
+}
+
+uint32_t sd_rpc_evt_release(adapter_t *adapter, const ble_evt_t *p_ble_evt)
+{
+    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr || p_ble_evt == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    return adapterLayer->transport->releaseEvent(p_ble_evt);
+}
+
+uint32_t sd_rpc_shared_io_thread_count_set(uint32_t thread_count)
+{
+    return UartTransport::setSharedIoThreadCount(thread_count);
+}
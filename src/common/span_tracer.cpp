@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "span_tracer.h"
+
+#include "nrf_error.h"
+
+#include <array>
+#include <iomanip>
+
+struct SpanTracer::ThreadRing
+{
+    std::array<Span, SpanRingCapacity> spans;
+
+    // Position of the next span to record and the next span to write
+    std::atomic<size_t> tail;
+    std::atomic<size_t> head;
+    uint32_t thread;
+};
+
+namespace {
+std::atomic<uint32_t> nextThreadIndex(0);
+
+// Timestamp in the microseconds of the Chrome trace format, keeping nanoseconds as decimals
+void writeMicroseconds(std::ostream &out, const int64_t nanoseconds)
+{
+    out << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000;
+}
+} // namespace
+
+std::atomic<bool> SpanTracer::tracing(false);
+
+SpanTracer::SpanTracer() noexcept
+    : droppedSpans(0)
+    , firstSpan(true)
+{}
+
+SpanTracer::~SpanTracer() noexcept
+{
+    stop();
+}
+
+SpanTracer &SpanTracer::global() noexcept
+{
+    static SpanTracer tracer;
+    return tracer;
+}
+
+Span SpanTracer::span(const char *name, const uint32_t adapter,
+                      const std::chrono::steady_clock::time_point start,
+                      const std::chrono::steady_clock::time_point end) noexcept
+{
+    Span span;
+    span.name     = name;
+    span.start    = timestamp(start);
+    span.duration = timestamp(end) - span.start;
+    span.adapter  = adapter;
+    span.tags     = 0;
+    return span;
+}
+
+SpanTracer::ThreadRing &SpanTracer::threadRing()
+{
+    thread_local std::shared_ptr<ThreadRing> ring;
+
+    if (!ring)
+    {
+        auto newRing = std::make_shared<ThreadRing>();
+        newRing->tail.store(0, std::memory_order_relaxed);
+        newRing->head.store(0, std::memory_order_relaxed);
+        newRing->thread = nextThreadIndex++;
+
+        {
+            std::lock_guard<std::mutex> ringsLock(ringsMutex);
+            rings.push_back(newRing);
+        }
+
+        ring = std::move(newRing);
+    }
+
+    return *ring;
+}
+
+void SpanTracer::record(Span &span) noexcept
+{
+    try
+    {
+        auto &ring      = threadRing();
+        const auto tail = ring.tail.load(std::memory_order_relaxed);
+
+        if (tail - ring.head.load(std::memory_order_acquire) == SpanRingCapacity)
+        {
+            droppedSpans.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        span.thread                         = ring.thread;
+        ring.spans[tail % SpanRingCapacity] = span;
+        ring.tail.store(tail + 1, std::memory_order_release);
+    }
+    catch (const std::bad_alloc &)
+    {
+        droppedSpans.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+uint64_t SpanTracer::dropped() const noexcept
+{
+    return droppedSpans.load(std::memory_order_relaxed);
+}
+
+uint32_t SpanTracer::start(const std::string &path) noexcept
+{
+    std::lock_guard<std::mutex> flushLock(flushMutex);
+
+    if (tracing)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    try
+    {
+        file.open(path, std::ios::binary | std::ios::trunc);
+
+        if (!file)
+        {
+            file.clear();
+            return NRF_ERROR_INVALID_PARAM;
+        }
+
+        // Spans recorded after the previous trace was stopped
+        {
+            std::lock_guard<std::mutex> ringsLock(ringsMutex);
+
+            for (const auto &ring : rings)
+            {
+                ring->head.store(ring->tail.load(std::memory_order_acquire),
+                                 std::memory_order_release);
+            }
+        }
+
+        file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        firstSpan = true;
+
+        tracing = true;
+        flusher = std::thread([this] { flushRunner(); });
+    }
+    catch (const std::exception &)
+    {
+        tracing = false;
+        file.close();
+        return NRF_ERROR_NO_MEM;
+    }
+
+    return NRF_SUCCESS;
+}
+
+uint32_t SpanTracer::stop() noexcept
+{
+    {
+        std::lock_guard<std::mutex> flushLock(flushMutex);
+
+        if (!tracing)
+        {
+            return NRF_ERROR_INVALID_STATE;
+        }
+
+        tracing = false;
+    }
+
+    flushStop.notify_all();
+
+    if (flusher.joinable())
+    {
+        flusher.join();
+    }
+
+    try
+    {
+        flush();
+        file << "\n],\"otherData\":{\"dropped_spans\":\"" << dropped() << "\"}}\n";
+    }
+    catch (const std::exception &)
+    {
+        // The trace file is incomplete, the spans written so far can still be read
+    }
+
+    file.close();
+    return NRF_SUCCESS;
+}
+
+void SpanTracer::flushRunner() noexcept
+{
+    std::unique_lock<std::mutex> flushLock(flushMutex);
+
+    while (!flushStop.wait_for(flushLock, SpanFlushInterval, [] { return !tracing; }))
+    {
+        try
+        {
+            flush();
+        }
+        catch (const std::exception &)
+        {
+            // Try again at the next interval
+        }
+    }
+}
+
+void SpanTracer::flush()
+{
+    std::lock_guard<std::mutex> ringsLock(ringsMutex);
+
+    for (auto ring = rings.begin(); ring != rings.end();)
+    {
+        auto &threadRing = **ring;
+        auto head        = threadRing.head.load(std::memory_order_relaxed);
+        const auto tail  = threadRing.tail.load(std::memory_order_acquire);
+
+        for (; head != tail; head++)
+        {
+            writeSpan(threadRing.spans[head % SpanRingCapacity]);
+        }
+
+        threadRing.head.store(head, std::memory_order_release);
+
+        // Only this list refers to the ring of an exited thread
+        if (ring->use_count() == 1)
+        {
+            ring = rings.erase(ring);
+        }
+        else
+        {
+            ++ring;
+        }
+    }
+
+    file.flush();
+}
+
+void SpanTracer::writeSpan(const Span &span)
+{
+    file << (firstSpan ? "\n" : ",\n");
+    firstSpan = false;
+
+    file << "{\"name\":\"" << span.name << "\",\"cat\":\"pc-ble-driver\",\"ph\":\"X\",\"pid\":1"
+         << ",\"tid\":" << span.thread << ",\"ts\":";
+    writeMicroseconds(file, span.start);
+    file << ",\"dur\":";
+    writeMicroseconds(file, span.duration);
+    file << ",\"args\":{\"adapter\":" << span.adapter;
+
+    if ((span.tags & SPAN_TAG_OPCODE) != 0)
+    {
+        file << ",\"opcode\":\"0x" << std::hex << std::setw(2) << std::setfill('0')
+             << +span.opcode << std::dec << '"';
+    }
+
+    if ((span.tags & SPAN_TAG_EVENT_ID) != 0)
+    {
+        file << ",\"event_id\":\"0x" << std::hex << std::setw(2) << std::setfill('0')
+             << span.eventId << std::dec << '"';
+    }
+
+    if ((span.tags & SPAN_TAG_SEQ_NUM) != 0)
+    {
+        file << ",\"seq_num\":" << +span.seqNum;
+    }
+
+    if ((span.tags & SPAN_TAG_ACK_NUM) != 0)
+    {
+        file << ",\"ack_num\":" << +span.ackNum;
+    }
+
+    file << "}}";
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "command_latencies.h"
+
+#include <new>
+
+CommandLatencies::CommandLatencies() noexcept
+{
+    for (auto &opcode : opcodes)
+    {
+        opcode.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+CommandLatencies::~CommandLatencies() noexcept
+{
+    for (auto &opcode : opcodes)
+    {
+        delete opcode.load(std::memory_order_relaxed);
+    }
+}
+
+void CommandLatencies::record(const uint8_t opcode, const sd_rpc_cmd_phase_t phase,
+                              const std::chrono::nanoseconds duration) noexcept
+{
+    if (phase >= SD_RPC_CMD_PHASE_COUNT)
+    {
+        return;
+    }
+
+    auto latencies = opcodes[opcode].load(std::memory_order_acquire);
+
+    if (latencies == nullptr)
+    {
+        const auto allocated = new (std::nothrow) OpcodeLatencies();
+
+        if (allocated == nullptr)
+        {
+            return;
+        }
+
+        // Another thread may record the first command with the opcode at the same time
+        if (opcodes[opcode].compare_exchange_strong(latencies, allocated, std::memory_order_acq_rel,
+                                                    std::memory_order_acquire))
+        {
+            latencies = allocated;
+        }
+        else
+        {
+            delete allocated;
+        }
+    }
+
+    (*latencies)[phase].record(duration);
+}
+
+const LatencyHistogram *CommandLatencies::histogram(const uint8_t opcode,
+                                                    const sd_rpc_cmd_phase_t phase) const noexcept
+{
+    if (phase >= SD_RPC_CMD_PHASE_COUNT)
+    {
+        return nullptr;
+    }
+
+    const auto latencies = opcodes[opcode].load(std::memory_order_acquire);
+    return latencies == nullptr ? nullptr : &(*latencies)[phase];
+}
+
+void CommandLatencies::reset() noexcept
+{
+    for (auto &opcode : opcodes)
+    {
+        const auto latencies = opcode.load(std::memory_order_acquire);
+
+        if (latencies == nullptr)
+        {
+            continue;
+        }
+
+        for (auto &histogram : *latencies)
+        {
+            histogram.reset();
+        }
+    }
+}
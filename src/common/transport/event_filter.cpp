@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "event_filter.h"
+
+#include "nrf_error.h"
+#include "serialized_event.h"
+
+constexpr size_t EventFilter::EventIdCount;
+constexpr size_t EventFilter::ConnHandleCount;
+
+EventFilter::EventFilter() noexcept
+    : discardedCount(0)
+    , advReportFilter(nullptr)
+    , advReportFilterContext(nullptr)
+    , advReportFilterSet(false)
+    , active(false)
+{
+    for (auto &discarded : discardedEventIds)
+    {
+        discarded = false;
+    }
+
+    for (auto &discarded : discardedConnHandles)
+    {
+        discarded = false;
+    }
+}
+
+uint32_t EventFilter::setEventId(const uint16_t eventId, const bool discard) noexcept
+{
+    if (eventId >= EventIdCount)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    std::lock_guard<std::mutex> lck(setMutex);
+
+    if (discardedEventIds[eventId].exchange(discard) != discard)
+    {
+        discard ? discardedCount++ : discardedCount--;
+    }
+
+    updateActive();
+    return NRF_SUCCESS;
+}
+
+uint32_t EventFilter::setConnHandle(const uint16_t connHandle, const bool discard) noexcept
+{
+    if (connHandle >= ConnHandleCount)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    std::lock_guard<std::mutex> lck(setMutex);
+
+    if (discardedConnHandles[connHandle].exchange(discard) != discard)
+    {
+        discard ? discardedCount++ : discardedCount--;
+    }
+
+    updateActive();
+    return NRF_SUCCESS;
+}
+
+void EventFilter::setAdvReportFilter(const sd_rpc_adv_report_filter_t filter,
+                                     void *context) noexcept
+{
+    std::lock_guard<std::mutex> lck(setMutex);
+
+    {
+        std::lock_guard<std::mutex> filterLck(advReportFilterMutex);
+        advReportFilter        = filter;
+        advReportFilterContext = context;
+    }
+
+    advReportFilterSet = filter != nullptr;
+    updateActive();
+}
+
+bool EventFilter::pass(const uint8_t *event, const size_t length) noexcept
+{
+    if (!active.load(std::memory_order_acquire))
+    {
+        return true;
+    }
+
+    const auto eventId = serialized_event_id(event, length);
+
+    if (eventId < EventIdCount && discardedEventIds[eventId].load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+
+    uint16_t connHandle;
+
+    if (serialized_event_conn_handle(event, length, &connHandle) && connHandle < ConnHandleCount &&
+        discardedConnHandles[connHandle].load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+
+    ble_gap_addr_t peerAddr;
+    int8_t rssi;
+
+    if (advReportFilterSet.load(std::memory_order_acquire) &&
+        serialized_adv_report_peer_addr(event, length, &peerAddr, &rssi))
+    {
+        std::lock_guard<std::mutex> lck(advReportFilterMutex);
+
+        if (advReportFilter != nullptr &&
+            advReportFilter(&peerAddr, rssi, advReportFilterContext) == 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void EventFilter::updateActive() noexcept
+{
+    active.store(discardedCount > 0 || advReportFilterSet, std::memory_order_release);
+}
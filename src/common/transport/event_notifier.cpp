@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "event_notifier.h"
+
+#include "nrf_error.h"
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+EventNotifier::EventNotifier() noexcept
+    : readFd(-1)
+    , writeFd(-1)
+    , notified(false)
+{}
+
+EventNotifier::~EventNotifier() noexcept
+{
+#if defined(__linux__) || defined(__APPLE__)
+    if (readFd >= 0)
+    {
+        close(readFd);
+    }
+
+    if (writeFd >= 0 && writeFd != readFd)
+    {
+        close(writeFd);
+    }
+#endif
+}
+
+uint32_t EventNotifier::open() noexcept
+{
+    if (readFd >= 0)
+    {
+        return NRF_SUCCESS;
+    }
+
+#if defined(__linux__)
+    readFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if (readFd < 0)
+    {
+        return NRF_ERROR_INTERNAL;
+    }
+
+    writeFd = readFd;
+#elif defined(__APPLE__)
+    int fds[2];
+
+    if (pipe(fds) != 0)
+    {
+        return NRF_ERROR_INTERNAL;
+    }
+
+    for (const auto fd : fds)
+    {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    readFd  = fds[0];
+    writeFd = fds[1];
+#endif
+
+    notified = false;
+    return NRF_SUCCESS;
+}
+
+int EventNotifier::fd() const noexcept
+{
+    return readFd;
+}
+
+void EventNotifier::notify() noexcept
+{
+    // The exchange pairs with the one in clear, a notification is not lost between the check for
+    // events and clear
+    if (writeFd < 0 || notified.exchange(true))
+    {
+        return;
+    }
+
+#if defined(__linux__) || defined(__APPLE__)
+    // An eventfd takes an 8 byte counter, one byte is enough for a pipe
+    const uint64_t value = 1;
+    const auto length    = readFd == writeFd ? sizeof(value) : 1;
+
+    if (write(writeFd, &value, length) < 0)
+    {
+        return;
+    }
+#endif
+}
+
+void EventNotifier::clear() noexcept
+{
+    if (readFd < 0 || !notified.exchange(false))
+    {
+        return;
+    }
+
+#if defined(__linux__) || defined(__APPLE__)
+    uint64_t value;
+
+    if (read(readFd, &value, sizeof(value)) < 0)
+    {
+        return;
+    }
+#endif
+}
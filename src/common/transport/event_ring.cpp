@@ -0,0 +1,484 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "event_ring.h"
+
+#include <thread>
+
+namespace {
+// Number of times a waiting thread checks the ring before it parks
+constexpr int SpinCount = 100;
+
+size_t roundUpToPowerOfTwo(const size_t value)
+{
+    size_t result = 1;
+
+    while (result < value)
+    {
+        result <<= 1;
+    }
+
+    return result;
+}
+} // namespace
+
+constexpr uint32_t EventRing::Unordered;
+
+EventRing::EventRing(const size_t capacity, const size_t laneCount, const size_t reserve)
+    : maximumSize(capacity)
+    , reserveSize(reserve)
+    , lanesInRing(laneCount)
+    , slotCount(roundUpToPowerOfTwo(2 * (capacity + reserve)))
+    , mask(slotCount - 1)
+    , lanes(new Lane[laneCount])
+    , pushLane(0)
+    , nextSequenceNumber(0)
+    , popSlot(nullptr)
+    , popLane(0)
+    , highWater(0)
+    , stopped(false)
+    , parked(0)
+{
+    for (size_t laneIndex = 0; laneIndex < lanesInRing; laneIndex++)
+    {
+        auto &lane = lanes[laneIndex];
+        lane.slots.reset(new Slot[slotCount]);
+        lane.head   = 0;
+        lane.tail   = 0;
+        lane.queued = 0;
+
+        for (size_t i = 0; i < slotCount; i++)
+        {
+            lane.slots[i].state = SlotDropped;
+        }
+    }
+}
+
+std::vector<uint8_t> *EventRing::beginPush(const size_t lane, const bool useReserve) noexcept
+{
+    const auto limit = useReserve ? maximumSize + reserveSize : maximumSize;
+
+    if (!wait([&] { return !full(lane, limit); }))
+    {
+        return nullptr;
+    }
+
+    pushLane = lane;
+
+    auto &queue = lanes[lane];
+    return &queue.slots[queue.tail.load(std::memory_order_relaxed) & mask].data;
+}
+
+std::vector<uint8_t> *EventRing::tryBeginPush(const size_t lane, const bool useReserve) noexcept
+{
+    if (full(lane, useReserve ? maximumSize + reserveSize : maximumSize))
+    {
+        return nullptr;
+    }
+
+    pushLane = lane;
+
+    auto &queue = lanes[lane];
+    return &queue.slots[queue.tail.load(std::memory_order_relaxed) & mask].data;
+}
+
+void EventRing::endPush(const uint32_t orderingKey, const uint8_t flags) noexcept
+{
+    auto &lane          = lanes[pushLane];
+    const auto position = lane.tail.load(std::memory_order_relaxed);
+    auto &slot          = lane.slots[position & mask];
+
+    slot.sequenceNumber = nextSequenceNumber++;
+    slot.orderingKey    = orderingKey;
+    slot.flags          = flags;
+    slot.state.store(SlotQueued, std::memory_order_relaxed);
+
+    lane.queued.fetch_add(1);
+
+    // Only the producer writes highWater
+    const auto depth = size();
+
+    if (depth > highWater.load(std::memory_order_relaxed))
+    {
+        highWater.store(depth, std::memory_order_relaxed);
+    }
+
+    lane.tail.store(position + 1, std::memory_order_seq_cst);
+    wake();
+}
+
+bool EventRing::full(const size_t lane) const noexcept
+{
+    return full(lane, maximumSize);
+}
+
+bool EventRing::full(const size_t lane, const size_t limit) const noexcept
+{
+    const auto &queue = lanes[lane];
+
+    return queue.queued.load(std::memory_order_seq_cst) >= limit ||
+           queue.tail.load(std::memory_order_relaxed) -
+                   queue.head.load(std::memory_order_seq_cst) >=
+               slotCount;
+}
+
+std::vector<uint8_t> *EventRing::beginPop(size_t *lane) noexcept
+{
+    return pop(lane, TimePoint::max());
+}
+
+std::vector<uint8_t> *EventRing::tryBeginPop(size_t *lane) noexcept
+{
+    return pop(lane, TimePoint::min());
+}
+
+std::vector<uint8_t> *EventRing::beginPopUntil(const TimePoint deadline, size_t *lane) noexcept
+{
+    return pop(lane, deadline);
+}
+
+std::vector<uint8_t> *EventRing::pop(size_t *lane, const TimePoint deadline) noexcept
+{
+    for (;;)
+    {
+        if (deadline == TimePoint::min() ? (stopped || empty())
+                                         : !wait([&] { return !empty(); }, deadline))
+        {
+            return nullptr;
+        }
+
+        Slot *slot      = nullptr;
+        size_t slotLane = 0;
+        auto retry      = false;
+
+        // Lanes with lower indexes first
+        for (; slotLane < lanesInRing && !retry; slotLane++)
+        {
+            slot = front(slotLane, retry);
+
+            if (slot != nullptr)
+            {
+                break;
+            }
+        }
+
+        if (slot != nullptr)
+        {
+            auto olderLane   = slotLane;
+            const auto older = olderWithSameKey(slotLane, *slot, olderLane, retry);
+
+            if (older != nullptr)
+            {
+                slot     = older;
+                slotLane = olderLane;
+            }
+        }
+
+        auto expected = static_cast<uint8_t>(SlotQueued);
+
+        // The producer may have dropped the event or started to rewrite it meanwhile
+        if (slot != nullptr && !retry && slot->state.compare_exchange_strong(expected, SlotBusy))
+        {
+            popSlot = slot;
+            popLane = slotLane;
+
+            if (lane != nullptr)
+            {
+                *lane = slotLane;
+            }
+
+            return &slot->data;
+        }
+
+        std::this_thread::yield();
+    }
+}
+
+uint8_t EventRing::flags() const noexcept
+{
+    return popSlot->flags;
+}
+
+void EventRing::endPop() noexcept
+{
+    auto &lane          = lanes[popLane];
+    const auto position = lane.head.load(std::memory_order_relaxed);
+
+    lane.queued.fetch_sub(1);
+
+    if (popSlot == &lane.slots[position & mask])
+    {
+        // Pass the slots of events taken out of order or dropped behind the event as well
+        auto next       = position + 1;
+        const auto last = lane.tail.load(std::memory_order_acquire);
+
+        while (next != last &&
+               lane.slots[next & mask].state.load(std::memory_order_acquire) == SlotDropped)
+        {
+            next++;
+        }
+
+        lane.head.store(next, std::memory_order_seq_cst);
+    }
+    else
+    {
+        // Taken before older events of the lane, the slot is passed when it reaches the head
+        popSlot->state.store(SlotDropped, std::memory_order_release);
+    }
+
+    popSlot = nullptr;
+    wake();
+}
+
+EventRing::Slot *EventRing::front(const size_t laneIndex, bool &retry) noexcept
+{
+    auto &lane    = lanes[laneIndex];
+    auto position = lane.head.load(std::memory_order_relaxed);
+
+    while (lane.tail.load(std::memory_order_seq_cst) != position)
+    {
+        auto &slot       = lane.slots[position & mask];
+        const auto state = slot.state.load(std::memory_order_acquire);
+
+        if (state == SlotQueued)
+        {
+            return &slot;
+        }
+
+        if (state == SlotBusy)
+        {
+            // Being rewritten by the producer
+            retry = true;
+            return nullptr;
+        }
+
+        // Give the dropped slot back to the producer
+        lane.head.store(++position, std::memory_order_seq_cst);
+        wake();
+    }
+
+    return nullptr;
+}
+
+EventRing::Slot *EventRing::olderWithSameKey(const size_t laneIndex, const Slot &slot,
+                                             size_t &olderLane, bool &retry) noexcept
+{
+    if (slot.orderingKey == Unordered)
+    {
+        return nullptr;
+    }
+
+    Slot *oldest = nullptr;
+
+    for (auto other = laneIndex + 1; other < lanesInRing; other++)
+    {
+        auto &lane       = lanes[other];
+        const auto first = lane.head.load(std::memory_order_relaxed);
+        const auto last  = lane.tail.load(std::memory_order_acquire);
+
+        for (auto position = first; position != last; position++)
+        {
+            auto &candidate = lane.slots[position & mask];
+
+            // The events of a lane are in the order they are pushed
+            if (candidate.sequenceNumber > slot.sequenceNumber ||
+                (oldest != nullptr && candidate.sequenceNumber > oldest->sequenceNumber))
+            {
+                break;
+            }
+
+            if (candidate.orderingKey != slot.orderingKey)
+            {
+                continue;
+            }
+
+            const auto state = candidate.state.load(std::memory_order_acquire);
+
+            if (state == SlotBusy)
+            {
+                retry = true;
+                return nullptr;
+            }
+
+            if (state == SlotQueued)
+            {
+                oldest    = &candidate;
+                olderLane = other;
+                break;
+            }
+        }
+    }
+
+    return oldest;
+}
+
+void EventRing::clear() noexcept
+{
+    for (size_t laneIndex = 0; laneIndex < lanesInRing; laneIndex++)
+    {
+        auto &lane      = lanes[laneIndex];
+        const auto last = lane.tail.load(std::memory_order_acquire);
+        auto position   = lane.head.load(std::memory_order_relaxed);
+
+        while (position != last)
+        {
+            auto &slot    = lane.slots[position & mask];
+            auto expected = static_cast<uint8_t>(SlotQueued);
+
+            if (slot.state.compare_exchange_strong(expected, SlotBusy))
+            {
+                lane.queued.fetch_sub(1);
+            }
+            else if (expected == SlotBusy)
+            {
+                // Being rewritten by the producer
+                std::this_thread::yield();
+                continue;
+            }
+
+            lane.head.store(++position, std::memory_order_seq_cst);
+        }
+    }
+
+    wake();
+}
+
+void EventRing::stop() noexcept
+{
+    std::lock_guard<std::mutex> lck(parkMutex);
+    stopped = true;
+    parkCondition.notify_all();
+}
+
+void EventRing::start() noexcept
+{
+    stopped = false;
+}
+
+size_t EventRing::capacity() const noexcept
+{
+    return maximumSize;
+}
+
+size_t EventRing::reserve() const noexcept
+{
+    return reserveSize;
+}
+
+size_t EventRing::laneCount() const noexcept
+{
+    return lanesInRing;
+}
+
+size_t EventRing::size() const noexcept
+{
+    size_t depth = 0;
+
+    for (size_t laneIndex = 0; laneIndex < lanesInRing; laneIndex++)
+    {
+        depth += lanes[laneIndex].queued.load(std::memory_order_relaxed);
+    }
+
+    return depth;
+}
+
+size_t EventRing::highWaterMark() const noexcept
+{
+    return highWater.load(std::memory_order_relaxed);
+}
+
+bool EventRing::empty() const noexcept
+{
+    for (size_t laneIndex = 0; laneIndex < lanesInRing; laneIndex++)
+    {
+        const auto &lane = lanes[laneIndex];
+
+        if (lane.tail.load(std::memory_order_seq_cst) !=
+            lane.head.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename Predicate>
+bool EventRing::wait(const Predicate &ready, const TimePoint deadline) noexcept
+{
+    for (auto i = 0; i < SpinCount; i++)
+    {
+        if (ready())
+        {
+            return true;
+        }
+
+        if (stopped)
+        {
+            return false;
+        }
+
+        std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lck(parkMutex);
+
+    // The other side checks parked after updating its index. Announcing the wait before checking
+    // the index again means either this thread sees the update or the other side sees parked.
+    parked.fetch_add(1, std::memory_order_seq_cst);
+
+    if (deadline == TimePoint::max())
+    {
+        parkCondition.wait(lck, [&] { return ready() || stopped; });
+    }
+    else
+    {
+        parkCondition.wait_until(lck, deadline, [&] { return ready() || stopped; });
+    }
+
+    parked.fetch_sub(1, std::memory_order_relaxed);
+
+    return !stopped && ready();
+}
+
+void EventRing::wake() noexcept
+{
+    if (parked.load(std::memory_order_seq_cst) > 0)
+    {
+        std::lock_guard<std::mutex> lck(parkMutex);
+        parkCondition.notify_all();
+    }
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "event_slab_pool.h"
+
+#include "nrf_error.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+size_t roundUpToAlignment(const size_t size)
+{
+    constexpr auto alignment = sizeof(std::max_align_t);
+    return (size + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+EventSlabPool::EventSlabPool(const size_t slabCount, const size_t slabSize)
+    : size(roundUpToAlignment(slabSize))
+    , storage(new std::max_align_t[slabCount * size / sizeof(std::max_align_t)])
+    , states(slabCount, SlabState{0, false, false})
+    , retainedCount(0)
+{
+    std::memset(storage.get(), 0, slabCount * size);
+    freeSlabs.reserve(slabCount);
+
+    // Slabs are handed out from the back, start with the first slab
+    for (auto i = slabCount; i > 0; i--)
+    {
+        freeSlabs.push_back(i - 1);
+    }
+}
+
+size_t EventSlabPool::slabSize() const noexcept
+{
+    return size;
+}
+
+size_t EventSlabPool::slabCount() const noexcept
+{
+    return states.size();
+}
+
+uint8_t *EventSlabPool::take() noexcept
+{
+    size_t index;
+
+    {
+        std::lock_guard<std::mutex> lck(mutex);
+
+        if (freeSlabs.empty())
+        {
+            return nullptr;
+        }
+
+        index = freeSlabs.back();
+        freeSlabs.pop_back();
+        states[index].taken = true;
+    }
+
+    // The slab is owned by the caller from here, clear it outside the lock
+    const auto slab = reinterpret_cast<uint8_t *>(storage.get()) + index * size;
+    std::memset(slab, 0, states[index].dirtyLength);
+    states[index].dirtyLength = 0;
+
+    return slab;
+}
+
+void EventSlabPool::put(uint8_t *slab, const size_t writtenLength) noexcept
+{
+    const auto index = indexOf(slab);
+
+    if (index < 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lck(mutex);
+
+    auto &state       = states[index];
+    state.dirtyLength = std::min(writtenLength, size);
+    state.taken       = false;
+
+    if (!state.retained)
+    {
+        freeSlabs.push_back(static_cast<size_t>(index));
+    }
+}
+
+uint32_t EventSlabPool::retain(const void *data) noexcept
+{
+    const auto index = indexOf(data);
+
+    if (index < 0)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    std::lock_guard<std::mutex> lck(mutex);
+
+    auto &state = states[index];
+
+    // Only the event currently being processed can be retained
+    if (!state.taken || state.retained)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    // Keep a slab for the next event
+    if (freeSlabs.empty())
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    state.retained = true;
+    retainedCount++;
+
+    return NRF_SUCCESS;
+}
+
+uint32_t EventSlabPool::release(const void *data) noexcept
+{
+    const auto index = indexOf(data);
+
+    if (index < 0)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    std::lock_guard<std::mutex> lck(mutex);
+
+    auto &state = states[index];
+
+    if (!state.retained)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    state.retained = false;
+    retainedCount--;
+
+    // Released from the event callback, the slab is returned by put
+    if (!state.taken)
+    {
+        freeSlabs.push_back(static_cast<size_t>(index));
+    }
+
+    return NRF_SUCCESS;
+}
+
+size_t EventSlabPool::retained() const noexcept
+{
+    std::lock_guard<std::mutex> lck(mutex);
+    return retainedCount;
+}
+
+ptrdiff_t EventSlabPool::indexOf(const void *data) const noexcept
+{
+    const auto start  = reinterpret_cast<uintptr_t>(storage.get());
+    const auto offset = reinterpret_cast<uintptr_t>(data) - start;
+
+    if (reinterpret_cast<uintptr_t>(data) < start || offset % size != 0 ||
+        offset / size >= states.size())
+    {
+        return -1;
+    }
+
+    return static_cast<ptrdiff_t>(offset / size);
+}
@@ -38,7 +38,7 @@
 #include "h5.h"
 #include "nrf_error.h"
 #include "sd_rpc_types.h"
-#include <algorithm>
+#include <cstddef>
 #include <vector>
 
 const uint8_t seqNumMask         = 0x07;
@@ -54,7 +54,7 @@ const uint16_t payloadLengthFirstNibbleMask  = 0x000F;
 const uint16_t payloadLengthSecondNibbleMask = 0x0FF0;
 const uint8_t payloadLengthOffset            = 4;
 
-uint8_t calculate_header_checksum(const std::vector<uint8_t> &header)
+uint8_t calculate_header_checksum(const uint8_t *header)
 {
     uint16_t checksum = header[0];
     checksum += header[1];
@@ -65,86 +65,175 @@ uint8_t calculate_header_checksum(const std::vector<uint8_t> &header)
     return static_cast<uint8_t>(checksum);
 }
 
-uint16_t calculate_crc16_checksum(const std::vector<uint8_t>::const_iterator &start,
-                                  const std::vector<uint8_t>::const_iterator &end)
+namespace {
+// CRC-CCITT polynomial (x^16 + x^12 + x^5 + 1), processed most significant bit first
+constexpr uint16_t crc16Polynomial = 0x1021;
+constexpr size_t crc16SliceCount   = 8;
+
+/**
+ * @brief Lookup tables for slice-by-8 CRC16 calculation.
+ *
+ * table[0][n] is the CRC register after shifting in byte n from a zero register,
+ * table[k][n] is the same register after shifting in k zero bytes more. Eight input bytes can then
+ * be folded into the register with one lookup per byte.
+ */
+struct Crc16Tables
+{
+    uint16_t table[crc16SliceCount][256];
+
+    constexpr Crc16Tables()
+        : table()
+    {
+        for (uint16_t n = 0; n < 256; n++)
+        {
+            uint16_t crc = static_cast<uint16_t>(n << 8);
+
+            for (auto bit = 0; bit < 8; bit++)
+            {
+                crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ crc16Polynomial
+                                                           : (crc << 1));
+            }
+
+            table[0][n] = crc;
+        }
+
+        for (size_t slice = 1; slice < crc16SliceCount; slice++)
+        {
+            for (size_t n = 0; n < 256; n++)
+            {
+                const auto previous = table[slice - 1][n];
+                table[slice][n] =
+                    static_cast<uint16_t>((previous << 8) ^ table[0][previous >> 8]);
+            }
+        }
+    }
+};
+
+constexpr Crc16Tables crc16Tables;
+} // namespace
+
+uint16_t calculate_crc16_checksum(const uint8_t *start, const uint8_t *end, uint16_t crc)
 {
-    uint16_t crc = 0xFFFF;
+    const auto &table = crc16Tables.table;
 
-    std::for_each(start, end, [&crc](const uint8_t data) {
-        crc = (crc >> 8) | (crc << 8);
-        crc ^= data;
-        crc ^= (crc & 0xFF) >> 4;
-        crc ^= crc << 12;
-        crc ^= (crc & 0xFF) << 5;
-    });
+    while (end - start >= static_cast<ptrdiff_t>(crc16SliceCount))
+    {
+        crc = table[7][start[0] ^ (crc >> 8)] ^ table[6][start[1] ^ (crc & 0xFF)] ^
+              table[5][start[2]] ^ table[4][start[3]] ^ table[3][start[4]] ^ table[2][start[5]] ^
+              table[1][start[6]] ^ table[0][start[7]];
+        start += crc16SliceCount;
+    }
+
+    while (start != end)
+    {
+        crc = static_cast<uint16_t>((crc << 8) ^ table[0][*start++ ^ (crc >> 8)]);
+    }
 
     return crc;
 }
 
-void add_h5_header(std::vector<uint8_t> &out_packet, const uint8_t seq_num, const uint8_t ack_num,
-                   const bool crc_present, const bool reliable_packet, const uint8_t packet_type,
-                   const uint16_t payload_length)
+void write_h5_header(uint8_t *header, const uint8_t seq_num, const uint8_t ack_num,
+                     const bool crc_present, const bool reliable_packet, const uint8_t packet_type,
+                     const uint16_t payload_length)
 {
-    out_packet.push_back((seq_num & seqNumMask) | ((ack_num & ackNumMask) << ackNumPos) |
-                         ((crc_present & crcPresentMask) << crcPresentPos) |
-                         ((reliable_packet & reliablePacketMask) << reliablePacketPos));
+    header[0] = (seq_num & seqNumMask) | ((ack_num & ackNumMask) << ackNumPos) |
+                ((crc_present & crcPresentMask) << crcPresentPos) |
+                ((reliable_packet & reliablePacketMask) << reliablePacketPos);
 
-    out_packet.push_back((packet_type & packetTypeMask) |
-                         ((payload_length & payloadLengthFirstNibbleMask) << payloadLengthOffset));
+    header[1] = (packet_type & packetTypeMask) |
+                ((payload_length & payloadLengthFirstNibbleMask) << payloadLengthOffset);
 
-    out_packet.push_back((payload_length & payloadLengthSecondNibbleMask) >> payloadLengthOffset);
-    out_packet.push_back(calculate_header_checksum(out_packet));
+    header[2] = (payload_length & payloadLengthSecondNibbleMask) >> payloadLengthOffset;
+    header[3] = calculate_header_checksum(header);
 }
 
-void add_crc16(std::vector<uint8_t> &out_packet)
+void write_crc16(uint8_t *crc, const uint8_t *start, const uint8_t *end)
 {
-    const auto crc16 = calculate_crc16_checksum(out_packet.begin(), out_packet.end());
-    out_packet.push_back(crc16 & 0xFF);
-    out_packet.push_back((crc16 >> 8) & 0xFF);
+    const auto crc16 = calculate_crc16_checksum(start, end);
+    crc[0]           = crc16 & 0xFF;
+    crc[1]           = (crc16 >> 8) & 0xFF;
 }
 
 void h5_encode(const std::vector<uint8_t> &in_packet, std::vector<uint8_t> &out_packet,
                const uint8_t seq_num, const uint8_t ack_num, const bool crc_present,
                const bool reliable_packet, const h5_pkt_type_t packet_type)
 {
-    add_h5_header(out_packet, seq_num, ack_num, crc_present, reliable_packet, packet_type,
-                  static_cast<uint16_t>(in_packet.size()));
+    const auto start = out_packet.size();
+    out_packet.resize(start + H5_HEADER_LENGTH);
+
+    write_h5_header(out_packet.data() + start, seq_num, ack_num, crc_present, reliable_packet,
+                    packet_type, static_cast<uint16_t>(in_packet.size()));
 
     out_packet.insert(out_packet.end(), in_packet.begin(), in_packet.end());
 
     // Add CRC
     if (crc_present)
     {
-        add_crc16(out_packet);
+        const auto end = out_packet.size();
+        out_packet.resize(end + 2);
+        write_crc16(out_packet.data() + end, out_packet.data() + start, out_packet.data() + end);
     }
 }
 
-uint32_t h5_decode(const std::vector<uint8_t> &slipPayload, std::vector<uint8_t> &h5Payload,
-                   uint8_t *seq_num, uint8_t *ack_num, bool *_data_integrity,
-                   uint16_t *_payload_length, uint8_t *_header_checksum, bool *reliable_packet,
-                   h5_pkt_type_t *packet_type)
+void h5_encode(TxBuffer &packet, const uint8_t seq_num, const uint8_t ack_num,
+               const bool crc_present, const bool reliable_packet,
+               const h5_pkt_type_t packet_type)
 {
-    if (slipPayload.size() < 4)
+    const auto payload_length = static_cast<uint16_t>(packet.size());
+    const auto header         = packet.prepend(H5_HEADER_LENGTH);
+
+    write_h5_header(header, seq_num, ack_num, crc_present, reliable_packet, packet_type,
+                    payload_length);
+
+    // Add CRC
+    if (crc_present)
     {
-        return NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_PAYLOAD_SIZE;
+        const auto end = packet.data() + packet.size();
+        write_crc16(packet.append(2), packet.data(), end);
     }
+}
 
-    *seq_num = slipPayload[0] & seqNumMask;
-    *ack_num = (slipPayload[0] >> ackNumPos) & ackNumMask;
-    const auto crc_present =
-        static_cast<bool>(((slipPayload[0] >> crcPresentPos) & crcPresentMask) != 0);
+void h5_decode_header(const uint8_t *header, uint8_t *seq_num, uint8_t *ack_num,
+                      bool *crc_present, bool *reliable_packet, h5_pkt_type_t *packet_type,
+                      uint16_t *payload_length)
+{
+    *seq_num     = header[0] & seqNumMask;
+    *ack_num     = (header[0] >> ackNumPos) & ackNumMask;
+    *crc_present = static_cast<bool>(((header[0] >> crcPresentPos) & crcPresentMask) != 0);
     *reliable_packet =
-        static_cast<bool>(((slipPayload[0] >> reliablePacketPos) & reliablePacketMask) != 0);
-    *packet_type = static_cast<h5_pkt_type_t>(slipPayload[1] & packetTypeMask);
-    const uint16_t payload_length =
-        ((slipPayload[1] >> payloadLengthOffset) & payloadLengthFirstNibbleMask) +
-        (static_cast<uint16_t>(slipPayload[2]) << payloadLengthOffset);
+        static_cast<bool>(((header[0] >> reliablePacketPos) & reliablePacketMask) != 0);
+    *packet_type    = static_cast<h5_pkt_type_t>(header[1] & packetTypeMask);
+    *payload_length = ((header[1] >> payloadLengthOffset) & payloadLengthFirstNibbleMask) +
+                      (static_cast<uint16_t>(header[2]) << payloadLengthOffset);
+}
+
+bool h5_header_checksum_valid(const uint8_t *header)
+{
+    return header[3] == calculate_header_checksum(header);
+}
+
+uint32_t h5_decode(const uint8_t *slipPayload, const size_t slipPayloadLength,
+                   const uint8_t **h5Payload, uint8_t *seq_num, uint8_t *ack_num,
+                   bool *_data_integrity, uint16_t *_payload_length, uint8_t *_header_checksum,
+                   bool *reliable_packet, h5_pkt_type_t *packet_type)
+{
+    if (slipPayloadLength < 4)
+    {
+        return NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_PAYLOAD_SIZE;
+    }
+
+    bool crc_present;
+    uint16_t payload_length;
+
+    h5_decode_header(slipPayload, seq_num, ack_num, &crc_present, reliable_packet, packet_type,
+                     &payload_length);
+
     const auto header_checksum = slipPayload[3];
 
     // Check if received packet size matches the packet size stated in header
     const auto calculatedPayloadSize = payload_length + H5_HEADER_LENGTH + (crc_present ? 2 : 0);
 
-    if (slipPayload.size() != calculatedPayloadSize)
+    if (slipPayloadLength != calculatedPayloadSize)
     {
         return NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_CALCULATED_PAYLOAD_SIZE;
     }
@@ -156,9 +245,7 @@ uint32_t h5_decode(const std::vector<uint8_t> &slipPayload, std::vector<uint8_t>
     if (_header_checksum != nullptr)
         *_header_checksum = header_checksum;
 
-    const auto calculated_header_checksum = calculate_header_checksum(slipPayload);
-
-    if (header_checksum != calculated_header_checksum)
+    if (!h5_header_checksum_valid(slipPayload))
     {
         return NRF_ERROR_SD_RPC_H5_TRANSPORT_HEADER_CHECKSUM;
     }
@@ -167,8 +254,8 @@ uint32_t h5_decode(const std::vector<uint8_t> &slipPayload, std::vector<uint8_t>
     {
         const uint16_t packet_checksum = slipPayload[payload_length + H5_HEADER_LENGTH] +
                                          (slipPayload[payload_length + H5_HEADER_LENGTH + 1] << 8);
-        const auto calculated_packet_checksum = calculate_crc16_checksum(
-            slipPayload.begin(), slipPayload.begin() + payload_length + H5_HEADER_LENGTH);
+        const auto calculated_packet_checksum =
+            calculate_crc16_checksum(slipPayload, slipPayload + payload_length + H5_HEADER_LENGTH);
 
         if (packet_checksum != calculated_packet_checksum)
         {
@@ -176,10 +263,35 @@ uint32_t h5_decode(const std::vector<uint8_t> &slipPayload, std::vector<uint8_t>
         }
     }
 
+    // Payload is not copied, it refers to the decoded packet
+    *h5Payload = slipPayload + H5_HEADER_LENGTH;
+
+    return NRF_SUCCESS;
+}
+
+uint32_t h5_decode(const std::vector<uint8_t> &slipPayload, std::vector<uint8_t> &h5Payload,
+                   uint8_t *seq_num, uint8_t *ack_num, bool *_data_integrity,
+                   uint16_t *_payload_length, uint8_t *_header_checksum, bool *reliable_packet,
+                   h5_pkt_type_t *packet_type)
+{
+    const uint8_t *payload  = nullptr;
+    uint16_t payload_length = 0;
+
+    const auto err_code =
+        h5_decode(slipPayload.data(), slipPayload.size(), &payload, seq_num, ack_num,
+                  _data_integrity, &payload_length, _header_checksum, reliable_packet, packet_type);
+
+    if (_payload_length != nullptr)
+        *_payload_length = payload_length;
+
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
     if (payload_length > 0)
     {
-        const auto payloadIterator = slipPayload.begin() + 4;
-        h5Payload.insert(h5Payload.begin(), payloadIterator, payloadIterator + payload_length);
+        h5Payload.insert(h5Payload.begin(), payload, payload + payload_length);
     }
 
     return NRF_SUCCESS;
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "h5_stream_decoder.h"
+
+#include "nrf_error.h"
+#include "sd_rpc_types.h"
+
+#include <algorithm>
+
+namespace {
+constexpr uint8_t SLIP_END     = 0xC0;
+constexpr uint8_t SLIP_ESC     = 0xDB;
+constexpr uint8_t SLIP_ESC_END = 0xDC;
+constexpr uint8_t SLIP_ESC_ESC = 0xDD;
+} // namespace
+
+H5StreamDecoder::H5StreamDecoder(const h5_frame_cb_t &frameCallback)
+    : frameCallback(frameCallback)
+    , state(STATE_WAIT_START)
+    , oversized(false)
+    , header()
+    , headerDecoded(false)
+    , headerChecksumValid(false)
+    , crc(H5_CRC16_INITIAL_VALUE)
+    , crcLength(0)
+{
+    frame.reserve(H5_MAX_PACKET_LENGTH);
+}
+
+void H5StreamDecoder::reset()
+{
+    state         = STATE_WAIT_START;
+    oversized     = false;
+    headerDecoded = false;
+    crc           = H5_CRC16_INITIAL_VALUE;
+    crcLength     = 0;
+    frame.clear();
+}
+
+void H5StreamDecoder::decode(const uint8_t *data, const size_t length)
+{
+    const auto end = data + length;
+    auto current   = data;
+
+    while (current != end)
+    {
+        switch (state)
+        {
+            case STATE_WAIT_START:
+                // Data before the start of packet is irrelevant
+                current = std::find(current, end, SLIP_END);
+
+                if (current != end)
+                {
+                    ++current;
+                    state = STATE_PACKET;
+                }
+                break;
+
+            case STATE_PACKET:
+            {
+                // Copy bytes up to the next byte with special meaning in one operation
+                const auto special = std::find_if(current, end, [](const uint8_t byte) {
+                    return byte == SLIP_END || byte == SLIP_ESC;
+                });
+
+                append(current, special);
+                current = special;
+
+                if (current == end)
+                {
+                    break;
+                }
+
+                if (*current++ == SLIP_ESC)
+                {
+                    state = STATE_ESCAPE;
+                }
+                else if (!frame.empty())
+                {
+                    emitFrame(NRF_SUCCESS);
+                }
+
+                // Two 0xC0 after another is assumed to be the beginning of a new packet, and
+                // not the end, stay in STATE_PACKET
+                break;
+            }
+
+            case STATE_ESCAPE:
+            {
+                const auto byte = *current++;
+
+                if (byte == SLIP_ESC_END || byte == SLIP_ESC_ESC)
+                {
+                    const uint8_t unescaped = byte == SLIP_ESC_END ? SLIP_END : SLIP_ESC;
+                    append(&unescaped, &unescaped + 1);
+                    state = STATE_PACKET;
+                }
+                else if (byte == SLIP_END)
+                {
+                    emitFrame(NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_DECODING);
+                }
+                else
+                {
+                    state = STATE_DISCARD;
+                }
+                break;
+            }
+
+            case STATE_DISCARD:
+                current = std::find(current, end, SLIP_END);
+
+                if (current != end)
+                {
+                    ++current;
+                    emitFrame(NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_DECODING);
+                }
+                break;
+        }
+    }
+
+    updateCrc();
+}
+
+void H5StreamDecoder::append(const uint8_t *start, const uint8_t *end)
+{
+    // A packet longer than the H5 maximum can not be valid, keep only what is needed to report it
+    const auto available = H5_MAX_PACKET_LENGTH + 1 - frame.size();
+    const auto length    = static_cast<size_t>(end - start);
+
+    if (length > available)
+    {
+        end       = start + available;
+        oversized = true;
+    }
+
+    frame.insert(frame.end(), start, end);
+
+    if (!headerDecoded && frame.size() >= H5_HEADER_LENGTH)
+    {
+        h5_decode_header(frame.data(), &header.seqNum, &header.ackNum, &header.crcPresent,
+                         &header.reliable, &header.type, &header.payloadLength);
+        headerChecksumValid = h5_header_checksum_valid(frame.data());
+        headerDecoded       = true;
+    }
+}
+
+void H5StreamDecoder::updateCrc()
+{
+    // The CRC covers the header and the payload, not the CRC itself
+    auto crcEnd = frame.size();
+
+    if (headerDecoded)
+    {
+        if (!header.crcPresent || !headerChecksumValid)
+        {
+            return;
+        }
+
+        crcEnd = std::min(crcEnd, static_cast<size_t>(H5_HEADER_LENGTH + header.payloadLength));
+    }
+
+    if (crcEnd > crcLength)
+    {
+        crc       = calculate_crc16_checksum(frame.data() + crcLength, frame.data() + crcEnd, crc);
+        crcLength = crcEnd;
+    }
+}
+
+void H5StreamDecoder::emitFrame(const uint32_t slipErrorCode)
+{
+    // Header fields are only available if the header has been received
+    auto decoded        = headerDecoded ? header : H5Frame();
+    decoded.payload     = nullptr;
+    decoded.slipPayload = &frame;
+
+    // Validation is done in the same order as h5_decode
+    if (slipErrorCode != NRF_SUCCESS)
+    {
+        decoded.errorCode = slipErrorCode;
+    }
+    else if (frame.size() < H5_HEADER_LENGTH)
+    {
+        decoded.errorCode = NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_PAYLOAD_SIZE;
+    }
+    else if (oversized || frame.size() != H5_HEADER_LENGTH + header.payloadLength +
+                                               (header.crcPresent ? H5_CRC_LENGTH : 0))
+    {
+        decoded.errorCode = NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_CALCULATED_PAYLOAD_SIZE;
+    }
+    else if (!headerChecksumValid)
+    {
+        decoded.errorCode = NRF_ERROR_SD_RPC_H5_TRANSPORT_HEADER_CHECKSUM;
+    }
+    else
+    {
+        decoded.errorCode = NRF_SUCCESS;
+
+        if (header.crcPresent)
+        {
+            updateCrc();
+
+            const auto packetCrc = frame.data() + H5_HEADER_LENGTH + header.payloadLength;
+            const auto packetChecksum =
+                static_cast<uint16_t>(packetCrc[0] + (static_cast<uint16_t>(packetCrc[1]) << 8));
+
+            if (packetChecksum != crc)
+            {
+                decoded.errorCode = NRF_ERROR_SD_RPC_H5_TRANSPORT_PACKET_CHECKSUM;
+            }
+        }
+
+        if (decoded.errorCode == NRF_SUCCESS)
+        {
+            decoded.payload = frame.data() + H5_HEADER_LENGTH;
+        }
+    }
+
+    frameCallback(decoded);
+
+    reset();
+}
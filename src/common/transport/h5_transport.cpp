@@ -57,7 +57,9 @@
 #include "sd_rpc_types.h"
 
 #include "h5.h"
+#include "shared_io_context.h"
 #include "slip.h"
+#include "span_tracer.h"
 
 #include <algorithm>
 #include <chrono>
@@ -80,24 +82,73 @@ const auto OPEN_WAIT_TIMEOUT = std::chrono::milliseconds(3000);
 // Duration to wait before continuing UART communication after reset is sent to target
 const auto RESET_WAIT_DURATION = std::chrono::milliseconds(300);
 
+// Deadline of states that are only left when the state machine is notified
+const auto NoDeadline = std::chrono::steady_clock::time_point::max();
+
+// Strand and timer running the state machine on the threads of a SharedIoContext
+struct H5Transport::SharedStateMachine
+{
+    explicit SharedStateMachine(const std::shared_ptr<SharedIoContext> &sharedIoContext)
+        : ioContext(sharedIoContext)
+        , strand(sharedIoContext->context().get_executor())
+        , timer(sharedIoContext->context())
+        , timerDeadline(NoDeadline)
+        , running(true)
+        , stepScheduled(false)
+        , pendingHandlers(0)
+    {}
+
+    std::shared_ptr<SharedIoContext> ioContext;
+    asio::strand<asio::io_context::executor_type> strand;
+
+    // Only used on the strand
+    asio::steady_timer timer;
+    std::chrono::steady_clock::time_point timerDeadline;
+
+    // Protected by stateMachineStepMutex, running is only cleared on the strand
+    bool running;
+    bool stepScheduled;
+    size_t pendingHandlers;
+};
+
 #pragma region Public methods
-H5Transport::H5Transport(UartTransport *_nextTransportLayer, const uint32_t retransmission_interval)
+H5Transport::H5Transport(UartTransport *_nextTransportLayer, const uint32_t retransmission_interval,
+                         const uint8_t sliding_window_size)
     : nextTransportLayer(_nextTransportLayer)
     , seqNum(0)
     , ackNum(0)
-    , c0Found(false)
+    , rxDecoder(std::bind(&H5Transport::processPacket, this, std::placeholders::_1))
     , retransmissionInterval(std::chrono::milliseconds(retransmission_interval))
+    , rttEstimator(retransmissionInterval, MinRetransmissionTimeout,
+                   std::max<std::chrono::microseconds>(MaxRetransmissionTimeout,
+                                                       retransmissionInterval))
+    , requestedSlidingWindowSize(std::min(std::max(sliding_window_size, MinSlidingWindowSize),
+                                          MaxSlidingWindowSize))
+    , negotiatedSlidingWindowSize(MinSlidingWindowSize)
+    , outstandingHead(0)
+    , outstandingCount(0)
+    , retransmitting(false)
     , incomingPacketCount(0)
     , outgoingPacketCount(0)
     , errorPacketCount(0)
+    , slipErrorCount(0)
+    , headerErrorCount(0)
+    , crcErrorCount(0)
+    , retransmissionCount(0)
+    , resyncCount(0)
     , currentState(STATE_START)
     , stateMachineReady(false)
+    , stateEntered(false)
+    , syncRetransmission(0)
     , isOpen(false)
-{}
+{
+    updateRttSnapshot();
+}
 
 H5Transport::~H5Transport() noexcept
 {
     stopStateMachine();
+    stopRetransmission();
     delete nextTransportLayer;
 }
 
@@ -137,8 +188,7 @@ uint32_t H5Transport::open(const status_cb_t &status_callback, const data_cb_t &
         // Wait for the state machine to be ready
         setupStateMachine();
         startStateMachine();
-
-        lastPacket.clear();
+        startRetransmission();
 
         statusCallback = std::bind(&H5Transport::statusHandler, this, std::placeholders::_1,
                                    std::placeholders::_2);
@@ -171,7 +221,7 @@ uint32_t H5Transport::open(const status_cb_t &status_callback, const data_cb_t &
         }
 
         stateMachineLock.unlock();
-        stateMachineChange.notify_all();
+        notifyStateMachine();
     }
     catch (const std::out_of_range &)
     {
@@ -221,6 +271,9 @@ uint32_t H5Transport::close() noexcept
 
     isOpen = false;
 
+    // Fail packets that will never be acknowledged and stop accepting new ones
+    stopRetransmission();
+
     {
         std::unique_lock<std::mutex> currentStateLck(currentStateMutex);
 
@@ -235,7 +288,7 @@ uint32_t H5Transport::close() noexcept
                 exitCriteria->close = true;
             }
 
-            stateMachineChange.notify_all();
+            notifyStateMachine();
         }
         catch (const std::out_of_range &)
         {
@@ -265,85 +318,272 @@ uint32_t H5Transport::close() noexcept
 
 uint32_t H5Transport::send(const std::vector<uint8_t> &data) noexcept
 {
-    std::lock_guard<std::recursive_mutex> openLck(isOpenMutex);
+    std::shared_ptr<TxBuffer> buffer;
 
-    if (!isOpen)
+    try
     {
-        return NRF_ERROR_SD_RPC_H5_TRANSPORT_STATE;
+        buffer = std::make_shared<TxBuffer>(data.size());
+        std::copy(data.begin(), data.end(), buffer->payload());
+        buffer->setPayloadLength(data.size());
+    }
+    catch (const std::exception &)
+    {
+        return NRF_ERROR_SD_RPC_H5_TRANSPORT_INTERNAL_ERROR;
     }
 
-    if (currentState != STATE_ACTIVE)
+    return send(buffer);
+}
+
+uint32_t H5Transport::send(const std::shared_ptr<TxBuffer> &buffer) noexcept
+{
+    // Completion of the packet on this stack, the callback is invoked before sendAsync lets go
+    // of it. Capturing only a reference keeps the callback from allocating memory.
+    struct SentCompletion
+    {
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool completed;
+        uint32_t errorCode;
+    } sent;
+
+    sent.completed = false;
+    sent.errorCode = NRF_SUCCESS;
+
+    const auto errCode = sendAsync(buffer, [&sent](const uint32_t errorCode) {
+        std::lock_guard<std::mutex> sentGuard(sent.mutex);
+        sent.errorCode = errorCode;
+        sent.completed = true;
+        sent.condition.notify_one();
+    });
+
+    if (errCode != NRF_SUCCESS)
     {
-        return NRF_ERROR_SD_RPC_H5_TRANSPORT_STATE;
+        return errCode;
     }
 
+    // Packets in the window are retransmitted until acknowledged or failed, and failed when the
+    // transport is closed, so the callback is always invoked
+    std::unique_lock<std::mutex> sentGuard(sent.mutex);
+    sent.condition.wait(sentGuard, [&sent] { return sent.completed; });
+    return sent.errorCode;
+}
+
+uint32_t H5Transport::sendAsync(const std::shared_ptr<TxBuffer> &buffer,
+                                const sent_cb_t &sentCallback) noexcept
+{
+    {
+        std::lock_guard<std::recursive_mutex> openLck(isOpenMutex);
+
+        if (!isOpen)
+        {
+            return NRF_ERROR_SD_RPC_H5_TRANSPORT_STATE;
+        }
+
+        if (currentState != STATE_ACTIVE)
+        {
+            return NRF_ERROR_SD_RPC_H5_TRANSPORT_STATE;
+        }
+    }
+
+    // From waiting for room in the sliding window until the packet is written
+    TraceSpan sendSpan("h5_send", traceAdapter);
+
     try
     {
-        // max theoretical length of encoded packet, aditional 6 bytes h5 encoding and all bytes
-        // escaped
-        // + 2 packet encapsuling
+        std::unique_lock<std::mutex> ackLock(ackMutex);
 
-        payload_t h5EncodedPacket;
+        // Wait for room in the sliding window. Packets in the window are retransmitted until
+        // acknowledged or failed, so this wait is bounded by the retransmission scheme.
+        const auto windowWaitTimeout =
+            rttEstimator.maximumTimeout() * (PACKET_RETRANSMISSIONS + 1);
+
+        if (!ackReceived.wait_for(ackLock, windowWaitTimeout, [this] {
+                return !retransmitting || outstandingCount < negotiatedSlidingWindowSize;
+            }))
+        {
+            return NRF_ERROR_SD_RPC_H5_TRANSPORT_NO_RESPONSE;
+        }
+
+        // Closed while waiting
+        if (!retransmitting)
+        {
+            return NRF_ERROR_SD_RPC_H5_TRANSPORT_STATE;
+        }
+
+        auto &packet = outstandingPacket(outstandingCount);
 
         {
             std::unique_lock<std::recursive_mutex> seqNumLck(seqNumMutex);
             std::unique_lock<std::recursive_mutex> ackNumLck(ackNumMutex);
-            h5_encode(data, h5EncodedPacket, seqNum, ackNum, true, true, VENDOR_SPECIFIC_PACKET);
+            packet.seqNum = static_cast<uint8_t>((seqNum + outstandingCount) & 0x07);
+            h5_encode(*buffer, packet.seqNum, ackNum, true, true, VENDOR_SPECIFIC_PACKET);
+            sendSpan.seqNum(packet.seqNum);
+            sendSpan.ackNum(ackNum);
         }
 
-        payload_t encodedPacket;
-        slip_encode(h5EncodedPacket, encodedPacket);
+        logPacket(true, buffer->data(), buffer->size());
 
-        auto remainingRetransmissions = PACKET_RETRANSMISSIONS;
+        // Encode in place, the same buffer is used for retransmissions
+        slip_encode(*buffer);
 
-        lastPacket.clear();
-        lastPacket = encodedPacket;
+        packet.firstSent     = std::chrono::steady_clock::now();
+        packet.lastSent      = packet.firstSent;
+        packet.transmissions = 1;
 
-        std::unique_lock<std::mutex> ackLock(ackMutex);
+        const auto errCode = nextTransportLayer->send(buffer);
 
-        while (remainingRetransmissions--)
+        if (errCode != NRF_SUCCESS)
         {
-            uint8_t seqNumBefore;
+            return errCode;
+        }
 
-            {
-                // seqNumBefore must be assigned a value before calling send() as otherwise the 
-                // seqNum value might already have been increased if context switch happens after
-                // send() and right before assigning the seqNumBefore.
-                std::unique_lock<std::recursive_mutex> seqNumLck(seqNumMutex);
-                seqNumBefore = seqNum;
-            }
+        packet.slipPacket   = buffer;
+        packet.sentCallback = sentCallback;
+        outstandingCount++;
 
+        const auto firstInWindow = outstandingCount == 1;
+        ackLock.unlock();
 
-            logPacket(true, h5EncodedPacket);
-            const auto err_code = nextTransportLayer->send(lastPacket);
+        // The state machine waits for the timeout of the oldest packet in the window, it checks
+        // the window with stateMachineMutex held
+        if (firstInWindow)
+        {
+            std::lock_guard<std::mutex> stateMachineLock(stateMachineMutex);
+            notifyStateMachine();
+        }
+    }
+    catch (const std::exception &)
+    {
+        return NRF_ERROR_SD_RPC_H5_TRANSPORT_INTERNAL_ERROR;
+    }
 
-            if (err_code != NRF_SUCCESS)
-                return err_code;
+    return NRF_SUCCESS;
+}
 
-            // Checking for timeout. Also checking against spurios wakeup by making sure the
-            // sequence number has actually increased. If the sequence number has not increased, we
-            // have not received an ACK packet, and should not exit the loop (unless timeout). Ref.
-            // spurious wakeup: http://en.cppreference.com/w/cpp/thread/condition_variable
-            // https://en.wikipedia.org/wiki/Spurious_wakeup
-            if (ackReceived.wait_for(
-                    ackLock, std::chrono::milliseconds(retransmissionInterval), [&] {
-                        std::unique_lock<std::recursive_mutex> seqNumLck(seqNumMutex);
-                        return seqNum != seqNumBefore;
-                    }))
-            {
-                lastPacket.clear();
-                return NRF_SUCCESS;
-            }
+H5Transport::OutstandingPacket &H5Transport::outstandingPacket(const size_t index)
+{
+    return outstandingPackets[(outstandingHead + index) % outstandingPackets.size()];
+}
+
+void H5Transport::retransmitOutstandingPackets()
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    // Wait longer for the retransmitted packets, the timeout is kept until a packet sent only once
+    // is acknowledged
+    rttEstimator.backOff();
+    updateRttSnapshot();
+
+    for (size_t i = 0; i < outstandingCount; i++)
+    {
+        auto &packet = outstandingPacket(i);
+
+        if (isLogged(SD_RPC_LOG_DEBUG))
+        {
+            const auto &slipPacket = packet.slipPacket;
+            payload_t h5Packet;
+            slip_decode(payload_t(slipPacket->data(), slipPacket->data() + slipPacket->size()),
+                        h5Packet);
+            logPacket(true, h5Packet);
+        }
+        else
+        {
+            outgoingPacketCount.fetch_add(1, std::memory_order_relaxed);
         }
 
-        lastPacket.clear();
+        retransmissionCount.fetch_add(1, std::memory_order_relaxed);
+        packet.lastSent = now;
+        packet.transmissions++;
+        nextTransportLayer->send(packet.slipPacket);
     }
-    catch (const std::exception &)
+}
+
+void H5Transport::failOutstandingPackets()
+{
+    const auto failedCount = outstandingCount;
+
+    for (size_t i = 0; i < failedCount; i++)
     {
-        return NRF_ERROR_SD_RPC_H5_TRANSPORT_INTERNAL_ERROR;
+        auto &packet = outstandingPacket(i);
+        packet.slipPacket.reset();
+
+        if (packet.sentCallback)
+        {
+            failedSentCallbacks.push_back(std::move(packet.sentCallback));
+            packet.sentCallback = nullptr;
+        }
+    }
+
+    outstandingHead  = (outstandingHead + failedCount) % outstandingPackets.size();
+    outstandingCount = 0;
+    ackReceived.notify_all();
+}
+
+bool H5Transport::hasFailedPackets()
+{
+    std::lock_guard<std::mutex> ackLock(ackMutex);
+    return !failedSentCallbacks.empty();
+}
+
+void H5Transport::completeFailedPackets()
+{
+    std::vector<sent_cb_t> sentCallbacks;
+
+    {
+        std::lock_guard<std::mutex> ackLock(ackMutex);
+        sentCallbacks.swap(failedSentCallbacks);
+    }
+
+    for (const auto &sentCallback : sentCallbacks)
+    {
+        sentCallback(NRF_ERROR_SD_RPC_H5_TRANSPORT_NO_RESPONSE);
+    }
+}
+
+void H5Transport::startRetransmission()
+{
+    std::lock_guard<std::mutex> ackLock(ackMutex);
+    retransmitting = true;
+}
+
+void H5Transport::stopRetransmission()
+{
+    {
+        std::lock_guard<std::mutex> ackLock(ackMutex);
+        retransmitting = false;
+        failOutstandingPackets();
+    }
+
+    completeFailedPackets();
+}
+
+bool H5Transport::retransmitTimedOutPackets(std::chrono::steady_clock::time_point &deadline)
+{
+    std::unique_lock<std::mutex> ackLock(ackMutex);
+
+    while (outstandingCount > 0)
+    {
+        // Go-back-N: when the oldest packet in the window times out, it and all packets sent
+        // after it are retransmitted
+        const auto &oldest = outstandingPacket(0);
+        deadline           = oldest.lastSent + rttEstimator.timeout();
+
+        if (std::chrono::steady_clock::now() < deadline)
+        {
+            return true;
+        }
+
+        if (oldest.transmissions >= PACKET_RETRANSMISSIONS)
+        {
+            failOutstandingPackets();
+        }
+        else
+        {
+            retransmitOutstandingPackets();
+        }
     }
 
-    return NRF_ERROR_SD_RPC_H5_TRANSPORT_NO_RESPONSE;
+    return false;
 }
 
 h5_state_t H5Transport::state() const
@@ -351,58 +591,134 @@ h5_state_t H5Transport::state() const
     return currentState;
 }
 
-#pragma endregion Public methods
+uint8_t H5Transport::slidingWindowSize() const
+{
+    return negotiatedSlidingWindowSize;
+}
 
-#pragma region Processing incoming data from UART
-void H5Transport::processPacket(const payload_t &packet)
+void H5Transport::getStats(sd_rpc_stats_t &stats) noexcept
 {
-    uint8_t decodedSeqNum;
-    uint8_t decodedAckNum;
-    bool decodedReliablePacket;
-    h5_pkt_type_t decodedPacketType;
+    stats.h5_rtt_smoothed_us  = smoothedRttUs.load(std::memory_order_relaxed);
+    stats.h5_rtt_variation_us = rttVariationUs.load(std::memory_order_relaxed);
+    stats.h5_rto_us           = retransmissionTimeoutUs.load(std::memory_order_relaxed);
+    stats.h5_tx_packets      = outgoingPacketCount.load(std::memory_order_relaxed);
+    stats.h5_rx_packets      = incomingPacketCount.load(std::memory_order_relaxed);
+    stats.h5_retransmissions = retransmissionCount.load(std::memory_order_relaxed);
+    stats.h5_slip_errors     = slipErrorCount.load(std::memory_order_relaxed);
+    stats.h5_header_errors   = headerErrorCount.load(std::memory_order_relaxed);
+    stats.h5_crc_errors      = crcErrorCount.load(std::memory_order_relaxed);
+    stats.h5_resyncs         = resyncCount.load(std::memory_order_relaxed);
+    stats.h5_ack_rtt_min_us  = toMicroseconds(ackRtt.min());
+    stats.h5_ack_rtt_avg_us  = toMicroseconds(ackRtt.mean());
+    stats.h5_ack_rtt_max_us  = toMicroseconds(ackRtt.max());
+
+    if (nextTransportLayer != nullptr)
+    {
+        nextTransportLayer->getStats(stats);
+    }
+}
+
+std::string H5Transport::portName() const
+{
+    return nextTransportLayer != nullptr ? nextTransportLayer->portName() : std::string();
+}
 
-    payload_t slipPayload;
-    auto err_code = slip_decode(packet, slipPayload);
+void H5Transport::setLogSeverityFilter(const sd_rpc_log_severity_t severity) noexcept
+{
+    Transport::setLogSeverityFilter(severity);
 
-    if (err_code != NRF_SUCCESS)
+    if (nextTransportLayer != nullptr)
     {
-        ++errorPacketCount;
+        nextTransportLayer->setLogSeverityFilter(severity);
+    }
+}
 
-        std::stringstream ss;
-        ss << "slip_decode error, code: 0x" << std::hex << static_cast<uint32_t>(err_code);
-        ss << ", H5 error count: " << static_cast<uint32_t>(errorPacketCount)
-           << ". raw packet: " << asHex(packet);
-        log(SD_RPC_LOG_ERROR, ss.str());
+void H5Transport::setTraceAdapter(const uint32_t adapter) noexcept
+{
+    Transport::setTraceAdapter(adapter);
 
-        return;
+    if (nextTransportLayer != nullptr)
+    {
+        nextTransportLayer->setTraceAdapter(adapter);
     }
+}
 
-    logPacket(false, slipPayload);
+void H5Transport::setLogChannel(const uint32_t channel) noexcept
+{
+    Transport::setLogChannel(channel);
 
-    payload_t h5Payload;
+    if (nextTransportLayer != nullptr)
+    {
+        nextTransportLayer->setLogChannel(channel);
+    }
+}
 
-    err_code = h5_decode(slipPayload, h5Payload, &decodedSeqNum, &decodedAckNum, nullptr, nullptr,
-                         nullptr, &decodedReliablePacket, &decodedPacketType);
+#pragma endregion Public methods
 
-    if (err_code != NRF_SUCCESS)
+#pragma region Processing incoming data from UART
+void H5Transport::processPacket(const H5Frame &frame)
+{
+    if (frame.errorCode == NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_DECODING)
     {
-        ++errorPacketCount;
+        incomingPacketCount.fetch_add(1, std::memory_order_relaxed);
+        countPacketError(frame.errorCode);
+
+        if (!isLogged(SD_RPC_LOG_ERROR))
+        {
+            return;
+        }
 
-        std::stringstream ss;
-        ss << "h5_decode error, code: 0x" << std::hex << static_cast<uint32_t>(err_code);
-        ss << ", H5 error count: " << static_cast<uint32_t>(errorPacketCount)
-           << ". raw packet: " << asHex(packet);
-        log(SD_RPC_LOG_ERROR, ss.str());
+        const auto &packet = *frame.slipPayload;
+        logRecord(SD_RPC_LOG_ERROR,
+                  LOG_FORMAT_ID("slip_decode error, code: 0x{x}, H5 error count: {}. "
+                                "decoded packet: {}"),
+                  frame.errorCode, errorPacketCount.load(std::memory_order_relaxed),
+                  LogBytes{packet.data(), packet.size()});
 
         return;
     }
 
+    logPacket(false, *frame.slipPayload);
+
+    if (frame.errorCode != NRF_SUCCESS)
+    {
+        countPacketError(frame.errorCode);
+
+        if (!isLogged(SD_RPC_LOG_ERROR))
+        {
+            return;
+        }
+
+        const auto &packet = *frame.slipPayload;
+        logRecord(SD_RPC_LOG_ERROR,
+                  LOG_FORMAT_ID("h5_decode error, code: 0x{x}, H5 error count: {}. "
+                                "decoded packet: {}"),
+                  frame.errorCode, errorPacketCount.load(std::memory_order_relaxed),
+                  LogBytes{packet.data(), packet.size()});
+
+        return;
+    }
+
+    const auto decodedSeqNum         = frame.seqNum;
+    const auto decodedAckNum         = frame.ackNum;
+    const auto decodedReliablePacket = frame.reliable;
+    const auto decodedPacketType     = frame.type;
+
+    // Callbacks of acknowledged packets, invoked when the locks are released since they may send
+    // the next packet
+    std::array<sent_cb_t, MaxSlidingWindowSize> sentCallbacks;
+    size_t sentCount = 0;
+
+    // Payload of a received reliable packet, passed to the upper layer when the locks are
+    // released since its event callback may run inline and take as long as it likes
+    auto deliverPayload = false;
+
     std::unique_lock<std::mutex> currentStateLock(currentStateMutex);
 
     if (currentState == STATE_RESET)
     {
         // Ignore packets packets received in this state.
-        stateMachineChange.notify_all();
+        notifyStateMachine();
         return;
     }
 
@@ -410,6 +726,8 @@ void H5Transport::processPacket(const payload_t &packet)
 
     if (decodedPacketType == LINK_CONTROL_PACKET)
     {
+        const payload_t h5Payload(frame.payload, frame.payload + frame.payloadLength);
+
         if (currentState == STATE_UNINITIALIZED)
         {
             if (H5Transport::isSyncResponsePacket(h5Payload))
@@ -434,10 +752,13 @@ void H5Transport::processPacket(const payload_t &packet)
 
             if (H5Transport::isSyncConfigResponsePacket(h5Payload))
             {
+                // The peer responds with the configuration it supports
+                negotiateSlidingWindowSize(h5Payload);
                 exit->syncConfigRspReceived = true;
             }
             else if (H5Transport::isSyncConfigPacket(h5Payload))
             {
+                negotiateSlidingWindowSize(h5Payload);
                 sendControlPacket(CONTROL_PKT_SYNC_CONFIG_RESPONSE);
             }
             else if (H5Transport::isSyncPacket(h5Payload))
@@ -456,6 +777,7 @@ void H5Transport::processPacket(const payload_t &packet)
             }
             else if (H5Transport::isSyncConfigPacket(h5Payload))
             {
+                negotiateSlidingWindowSize(h5Payload);
                 sendControlPacket(CONTROL_PKT_SYNC_CONFIG_RESPONSE);
             }
         }
@@ -472,7 +794,7 @@ void H5Transport::processPacket(const payload_t &packet)
                 {
                     incrementAckNum();
                     sendControlPacket(CONTROL_PKT_ACK, ackNum);
-                    upperDataCallback(h5Payload.data(), h5Payload.size());
+                    deliverPayload = true;
                 }
                 else
                 {
@@ -483,13 +805,51 @@ void H5Transport::processPacket(const payload_t &packet)
     }
     else if (decodedPacketType == ACK_PACKET)
     {
-        std::lock_guard<std::recursive_mutex> lck(seqNumMutex);
+        std::unique_lock<std::mutex> ackLock(ackMutex);
+        std::unique_lock<std::recursive_mutex> lck(seqNumMutex);
 
-        if (decodedAckNum == ((seqNum + 1) & 0x07))
+        // ack_num is the next sequence number the peer expects, the acknowledgement is cumulative
+        // and covers all packets in the window up to, but not including, ack_num.
+        const auto acknowledgedCount = static_cast<uint8_t>((decodedAckNum - seqNum) & 0x07);
+
+        if (acknowledgedCount > 0 &&
+            acknowledgedCount <= std::max(outstandingCount, static_cast<size_t>(1)))
         {
-            // Received a packet with valid ack_num, inform threads that wait the command is
-            // received on the other end
-            incrementSeqNum();
+            // Received a packet with valid ack_num
+            const auto now = std::chrono::steady_clock::now();
+
+            while (sentCount < acknowledgedCount && outstandingCount > 0)
+            {
+                auto &packet = outstandingPacket(0);
+
+                // Karn's rule, the acknowledgement of a retransmitted packet can not be matched
+                // to one of its transmissions
+                if (packet.transmissions == 1)
+                {
+                    const auto rtt = std::chrono::duration_cast<std::chrono::microseconds>(
+                        now - packet.lastSent);
+                    rttEstimator.addSample(rtt);
+                    updateRttSnapshot();
+                    ackRtt.record(rtt);
+                }
+
+                // From the first transmission of the packet until it is acknowledged
+                if (SpanTracer::isTracing())
+                {
+                    auto span = SpanTracer::span("h5_ack", traceAdapter, packet.firstSent, now);
+                    span.seqNum = packet.seqNum;
+                    span.ackNum = decodedAckNum;
+                    span.tags   = SPAN_TAG_SEQ_NUM | SPAN_TAG_ACK_NUM;
+                    SpanTracer::global().record(span);
+                }
+
+                packet.slipPacket.reset();
+                sentCallbacks[sentCount++].swap(packet.sentCallback);
+                outstandingHead = (outstandingHead + 1) % outstandingPackets.size();
+                outstandingCount--;
+            }
+
+            seqNum = decodedAckNum;
             ackReceived.notify_all();
         }
         else if (decodedAckNum == seqNum)
@@ -520,7 +880,22 @@ void H5Transport::processPacket(const payload_t &packet)
     }
 
     stateMachineLock.unlock();
-    stateMachineChange.notify_all();
+    notifyStateMachine();
+    currentStateLock.unlock();
+
+    // Packets are processed one at a time, payloads are passed up in the order received
+    if (deliverPayload)
+    {
+        upperDataCallback(frame.payload, frame.payloadLength);
+    }
+
+    for (size_t i = 0; i < sentCount; i++)
+    {
+        if (sentCallbacks[i])
+        {
+            sentCallbacks[i](NRF_SUCCESS);
+        }
+    }
 }
 
 void H5Transport::statusHandler(const sd_rpc_app_status_t code, const std::string &message) noexcept
@@ -539,7 +914,7 @@ void H5Transport::statusHandler(const sd_rpc_app_status_t code, const std::strin
             }
 
             stateMachineLock.unlock();
-            stateMachineChange.notify_all();
+            notifyStateMachine();
         }
         catch (std::out_of_range &)
         {
@@ -577,63 +952,16 @@ void H5Transport::statusHandler(const sd_rpc_app_status_t code, const std::strin
 
 void H5Transport::dataHandler(const uint8_t *data, const size_t length) noexcept
 {
-    payload_t packet;
-
     try
     {
-        // Check if we have any data from before that has not been processed.
-        // If so add the remaining data from previous callback(s) to this packet
-        if (!unprocessedData.empty())
-        {
-            packet.insert(packet.begin(), unprocessedData.begin(), unprocessedData.end());
-        }
-
-        for (size_t i = 0; i < length; i++)
-        {
-            packet.push_back(data[i]);
-
-            if (data[i] == 0xC0)
-            {
-                if (c0Found)
-                {
-                    // End of packet found
-
-                    // If we have two 0xC0 after another we assume it is the beginning of a new
-                    // packet, and not the end
-                    if (packet.size() == 2)
-                    {
-                        packet.clear();
-                        packet.push_back(0xc0);
-                        continue;
-                    }
-
-                    processPacket(packet);
-
-                    packet.clear();
-                    unprocessedData.clear();
-                    c0Found = false;
-                }
-                else
-                {
-                    // Start of packet found
-                    c0Found = true;
-
-                    // Clear previous data from packet since data before the start of packet is
-                    // irrelevant.
-                    packet.clear();
-                    packet.push_back(0xC0);
-                }
-            }
-        }
-
-        if (!packet.empty())
-        {
-            unprocessedData.clear();
-            unprocessedData.insert(unprocessedData.begin(), packet.begin(), packet.end());
-        }
+        // Complete packets are passed to ::processPacket, partial packets are kept by the decoder
+        // until the rest of the packet is received
+        rxDecoder.decode(data, length);
     }
     catch (const std::exception &e)
     {
+        rxDecoder.reset();
+
         try
         {
             std::stringstream ss;
@@ -647,11 +975,29 @@ void H5Transport::dataHandler(const uint8_t *data, const size_t length) noexcept
     }
 }
 
-void H5Transport::incrementSeqNum()
+void H5Transport::resetSequenceNumbers()
 {
-    std::unique_lock<std::recursive_mutex> lck(seqNumMutex);
-    seqNum++;
-    seqNum = seqNum & 0x07;
+    // Reset before STATE_ACTIVE is entered, a packet may be received as soon as it is
+    std::lock_guard<std::mutex> ackLock(ackMutex);
+    std::lock_guard<std::recursive_mutex> seqNumLck(seqNumMutex);
+    std::lock_guard<std::recursive_mutex> ackNumLck(ackNumMutex);
+
+    seqNum = 0;
+    ackNum = 0;
+
+    // The link is restarted, measurements from an earlier session do not apply
+    rttEstimator.reset();
+    updateRttSnapshot();
+}
+
+void H5Transport::updateRttSnapshot() noexcept
+{
+    smoothedRttUs.store(static_cast<uint32_t>(rttEstimator.smoothedRtt().count()),
+                        std::memory_order_relaxed);
+    rttVariationUs.store(static_cast<uint32_t>(rttEstimator.rttVariation().count()),
+                         std::memory_order_relaxed);
+    retransmissionTimeoutUs.store(static_cast<uint32_t>(rttEstimator.timeout().count()),
+                                  std::memory_order_relaxed);
 }
 
 void H5Transport::incrementAckNum()
@@ -667,18 +1013,23 @@ void H5Transport::incrementAckNum()
 
 h5_state_t H5Transport::stateActionStart()
 {
-    std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
     auto exit = dynamic_cast<StartExitCriterias *>(exitCriterias[STATE_START].get());
 
-    stateMachineReady = true;
+    if (!stateEntered)
+    {
+        stateEntered      = true;
+        stateMachineReady = true;
 
-    // Notify other threads that the state machine is ready
-    stateMachineLock.unlock();
-    stateMachineChange.notify_all();
-    stateMachineLock.lock();
+        // Notify other threads that the state machine is ready
+        stateMachineChange.notify_all();
+    }
 
-    // Wait for notification of a stateMachineChange that exits the state
-    stateMachineChange.wait(stateMachineLock, [&exit] { return exit->isFullfilled(); });
+    // Stay until a stateMachineChange exits the state
+    if (!exit->isFullfilled())
+    {
+        stateDeadline = NoDeadline;
+        return STATE_START;
+    }
 
     // Order is of importance when returning state
     if (exit->ioResourceError)
@@ -701,20 +1052,28 @@ h5_state_t H5Transport::stateActionStart()
 
 h5_state_t H5Transport::stateActionReset()
 {
-    std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
     auto exit = dynamic_cast<ResetExitCriterias *>(exitCriterias[STATE_RESET].get());
 
     // Send the reset packet, and wait for the device to reboot and ready for receiving commands
-    sendControlPacket(CONTROL_PKT_RESET);
+    if (!stateEntered)
+    {
+        stateEntered = true;
+        sendControlPacket(CONTROL_PKT_RESET);
+
+        if (statusCallback)
+        {
+            statusCallback(RESET_PERFORMED, "Target Reset performed");
+        }
 
-    if (statusCallback)
+        exit->resetSent = true;
+        stateDeadline   = std::chrono::steady_clock::now() + RESET_WAIT_DURATION;
+    }
+
+    if (!exit->isFullfilled() && std::chrono::steady_clock::now() < stateDeadline)
     {
-        statusCallback(RESET_PERFORMED, "Target Reset performed");
+        return STATE_RESET;
     }
 
-    exit->resetSent = true;
-    stateMachineChange.wait_for(stateMachineLock, RESET_WAIT_DURATION,
-                                [&exit] { return exit->isFullfilled(); });
     exit->resetWait = true;
 
     // Order is of importance when returning state
@@ -738,20 +1097,31 @@ h5_state_t H5Transport::stateActionReset()
 
 h5_state_t H5Transport::stateActionUninitialized()
 {
-    std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
     auto exit =
         dynamic_cast<UninitializedExitCriterias *>(exitCriterias[STATE_UNINITIALIZED].get());
-    auto syncRetransmission = PACKET_RETRANSMISSIONS;
 
-    while (!exit->isFullfilled() && syncRetransmission > 0)
+    if (!stateEntered)
+    {
+        stateEntered       = true;
+        syncRetransmission = PACKET_RETRANSMISSIONS;
+        stateDeadline      = std::chrono::steady_clock::now();
+    }
+
+    // Send SYNC each retransmission interval until the peer responds
+    if (!exit->isFullfilled() && syncRetransmission > 0 &&
+        std::chrono::steady_clock::now() >= stateDeadline)
     {
         sendControlPacket(CONTROL_PKT_SYNC);
         exit->syncSent = true;
-        stateMachineChange.wait_for(stateMachineLock, retransmissionInterval,
-                                    [&exit] { return exit->isFullfilled(); });
+        stateDeadline  = std::chrono::steady_clock::now() + retransmissionInterval;
         syncRetransmission--;
     }
 
+    if (!exit->isFullfilled() && std::chrono::steady_clock::now() < stateDeadline)
+    {
+        return STATE_UNINITIALIZED;
+    }
+
     // Order is of importance when returning state
     if (exit->ioResourceError)
     {
@@ -782,22 +1152,30 @@ h5_state_t H5Transport::stateActionUninitialized()
 
 h5_state_t H5Transport::stateActionInitialized()
 {
-    std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
     auto exit = dynamic_cast<InitializedExitCriterias *>(exitCriterias[STATE_INITIALIZED].get());
-    auto syncRetransmission = PACKET_RETRANSMISSIONS;
 
     // Send a package immediately
-    while (!exit->isFullfilled() && syncRetransmission > 0)
+    if (!stateEntered)
+    {
+        stateEntered       = true;
+        syncRetransmission = PACKET_RETRANSMISSIONS;
+        stateDeadline      = std::chrono::steady_clock::now();
+    }
+
+    if (!exit->isFullfilled() && syncRetransmission > 0 &&
+        std::chrono::steady_clock::now() >= stateDeadline)
     {
         sendControlPacket(CONTROL_PKT_SYNC_CONFIG);
         exit->syncConfigSent = true;
-
-        stateMachineChange.wait_for(stateMachineLock, retransmissionInterval,
-                                    [&exit] { return exit->isFullfilled(); });
-
+        stateDeadline        = std::chrono::steady_clock::now() + retransmissionInterval;
         syncRetransmission--;
     }
 
+    if (!exit->isFullfilled() && std::chrono::steady_clock::now() < stateDeadline)
+    {
+        return STATE_INITIALIZED;
+    }
+
     // Order is of importance when returning state
     if (exit->ioResourceError)
     {
@@ -827,19 +1205,30 @@ h5_state_t H5Transport::stateActionInitialized()
 };
 h5_state_t H5Transport::stateActionActive()
 {
-    std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
     auto exit = dynamic_cast<ActiveExitCriterias *>(exitCriterias[STATE_ACTIVE].get());
 
+    if (!stateEntered)
     {
-        std::unique_lock<std::recursive_mutex> seqNumLck(seqNumMutex);
-        std::unique_lock<std::recursive_mutex> ackNumLck(ackNumMutex);
+        stateEntered = true;
+        statusHandler(CONNECTION_ACTIVE, "Connection active");
+    }
 
-        seqNum = 0;
-        ackNum = 0;
+    // Retransmit packets of the window when they time out until the state is left
+    if (!exit->isFullfilled()) // T#2
+    {
+        if (!retransmitTimedOutPackets(stateDeadline))
+        {
+            stateDeadline = NoDeadline;
+        }
+
+        return STATE_ACTIVE;
     }
 
-    statusHandler(CONNECTION_ACTIVE, "Connection active");
-    stateMachineChange.wait(stateMachineLock, [&exit] { return exit->isFullfilled(); }); // T#2
+    {
+        // Packets in the window will never be acknowledged after leaving this state
+        std::lock_guard<std::mutex> ackLock(ackMutex);
+        failOutstandingPackets();
+    }
 
     if (exit->ioResourceError)
     {
@@ -853,6 +1242,7 @@ h5_state_t H5Transport::stateActionActive()
 
     if (exit->syncReceived || exit->irrecoverableSyncError)
     {
+        resyncCount.fetch_add(1, std::memory_order_relaxed);
         return STATE_RESET;
     }
 
@@ -861,20 +1251,17 @@ h5_state_t H5Transport::stateActionActive()
 
 h5_state_t H5Transport::stateActionFailed()
 {
-    std::lock_guard<std::mutex> stateMachineLock(stateMachineMutex);
     log(SD_RPC_LOG_FATAL, "Entered state failed. No exit exists from this state.");
     return STATE_FAILED;
 };
 
 h5_state_t H5Transport::stateActionClosed()
 {
-    std::lock_guard<std::mutex> stateMachineLock(stateMachineMutex);
     log(SD_RPC_LOG_DEBUG, "Entered state closed.");
     return STATE_CLOSED;
 };
 h5_state_t H5Transport::stateActionNoResponse()
 {
-    std::lock_guard<std::mutex> stateMachineLock(stateMachineMutex);
     log(SD_RPC_LOG_DEBUG, "No response to data sent to device.");
     return STATE_NO_RESPONSE;
 };
@@ -907,21 +1294,37 @@ void H5Transport::setupStateMachine()
 
 void H5Transport::startStateMachine()
 {
-    if (!stateMachineThread.joinable())
+    if (!stateMachineThread.joinable() && !sharedStateMachine)
     {
         currentState = STATE_START;
 
-        // Lock the stateMachineMutex and let stateMachineThread notify
-        // when the state machine is ready to process states
+        // Lock the stateMachineMutex and let the state machine notify
+        // when it is ready to process states
         std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
-        stateMachineThread = std::thread([this] { stateMachineWorker(); });
+        stateEntered = false;
+
+        const auto sharedIoContext = SharedIoContext::current();
+
+        if (sharedIoContext)
+        {
+            {
+                std::lock_guard<std::mutex> stepLock(stateMachineStepMutex);
+                sharedStateMachine = std::make_unique<SharedStateMachine>(sharedIoContext);
+            }
+
+            scheduleStateMachineStep();
+        }
+        else
+        {
+            stateMachineThread = std::thread([this] { stateMachineWorker(); });
+        }
 
         // Wait for the state machine to be ready
         stateMachineChange.wait(stateMachineLock, [this] { return stateMachineReady; });
     }
     else
     {
-        // Terminate if the state machine thread is joinable (already runs), this should not happen.
+        // Terminate if the state machine already runs, this should not happen.
         std::cerr << __FILE__ << ":" << __LINE__
                   << " stateMachineThread exists, this should not happen. Terminating."
                   << std::endl;
@@ -935,6 +1338,84 @@ void H5Transport::stopStateMachine()
     {
         stateMachineThread.join();
     }
+
+    std::unique_ptr<SharedStateMachine> stopped;
+
+    {
+        std::unique_lock<std::mutex> stepLock(stateMachineStepMutex);
+
+        if (sharedStateMachine)
+        {
+            // Wait for the terminal state and for the handlers still queued on the strand
+            stateMachineStepDone.wait(stepLock, [this] {
+                return !sharedStateMachine->running && sharedStateMachine->pendingHandlers == 0;
+            });
+        }
+
+        stopped = std::move(sharedStateMachine);
+    }
+
+    // The shared context is released without holding stateMachineStepMutex
+    stopped.reset();
+}
+
+bool H5Transport::enterState(const h5_state_t nextState)
+{
+    logStateTransition(currentState, nextState);
+
+    // Reset the next states variables before starting to use them.
+    switch (nextState)
+    {
+        case STATE_START:
+            dynamic_cast<StartExitCriterias *>(exitCriterias[STATE_START].get())->reset();
+            break;
+        case STATE_RESET:
+            dynamic_cast<ResetExitCriterias *>(exitCriterias[STATE_RESET].get())->reset();
+            break;
+        case STATE_UNINITIALIZED:
+            dynamic_cast<UninitializedExitCriterias *>(exitCriterias[STATE_UNINITIALIZED].get())
+                ->reset();
+            break;
+        case STATE_INITIALIZED:
+            dynamic_cast<InitializedExitCriterias *>(exitCriterias[STATE_INITIALIZED].get())
+                ->reset();
+            break;
+        case STATE_ACTIVE:
+            dynamic_cast<ActiveExitCriterias *>(exitCriterias[STATE_ACTIVE].get())->reset();
+            resetSequenceNumbers();
+            break;
+        case STATE_FAILED:
+        case STATE_CLOSED:
+        case STATE_NO_RESPONSE:
+            // These are terminal states that do not have exit criteria associated with
+            // them
+            break;
+        case STATE_UNKNOWN:
+            // Not used
+            break;
+    }
+
+    currentState = nextState;
+    stateEntered = false;
+
+    // Inform interested parties that new current state is set and ready
+    currentStateChange.notify_all();
+
+    // Check if current state give any reason to continue running the state machine
+    if (currentState == STATE_FAILED || currentState == STATE_CLOSED ||
+        currentState == STATE_NO_RESPONSE)
+    {
+        stateMachineReady = false;
+        return false;
+    }
+
+    return true;
+}
+
+void H5Transport::notifyStateMachine()
+{
+    stateMachineChange.notify_all();
+    scheduleStateMachineStep();
 }
 
 // State machine thread
@@ -946,73 +1427,173 @@ void H5Transport::stateMachineWorker() noexcept
 
         while (doRun)
         {
-            // Run next state actions
-            const auto nextState = stateActions[currentState]();
+            std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
+
+            // Run the current state action until it returns the next state
+            auto nextState = stateActions[currentState]();
+
+            while (nextState == currentState)
+            {
+                if (hasFailedPackets())
+                {
+                    // The callbacks may send packets, which takes stateMachineMutex. The action
+                    // runs again afterwards since notifications are not waited for meanwhile.
+                    stateMachineLock.unlock();
+                    completeFailedPackets();
+                    stateMachineLock.lock();
+                }
+                else if (stateDeadline == NoDeadline)
+                {
+                    stateMachineChange.wait(stateMachineLock);
+                }
+                else
+                {
+                    stateMachineChange.wait_until(stateMachineLock, stateDeadline);
+                }
+
+                nextState = stateActions[currentState]();
+            }
+
+            stateMachineLock.unlock();
+            completeFailedPackets();
 
             // After returning from current state action, lock the current state
             std::unique_lock<std::mutex> currentStateLck(currentStateMutex);
 
             // Make sure that state is not changed when assigning a new current state
-            {
-                std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
-                logStateTransition(currentState, nextState);
+            stateMachineLock.lock();
+            doRun = enterState(nextState);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        log(SD_RPC_LOG_FATAL, "Error in state machine thread", e);
+    }
+}
 
-                // Reset the next states variables before starting to use them.
-                switch (nextState)
-                {
-                    case STATE_START:
-                        dynamic_cast<StartExitCriterias *>(exitCriterias[STATE_START].get())
-                            ->reset();
-                        break;
-                    case STATE_RESET:
-                        dynamic_cast<ResetExitCriterias *>(exitCriterias[STATE_RESET].get())
-                            ->reset();
-                        break;
-                    case STATE_UNINITIALIZED:
-                        dynamic_cast<UninitializedExitCriterias *>(
-                            exitCriterias[STATE_UNINITIALIZED].get())
-                            ->reset();
-                        break;
-                    case STATE_INITIALIZED:
-                        dynamic_cast<InitializedExitCriterias *>(
-                            exitCriterias[STATE_INITIALIZED].get())
-                            ->reset();
-                        break;
-                    case STATE_ACTIVE:
-                        dynamic_cast<ActiveExitCriterias *>(exitCriterias[STATE_ACTIVE].get())
-                            ->reset();
-                        break;
-                    case STATE_FAILED:
-                    case STATE_CLOSED:
-                    case STATE_NO_RESPONSE:
-                        // These are terminal states that do not have exit criteria associated with
-                        // them
-                        break;
-                    case STATE_UNKNOWN:
-                        // Not used
-                        break;
-                }
+void H5Transport::scheduleStateMachineStep()
+{
+    std::lock_guard<std::mutex> stepLock(stateMachineStepMutex);
+
+    if (!sharedStateMachine || !sharedStateMachine->running || sharedStateMachine->stepScheduled)
+    {
+        return;
+    }
 
-                currentState = nextState;
+    // Notifications received before the step runs are handled by the same step
+    asio::post(sharedStateMachine->strand, [this] {
+        {
+            std::lock_guard<std::mutex> stepLock(stateMachineStepMutex);
+            sharedStateMachine->stepScheduled = false;
+        }
 
-                // Check if current state give any reason to continue running this thread
-                if (currentState == STATE_FAILED || currentState == STATE_CLOSED ||
-                    currentState == STATE_NO_RESPONSE)
-                {
-                    doRun = false;
-                }
+        runStateMachineStep();
+
+        std::lock_guard<std::mutex> stepLock(stateMachineStepMutex);
+        sharedStateMachine->pendingHandlers--;
+        stateMachineStepDone.notify_all();
+    });
+
+    sharedStateMachine->stepScheduled = true;
+    sharedStateMachine->pendingHandlers++;
+}
+
+// Runs on the strand of the shared state machine
+void H5Transport::runStateMachineStep() noexcept
+{
+    if (!sharedStateMachine->running)
+    {
+        return;
+    }
+
+    auto running = true;
+
+    try
+    {
+        std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
 
-                // Inform interested parties that new current state is set and ready
-                currentStateChange.notify_all();
+        // Run state actions until the current state stays
+        auto nextState = stateActions[currentState]();
+
+        while (nextState != currentState && running)
+        {
+            stateMachineLock.unlock();
+
+            {
+                std::unique_lock<std::mutex> currentStateLck(currentStateMutex);
+                std::lock_guard<std::mutex> enterLock(stateMachineMutex);
+                running = enterState(nextState);
+            }
+
+            stateMachineLock.lock();
+
+            if (running)
+            {
+                nextState = stateActions[currentState]();
             }
         }
 
-        stateMachineReady = false;
+        if (running)
+        {
+            const auto deadline = stateDeadline;
+            stateMachineLock.unlock();
+            armStateMachineTimer(deadline);
+        }
     }
     catch (const std::exception &e)
     {
-        log(SD_RPC_LOG_FATAL, "Error in state machine thread", e);
+        log(SD_RPC_LOG_FATAL, "Error in state machine", e);
+        running = false;
     }
+
+    if (!running)
+    {
+        sharedStateMachine->timer.cancel();
+
+        std::lock_guard<std::mutex> stepLock(stateMachineStepMutex);
+        sharedStateMachine->running = false;
+        stateMachineStepDone.notify_all();
+    }
+
+    // Packets sent by the callbacks notify the state machine, which schedules another step
+    completeFailedPackets();
+}
+
+// Runs on the strand of the shared state machine
+void H5Transport::armStateMachineTimer(const std::chrono::steady_clock::time_point deadline)
+{
+    auto &shared = *sharedStateMachine;
+
+    if (deadline == shared.timerDeadline)
+    {
+        return;
+    }
+
+    shared.timerDeadline = deadline;
+
+    if (deadline == NoDeadline)
+    {
+        shared.timer.cancel();
+        return;
+    }
+
+    // Cancels the previous wait, its handler runs with operation_aborted
+    shared.timer.expires_at(deadline);
+    shared.timer.async_wait(
+        asio::bind_executor(shared.strand, [this](const asio::error_code &error) {
+            if (!error)
+            {
+                sharedStateMachine->timerDeadline = NoDeadline;
+                runStateMachineStep();
+            }
+
+            std::lock_guard<std::mutex> stepLock(stateMachineStepMutex);
+            sharedStateMachine->pendingHandlers--;
+            stateMachineStepDone.notify_all();
+        }));
+
+    std::lock_guard<std::mutex> stepLock(stateMachineStepMutex);
+    shared.pendingHandlers++;
 }
 
 bool H5Transport::waitForState(h5_state_t state, std::chrono::milliseconds timeout)
@@ -1057,13 +1638,25 @@ void H5Transport::sendControlPacket(const control_pkt_type type, const uint8_t a
 
     try
     {
-        const auto payload = getPktPattern(type);
+        auto payload = getPktPattern(type);
+
+        // A configuration offers the window this side requests, a response confirms the window
+        // negotiated with the configuration of the peer. Responses are only sent by the thread
+        // negotiating the window.
+        if (type == CONTROL_PKT_SYNC_CONFIG)
+        {
+            payload[2] = syncConfigField(requestedSlidingWindowSize);
+        }
+        else if (type == CONTROL_PKT_SYNC_CONFIG_RESPONSE)
+        {
+            payload[2] = syncConfigField(negotiatedSlidingWindowSize);
+        }
+
         h5_encode(payload, h5Packet, 0, type == CONTROL_PKT_ACK ? ackNum : 0, false, false,
                   h5_packet);
     }
     catch (const std::out_of_range &e)
     {
-        std::stringstream logLine;
         log(SD_RPC_LOG_FATAL, "Trying to send unknown control packet to device, aborting", e);
         std::terminate();
     }
@@ -1215,7 +1808,8 @@ std::string H5Transport::hciPacketLinkControlToString(const payload_t &payload)
     return retval.str();
 }
 
-std::string H5Transport::h5PktToString(const bool out, const payload_t &h5Packet) const
+std::string H5Transport::h5PktToString(const bool out, const uint32_t packetCount,
+                                       const uint32_t errorCount, const payload_t &h5Packet)
 {
     payload_t payload;
 
@@ -1235,12 +1829,11 @@ std::string H5Transport::h5PktToString(const bool out, const payload_t &h5Packet
 
     if (out)
     {
-        count << std::setw(8) << outgoingPacketCount << " -> ";
+        count << std::setw(8) << packetCount << " -> ";
     }
     else
     {
-        count << std::setw(5) << incomingPacketCount << "/" << std::setw(2) << errorPacketCount
-              << " <- ";
+        count << std::setw(5) << packetCount << "/" << std::setw(2) << errorCount << " <- ";
     }
 
     std::stringstream retval;
@@ -1265,23 +1858,72 @@ std::string H5Transport::h5PktToString(const bool out, const payload_t &h5Packet
     return retval.str();
 }
 
-void H5Transport::logPacket(const bool outgoing, const payload_t &packet)
+std::string H5Transport::formatPacket(const LogRecord &record, const std::string &packet)
 {
-    if (outgoing)
+    const auto outgoing     = record.args[0] != 0;
+    const auto packetCount  = static_cast<uint32_t>(record.args[1]);
+    const auto errorCount   = static_cast<uint32_t>(record.args[2]);
+    const auto packetLength = record.args[3];
+
+    auto message = h5PktToString(outgoing, packetCount, errorCount,
+                                 payload_t(packet.begin(), packet.end()));
+
+    if (packet.size() < packetLength)
     {
-        ++outgoingPacketCount;
+        message += " (truncated)";
     }
-    else
+
+    return message;
+}
+
+void H5Transport::logPacket(const bool outgoing, const uint8_t *packet, const size_t length)
+{
+    auto &packetCount = outgoing ? outgoingPacketCount : incomingPacketCount;
+    const auto count  = packetCount.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    if (!isLogged(SD_RPC_LOG_DEBUG))
     {
-        ++incomingPacketCount;
+        return;
     }
 
-    const std::string logLine = h5PktToString(outgoing, packet);
-    log(SD_RPC_LOG_DEBUG, logLine);
+    // Only the packet is copied, it is decoded and formatted by the drain thread of the log ring
+    static const auto packetFormat = LogRing::registerFormat("H5 packet", &formatPacket);
+
+    logRecord(SD_RPC_LOG_DEBUG, packetFormat, outgoing, count,
+              errorPacketCount.load(std::memory_order_relaxed), LogBytes{packet, length});
+}
+
+void H5Transport::logPacket(const bool outgoing, const payload_t &packet)
+{
+    logPacket(outgoing, packet.data(), packet.size());
+}
+
+void H5Transport::countPacketError(const uint32_t errorCode) noexcept
+{
+    errorPacketCount.fetch_add(1, std::memory_order_relaxed);
+
+    switch (errorCode)
+    {
+        case NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_DECODING:
+            slipErrorCount.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case NRF_ERROR_SD_RPC_H5_TRANSPORT_PACKET_CHECKSUM:
+            crcErrorCount.fetch_add(1, std::memory_order_relaxed);
+            break;
+        default:
+            // Payload length or header checksum not matching the header
+            headerErrorCount.fetch_add(1, std::memory_order_relaxed);
+            break;
+    }
 }
 
 void H5Transport::logStateTransition(h5_state_t from, h5_state_t to) const
 {
+    if (!isLogged(SD_RPC_LOG_DEBUG))
+    {
+        return;
+    }
+
     std::stringstream logLine;
     logLine << "State change: " << stateToString(from) << " -> " << stateToString(to);
 
@@ -1340,6 +1982,29 @@ payload_t H5Transport::getPktPattern(const control_pkt_type type)
     }
 }
 
+uint8_t H5Transport::syncConfigField(const uint8_t slidingWindowSize)
+{
+    return static_cast<uint8_t>((SyncConfigField & ~SyncConfigSlidingWindowSizeMask) |
+                                (slidingWindowSize & SyncConfigSlidingWindowSizeMask));
+}
+
+void H5Transport::negotiateSlidingWindowSize(const payload_t &syncConfigPacket)
+{
+    // Use the smallest sliding window of the two, peers not reporting a configuration field get a
+    // window of 1
+    auto peerSlidingWindowSize = MinSlidingWindowSize;
+
+    if (syncConfigPacket.size() > 2)
+    {
+        peerSlidingWindowSize =
+            std::max(static_cast<uint8_t>(syncConfigPacket[2] & SyncConfigSlidingWindowSizeMask),
+                     MinSlidingWindowSize);
+    }
+
+    std::lock_guard<std::mutex> ackLock(ackMutex);
+    negotiatedSlidingWindowSize = std::min(requestedSlidingWindowSize, peerSlidingWindowSize);
+}
+
 bool H5Transport::isSyncPacket(const payload_t &packet, const uint8_t offset)
 {
     return checkPattern(packet, offset, payload_t{SyncFirstByte, SyncSecondByte});
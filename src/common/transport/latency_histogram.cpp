@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+LatencyHistogram::LatencyHistogram() noexcept
+{
+    reset();
+}
+
+void LatencyHistogram::record(const std::chrono::nanoseconds duration) noexcept
+{
+    const auto value = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+
+    buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    samples.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    auto current = minimum.load(std::memory_order_relaxed);
+
+    while (value < current &&
+           !minimum.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {}
+
+    current = maximum.load(std::memory_order_relaxed);
+
+    while (value > current &&
+           !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {}
+}
+
+void LatencyHistogram::reset() noexcept
+{
+    for (auto &bucket : buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+
+    samples.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    minimum.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    maximum.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const noexcept
+{
+    return samples.load(std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds LatencyHistogram::min() const noexcept
+{
+    const auto value = minimum.load(std::memory_order_relaxed);
+    return std::chrono::nanoseconds(value == std::numeric_limits<uint64_t>::max() ? 0 : value);
+}
+
+std::chrono::nanoseconds LatencyHistogram::max() const noexcept
+{
+    return std::chrono::nanoseconds(maximum.load(std::memory_order_relaxed));
+}
+
+std::chrono::nanoseconds LatencyHistogram::mean() const noexcept
+{
+    const auto sampleCount = count();
+
+    if (sampleCount == 0)
+    {
+        return std::chrono::nanoseconds::zero();
+    }
+
+    return std::chrono::nanoseconds(sum.load(std::memory_order_relaxed) / sampleCount);
+}
+
+std::chrono::nanoseconds LatencyHistogram::percentile(const double percentile) const noexcept
+{
+    uint64_t total = 0;
+
+    for (const auto &bucket : buckets)
+    {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+
+    if (total == 0)
+    {
+        return std::chrono::nanoseconds::zero();
+    }
+
+    const auto fraction = std::min(std::max(percentile, 0.0), 100.0) / 100.0;
+    const auto target =
+        std::max<uint64_t>(static_cast<uint64_t>(std::ceil(fraction * total)), 1);
+
+    uint64_t counted = 0;
+
+    for (size_t index = 0; index < buckets.size(); index++)
+    {
+        counted += buckets[index].load(std::memory_order_relaxed);
+
+        if (counted >= target)
+        {
+            // The last bucket also counts values above its bound
+            if (index == buckets.size() - 1)
+            {
+                return max();
+            }
+
+            // The bound of the bucket may be above every sample counted in it
+            const auto bound = static_cast<int64_t>(bucketUpperBound(index));
+            return std::chrono::nanoseconds(std::min<int64_t>(bound, max().count()));
+        }
+    }
+
+    return max();
+}
+
+uint64_t LatencyHistogram::bucketCount(const size_t index) const noexcept
+{
+    return index < buckets.size() ? buckets[index].load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(const size_t index) noexcept
+{
+    if (index < LatencyHistogramSubBuckets)
+    {
+        return index;
+    }
+
+    const auto shift    = index / LatencyHistogramSubBuckets - 1;
+    const auto subIndex = index % LatencyHistogramSubBuckets;
+    const auto lower    = (LatencyHistogramSubBuckets + subIndex) << shift;
+
+    return lower + (uint64_t(1) << shift) - 1;
+}
+
+size_t LatencyHistogram::bucketIndex(const uint64_t value) noexcept
+{
+    if (value < LatencyHistogramSubBuckets)
+    {
+        return static_cast<size_t>(value);
+    }
+
+    uint32_t magnitude = LatencyHistogramSubBucketBits;
+
+    while (magnitude < LatencyHistogramMagnitudes && (value >> (magnitude + 1)) != 0)
+    {
+        magnitude++;
+    }
+
+    if (magnitude >= LatencyHistogramMagnitudes)
+    {
+        return LatencyHistogramBucketCount - 1;
+    }
+
+    const auto shift = magnitude - LatencyHistogramSubBucketBits;
+
+    return (shift + 1) * LatencyHistogramSubBuckets +
+           static_cast<size_t>((value >> shift) - LatencyHistogramSubBuckets);
+}
+
+uint32_t toMicroseconds(const std::chrono::nanoseconds duration) noexcept
+{
+    const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+    return static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(microseconds.count(), 0),
+                                                   std::numeric_limits<uint32_t>::max()));
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "rtt_estimator.h"
+
+#include <algorithm>
+
+namespace {
+// Constants recommended by RFC 6298, alpha = 1/8 and beta = 1/4 are applied as shifts
+constexpr int RttAlphaShift          = 3;
+constexpr int RttBetaShift           = 2;
+constexpr int RttVarianceMultiplier = 4;
+
+// Resolution of the timers waiting for acknowledgements
+constexpr std::chrono::microseconds ClockGranularity = std::chrono::milliseconds(1);
+} // namespace
+
+RttEstimator::RttEstimator(const std::chrono::microseconds initialTimeout,
+                           const std::chrono::microseconds minimumTimeout,
+                           const std::chrono::microseconds maximumTimeout) noexcept
+    : initial(std::min(std::max(initialTimeout, minimumTimeout), maximumTimeout))
+    , minimum(minimumTimeout)
+    , maximum(maximumTimeout)
+    , sampled(false)
+    , srtt(0)
+    , rttvar(0)
+    , rto(initial)
+{}
+
+void RttEstimator::addSample(const std::chrono::microseconds rtt) noexcept
+{
+    if (!sampled)
+    {
+        srtt    = rtt;
+        rttvar  = rtt / 2;
+        sampled = true;
+    }
+    else
+    {
+        const auto deviation = srtt > rtt ? srtt - rtt : rtt - srtt;
+        rttvar += (deviation - rttvar) / (1 << RttBetaShift);
+        srtt += (rtt - srtt) / (1 << RttAlphaShift);
+    }
+
+    rto = clamp(srtt + std::max(ClockGranularity, RttVarianceMultiplier * rttvar));
+}
+
+void RttEstimator::backOff() noexcept
+{
+    rto = clamp(rto * 2);
+}
+
+void RttEstimator::reset() noexcept
+{
+    sampled = false;
+    srtt    = std::chrono::microseconds::zero();
+    rttvar  = std::chrono::microseconds::zero();
+    rto     = initial;
+}
+
+bool RttEstimator::hasSample() const noexcept
+{
+    return sampled;
+}
+
+std::chrono::microseconds RttEstimator::smoothedRtt() const noexcept
+{
+    return srtt;
+}
+
+std::chrono::microseconds RttEstimator::rttVariation() const noexcept
+{
+    return rttvar;
+}
+
+std::chrono::microseconds RttEstimator::timeout() const noexcept
+{
+    return rto;
+}
+
+std::chrono::microseconds RttEstimator::maximumTimeout() const noexcept
+{
+    return maximum;
+}
+
+std::chrono::microseconds RttEstimator::clamp(const std::chrono::microseconds timeout) const
+    noexcept
+{
+    return std::min(std::max(timeout, minimum), maximum);
+}
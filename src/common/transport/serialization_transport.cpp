@@ -42,24 +42,100 @@
 #include "nrf_error.h"
 
 #include "ble_common.h"
+#include "serialized_event.h"
+#include "span_tracer.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iterator>
 #include <memory>
 #include <sstream>
 
+namespace {
+// Events that are queued in the high priority lane by default. Connection and security
+// procedures, and requests the SoftDevice times out if they are not answered.
+const uint16_t HighPriorityEvents[] = {
+    BLE_GAP_EVT_CONNECTED,
+    BLE_GAP_EVT_DISCONNECTED,
+    BLE_GAP_EVT_CONN_PARAM_UPDATE_REQUEST,
+    BLE_GAP_EVT_SEC_PARAMS_REQUEST,
+    BLE_GAP_EVT_SEC_INFO_REQUEST,
+    BLE_GAP_EVT_PASSKEY_DISPLAY,
+    BLE_GAP_EVT_AUTH_KEY_REQUEST,
+    BLE_GAP_EVT_LESC_DHKEY_REQUEST,
+    BLE_GAP_EVT_AUTH_STATUS,
+    BLE_GAP_EVT_CONN_SEC_UPDATE,
+    BLE_GAP_EVT_SEC_REQUEST,
+#if NRF_SD_BLE_API_VERSION >= 5
+    BLE_GAP_EVT_PHY_UPDATE_REQUEST,
+    BLE_GAP_EVT_DATA_LENGTH_UPDATE_REQUEST,
+#endif
+    BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST,
+    BLE_GATTS_EVT_SYS_ATTR_MISSING,
+#if NRF_SD_BLE_API_VERSION >= 3
+    BLE_GATTS_EVT_EXCHANGE_MTU_REQUEST,
+#endif
+    BLE_EVT_USER_MEM_REQUEST,
+};
+
+// Flag of queued events discarded by the event filter
+constexpr uint8_t EventFlagDiscarded = 0x01;
+
+// Decoders of these events update state kept by the driver for the application, like key storage
+// and advertising buffers. They are decoded also when the event filter discards them.
+bool decoderKeepsState(const uint16_t eventId)
+{
+    switch (eventId)
+    {
+        case BLE_EVT_USER_MEM_RELEASE:
+        case BLE_GAP_EVT_AUTH_STATUS:
+#if NRF_SD_BLE_API_VERSION >= 6
+#if !defined(S112)
+        case BLE_GAP_EVT_ADV_REPORT:
+#endif
+        case BLE_GAP_EVT_ADV_SET_TERMINATED:
+#endif
+            return true;
+        default:
+            return false;
+    }
+}
+} // namespace
+
 SerializationTransport::SerializationTransport(H5Transport *dataLinkLayer,
                                                uint32_t response_timeout)
     : statusCallback(nullptr)
     , eventCallback(nullptr)
+    , discardedEventCallback(nullptr)
     , logCallback(nullptr)
-    , responseReceived(false)
-    , responseBuffer(nullptr)
+    , traceAdapter(0)
+    , nextResponseId(0)
+    , eventQueue(new EventRing(EventQueueCapacity, EventLaneCount, EventQueueOverflowReserve))
     , processEvents(false)
+    , filteredEvents(0)
+    , filteredAdvReports(0)
+    , eventQueueOverflowPolicy(EventQueueDefaultOverflowPolicy)
+    , droppedEvents(0)
+    , coalescedEvents(0)
+    , lostEvents(0)
+    , eventDispatch(SD_RPC_EVT_DISPATCH_EVENT_THREAD)
+    , inlineDispatchThread(std::thread::id())
+    , eventSlabs(new EventSlabPool(EventSlabCount, MaxPossibleEventLength))
+    , eventBatchCallback(nullptr)
+    , eventBatchMaxCount(1)
+    , eventBatchTimeBudget(0)
     , isOpen(false)
 {
     // SerializationTransport takes ownership of dataLinkLayer provided object
     nextTransportLayer = std::shared_ptr<H5Transport>(dataLinkLayer);
     responseTimeout    = response_timeout;
+
+    eventLanes.fill(EventLaneNormal);
+
+    for (const auto eventId : HighPriorityEvents)
+    {
+        eventLanes[eventId] = EventLaneHigh;
+    }
 }
 
 SerializationTransport::~SerializationTransport()
@@ -72,7 +148,8 @@ SerializationTransport::~SerializationTransport()
 
 uint32_t SerializationTransport::open(const status_cb_t &status_callback,
                                       const evt_cb_t &event_callback,
-                                      const log_cb_t &log_callback) noexcept
+                                      const log_cb_t &log_callback,
+                                      const evt_cb_t &discarded_event_callback) noexcept
 {
     std::lock_guard<std::recursive_mutex> openLck(isOpenMutex);
 
@@ -81,13 +158,31 @@ uint32_t SerializationTransport::open(const status_cb_t &status_callback,
         return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_ALREADY_OPEN;
     }
 
-    statusCallback = status_callback;
-    eventCallback  = event_callback;
-    logCallback    = log_callback;
+    statusCallback         = status_callback;
+    eventCallback          = event_callback;
+    discardedEventCallback = discarded_event_callback;
+    logCallback            = log_callback;
 
     const auto dataCallback = std::bind(&SerializationTransport::readHandler, this,
                                         std::placeholders::_1, std::placeholders::_2);
 
+    eventQueue->start();
+
+    // Events left from before the transport was closed are dropped before the link is opened,
+    // the events received from then on are all passed
+    {
+        std::lock_guard<std::mutex> pullLck(pullMutex);
+        drainEventQueue();
+        eventNotifier.clear();
+    }
+
+    droppedEvents      = 0;
+    coalescedEvents    = 0;
+    lostEvents         = 0;
+    filteredEvents     = 0;
+    filteredAdvReports = 0;
+    lastOverflowReport = std::chrono::steady_clock::now() - EventQueueOverflowReportInterval;
+
     const auto errorCode = nextTransportLayer->open(status_callback, dataCallback, log_callback);
 
     if (errorCode != NRF_SUCCESS)
@@ -97,22 +192,18 @@ uint32_t SerializationTransport::open(const status_cb_t &status_callback,
 
     isOpen = true;
 
+    if (eventDispatch == SD_RPC_EVT_DISPATCH_PULL)
+    {
+        // Events wait in eventQueue until the application takes them
+        processEvents = true;
+        return NRF_SUCCESS;
+    }
+
     // Thread should not be running from before when calling this
     if (!eventThread.joinable())
     {
-        // If ::close is called when this method (::open) returns
-        // and eventThread is executing somewhere between while (isOpen)
-        // and eventWaitCondition notification we could get a deadlock.
-        //
-        // To prevent this, lock eventMutex in this thread, let eventThread
-        // wait until eventMutex is unlocked (.wait in this thread).
-        // When eventThread is started and outside critical region,
-        // let eventThread notify eventWaitCondition, making .wait
-        // return
-        std::unique_lock<std::mutex> eventLock(eventMutex);
         processEvents = true;
         eventThread   = std::thread([this] { eventHandlingRunner(); });
-        eventWaitCondition.wait(eventLock);
     }
     else
     {
@@ -122,16 +213,290 @@ uint32_t SerializationTransport::open(const status_cb_t &status_callback,
     return NRF_SUCCESS;
 }
 
+void SerializationTransport::getStats(sd_rpc_stats_t &stats) noexcept
+{
+    nextTransportLayer->getStats(stats);
+
+    stats.event_queue_depth          = static_cast<uint32_t>(eventQueue->size());
+    stats.event_queue_high_water     = static_cast<uint32_t>(eventQueue->highWaterMark());
+    stats.event_queue_dropped        = droppedEvents;
+    stats.event_queue_coalesced      = coalescedEvents;
+    stats.event_queue_lost           = lostEvents;
+    stats.event_filtered             = filteredEvents;
+    stats.event_filtered_adv_reports = filteredAdvReports;
+
+    stats.command_count          = static_cast<uint32_t>(commandLatency.count());
+    stats.command_latency_p50_us = toMicroseconds(commandLatency.percentile(50));
+    stats.command_latency_p90_us = toMicroseconds(commandLatency.percentile(90));
+    stats.command_latency_p99_us = toMicroseconds(commandLatency.percentile(99));
+    stats.command_latency_max_us = toMicroseconds(commandLatency.max());
+}
+
+std::string SerializationTransport::portName() const
+{
+    return nextTransportLayer->portName();
+}
+
+CommandLatencies &SerializationTransport::commandLatencies() noexcept
+{
+    return latencies;
+}
+
+void SerializationTransport::setLogSeverityFilter(const sd_rpc_log_severity_t severity) noexcept
+{
+    nextTransportLayer->setLogSeverityFilter(severity);
+}
+
+void SerializationTransport::setTraceAdapter(const uint32_t adapter) noexcept
+{
+    traceAdapter = adapter;
+    nextTransportLayer->setTraceAdapter(adapter);
+}
+
+void SerializationTransport::setLogChannel(const uint32_t channel) noexcept
+{
+    nextTransportLayer->setLogChannel(channel);
+}
+
+uint32_t SerializationTransport::setEventQueueConfig(
+    const size_t capacity, const sd_rpc_evt_queue_overflow_t overflowPolicy) noexcept
+{
+    std::lock_guard<std::recursive_mutex> openLck(isOpenMutex);
+
+    // Events are pulled by the thread sending commands, a blocked read would hold up the
+    // responses until the thread pulls again
+    if (isOpen || (overflowPolicy == SD_RPC_EVT_QUEUE_OVERFLOW_BLOCK &&
+                   eventDispatch == SD_RPC_EVT_DISPATCH_PULL))
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    try
+    {
+        if (capacity != eventQueue->capacity())
+        {
+            eventQueue.reset(new EventRing(capacity, EventLaneCount, EventQueueOverflowReserve));
+        }
+    }
+    catch (const std::bad_alloc &)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    eventQueueOverflowPolicy = overflowPolicy;
+    return NRF_SUCCESS;
+}
+
+uint32_t SerializationTransport::setEventDispatch(const sd_rpc_evt_dispatch_t dispatch) noexcept
+{
+    std::lock_guard<std::recursive_mutex> openLck(isOpenMutex);
+
+    if (isOpen || (dispatch == SD_RPC_EVT_DISPATCH_PULL &&
+                   eventQueueOverflowPolicy == SD_RPC_EVT_QUEUE_OVERFLOW_BLOCK))
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if (dispatch == SD_RPC_EVT_DISPATCH_PULL)
+    {
+        const auto errCode = eventNotifier.open();
+
+        if (errCode != NRF_SUCCESS)
+        {
+            return errCode;
+        }
+    }
+
+    eventDispatch = dispatch;
+    return NRF_SUCCESS;
+}
+
+uint32_t SerializationTransport::getEvent(ble_evt_t *event, uint32_t &eventLength,
+                                          const std::chrono::milliseconds timeout) noexcept
+{
+    if (eventDispatch != SD_RPC_EVT_DISPATCH_PULL)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    // Decoders do not check the length of all fields they write
+    if (eventLength < MaxPossibleEventLength)
+    {
+        eventLength = MaxPossibleEventLength;
+        return NRF_ERROR_DATA_SIZE;
+    }
+
+    std::lock_guard<std::mutex> pullLck(pullMutex);
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    for (;;)
+    {
+        if (!processEvents)
+        {
+            return NRF_ERROR_INVALID_STATE;
+        }
+
+        auto eventData = eventQueue->tryBeginPop();
+
+        if (eventData == nullptr)
+        {
+            // An event queued after the check above notifies again
+            eventNotifier.clear();
+            eventData = eventQueue->beginPopUntil(deadline);
+        }
+
+        if (eventData == nullptr)
+        {
+            return processEvents ? NRF_ERROR_NOT_FOUND : NRF_ERROR_INVALID_STATE;
+        }
+
+        EventCodecContext context(this);
+
+        if ((eventQueue->flags() & EventFlagDiscarded) != 0)
+        {
+            uint32_t discardedLength = 0;
+            const auto discarded =
+                decodeEvent(eventData->data(), eventData->size(), discardedLength);
+            eventQueue->endPop();
+
+            if (discarded != nullptr)
+            {
+                if (discardedEventCallback)
+                {
+                    discardedEventCallback(discarded);
+                }
+
+                eventSlabs->put(reinterpret_cast<uint8_t *>(discarded), discardedLength);
+            }
+
+            continue;
+        }
+
+        std::memset(event, 0, MaxPossibleEventLength);
+        auto length        = static_cast<uint32_t>(MaxPossibleEventLength);
+        const auto errCode = ble_event_dec(
+            eventData->data(), static_cast<uint32_t>(eventData->size()), event, &length);
+        eventQueue->endPop();
+
+        if (errCode != NRF_SUCCESS)
+        {
+            reportDecodeError(errCode);
+            continue;
+        }
+
+        eventLength = length;
+        return NRF_SUCCESS;
+    }
+}
+
+uint32_t SerializationTransport::getEventFd(int &fd) const noexcept
+{
+    if (eventDispatch != SD_RPC_EVT_DISPATCH_PULL)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    fd = eventNotifier.fd();
+    return fd < 0 ? NRF_ERROR_NOT_SUPPORTED : NRF_SUCCESS;
+}
+
+uint32_t SerializationTransport::setEventPriority(const uint16_t eventId,
+                                                  const sd_rpc_evt_priority_t priority) noexcept
+{
+    std::lock_guard<std::recursive_mutex> openLck(isOpenMutex);
+
+    if (isOpen)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if (eventId >= eventLanes.size())
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    eventLanes[eventId] = priority == SD_RPC_EVT_PRIORITY_HIGH ? EventLaneHigh : EventLaneNormal;
+    return NRF_SUCCESS;
+}
+
+uint32_t SerializationTransport::setEventBatchConfig(
+    const evt_batch_cb_t &callback, const uint32_t maxCount,
+    const std::chrono::microseconds timeBudget) noexcept
+{
+    std::lock_guard<std::recursive_mutex> openLck(isOpenMutex);
+
+    if (isOpen)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    const auto batchCount = callback ? maxCount : 1;
+
+    if (batchCount == 0 || batchCount > EventBatchMaxCount)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    // Events retained by the application keep their slabs over close and open
+    if (eventSlabs->retained() > 0)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    try
+    {
+        // All events of a batch are decoded before the batch is passed, the application may
+        // still retain as many events as without batches
+        const auto slabCount = EventSlabCount + batchCount - 1;
+
+        if (slabCount != eventSlabs->slabCount())
+        {
+            eventSlabs.reset(new EventSlabPool(slabCount, MaxPossibleEventLength));
+        }
+
+        eventBatch.resize(batchCount);
+        eventBatchLengths.resize(batchCount);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    eventBatchCallback   = callback;
+    eventBatchMaxCount   = batchCount;
+    eventBatchTimeBudget = timeBudget;
+    return NRF_SUCCESS;
+}
+
+EventFilter &SerializationTransport::eventFilter() noexcept
+{
+    return filter;
+}
+
+uint32_t SerializationTransport::retainEvent(const ble_evt_t *event) noexcept
+{
+    return eventSlabs->retain(event);
+}
+
+uint32_t SerializationTransport::releaseEvent(const ble_evt_t *event) noexcept
+{
+    return eventSlabs->release(event);
+}
+
 uint32_t SerializationTransport::close() noexcept
 {
-    // Stop event processing thread before closing since
-    // event callbacks may in application space invoke new calls to SerializationTransport
+    // Closing joins the H5Transport thread
+    if (isInlineDispatchThread())
     {
-        std::unique_lock<std::mutex> eventLock(eventMutex);
-        processEvents = false;
-        eventWaitCondition.notify_all();
+        return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_INVALID_STATE;
     }
 
+    // Stop event processing thread before closing since
+    // event callbacks may in application space invoke new calls to SerializationTransport
+    processEvents = false;
+    eventQueue->stop();
+
     if (eventThread.joinable())
     {
         if (std::this_thread::get_id() == eventThread.get_id())
@@ -161,138 +526,390 @@ uint32_t SerializationTransport::close() noexcept
 
     isOpen = false;
 
-    return nextTransportLayer->close();
+    const auto errCode = nextTransportLayer->close();
+
+    // Responses to commands still pending will not be received
+    failPendingResponses(NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_INVALID_STATE);
+
+    return errCode;
+}
+
+namespace {
+std::shared_ptr<TxBuffer> toTxBuffer(const std::vector<uint8_t> &data)
+{
+    auto buffer = std::make_shared<TxBuffer>(data.size());
+    std::copy(data.begin(), data.end(), buffer->payload());
+    buffer->setPayloadLength(data.size());
+    return buffer;
 }
+} // namespace
 
 uint32_t SerializationTransport::send(const std::vector<uint8_t> &cmdBuffer,
                                       std::shared_ptr<std::vector<uint8_t>> rspBuffer,
                                       serialization_pkt_type_t pktType) noexcept
 {
-    std::lock_guard<std::recursive_mutex> openLck(isOpenMutex);
-
-    if (!isOpen)
+    try
     {
-        return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_INVALID_STATE;
+        return send(toTxBuffer(cmdBuffer), rspBuffer, pktType);
+    }
+    catch (const std::exception &)
+    {
+        return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT;
     }
+}
+
+uint32_t SerializationTransport::send(const std::shared_ptr<TxBuffer> &cmdBuffer,
+                                      std::shared_ptr<std::vector<uint8_t>> rspBuffer,
+                                      serialization_pkt_type_t pktType) noexcept
+{
+    std::shared_ptr<ResponseCompletion> completion;
 
-    // Mutex to avoid multiple threads sending commands at the same time.
-    std::lock_guard<std::mutex> sendGuard(sendMutex);
-    responseReceived = false;
-    responseBuffer   = rspBuffer;
+    try
+    {
+        completion = acquireResponseCompletion();
+    }
+    catch (const std::bad_alloc &)
+    {
+        return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT;
+    }
 
-    std::vector<uint8_t> commandBuffer(cmdBuffer.size() + 1);
-    commandBuffer[0] = pktType;
-    std::copy(cmdBuffer.begin(), cmdBuffer.end(), commandBuffer.begin() + 1);
+    // The payload is SLIP encoded in place when it is sent
+    const auto opcode = cmdBuffer->payload()[0];
+    const auto sentAt = std::chrono::steady_clock::now();
 
-    const auto errCode = nextTransportLayer->send(commandBuffer);
+    uint32_t responseId;
+    const auto errCode = sendAsync(cmdBuffer, rspBuffer, nullptr, completion, pktType, responseId);
 
     if (errCode != NRF_SUCCESS)
     {
         return errCode;
     }
 
+    std::unique_lock<std::mutex> completionGuard(completion->mutex);
+
+    // Without a response the command is completed when it is acknowledged
     if (!rspBuffer)
     {
-        return NRF_SUCCESS;
+        completion->condition.wait(completionGuard, [&] { return completion->completed; });
+        return completion->errorCode;
     }
 
-    std::unique_lock<std::mutex> responseGuard(responseMutex);
+    // The data link layer acknowledges or fails the command after its retransmissions, a failed
+    // command is completed
+    completion->condition.wait(completionGuard,
+                               [&] { return completion->acknowledged || completion->completed; });
+
+    // The response may be received before the acknowledgement is passed on
+    const auto acknowledgedAt =
+        completion->acknowledged ? completion->acknowledgedAt : std::chrono::steady_clock::now();
+
+    TraceSpan responseSpan("response_wait", traceAdapter);
+    responseSpan.opcode(opcode);
 
     const std::chrono::milliseconds timeout(responseTimeout);
-    const auto wakeupTime = std::chrono::system_clock::now() + timeout;
+    completion->condition.wait_until(completionGuard, acknowledgedAt + timeout,
+                                     [&] { return completion->completed; });
+
+    if (completion->completed)
+    {
+        if (pktType == SERIALIZATION_COMMAND && completion->errorCode == NRF_SUCCESS)
+        {
+            latencies.record(opcode, SD_RPC_CMD_PHASE_WIRE, acknowledgedAt - sentAt);
+            latencies.record(opcode, SD_RPC_CMD_PHASE_RESPONSE,
+                             std::chrono::steady_clock::now() - acknowledgedAt);
+        }
+
+        return completion->errorCode;
+    }
 
-    responseWaitCondition.wait_until(responseGuard, wakeupTime, [&] { return responseReceived; });
+    completionGuard.unlock();
+
+    bool removed;
 
-    if (!responseReceived)
     {
-        logCallback(SD_RPC_LOG_WARNING, "Failed to receive response for command");
-        return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_NO_RESPONSE;
+        std::lock_guard<std::mutex> responseGuard(responseMutex);
+        removed = removePendingResponse(responseId);
     }
 
-    return NRF_SUCCESS;
+    if (!removed)
+    {
+        // The response was received after the timeout but before the pending response could be
+        // removed, the response callback has completed or is about to complete the command.
+        completionGuard.lock();
+        completion->condition.wait(completionGuard, [&] { return completion->completed; });
+        return completion->errorCode;
+    }
+
+    logCallback(SD_RPC_LOG_WARNING, "Failed to receive response for command");
+    return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_NO_RESPONSE;
 }
 
-void SerializationTransport::drainEventQueue()
+uint32_t SerializationTransport::sendAsync(const std::vector<uint8_t> &cmdBuffer,
+                                           std::shared_ptr<std::vector<uint8_t>> rspBuffer,
+                                           const rsp_cb_t &responseCallback,
+                                           serialization_pkt_type_t pktType) noexcept
 {
-    std::unique_lock<std::mutex> eventLock(eventMutex);
+    try
+    {
+        return sendAsync(toTxBuffer(cmdBuffer), rspBuffer, responseCallback, pktType);
+    }
+    catch (const std::exception &)
+    {
+        return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT;
+    }
+}
+
+uint32_t SerializationTransport::sendAsync(const std::shared_ptr<TxBuffer> &cmdBuffer,
+                                           std::shared_ptr<std::vector<uint8_t>> rspBuffer,
+                                           const rsp_cb_t &responseCallback,
+                                           serialization_pkt_type_t pktType) noexcept
+{
+    uint32_t responseId;
+    return sendAsync(cmdBuffer, rspBuffer, responseCallback, nullptr, pktType, responseId);
+}
+
+uint32_t SerializationTransport::sendAsync(
+    const std::shared_ptr<TxBuffer> &cmdBuffer,
+    const std::shared_ptr<std::vector<uint8_t>> &rspBuffer, const rsp_cb_t &responseCallback,
+    const std::shared_ptr<ResponseCompletion> &completion, serialization_pkt_type_t pktType,
+    uint32_t &responseId) noexcept
+{
+    // Neither the acknowledgement nor the response can be received while the H5Transport thread
+    // runs an event callback
+    if (isInlineDispatchThread())
+    {
+        return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_INVALID_STATE;
+    }
+
+    {
+        // Not held while the command is sent, ::close fails the outstanding commands
+        std::lock_guard<std::recursive_mutex> openLck(isOpenMutex);
+
+        if (!isOpen)
+        {
+            return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_INVALID_STATE;
+        }
+    }
 
-    // Drain the queue for any old events
     try
     {
-        while (!eventQueue.empty())
+        // Packet type is added in front of the command without copying it
+        *cmdBuffer->prepend(1) = pktType;
+
+        // Callback of the data link layer. Only the response ID is captured for commands with a
+        // response, the callback is then stored without allocating memory.
+        sent_cb_t sentCallback;
+
+        // Mutex to avoid multiple threads sending commands at the same time, the response to
+        // this command must be queued before a response to a later command can be received.
+        std::lock_guard<std::mutex> sendGuard(sendMutex);
+
+        if (rspBuffer)
         {
-            eventQueue.pop();
+            std::lock_guard<std::mutex> responseGuard(responseMutex);
+            responseId = nextResponseId++;
+            pendingResponses.push_back({responseId, rspBuffer, responseCallback, completion,
+                                        std::chrono::steady_clock::now()});
+
+            sentCallback = [this, responseId](const uint32_t errorCode) {
+                commandSent(responseId, errorCode);
+            };
+        }
+        else if (completion)
+        {
+            sentCallback = [completion](const uint32_t errorCode) {
+                std::lock_guard<std::mutex> completionGuard(completion->mutex);
+                completion->errorCode = errorCode;
+                completion->completed = true;
+                completion->condition.notify_one();
+            };
+        }
+        else
+        {
+            sentCallback = responseCallback;
+        }
+
+        // Returns when the command has a sequence number and is written, the callback is invoked
+        // when it is acknowledged
+        const auto errCode = nextTransportLayer->sendAsync(cmdBuffer, sentCallback);
+
+        if (errCode != NRF_SUCCESS)
+        {
+            if (rspBuffer)
+            {
+                std::lock_guard<std::mutex> responseGuard(responseMutex);
+                removePendingResponse(responseId);
+            }
+
+            return errCode;
         }
     }
     catch (const std::exception &)
     {
-        logCallback(SD_RPC_LOG_ERROR, "Error in SerializationTransport::drainEventQueue");
+        return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT;
+    }
+
+    return NRF_SUCCESS;
+}
+
+void SerializationTransport::commandSent(const uint32_t responseId, const uint32_t errorCode)
+{
+    std::unique_lock<std::mutex> responseGuard(responseMutex);
+
+    // The response may already be received, or the command may have timed out
+    const auto pendingResponse = std::find_if(
+        pendingResponses.begin(), pendingResponses.end(),
+        [responseId](const PendingResponse &response) { return response.id == responseId; });
+
+    if (pendingResponse == pendingResponses.end())
+    {
+        return;
+    }
+
+    if (errorCode == NRF_SUCCESS)
+    {
+        if (pendingResponse->completion)
+        {
+            const auto &completion = pendingResponse->completion;
+            std::lock_guard<std::mutex> completionGuard(completion->mutex);
+            completion->acknowledgedAt = std::chrono::steady_clock::now();
+            completion->acknowledged   = true;
+            completion->condition.notify_one();
+        }
+
+        return;
+    }
+
+    auto failedResponse = std::move(*pendingResponse);
+    pendingResponses.erase(pendingResponse);
+    responseGuard.unlock();
+
+    completePendingResponse(failedResponse, errorCode);
+}
+
+bool SerializationTransport::removePendingResponse(const uint32_t id)
+{
+    for (auto it = pendingResponses.begin(); it != pendingResponses.end(); ++it)
+    {
+        if (it->id == id)
+        {
+            pendingResponses.erase(it);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SerializationTransport::failPendingResponses(const uint32_t errorCode)
+{
+    std::vector<PendingResponse> failedResponses;
+
+    {
+        std::lock_guard<std::mutex> responseGuard(responseMutex);
+        failedResponses.swap(pendingResponses);
+    }
+
+    for (auto &pendingResponse : failedResponses)
+    {
+        completePendingResponse(pendingResponse, errorCode);
     }
 }
 
+std::shared_ptr<SerializationTransport::ResponseCompletion>
+SerializationTransport::acquireResponseCompletion()
+{
+    // A completion still referred to by a pending response of a command that timed out is not
+    // reused
+    thread_local std::shared_ptr<ResponseCompletion> completion;
+
+    if (!completion || completion.use_count() > 1)
+    {
+        completion = std::make_shared<ResponseCompletion>();
+    }
+
+    completion->acknowledged = false;
+    completion->completed    = false;
+    completion->errorCode    = NRF_SUCCESS;
+    return completion;
+}
+
+void SerializationTransport::completePendingResponse(PendingResponse &pendingResponse,
+                                                     const uint32_t errorCode)
+{
+    // The sender may reuse the response buffer as soon as the command is completed
+    pendingResponse.buffer.reset();
+
+    if (pendingResponse.callback)
+    {
+        pendingResponse.callback(errorCode);
+    }
+
+    if (pendingResponse.completion)
+    {
+        // The sending thread refers to the completion until it is completed. The reference of
+        // the pending response is released first, the completion can then be reused as soon as
+        // the sending thread returns.
+        const auto completion = pendingResponse.completion.get();
+        std::lock_guard<std::mutex> completionGuard(completion->mutex);
+        pendingResponse.completion.reset();
+        completion->errorCode = errorCode;
+        completion->completed = true;
+        completion->condition.notify_one();
+    }
+}
+
+void SerializationTransport::drainEventQueue()
+{
+    eventQueue->clear();
+}
+
 // Event Thread
 void SerializationTransport::eventHandlingRunner() noexcept
 {
     try
     {
-        drainEventQueue();
-
-        std::unique_lock<std::mutex> eventLock(eventMutex);
-
         while (processEvents)
         {
-            // Suspend this thread until event wait condition
-            // is notified. This can happen from ::close and
-            // ::readHandler (thread in H5Transport)
-            eventWaitCondition.notify_all();
-            eventWaitCondition.wait(eventLock);
+            // Oldest event received from the H5Transport thread, waits until an event is
+            // received or ::close stops the queue
+            const auto eventData = eventQueue->beginPop();
 
-            while (!eventQueue.empty() && processEvents)
+            if (eventData == nullptr || !processEvents)
             {
-                // Get oldest event received from UART thread
-                const auto eventData     = eventQueue.front();
-                const auto eventDataSize = static_cast<uint32_t>(eventData.size());
-
-                // Remove oldest event received from H5Transport thread
-                eventQueue.pop();
+                break;
+            }
 
-                // Let UART thread add events to eventQueue
-                // while popped event is processed
-                eventLock.unlock();
+            // Set codec context
+            EventCodecContext context(this);
 
-                // Set codec context
-                EventCodecContext context(this);
+            if (eventBatchCallback)
+            {
+                handleEventBatch(eventData);
+                continue;
+            }
 
-                // Allocate memory to store decoded event including an unknown quantity of padding
-                auto possibleEventLength = static_cast<uint32_t>(MaxPossibleEventLength);
-                std::vector<uint8_t> eventDecodeBuffer;
-                eventDecodeBuffer.resize(MaxPossibleEventLength);
-                const auto event = reinterpret_cast<ble_evt_t *>(eventDecodeBuffer.data());
+            const auto discarded = (eventQueue->flags() & EventFlagDiscarded) != 0;
+            uint32_t eventLength = 0;
+            const auto event     = decodeEvent(eventData->data(), eventData->size(), eventLength);
+            eventQueue->endPop();
 
-                // Decode event
-                const auto errCode =
-                    ble_event_dec(eventData.data(), eventDataSize, event, &possibleEventLength);
+            if (event == nullptr)
+            {
+                continue;
+            }
 
-                if (eventCallback && errCode == NRF_SUCCESS)
-                {
-                    eventCallback(event);
-                }
+            const auto &callback = discarded ? discardedEventCallback : eventCallback;
 
-                if (errCode != NRF_SUCCESS)
-                {
-                    std::stringstream logMessage;
-                    logMessage << "Failed to decode event, error code is " << std::dec << errCode
-                               << "/0x" << std::hex << errCode << ".";
-                    logCallback(SD_RPC_LOG_ERROR, logMessage.str());
-                    statusCallback(PKT_DECODE_ERROR, logMessage.str());
-                }
-
-                // Prevent UART from adding events to eventQueue
-                eventLock.lock();
+            if (callback)
+            {
+                TraceSpan callbackSpan("event_callback", traceAdapter);
+                callbackSpan.eventId(event->header.evt_id);
+                callback(event);
             }
-        }
 
-        eventWaitCondition.notify_all();
+            eventSlabs->put(reinterpret_cast<uint8_t *>(event), eventLength);
+        }
     }
     catch (const std::exception &e)
     {
@@ -302,6 +919,102 @@ void SerializationTransport::eventHandlingRunner() noexcept
     }
 }
 
+void SerializationTransport::handleEventBatch(std::vector<uint8_t> *eventData)
+{
+    // The batch holds the events already queued, the event thread does not wait for more
+    const auto deadline = std::chrono::steady_clock::now() + eventBatchTimeBudget;
+    uint32_t count      = 0;
+
+    while (eventData != nullptr)
+    {
+        const auto discarded = (eventQueue->flags() & EventFlagDiscarded) != 0;
+        uint32_t eventLength = 0;
+        const auto event     = decodeEvent(eventData->data(), eventData->size(), eventLength);
+        eventQueue->endPop();
+
+        if (event != nullptr && discarded)
+        {
+            if (discardedEventCallback)
+            {
+                discardedEventCallback(event);
+            }
+
+            eventSlabs->put(reinterpret_cast<uint8_t *>(event), eventLength);
+        }
+        else if (event != nullptr)
+        {
+            eventBatch[count]        = event;
+            eventBatchLengths[count] = eventLength;
+            count++;
+        }
+
+        if (count == eventBatchMaxCount || std::chrono::steady_clock::now() >= deadline ||
+            !processEvents)
+        {
+            break;
+        }
+
+        eventData = eventQueue->tryBeginPop();
+    }
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    {
+        TraceSpan callbackSpan("event_callback", traceAdapter);
+        eventBatchCallback(eventBatch.data(), count);
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        eventSlabs->put(reinterpret_cast<uint8_t *>(eventBatch[i]), eventBatchLengths[i]);
+    }
+}
+
+ble_evt_t *SerializationTransport::decodeEvent(const uint8_t *data, const size_t length,
+                                               uint32_t &eventLength)
+{
+    // Memory to store decoded event including an unknown quantity of padding, the slab is
+    // cleared since the decoders do not write all fields of all events
+    const auto slab = eventSlabs->take();
+
+    if (slab == nullptr)
+    {
+        logCallback(SD_RPC_LOG_ERROR, "No buffer available to decode event, event dropped");
+        return nullptr;
+    }
+
+    eventLength      = static_cast<uint32_t>(eventSlabs->slabSize());
+    const auto event = reinterpret_cast<ble_evt_t *>(slab);
+
+    // Decode event
+    TraceSpan decodeSpan("event_decode", traceAdapter);
+    const auto errCode = ble_event_dec(data, static_cast<uint32_t>(length), event, &eventLength);
+
+    if (errCode != NRF_SUCCESS)
+    {
+        // After a failure any part of the slab may have been written
+        eventSlabs->put(slab, eventSlabs->slabSize());
+        reportDecodeError(errCode);
+        return nullptr;
+    }
+
+    // The length of a decoded event covers all bytes written by the decoder
+    decodeSpan.eventId(event->header.evt_id);
+    return event;
+}
+
+void SerializationTransport::reportDecodeError(const uint32_t errCode)
+{
+    std::stringstream logMessage;
+    logMessage << "Failed to decode event, error code is " << std::dec << errCode << "/0x"
+               << std::hex << errCode << ".";
+    logCallback(SD_RPC_LOG_ERROR, logMessage.str());
+    statusCallback(PKT_DECODE_ERROR, logMessage.str());
+}
+
 void SerializationTransport::readHandler(const uint8_t *data, const size_t length)
 {
     const auto eventType = static_cast<serialization_pkt_type_t>(data[0]);
@@ -311,7 +1024,28 @@ void SerializationTransport::readHandler(const uint8_t *data, const size_t lengt
 
     if (eventType == SERIALIZATION_RESPONSE)
     {
-        if (responseBuffer && !responseBuffer->empty())
+        PendingResponse pendingResponse;
+
+        {
+            std::lock_guard<std::mutex> responseGuard(responseMutex);
+
+            if (pendingResponses.empty())
+            {
+                logCallback(SD_RPC_LOG_ERROR, "Received SERIALIZATION_RESPONSE but no command is "
+                                              "waiting for a response.");
+                return;
+            }
+
+            // Responses are received in the same order as the commands are sent
+            pendingResponse = std::move(pendingResponses.front());
+            pendingResponses.erase(pendingResponses.begin());
+        }
+
+        commandLatency.record(std::chrono::steady_clock::now() - pendingResponse.sentAt);
+
+        const auto &responseBuffer = pendingResponse.buffer;
+
+        if (!responseBuffer->empty())
         {
             if (responseBuffer->size() >= dataLength)
             {
@@ -330,18 +1064,11 @@ void SerializationTransport::readHandler(const uint8_t *data, const size_t lengt
                                           "provide a buffer for the reply.");
         }
 
-        std::lock_guard<std::mutex> responseGuard(responseMutex);
-        responseReceived = true;
-        responseWaitCondition.notify_one();
+        completePendingResponse(pendingResponse, NRF_SUCCESS);
     }
     else if (eventType == SERIALIZATION_EVENT)
     {
-        std::vector<uint8_t> event;
-        event.reserve(dataLength);
-        std::copy(startOfData, startOfData + dataLength, std::back_inserter(event));
-        std::lock_guard<std::mutex> eventLock(eventMutex);
-        eventQueue.push(std::move(event));
-        eventWaitCondition.notify_one();
+        receiveEvent(startOfData, dataLength);
     }
     else
     {
@@ -349,3 +1076,256 @@ void SerializationTransport::readHandler(const uint8_t *data, const size_t lengt
                     "Unknown Nordic Semiconductor vendor specific packet received");
     }
 }
+
+void SerializationTransport::receiveEvent(const uint8_t *data, const size_t length)
+{
+    uint8_t flags = 0;
+
+    if (!filter.pass(data, length))
+    {
+        filteredEvents.fetch_add(1, std::memory_order_relaxed);
+
+        const auto eventId = serialized_event_id(data, length);
+
+        if (!decoderKeepsState(eventId))
+        {
+            return;
+        }
+
+#if NRF_SD_BLE_API_VERSION >= 6 && !defined(S112)
+        // Each of these costs a decode and a scan start command round trip on the event thread
+        if (eventId == BLE_GAP_EVT_ADV_REPORT)
+        {
+            filteredAdvReports.fetch_add(1, std::memory_order_relaxed);
+        }
+#endif
+
+        flags = EventFlagDiscarded;
+    }
+
+    if (eventDispatch == SD_RPC_EVT_DISPATCH_INLINE && flags == 0)
+    {
+        dispatchEvent(data, length);
+        return;
+    }
+
+    queueEvent(data, length, flags);
+}
+
+void SerializationTransport::dispatchEvent(const uint8_t *data, const size_t length)
+{
+    EventCodecContext context(this);
+
+    uint32_t eventLength = 0;
+    const auto event     = decodeEvent(data, length, eventLength);
+
+    if (event == nullptr)
+    {
+        return;
+    }
+
+    inlineDispatchThread = std::this_thread::get_id();
+
+    {
+        TraceSpan callbackSpan("event_callback", traceAdapter);
+        callbackSpan.eventId(event->header.evt_id);
+
+        if (eventBatchCallback)
+        {
+            eventBatchCallback(&event, 1);
+        }
+        else if (eventCallback)
+        {
+            eventCallback(event);
+        }
+    }
+
+    inlineDispatchThread = std::thread::id();
+
+    eventSlabs->put(reinterpret_cast<uint8_t *>(event), eventLength);
+}
+
+bool SerializationTransport::isInlineDispatchThread() const noexcept
+{
+    return inlineDispatchThread == std::this_thread::get_id();
+}
+
+void SerializationTransport::queueEvent(const uint8_t *data, const size_t length,
+                                        const uint8_t flags)
+{
+    auto &queue = *eventQueue;
+
+    const auto eventId = serialized_event_id(data, length);
+    const auto lane    = eventId < eventLanes.size() ? eventLanes[eventId] : EventLaneNormal;
+
+    // Including the wait for room in a full lane
+    TraceSpan enqueueSpan("event_enqueue", traceAdapter);
+    enqueueSpan.eventId(eventId);
+
+    // Events of a connection are passed to the event callback in the order received, whatever
+    // their lanes
+    uint16_t connHandle;
+    const auto orderingKey = serialized_event_conn_handle(data, length, &connHandle) &&
+                                     connHandle != BLE_CONN_HANDLE_INVALID
+                                 ? connHandle
+                                 : EventRing::Unordered;
+
+    const auto overflowed =
+        eventQueueOverflowPolicy != SD_RPC_EVT_QUEUE_OVERFLOW_BLOCK && queue.full(lane);
+    std::vector<uint8_t> *event;
+    auto eventFlags = flags;
+
+    if (overflowed)
+    {
+        // Only advertising reports are dropped, and only if the policy drops them. Reports whose
+        // decoders keep state are passed to discardedEventCallback instead, the event thread
+        // decodes them before their slots are freed.
+        const auto dropReports = eventQueueOverflowPolicy != SD_RPC_EVT_QUEUE_OVERFLOW_SPILL;
+        const auto isAdvReport =
+            (flags & EventFlagDiscarded) == 0 && serialized_event_is_adv_report(data, length);
+        const auto discardOnly = decoderKeepsState(BLE_GAP_EVT_ADV_REPORT);
+        const auto mayDrop     = dropReports && isAdvReport && !discardOnly;
+
+        const auto isQueuedAdvReport = [](const std::vector<uint8_t> &queued) {
+            return serialized_event_is_adv_report(queued.data(), queued.size());
+        };
+        const auto isSameSource = [&](const std::vector<uint8_t> &queued) {
+            return serialized_adv_report_same_source(queued.data(), queued.size(), data, length);
+        };
+
+        auto coalesced = false;
+
+        if (dropReports && isAdvReport &&
+            eventQueueOverflowPolicy == SD_RPC_EVT_QUEUE_OVERFLOW_COALESCE_ADV_REPORT)
+        {
+            const auto replace = [&](std::vector<uint8_t> &queued) {
+                queued.assign(data, data + length);
+            };
+
+            coalesced = discardOnly ? queue.flagNewest(isSameSource, EventFlagDiscarded, lane)
+                                    : queue.rewriteNewest(isSameSource, replace, lane);
+
+            if (coalesced)
+            {
+                coalescedEvents.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // The received report replaced the queued report
+            if (coalesced && !discardOnly)
+            {
+                reportEventQueueOverflow();
+                return;
+            }
+        }
+
+        if (dropReports && !coalesced)
+        {
+            const auto dropped = discardOnly
+                                     ? queue.flagOldest(isQueuedAdvReport, EventFlagDiscarded, lane)
+                                     : queue.dropOldest(isQueuedAdvReport, lane);
+
+            if (dropped)
+            {
+                droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // Without an older report to drop the received report is the oldest
+            if (isAdvReport && !dropped)
+            {
+                droppedEvents.fetch_add(1, std::memory_order_relaxed);
+
+                if (!discardOnly)
+                {
+                    reportEventQueueOverflow();
+                    return;
+                }
+
+                eventFlags |= EventFlagDiscarded;
+            }
+        }
+
+        // Other events, and reports replacing a dropped report, take a slot of the reserve of the
+        // lane. Dropped events keep their slots until the event thread passes them.
+        event = queue.tryBeginPush(lane, true);
+
+        if (event == nullptr && mayDrop)
+        {
+            droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            reportEventQueueOverflow();
+            return;
+        }
+
+        // Events are pulled by the thread sending commands, waiting here would hold up the
+        // responses until it pulls again
+        if (event == nullptr && eventDispatch == SD_RPC_EVT_DISPATCH_PULL)
+        {
+            droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            lostEvents.fetch_add(1, std::memory_order_relaxed);
+            reportLostEvent(eventId);
+            return;
+        }
+
+        if (event == nullptr)
+        {
+            // Other events are never dropped, reading waits for the event thread to make room
+            // in the reserve. Returns nullptr when the transport is closing.
+            event = queue.beginPush(lane, true);
+
+            if (event == nullptr)
+            {
+                return;
+            }
+        }
+    }
+    else
+    {
+        // Waits while the lane is full if the policy blocks, returns nullptr when the transport
+        // is closing
+        event = queue.beginPush(lane);
+
+        if (event == nullptr)
+        {
+            return;
+        }
+    }
+
+    event->assign(data, data + length);
+    queue.endPush(orderingKey, eventFlags);
+
+    if (eventDispatch == SD_RPC_EVT_DISPATCH_PULL)
+    {
+        eventNotifier.notify();
+    }
+
+    if (overflowed)
+    {
+        reportEventQueueOverflow();
+    }
+}
+
+void SerializationTransport::reportLostEvent(const uint16_t eventId)
+{
+    std::stringstream message;
+    message << "Event queue and its reserve full while events are pulled, event 0x" << std::hex
+            << eventId << std::dec << " lost, " << lostEvents << " events lost since open.";
+    logCallback(SD_RPC_LOG_ERROR, message.str());
+    statusCallback(EVENT_QUEUE_OVERFLOW, message.str());
+}
+
+void SerializationTransport::reportEventQueueOverflow()
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    if (now - lastOverflowReport < EventQueueOverflowReportInterval)
+    {
+        return;
+    }
+
+    lastOverflowReport = now;
+
+    std::stringstream message;
+    message << "Event queue full, " << droppedEvents << " events dropped and " << coalescedEvents
+            << " advertising reports coalesced since open.";
+    logCallback(SD_RPC_LOG_WARNING, message.str());
+    statusCallback(EVENT_QUEUE_OVERFLOW, message.str());
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "serialized_event.h"
+
+#include "ble.h"
+#include "ble_serialization.h"
+
+#include <cstring>
+
+namespace {
+constexpr size_t ConnHandlePosition = SER_EVT_HEADER_SIZE;
+
+// Positions in a serialized advertising report, see ble_gap_evt_adv_report_dec. The type byte
+// holds the flags that tell reports from the same peer apart, like the scan response flag.
+#if NRF_SD_BLE_API_VERSION > 5
+// Report type is a 16 bit field before the peer address, the flags are in the first byte
+constexpr size_t AdvReportTypePosition    = ConnHandlePosition + 2;
+constexpr uint8_t AdvReportTypeMask       = 0x1F;
+constexpr size_t AdvReportAddressPosition = AdvReportTypePosition + 2;
+// Direct address, primary PHY, secondary PHY and TX power come before the RSSI
+constexpr size_t AdvReportRssiPosition =
+    AdvReportAddressPosition + 2 * SerializedAdvReportAddressLength + 3;
+#elif NRF_SD_BLE_API_VERSION > 2
+// Direct address comes before the RSSI, scan response flag and type are packed after it
+constexpr size_t AdvReportAddressPosition = ConnHandlePosition + 2;
+constexpr size_t AdvReportRssiPosition =
+    AdvReportAddressPosition + 2 * SerializedAdvReportAddressLength;
+constexpr size_t AdvReportTypePosition = AdvReportRssiPosition + 1;
+constexpr uint8_t AdvReportTypeMask    = 0x07;
+#else
+// Scan response flag and type are packed with the data length after the RSSI
+constexpr size_t AdvReportAddressPosition = ConnHandlePosition + 2;
+constexpr size_t AdvReportRssiPosition =
+    AdvReportAddressPosition + SerializedAdvReportAddressLength;
+constexpr size_t AdvReportTypePosition = AdvReportRssiPosition + 1;
+constexpr uint8_t AdvReportTypeMask    = 0x07;
+#endif
+
+constexpr size_t AdvReportMinimumLength =
+    (AdvReportRssiPosition > AdvReportTypePosition ? AdvReportRssiPosition
+                                                   : AdvReportTypePosition) +
+    1;
+
+uint16_t readUint16(const uint8_t *data)
+{
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+} // namespace
+
+uint16_t serialized_event_id(const uint8_t *event, const size_t length)
+{
+    if (length < SER_EVT_HEADER_SIZE)
+    {
+        return 0;
+    }
+
+    return readUint16(event + SER_EVT_ID_POS);
+}
+
+bool serialized_event_conn_handle(const uint8_t *event, const size_t length,
+                                  uint16_t *conn_handle)
+{
+    if (length < ConnHandlePosition + 2)
+    {
+        return false;
+    }
+
+    *conn_handle = readUint16(event + ConnHandlePosition);
+    return true;
+}
+
+bool serialized_event_is_adv_report(const uint8_t *event, const size_t length)
+{
+#if defined(S112)
+    return false;
+#else
+    return serialized_event_id(event, length) == BLE_GAP_EVT_ADV_REPORT &&
+           length >= AdvReportMinimumLength;
+#endif
+}
+
+bool serialized_adv_report_peer(const uint8_t *event, const size_t length,
+                                const uint8_t **address, int8_t *rssi)
+{
+    if (!serialized_event_is_adv_report(event, length))
+    {
+        return false;
+    }
+
+    *address = event + AdvReportAddressPosition;
+    *rssi    = static_cast<int8_t>(event[AdvReportRssiPosition]);
+    return true;
+}
+
+bool serialized_adv_report_peer_addr(const uint8_t *event, const size_t length,
+                                     ble_gap_addr_t *peer_addr, int8_t *rssi)
+{
+    const uint8_t *address;
+
+    if (!serialized_adv_report_peer(event, length, &address, rssi))
+    {
+        return false;
+    }
+
+    // See ble_gap_addr_t_dec
+#if NRF_SD_BLE_API_VERSION > 2
+    peer_addr->addr_id_peer = address[0] & 0x01;
+    peer_addr->addr_type    = (address[0] >> 1) & 0x7F;
+#else
+    peer_addr->addr_type = address[0];
+#endif
+    std::memcpy(peer_addr->addr, address + 1, BLE_GAP_ADDR_LEN);
+
+    return true;
+}
+
+bool serialized_adv_report_same_source(const uint8_t *event, const size_t length,
+                                       const uint8_t *other, const size_t otherLength)
+{
+    if (!serialized_event_is_adv_report(event, length) ||
+        !serialized_event_is_adv_report(other, otherLength))
+    {
+        return false;
+    }
+
+    return std::memcmp(event + AdvReportAddressPosition, other + AdvReportAddressPosition,
+                       SerializedAdvReportAddressLength) == 0 &&
+           (event[AdvReportTypePosition] & AdvReportTypeMask) ==
+               (other[AdvReportTypePosition] & AdvReportTypeMask);
+}
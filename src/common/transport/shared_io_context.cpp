@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "shared_io_context.h"
+
+#include <exception>
+#include <mutex>
+
+namespace {
+std::mutex currentMutex;
+std::shared_ptr<SharedIoContext> currentInstance;
+} // namespace
+
+struct SharedIoContext::State
+{
+    State()
+        : workGuard(asio::make_work_guard(ioContext))
+    {}
+
+    asio::io_context ioContext;
+    asio::executor_work_guard<asio::io_context::executor_type> workGuard;
+};
+
+SharedIoContext::SharedIoContext(const uint32_t threadCount)
+    : state(std::make_shared<State>())
+{
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        const auto threadState = state;
+        threads.emplace_back([threadState] { run(*threadState); });
+    }
+}
+
+SharedIoContext::~SharedIoContext() noexcept
+{
+    state->workGuard.reset();
+    state->ioContext.stop();
+
+    for (auto &thread : threads)
+    {
+        if (thread.get_id() == std::this_thread::get_id())
+        {
+            thread.detach();
+        }
+        else if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+}
+
+asio::io_context &SharedIoContext::context() noexcept
+{
+    return state->ioContext;
+}
+
+std::shared_ptr<SharedIoContext> SharedIoContext::current()
+{
+    std::lock_guard<std::mutex> lck(currentMutex);
+    return currentInstance;
+}
+
+void SharedIoContext::setThreadCount(const uint32_t threadCount)
+{
+    std::shared_ptr<SharedIoContext> previous;
+
+    std::lock_guard<std::mutex> lck(currentMutex);
+    previous = std::move(currentInstance);
+
+    if (threadCount > 0)
+    {
+        currentInstance = std::make_shared<SharedIoContext>(threadCount);
+    }
+}
+
+void SharedIoContext::run(State &state) noexcept
+{
+    while (!state.ioContext.stopped())
+    {
+        try
+        {
+            state.ioContext.run();
+        }
+        catch (const std::exception &)
+        {
+            // A failing handler belongs to one adapter, keep serving the others
+        }
+    }
+}
@@ -39,36 +39,225 @@
 #include "nrf_error.h"
 #include "sd_rpc_types.h"
 #include <cstddef>
+#include <cstring>
 #include <vector>
 
+#if defined(__AVX2__)
+#define SLIP_USE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SLIP_USE_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SLIP_USE_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(SLIP_USE_SSE2) || defined(SLIP_USE_AVX2))
+#include <intrin.h>
+#endif
+
 constexpr uint8_t SLIP_END     = 0xC0;
 constexpr uint8_t SLIP_ESC     = 0xDB;
 constexpr uint8_t SLIP_ESC_END = 0xDC;
 constexpr uint8_t SLIP_ESC_ESC = 0xDD;
 
-void slip_encode(const std::vector<uint8_t> &in_packet, std::vector<uint8_t> &out_packet)
+namespace {
+#if defined(SLIP_USE_SSE2) || defined(SLIP_USE_AVX2)
+unsigned int countTrailingZeros(const uint32_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return static_cast<unsigned int>(index);
+#else
+    return static_cast<unsigned int>(__builtin_ctz(value));
+#endif
+}
+#endif
+
+bool isEscapable(const uint8_t byte)
+{
+    return byte == SLIP_END || byte == SLIP_ESC;
+}
+
+/**
+ * @brief Returns the first byte in [begin, end) that must be escaped, or end if there is none.
+ */
+const uint8_t *findEscapable(const uint8_t *begin, const uint8_t *end)
 {
-    out_packet.push_back(SLIP_END);
+#if defined(SLIP_USE_AVX2)
+    const auto slipEnd = _mm256_set1_epi8(static_cast<char>(SLIP_END));
+    const auto slipEsc = _mm256_set1_epi8(static_cast<char>(SLIP_ESC));
 
-    for (auto i : in_packet)
+    for (; end - begin >= 32; begin += 32)
     {
-        if (i == SLIP_END)
+        const auto data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+        const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(data, slipEnd), _mm256_cmpeq_epi8(data, slipEsc))));
+
+        if (mask != 0)
         {
-            out_packet.push_back(SLIP_ESC);
-            out_packet.push_back(SLIP_ESC_END);
+            return begin + countTrailingZeros(mask);
         }
-        else if (i == SLIP_ESC)
+    }
+#endif
+
+#if defined(SLIP_USE_SSE2) || defined(SLIP_USE_AVX2)
+    const auto slipEnd128 = _mm_set1_epi8(static_cast<char>(SLIP_END));
+    const auto slipEsc128 = _mm_set1_epi8(static_cast<char>(SLIP_ESC));
+
+    for (; end - begin >= 16; begin += 16)
+    {
+        const auto data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(data, slipEnd128), _mm_cmpeq_epi8(data, slipEsc128))));
+
+        if (mask != 0)
         {
-            out_packet.push_back(SLIP_ESC);
-            out_packet.push_back(SLIP_ESC_ESC);
+            return begin + countTrailingZeros(mask);
         }
-        else
+    }
+#elif defined(SLIP_USE_NEON)
+    const auto slipEnd = vdupq_n_u8(SLIP_END);
+    const auto slipEsc = vdupq_n_u8(SLIP_ESC);
+
+    for (; end - begin >= 16; begin += 16)
+    {
+        const auto data = vld1q_u8(begin);
+        const auto mask = vorrq_u8(vceqq_u8(data, slipEnd), vceqq_u8(data, slipEsc));
+
+        if (vmaxvq_u8(mask) != 0)
+        {
+            break;
+        }
+    }
+#endif
+
+    while (begin != end && !isEscapable(*begin))
+    {
+        begin++;
+    }
+
+    return begin;
+}
+
+/**
+ * @brief Returns the number of bytes in [begin, end) that must be escaped.
+ */
+size_t countEscapable(const uint8_t *begin, const uint8_t *end)
+{
+    size_t count = 0;
+
+#if defined(SLIP_USE_SSE2) || defined(SLIP_USE_AVX2)
+    const auto slipEnd = _mm_set1_epi8(static_cast<char>(SLIP_END));
+    const auto slipEsc = _mm_set1_epi8(static_cast<char>(SLIP_ESC));
+    const auto zero    = _mm_setzero_si128();
+
+    while (end - begin >= 16)
+    {
+        // Matching lanes compare to 0xFF, subtracting the comparison counts matches per lane.
+        // The per lane counters are summed before they can overflow.
+        auto laneCounts = zero;
+
+        for (auto i = 0; i < 255 && end - begin >= 16; i++, begin += 16)
+        {
+            const auto data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+            laneCounts      = _mm_sub_epi8(laneCounts, _mm_or_si128(_mm_cmpeq_epi8(data, slipEnd),
+                                                                _mm_cmpeq_epi8(data, slipEsc)));
+        }
+
+        const auto sums = _mm_sad_epu8(laneCounts, zero);
+        count += static_cast<size_t>(_mm_cvtsi128_si32(sums)) +
+                 static_cast<size_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+    }
+#elif defined(SLIP_USE_NEON)
+    const auto slipEnd = vdupq_n_u8(SLIP_END);
+    const auto slipEsc = vdupq_n_u8(SLIP_ESC);
+
+    for (; end - begin >= 16; begin += 16)
+    {
+        const auto data = vld1q_u8(begin);
+        const auto mask = vorrq_u8(vceqq_u8(data, slipEnd), vceqq_u8(data, slipEsc));
+        count += vaddvq_u8(vshrq_n_u8(mask, 7));
+    }
+#endif
+
+    for (; begin != end; begin++)
+    {
+        if (isEscapable(*begin))
         {
-            out_packet.push_back(i);
+            count++;
         }
     }
 
-    out_packet.push_back(SLIP_END);
+    return count;
+}
+} // namespace
+
+size_t slip_encoded_length(const uint8_t *packet, const size_t length)
+{
+    return length + countEscapable(packet, packet + length) + 2;
+}
+
+uint8_t *slip_encode(const uint8_t *in_packet, const size_t length, uint8_t *out_packet)
+{
+    const auto end = in_packet + length;
+
+    *out_packet++ = SLIP_END;
+
+    while (in_packet != end)
+    {
+        // Copy the run of bytes that need no escaping in one go
+        const auto escapable = findEscapable(in_packet, end);
+        const auto runLength = static_cast<size_t>(escapable - in_packet);
+
+        std::memmove(out_packet, in_packet, runLength);
+        out_packet += runLength;
+        in_packet = escapable;
+
+        if (in_packet == end)
+        {
+            break;
+        }
+
+        *out_packet++ = SLIP_ESC;
+        *out_packet++ = (*in_packet++ == SLIP_END) ? SLIP_ESC_END : SLIP_ESC_ESC;
+    }
+
+    *out_packet++ = SLIP_END;
+
+    return out_packet;
+}
+
+void slip_encode(const std::vector<uint8_t> &in_packet, std::vector<uint8_t> &out_packet)
+{
+    const auto start = out_packet.size();
+    out_packet.resize(start + slip_encoded_length(in_packet.data(), in_packet.size()));
+    slip_encode(in_packet.data(), in_packet.size(), out_packet.data() + start);
+}
+
+void slip_encode(TxBuffer &packet)
+{
+    const auto length      = packet.size();
+    const auto escapeCount = countEscapable(packet.data(), packet.data() + length);
+
+    packet.append(escapeCount + 1);
+    const auto start = packet.prepend(1);
+
+    if (escapeCount == 0)
+    {
+        // Nothing to escape, the packet is already in place between the two frame delimiters
+        start[0]          = SLIP_END;
+        start[length + 1] = SLIP_END;
+        return;
+    }
+
+    // Move the packet to the end of the buffer and encode it forwards into the start of the
+    // buffer. The encoded output never overtakes the bytes still to be read.
+    const auto in = start + escapeCount + 1;
+    std::memmove(in, start + 1, length);
+    slip_encode(in, length, start);
 }
 
 uint32_t slip_decode(const std::vector<uint8_t> &packet, std::vector<uint8_t> &out_packet)
@@ -45,7 +45,12 @@
 
 using namespace std;
 
-Transport::Transport()           = default;
+Transport::Transport()
+    : logSeverityFilter(SD_RPC_LOG_TRACE)
+    , traceAdapter(0)
+    , logChannel(0)
+{}
+
 Transport::~Transport() noexcept = default;
 
 uint32_t Transport::open(const status_cb_t &status_callback, const data_cb_t &data_callback,
@@ -63,8 +68,55 @@ uint32_t Transport::open(const status_cb_t &status_callback, const data_cb_t &da
     return NRF_SUCCESS;
 }
 
+uint32_t Transport::send(const std::shared_ptr<TxBuffer> &buffer) noexcept
+{
+    try
+    {
+        const std::vector<uint8_t> data(buffer->data(), buffer->data() + buffer->size());
+        return send(data);
+    }
+    catch (const std::exception &)
+    {
+        return NRF_ERROR_SD_RPC_SEND;
+    }
+}
+
+void Transport::getStats(sd_rpc_stats_t &) noexcept
+{}
+
+std::string Transport::portName() const
+{
+    return std::string();
+}
+
+void Transport::setLogSeverityFilter(const sd_rpc_log_severity_t severity) noexcept
+{
+    logSeverityFilter.store(severity, std::memory_order_relaxed);
+}
+
+void Transport::setTraceAdapter(const uint32_t adapter) noexcept
+{
+    traceAdapter = adapter;
+}
+
+void Transport::setLogChannel(const uint32_t channel) noexcept
+{
+    logChannel.store(channel, std::memory_order_relaxed);
+}
+
+bool Transport::isLogged(const sd_rpc_log_severity_t severity) const noexcept
+{
+    const auto filter = logSeverityFilter.load(std::memory_order_relaxed);
+    return static_cast<uint32_t>(severity) >= static_cast<uint32_t>(filter);
+}
+
 void Transport::log(const sd_rpc_log_severity_t severity, const std::string &message) const noexcept
 {
+    if (!isLogged(severity))
+    {
+        return;
+    }
+
     if (upperLogCallback)
     {
         try
@@ -92,6 +144,11 @@ void Transport::log(const sd_rpc_log_severity_t severity, const std::string &mes
 void Transport::log(const sd_rpc_log_severity_t severity, const std::string &message,
                     const std::exception &ex) const noexcept
 {
+    if (!isLogged(severity))
+    {
+        return;
+    }
+
     try
     {
         std::stringstream message_with_exception;
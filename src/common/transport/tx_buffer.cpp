@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "tx_buffer.h"
+
+#include <stdexcept>
+
+namespace {
+// H5 CRC and SLIP end delimiter
+constexpr size_t TxBufferTrailerLength = 3;
+} // namespace
+
+TxBuffer::TxBuffer(const size_t payloadCapacity)
+    : capacity(payloadCapacity)
+    , begin(TxBufferHeadroom)
+    , end(TxBufferHeadroom)
+{
+    // Worst case every byte of payload, headers and CRC is SLIP escaped into two bytes
+    storage.resize(TxBufferHeadroom + 2 * (payloadCapacity + TxBufferHeadroom) +
+                   2 * TxBufferTrailerLength);
+}
+
+uint8_t *TxBuffer::payload() noexcept
+{
+    return storage.data() + TxBufferHeadroom;
+}
+
+size_t TxBuffer::payloadCapacity() const noexcept
+{
+    return capacity;
+}
+
+void TxBuffer::setPayloadLength(const size_t length)
+{
+    if (length > capacity)
+    {
+        throw std::length_error("Payload length exceeds TX buffer capacity");
+    }
+
+    begin = TxBufferHeadroom;
+    end   = TxBufferHeadroom + length;
+}
+
+uint8_t *TxBuffer::prepend(const size_t length)
+{
+    if (length > headroom())
+    {
+        throw std::length_error("Not enough headroom in TX buffer");
+    }
+
+    begin -= length;
+    return storage.data() + begin;
+}
+
+uint8_t *TxBuffer::append(const size_t length)
+{
+    if (length > tailroom())
+    {
+        throw std::length_error("Not enough tailroom in TX buffer");
+    }
+
+    const auto appended = storage.data() + end;
+    end += length;
+    return appended;
+}
+
+uint8_t *TxBuffer::data() noexcept
+{
+    return storage.data() + begin;
+}
+
+const uint8_t *TxBuffer::data() const noexcept
+{
+    return storage.data() + begin;
+}
+
+size_t TxBuffer::size() const noexcept
+{
+    return end - begin;
+}
+
+size_t TxBuffer::headroom() const noexcept
+{
+    return begin;
+}
+
+size_t TxBuffer::tailroom() const noexcept
+{
+    return storage.size() - end;
+}
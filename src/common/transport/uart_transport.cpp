@@ -38,15 +38,22 @@
 #include "uart_transport.h"
 
 #include "nrf_error.h"
+#include "shared_io_context.h"
+#include "span_tracer.h"
 #include "uart_settings_boost.h"
 
-#include <thread>
+#include <atomic>
+#include <condition_variable>
 #include <deque>
 #include <functional>
 #include <mutex>
+#include <new>
 #include <sstream>
 #include <system_error>
 #include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #if defined(__APPLE__)
 #include <IOKit/serial/ioss.h>
@@ -68,35 +75,215 @@ constexpr auto DELAY_BEFORE_OPEN = std::chrono::milliseconds(200);
 constexpr auto readTotalTimeoutConstant = 20;
 #endif
 
+namespace {
+/**
+ * @brief Memory for the asynchronous operation of a serial port, allocated by asio when a read or
+ * write is started.
+ *
+ * Only one read and one write are in progress at a time and asio releases the memory of an
+ * operation before its completion handler is invoked, so the memory of the previous operation
+ * can be reused. Larger operations, or an operation started while the memory is in use, are
+ * allocated on the heap.
+ */
+class HandlerMemory
+{
+  public:
+    HandlerMemory() noexcept
+        : inUse(false)
+    {}
+
+    HandlerMemory(const HandlerMemory &) = delete;
+    HandlerMemory &operator=(const HandlerMemory &) = delete;
+
+    void *allocate(const size_t size)
+    {
+        if (size <= sizeof(storage) && !inUse.exchange(true))
+        {
+            return &storage;
+        }
+
+        return ::operator new(size);
+    }
+
+    void deallocate(void *pointer) noexcept
+    {
+        if (pointer == &storage)
+        {
+            inUse = false;
+        }
+        else
+        {
+            ::operator delete(pointer);
+        }
+    }
+
+  private:
+    std::aligned_storage<1024>::type storage;
+    std::atomic<bool> inUse;
+};
+
+template <typename T> class HandlerAllocator
+{
+  public:
+    using value_type = T;
+
+    explicit HandlerAllocator(HandlerMemory &memory) noexcept
+        : memory(memory)
+    {}
+
+    template <typename U>
+    HandlerAllocator(const HandlerAllocator<U> &other) noexcept
+        : memory(other.memory)
+    {}
+
+    T *allocate(const size_t n) const
+    {
+        return static_cast<T *>(memory.allocate(sizeof(T) * n));
+    }
+
+    void deallocate(T *pointer, const size_t) const noexcept
+    {
+        memory.deallocate(pointer);
+    }
+
+    template <typename U> bool operator==(const HandlerAllocator<U> &other) const noexcept
+    {
+        return &memory == &other.memory;
+    }
+
+    template <typename U> bool operator!=(const HandlerAllocator<U> &other) const noexcept
+    {
+        return &memory != &other.memory;
+    }
+
+  private:
+    template <typename> friend class HandlerAllocator;
+    HandlerMemory &memory;
+};
+
+/**
+ * @brief Buffer sequence referring to buffers owned by the serial port.
+ *
+ * asio keeps a copy of the buffer sequence of a write operation, copying a vector of buffers
+ * would allocate memory for each write.
+ */
+class BufferSequenceRef
+{
+  public:
+    using value_type     = asio::const_buffer;
+    using const_iterator = std::vector<asio::const_buffer>::const_iterator;
+
+    explicit BufferSequenceRef(const std::vector<asio::const_buffer> &buffers) noexcept
+        : buffers(&buffers)
+    {}
+
+    const_iterator begin() const noexcept
+    {
+        return buffers->begin();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return buffers->end();
+    }
+
+  private:
+    const std::vector<asio::const_buffer> *buffers;
+};
+
+// Completion handler allocating its operation from a HandlerMemory
+template <typename Handler> class AllocatingHandler
+{
+  public:
+    using allocator_type = HandlerAllocator<Handler>;
+
+    AllocatingHandler(HandlerMemory &memory, Handler handler)
+        : memory(memory)
+        , handler(std::move(handler))
+    {}
+
+    allocator_type get_allocator() const noexcept
+    {
+        return allocator_type(memory);
+    }
+
+    template <typename... Args> void operator()(Args &&... args)
+    {
+        handler(std::forward<Args>(args)...);
+    }
+
+  private:
+    HandlerMemory &memory;
+    Handler handler;
+};
+
+// Set while a thread runs a completion handler of a serial port
+thread_local const void *currentHandlerOwner = nullptr;
+} // namespace
+
 struct UartTransport::impl : Transport
 {
     std::array<uint8_t, UartTransportBufferSize> readBuffer;
-    std::vector<uint8_t> writeBufferVector;
-    std::deque<uint8_t> writeQueue;
+
+    // Packets are written from the buffers provided by the upper transport, buffers are kept
+    // alive in writeBuffersInProgress until the write operation completes
+    std::vector<std::shared_ptr<TxBuffer>> writeBuffersInProgress;
+    std::vector<asio::const_buffer> writeBufferSequence;
+    std::deque<std::shared_ptr<TxBuffer>> writeQueue;
     std::mutex queueMutex;
 
+    // Reused by the read and write operations, starting an operation does not allocate memory
+    HandlerMemory readMemory;
+    HandlerMemory writeMemory;
+
     bool isOpen;
     std::recursive_mutex isOpenMutex;
 
-    std::function<void(const asio::error_code, const size_t)> callbackReadHandle;
-    std::function<void(const asio::error_code, const size_t)> callbackWriteHandle;
-
     UartSettingsBoost uartSettingsBoost;
     bool asyncWriteInProgress;
     std::unique_ptr<std::thread> ioServiceThread;
 
+    // Bytes transferred by completed read and write operations, see UartTransport::getStats
+    std::atomic<uint64_t> bytesRead;
+    std::atomic<uint64_t> bytesWritten;
+
+    // Start of the write operation in progress, only set while tracing
+    std::chrono::steady_clock::time_point writeStartedAt;
+
+    // The serial port runs either on ioService and ioServiceThread owned by this transport or on
+    // the shared io_context enabled by UartTransport::setSharedIoThreadCount
     std::unique_ptr<asio::io_service> ioService;
+    std::shared_ptr<SharedIoContext> sharedIoContext;
+    std::unique_ptr<asio::strand<asio::io_context::executor_type>> strand;
     std::unique_ptr<asio::serial_port> serialPort;
     std::unique_ptr<asio::executor_work_guard<asio::io_context::executor_type>> workNotifier;
 
+    // Asynchronous operations not completed yet. On a shared io_context close waits for these
+    // since there is no thread of its own to join. When closed from one of its completion
+    // handlers the serial port is released by the last operation completing instead.
+    size_t pendingOperations;
+    bool releasePending;
+    std::mutex pendingOperationsMutex;
+    std::condition_variable pendingOperationsDone;
+
     impl(const UartCommunicationParameters &communicationParameters)
         : readBuffer()
         , isOpen(false)
         , uartSettingsBoost(communicationParameters)
         , asyncWriteInProgress(false)
         , ioServiceThread(nullptr)
+        , bytesRead(0)
+        , bytesWritten(0)
+        , pendingOperations(0)
+        , releasePending(false)
     {}
 
+    ~impl() noexcept
+    {
+        std::unique_lock<std::mutex> lck(pendingOperationsMutex);
+        pendingOperationsDone.wait(lck, [this] { return !releasePending; });
+    }
+
     /**
      *@brief Called when background thread receives bytes from uart.
      */
@@ -105,21 +292,29 @@ struct UartTransport::impl : Transport
         if (!errorCode)
         {
             const auto readBufferData = readBuffer.data();
+            bytesRead.fetch_add(bytesTransferred, std::memory_order_relaxed);
 
             if (upperDataCallback)
             {
                 upperDataCallback(readBufferData, bytesTransferred);
             }
 
-            asyncRead(); // Initiate a new read
+            // The data callback may have closed the serial port
+            if (serialPort->is_open())
+            {
+                asyncRead(); // Initiate a new read
+            }
         }
         else if (errorCode == asio::error::operation_aborted)
         {
-            std::stringstream message;
-            message << "serial port read on port " << uartSettingsBoost.getPortName()
-                    << " aborted.";
+            if (isLogged(SD_RPC_LOG_DEBUG))
+            {
+                std::stringstream message;
+                message << "serial port read on port " << uartSettingsBoost.getPortName()
+                        << " aborted.";
 
-            log(SD_RPC_LOG_DEBUG, message.str());
+                log(SD_RPC_LOG_DEBUG, message.str());
+            }
         }
         else
         {
@@ -136,15 +331,28 @@ struct UartTransport::impl : Transport
     {
         if (!errorCode)
         {
+            bytesWritten.fetch_add(bytesTransferred, std::memory_order_relaxed);
+
+            if (SpanTracer::isTracing() &&
+                writeStartedAt != std::chrono::steady_clock::time_point())
+            {
+                auto span = SpanTracer::span("uart_write", traceAdapter, writeStartedAt,
+                                             std::chrono::steady_clock::now());
+                SpanTracer::global().record(span);
+            }
+
             asyncWrite();
         }
         else if (errorCode == asio::error::operation_aborted)
         {
-            std::stringstream message;
-            message << "serial port write operation on port " << uartSettingsBoost.getPortName()
-                    << " aborted.";
+            if (isLogged(SD_RPC_LOG_DEBUG))
+            {
+                std::stringstream message;
+                message << "serial port write operation on port "
+                        << uartSettingsBoost.getPortName() << " aborted.";
 
-            log(SD_RPC_LOG_DEBUG, message.str());
+                log(SD_RPC_LOG_DEBUG, message.str());
+            }
 
             // In case of an aborted write operation, suppress notifications and return (i.e. no
             // asyncWrite)
@@ -153,7 +361,7 @@ struct UartTransport::impl : Transport
             asyncWriteInProgress = false;
             queueMutex.unlock();
         }
-        else
+        else if (isLogged(SD_RPC_LOG_ERROR))
         {
             std::stringstream message;
             message << "serial port write operation on port " << uartSettingsBoost.getPortName()
@@ -168,10 +376,87 @@ struct UartTransport::impl : Transport
         asyncRead();
     }
 
+    void operationStarted()
+    {
+        std::lock_guard<std::mutex> lck(pendingOperationsMutex);
+        pendingOperations++;
+    }
+
+    void operationCompleted()
+    {
+        std::unique_lock<std::mutex> lck(pendingOperationsMutex);
+        pendingOperations--;
+
+        if (pendingOperations == 0 && releasePending)
+        {
+            lck.unlock();
+            release();
+            lck.lock();
+            releasePending = false;
+        }
+
+        pendingOperationsDone.notify_all();
+    }
+
+    /**
+     * @brief Destroys the serial port and releases the io_context it ran on, no operation may be
+     * pending. The last serial port on a shared io_context may release it from a handler.
+     */
+    void release() noexcept
+    {
+        serialPort.reset();
+        strand.reset();
+        ioService.reset();
+        sharedIoContext.reset();
+    }
+
+    /**
+     * @brief Wraps a handler so that it runs serialized on the strand of this serial port and is
+     * accounted for in pendingOperations.
+     */
+    template <typename Handler> auto completionHandler(HandlerMemory &memory, Handler handler)
+    {
+        auto completion = [this, handler](const asio::error_code &errorCode,
+                                          const size_t bytesTransferred) {
+            const auto previousOwner = currentHandlerOwner;
+            currentHandlerOwner      = this;
+
+            try
+            {
+                (this->*handler)(errorCode, bytesTransferred);
+            }
+            catch (...)
+            {
+                currentHandlerOwner = previousOwner;
+                operationCompleted();
+                throw;
+            }
+
+            currentHandlerOwner = previousOwner;
+            operationCompleted();
+        };
+
+        return asio::bind_executor(
+            *strand, AllocatingHandler<decltype(completion)>(memory, std::move(completion)));
+    }
+
     void asyncRead()
     {
         const auto mutableReadBuffer = asio::buffer(readBuffer, UartTransportBufferSize);
-        serialPort->async_read_some(mutableReadBuffer, callbackReadHandle);
+
+        operationStarted();
+
+        try
+        {
+            serialPort->async_read_some(mutableReadBuffer,
+                                        completionHandler(readMemory,
+                                                          &UartTransport::impl::readHandler));
+        }
+        catch (...)
+        {
+            operationCompleted();
+            throw;
+        }
     }
 
     void asyncWrite()
@@ -179,25 +464,42 @@ struct UartTransport::impl : Transport
         { // lock_guard scope
             std::lock_guard<std::mutex> guard(queueMutex);
 
-            const auto numBytesPending = writeQueue.size();
+            writeBuffersInProgress.clear();
+            writeBufferSequence.clear();
 
-            if (numBytesPending == 0)
+            if (writeQueue.empty())
             {
                 asyncWriteInProgress = false;
                 return;
             }
 
             asyncWriteInProgress = true;
-            writeBufferVector.clear();
 
-            /* Write all available bytes in one operation */
-            writeBufferVector.insert(writeBufferVector.begin(), writeQueue.begin(),
-                                     writeQueue.end());
+            /* Write all queued packets in one operation */
+            for (auto &buffer : writeQueue)
+            {
+                writeBufferSequence.push_back(asio::buffer(buffer->data(), buffer->size()));
+                writeBuffersInProgress.push_back(std::move(buffer));
+            }
+
             writeQueue.clear();
         }
 
-        const auto buffer = asio::buffer(writeBufferVector, writeBufferVector.size());
-        asio::async_write(*serialPort, buffer, callbackWriteHandle);
+        writeStartedAt = SpanTracer::isTracing() ? std::chrono::steady_clock::now()
+                                                 : std::chrono::steady_clock::time_point();
+
+        operationStarted();
+
+        try
+        {
+            asio::async_write(*serialPort, BufferSequenceRef(writeBufferSequence),
+                              completionHandler(writeMemory, &UartTransport::impl::writeHandler));
+        }
+        catch (...)
+        {
+            operationCompleted();
+            throw;
+        }
     }
 
     /**
@@ -245,6 +547,18 @@ struct UartTransport::impl : Transport
             return NRF_ERROR_SD_RPC_SERIAL_PORT_ALREADY_OPEN;
         }
 
+        {
+            // Closed from a completion handler, the serial port is released by its last handler
+            std::unique_lock<std::mutex> lck(pendingOperationsMutex);
+
+            if (releasePending && currentHandlerOwner == this)
+            {
+                return NRF_ERROR_SD_RPC_SERIAL_PORT_STATE;
+            }
+
+            pendingOperationsDone.wait(lck, [this] { return !releasePending; });
+        }
+
         isOpen = true;
 
         Transport::open(status_callback, data_callback, log_callback);
@@ -253,11 +567,24 @@ struct UartTransport::impl : Transport
 
         try
         {
-            ioService  = std::make_unique<asio::io_service>();
-            serialPort = std::make_unique<asio::serial_port>(*ioService);
-            workNotifier =
-                std::make_unique<asio::executor_work_guard<asio::io_context::executor_type>>(
-                    asio::make_work_guard(*ioService));
+            sharedIoContext = SharedIoContext::current();
+
+            if (sharedIoContext)
+            {
+                strand = std::make_unique<asio::strand<asio::io_context::executor_type>>(
+                    sharedIoContext->context().get_executor());
+                serialPort = std::make_unique<asio::serial_port>(sharedIoContext->context());
+            }
+            else
+            {
+                ioService = std::make_unique<asio::io_service>();
+                strand    = std::make_unique<asio::strand<asio::io_context::executor_type>>(
+                    ioService->get_executor());
+                serialPort = std::make_unique<asio::serial_port>(*ioService);
+                workNotifier =
+                    std::make_unique<asio::executor_work_guard<asio::io_context::executor_type>>(
+                        asio::make_work_guard(*ioService));
+            }
 
             std::this_thread::sleep_for(DELAY_BEFORE_OPEN);
             serialPort->open(portName);
@@ -338,12 +665,6 @@ struct UartTransport::impl : Transport
 
         try
         {
-            callbackReadHandle = std::bind(&UartTransport::impl::readHandler, this,
-                                           std::placeholders::_1, std::placeholders::_2);
-
-            callbackWriteHandle = std::bind(&UartTransport::impl::writeHandler, this,
-                                            std::placeholders::_1, std::placeholders::_2);
-
             const auto asioWorker = [&]() {
                 try
                 {
@@ -354,9 +675,13 @@ struct UartTransport::impl : Transport
                     }
 
                     const auto count = ioService->run();
-                    std::stringstream message;
-                    message << "serial io_context executed " << count << " handlers.";
-                    log(SD_RPC_LOG_TRACE, message.str());
+
+                    if (isLogged(SD_RPC_LOG_TRACE))
+                    {
+                        std::stringstream message;
+                        message << "serial io_context executed " << count << " handlers.";
+                        log(SD_RPC_LOG_TRACE, message.str());
+                    }
                 }
                 catch (std::exception &e)
                 {
@@ -364,7 +689,10 @@ struct UartTransport::impl : Transport
                 }
             };
 
-            ioServiceThread = std::make_unique<std::thread>(asioWorker);
+            if (!sharedIoContext)
+            {
+                ioServiceThread = std::make_unique<std::thread>(asioWorker);
+            }
         }
         catch (std::exception &ex)
         {
@@ -453,19 +781,40 @@ struct UartTransport::impl : Transport
             serialPort->cancel();
             purge();
             serialPort->close();
-            ioService->stop();
-            workNotifier->reset();
 
-            if (ioServiceThread != nullptr)
+            if (sharedIoContext && currentHandlerOwner == this)
             {
-                if (ioServiceThread->joinable())
+                // Called from a handler of this serial port, the aborted operations complete on
+                // the strand after the handler returns. The last of them releases the port.
+                std::lock_guard<std::mutex> lck(pendingOperationsMutex);
+                releasePending = true;
+            }
+            else if (sharedIoContext)
+            {
+                // The aborted operations complete on the shared threads
+                std::unique_lock<std::mutex> lck(pendingOperationsMutex);
+                pendingOperationsDone.wait(lck, [this] { return pendingOperations == 0; });
+                lck.unlock();
+
+                release();
+            }
+            else
+            {
+                ioService->stop();
+                workNotifier->reset();
+
+                if (ioServiceThread != nullptr)
                 {
-                    ioServiceThread->join();
+                    if (ioServiceThread->joinable())
+                    {
+                        ioServiceThread->join();
+                    }
                 }
-            }
 
-            serialPort.reset();
-            ioService.reset();
+                // Handlers not run before the stop are destroyed with ioService
+                pendingOperations = 0;
+                release();
+            }
 
             std::stringstream message;
             message << "serial port " << uartSettingsBoost.getPortName() << " closed.";
@@ -483,6 +832,25 @@ struct UartTransport::impl : Transport
     }
 
     uint32_t send(const std::vector<uint8_t> &data) noexcept
+    {
+        std::shared_ptr<TxBuffer> buffer;
+
+        try
+        {
+            buffer = std::make_shared<TxBuffer>(data.size());
+            std::copy(data.begin(), data.end(), buffer->payload());
+            buffer->setPayloadLength(data.size());
+        }
+        catch (const std::exception &e)
+        {
+            log(SD_RPC_LOG_ERROR, "Error adding TX data", e);
+            return NRF_ERROR_SD_RPC_SERIAL_PORT_INTERNAL_ERROR;
+        }
+
+        return send(buffer);
+    }
+
+    uint32_t send(const std::shared_ptr<TxBuffer> &buffer) noexcept
     {
         {
             std::lock_guard<std::recursive_mutex> openLck(isOpenMutex);
@@ -502,7 +870,7 @@ struct UartTransport::impl : Transport
 
             try
             {
-                writeQueue.insert(writeQueue.end(), data.begin(), data.end());
+                writeQueue.push_back(buffer);
             }
             catch (const std::exception &e)
             {
@@ -548,7 +916,50 @@ uint32_t UartTransport::close() noexcept
     return pimpl->close();
 }
 
+void UartTransport::getStats(sd_rpc_stats_t &stats) noexcept
+{
+    stats.tx_bytes = pimpl->bytesWritten.load(std::memory_order_relaxed);
+    stats.rx_bytes = pimpl->bytesRead.load(std::memory_order_relaxed);
+}
+
+std::string UartTransport::portName() const
+{
+    return pimpl->uartSettingsBoost.getPortName();
+}
+
+void UartTransport::setLogSeverityFilter(const sd_rpc_log_severity_t severity) noexcept
+{
+    Transport::setLogSeverityFilter(severity);
+    pimpl->setLogSeverityFilter(severity);
+}
+
+void UartTransport::setTraceAdapter(const uint32_t adapter) noexcept
+{
+    Transport::setTraceAdapter(adapter);
+    pimpl->setTraceAdapter(adapter);
+}
+
 uint32_t UartTransport::send(const std::vector<uint8_t> &data) noexcept
 {
     return pimpl->send(data);
 }
+
+uint32_t UartTransport::send(const std::shared_ptr<TxBuffer> &buffer) noexcept
+{
+    return pimpl->send(buffer);
+}
+
+uint32_t UartTransport::setSharedIoThreadCount(const uint32_t threadCount) noexcept
+{
+    try
+    {
+        SharedIoContext::setThreadCount(threadCount);
+    }
+    catch (const std::exception &)
+    {
+        return NRF_ERROR_SD_RPC_SERIAL_PORT_INTERNAL_ERROR;
+    }
+
+    // Adapters still open keep the previous context and its threads until they are closed
+    return NRF_SUCCESS;
+}
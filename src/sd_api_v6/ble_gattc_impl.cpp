@@ -52,13 +52,13 @@ uint32_t sd_ble_gattc_primary_services_discover(adapter_t *adapter, uint16_t con
                                                 uint16_t start_handle,
                                                 ble_uuid_t const *p_srvc_uuid)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_gattc_primary_services_discover_req_enc(conn_handle, start_handle, p_srvc_uuid,
                                                            buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_gattc_primary_services_discover_rsp_dec(buffer, length, result);
     };
 
@@ -68,13 +68,13 @@ uint32_t sd_ble_gattc_primary_services_discover(adapter_t *adapter, uint16_t con
 uint32_t sd_ble_gattc_relationships_discover(adapter_t *adapter, uint16_t conn_handle,
                                              ble_gattc_handle_range_t const *p_handle_range)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_gattc_relationships_discover_req_enc(conn_handle, p_handle_range, buffer,
                                                         length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_gattc_relationships_discover_rsp_dec(buffer, length, result);
     };
 
@@ -84,13 +84,13 @@ uint32_t sd_ble_gattc_relationships_discover(adapter_t *adapter, uint16_t conn_h
 uint32_t sd_ble_gattc_characteristics_discover(adapter_t *adapter, uint16_t conn_handle,
                                                ble_gattc_handle_range_t const *p_handle_range)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_gattc_characteristics_discover_req_enc(conn_handle, p_handle_range, buffer,
                                                           length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_gattc_characteristics_discover_rsp_dec(buffer, length, result);
     };
 
@@ -100,12 +100,12 @@ uint32_t sd_ble_gattc_characteristics_discover(adapter_t *adapter, uint16_t conn
 uint32_t sd_ble_gattc_descriptors_discover(adapter_t *adapter, uint16_t conn_handle,
                                            ble_gattc_handle_range_t const *p_handle_range)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_gattc_descriptors_discover_req_enc(conn_handle, p_handle_range, buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_gattc_descriptors_discover_rsp_dec(buffer, length, result);
     };
 
@@ -116,13 +116,13 @@ uint32_t sd_ble_gattc_char_value_by_uuid_read(adapter_t *adapter, uint16_t conn_
                                               ble_uuid_t const *p_uuid,
                                               ble_gattc_handle_range_t const *p_handle_range)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_gattc_char_value_by_uuid_read_req_enc(conn_handle, p_uuid, p_handle_range,
                                                          buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_gattc_char_value_by_uuid_read_rsp_dec(buffer, length, result);
     };
 
@@ -132,12 +132,12 @@ uint32_t sd_ble_gattc_char_value_by_uuid_read(adapter_t *adapter, uint16_t conn_
 uint32_t sd_ble_gattc_read(adapter_t *adapter, uint16_t conn_handle, uint16_t handle,
                            uint16_t offset)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_gattc_read_req_enc(conn_handle, handle, offset, buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_gattc_read_rsp_dec(buffer, length, result);
     };
 
@@ -147,13 +147,13 @@ uint32_t sd_ble_gattc_read(adapter_t *adapter, uint16_t conn_handle, uint16_t ha
 uint32_t sd_ble_gattc_char_values_read(adapter_t *adapter, uint16_t conn_handle,
                                        uint16_t const *p_handles, uint16_t handle_count)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_gattc_char_values_read_req_enc(conn_handle, p_handles, handle_count, buffer,
                                                   length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_gattc_char_values_read_rsp_dec(buffer, length, result);
     };
 
@@ -163,12 +163,12 @@ uint32_t sd_ble_gattc_char_values_read(adapter_t *adapter, uint16_t conn_handle,
 uint32_t sd_ble_gattc_write(adapter_t *adapter, uint16_t conn_handle,
                             ble_gattc_write_params_t const *p_write_params)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_gattc_write_req_enc(conn_handle, p_write_params, buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_gattc_write_rsp_dec(buffer, length, result);
     };
 
@@ -177,12 +177,12 @@ uint32_t sd_ble_gattc_write(adapter_t *adapter, uint16_t conn_handle,
 
 uint32_t sd_ble_gattc_hv_confirm(adapter_t *adapter, uint16_t conn_handle, uint16_t handle)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_gattc_hv_confirm_req_enc(conn_handle, handle, buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_gattc_hv_confirm_rsp_dec(buffer, length, result);
     };
 
@@ -192,12 +192,12 @@ uint32_t sd_ble_gattc_hv_confirm(adapter_t *adapter, uint16_t conn_handle, uint1
 uint32_t sd_ble_gattc_attr_info_discover(adapter_t *adapter, uint16_t conn_handle,
                                          ble_gattc_handle_range_t const *p_handle_range)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_gattc_attr_info_discover_req_enc(conn_handle, p_handle_range, buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_gattc_attr_info_discover_rsp_dec(buffer, length, result);
     };
 
@@ -208,12 +208,12 @@ uint32_t sd_ble_gattc_attr_info_discover(adapter_t *adapter, uint16_t conn_handl
 uint32_t sd_ble_gattc_exchange_mtu_request(adapter_t *adapter, uint16_t conn_handle,
                                            uint16_t client_rx_mtu)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_gattc_exchange_mtu_request_req_enc(conn_handle, client_rx_mtu, buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_gattc_exchange_mtu_request_rsp_dec(buffer, length, result);
     };
 
@@ -48,12 +48,12 @@
 uint32_t sd_ble_uuid_encode(adapter_t *adapter, ble_uuid_t const *const p_uuid,
                             uint8_t *const p_uuid_le_len, uint8_t *const p_uuid_le)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_uuid_encode_req_enc(p_uuid, p_uuid_le_len, p_uuid_le, buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_uuid_encode_rsp_dec(buffer, length, p_uuid_le_len, p_uuid_le, result);
     };
 
@@ -63,12 +63,12 @@ uint32_t sd_ble_uuid_encode(adapter_t *adapter, ble_uuid_t const *const p_uuid,
 uint32_t sd_ble_uuid_vs_add(adapter_t *adapter, ble_uuid128_t const *const p_vs_uuid,
                             uint8_t *const p_uuid_type)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_uuid_vs_add_req_enc(p_vs_uuid, p_uuid_type, buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_uuid_vs_add_rsp_dec(buffer, length, const_cast<uint8_t **>(&p_uuid_type),
                                        result);
     };
@@ -79,12 +79,12 @@ uint32_t sd_ble_uuid_vs_add(adapter_t *adapter, ble_uuid128_t const *const p_vs_
 uint32_t sd_ble_uuid_decode(adapter_t *adapter, uint8_t uuid_le_len, uint8_t const *const p_uuid_le,
                             ble_uuid_t *const p_uuid)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_uuid_decode_req_enc(uuid_le_len, p_uuid_le, p_uuid, buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_uuid_decode_rsp_dec(buffer, length, const_cast<ble_uuid_t **>(&p_uuid), result);
     };
 
@@ -93,12 +93,12 @@ uint32_t sd_ble_uuid_decode(adapter_t *adapter, uint8_t uuid_le_len, uint8_t con
 
 uint32_t sd_ble_version_get(adapter_t *adapter, ble_version_t *p_version)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_version_get_req_enc(p_version, buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_version_get_rsp_dec(buffer, length, p_version, result);
     };
 
@@ -107,12 +107,12 @@ uint32_t sd_ble_version_get(adapter_t *adapter, ble_version_t *p_version)
 
 uint32_t sd_ble_opt_get(adapter_t *adapter, uint32_t opt_id, ble_opt_t *p_opt)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_opt_get_req_enc(opt_id, p_opt, buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_opt_get_rsp_dec(buffer, length, &opt_id, p_opt, result);
     };
 
@@ -121,12 +121,12 @@ uint32_t sd_ble_opt_get(adapter_t *adapter, uint32_t opt_id, ble_opt_t *p_opt)
 
 uint32_t sd_ble_opt_set(adapter_t *adapter, uint32_t opt_id, ble_opt_t const *p_opt)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_opt_set_req_enc(opt_id, p_opt, buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_opt_set_rsp_dec(buffer, length, result);
     };
 
@@ -136,12 +136,12 @@ uint32_t sd_ble_opt_set(adapter_t *adapter, uint32_t opt_id, ble_opt_t const *p_
 uint32_t sd_ble_cfg_set(adapter_t *adapter, uint32_t cfg_id, ble_cfg_t const *p_cfg,
                         uint32_t app_ram_base)
 {
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_cfg_set_req_enc(cfg_id, p_cfg, buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_cfg_set_rsp_dec(buffer, length, result);
     };
 
@@ -153,17 +153,20 @@ uint32_t sd_ble_enable(adapter_t *adapter, uint32_t *p_app_ram_base)
     (void)p_app_ram_base;
 
     auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
-    RequestReplyCodecContext context(adapterLayer->transport);
 
-    // Reset previous app_ble_gap data
-    app_ble_gap_state_reset();
+    {
+        RequestReplyCodecContext context(adapterLayer->transport);
+
+        // Reset previous app_ble_gap data
+        app_ble_gap_state_reset();
+    }
 
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_enable_req_enc(buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_enable_rsp_dec(buffer, length, result);
     };
 
@@ -178,12 +181,12 @@ uint32_t sd_ble_user_mem_reply(adapter_t *adapter, uint16_t conn_handle,
         return NRF_ERROR_INVALID_PARAM;
     }
 
-    encode_function_t encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
+    const auto encode_function = [&](uint8_t *buffer, uint32_t *length) -> uint32_t {
         return ble_user_mem_reply_req_enc(conn_handle, p_block, buffer, length);
     };
 
-    decode_function_t decode_function = [&](uint8_t *buffer, uint32_t length,
-                                            uint32_t *result) -> uint32_t {
+    const auto decode_function = [&](uint8_t *buffer, uint32_t length,
+                                     uint32_t *result) -> uint32_t {
         return ble_user_mem_reply_rsp_dec(buffer, length, result);
     };
 
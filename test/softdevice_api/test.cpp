@@ -1,3 +1,7 @@
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
 #include <iostream>
 #include <mutex>
 #include <test_environment.h>
@@ -8,9 +12,6 @@
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
-std::ostream &nrfLogStream(std::cout);
-std::mutex nrfLogMutex;
-
 #define CATCH_CONFIG_RUNNER
 #include "catch2/catch.hpp"
 
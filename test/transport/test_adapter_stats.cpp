@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <h5_peer.h>
+#include <nrf_error.h>
+
+#include <adapter.h>
+#include <ble.h>
+#include <sd_rpc.h>
+
+#include <chrono>
+#include <cstdint>
+
+TEST_CASE("AdapterStats")
+{
+    H5Peer peer(MaxSlidingWindowSize, std::chrono::milliseconds(0), false, true);
+
+    const auto adapter = createAdapter(peer.portName());
+    REQUIRE(sd_rpc_open(adapter, noopAdapterStatus, noopAdapterEvent, noopAdapterLog) ==
+            NRF_SUCCESS);
+
+    uint8_t value[20]      = {};
+    const auto writeParams = gattcWriteParams(value);
+
+    SECTION("Commands and link packets are counted in the statistics")
+    {
+        for (auto i = 0; i < 10; i++)
+        {
+            REQUIRE(sd_ble_gattc_write(adapter, 0, &writeParams) == NRF_SUCCESS);
+        }
+
+        sd_rpc_stats_t stats;
+        REQUIRE(sd_rpc_stats_get(adapter, &stats) == NRF_SUCCESS);
+
+        REQUIRE(stats.command_count == 10);
+        REQUIRE(stats.command_latency_p50_us <= stats.command_latency_p90_us);
+        REQUIRE(stats.command_latency_p90_us <= stats.command_latency_p99_us);
+        REQUIRE(stats.command_latency_p99_us <= stats.command_latency_max_us);
+
+        // Link establishment and the acknowledgements are counted too
+        REQUIRE(stats.h5_tx_packets >= 10);
+        REQUIRE(stats.h5_rx_packets >= 10);
+        REQUIRE(stats.tx_bytes > 0);
+        REQUIRE(stats.rx_bytes > 0);
+    }
+
+    REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+    sd_rpc_adapter_delete(adapter);
+}
+
+#endif // defined(__unix__) || defined(__APPLE__)
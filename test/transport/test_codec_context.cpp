@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <internal/app_ble_gap.h>
+#include <internal/ble_common.h>
+
+#include <h5.h>
+#include <nrf_error.h>
+#include <sd_rpc_types.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Adapters with GAP state, identified by their address as the real adapters are
+ */
+class Adapters
+{
+  public:
+    explicit Adapters(const size_t count)
+        : ids(count)
+    {
+        for (auto &id : ids)
+        {
+            app_ble_gap_state_create(&id);
+        }
+    }
+
+    ~Adapters()
+    {
+        for (auto &id : ids)
+        {
+            app_ble_gap_state_delete(&id);
+        }
+    }
+
+    void *id(const size_t index)
+    {
+        return &ids[index];
+    }
+
+    size_t count() const
+    {
+        return ids.size();
+    }
+
+  private:
+    std::vector<uint8_t> ids;
+};
+
+/**
+ * @brief Run function for each adapter in a thread of its own
+ */
+template <typename F> void forEachAdapterInParallel(Adapters &adapters, F function)
+{
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < adapters.count(); i++)
+    {
+        threads.emplace_back([&adapters, &function, i] { function(adapters.id(i), i); });
+    }
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+} // namespace
+
+TEST_CASE("CodecContext")
+{
+    SECTION("Codec contexts of different adapters are independent")
+    {
+        Adapters adapters(6);
+        std::atomic<uint32_t> failures(0);
+
+        forEachAdapterInParallel(adapters, [&failures](void *adapterId, const size_t index) {
+            const auto connHandle = static_cast<uint16_t>(index);
+
+            for (auto i = 0; i < 1000; i++)
+            {
+                uint32_t keyIndex;
+
+                {
+                    RequestReplyCodecContext context(adapterId);
+
+                    if (app_ble_gap_sec_keys_storage_create(connHandle, &keyIndex) != NRF_SUCCESS)
+                    {
+                        failures++;
+                    }
+                }
+
+                {
+                    EventCodecContext context(adapterId);
+                    uint32_t foundIndex;
+
+                    // Only the keys created for this adapter are visible
+                    if (app_ble_gap_sec_keys_find(connHandle, &foundIndex) != NRF_SUCCESS ||
+                        foundIndex != keyIndex ||
+                        app_ble_gap_sec_keys_find(connHandle + 1, &foundIndex) !=
+                            NRF_ERROR_NOT_FOUND ||
+                        app_ble_gap_sec_keys_storage_destroy(connHandle) != NRF_SUCCESS)
+                    {
+                        failures++;
+                    }
+                }
+            }
+        });
+
+        REQUIRE(failures == 0);
+    }
+
+    SECTION("Codec functions fail without a codec context")
+    {
+        uint32_t keyIndex;
+        REQUIRE(app_ble_gap_sec_keys_find(0, &keyIndex) == NRF_ERROR_SD_RPC_INVALID_STATE);
+    }
+}
+
+TEST_CASE("CodecContextScaling", "[.benchmark]")
+{
+    // Work done per event while the event codec context is set: decoding, approximated by a
+    // checksum of the event, and an application callback that blocks briefly (logging, I/O)
+    const auto eventsPerAdapter = 200;
+    const std::vector<uint8_t> event(256, 0x55);
+
+    const auto handleEvents = [&event](void *adapterId, const size_t) {
+        for (auto i = 0; i < eventsPerAdapter; i++)
+        {
+            EventCodecContext context(adapterId);
+            calculate_crc16_checksum(event.data(), event.data() + event.size());
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    };
+
+    for (const auto adapterCount : {1, 2, 4, 6})
+    {
+        Adapters adapters(adapterCount);
+
+        BENCHMARK(std::to_string(adapterCount) + " adapters, " +
+                  std::to_string(eventsPerAdapter) + " events each")
+        {
+            forEachAdapterInParallel(adapters, handleEvents);
+        };
+    }
+}
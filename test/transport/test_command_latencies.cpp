@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <h5_peer.h>
+#include <latency_histogram.h>
+#include <nrf_error.h>
+
+#include <adapter.h>
+#include <ble.h>
+#include <sd_rpc.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+TEST_CASE("CommandLatencies")
+{
+    H5Peer peer(MaxSlidingWindowSize, std::chrono::milliseconds(0), false, true);
+
+    const auto adapter = createAdapter(peer.portName());
+    REQUIRE(sd_rpc_open(adapter, noopAdapterStatus, noopAdapterEvent, noopAdapterLog) ==
+            NRF_SUCCESS);
+
+    uint8_t value[20]      = {};
+    const auto writeParams = gattcWriteParams(value);
+
+    SECTION("Latency of each command phase is recorded for the opcode")
+    {
+        for (auto i = 0; i < 10; i++)
+        {
+            REQUIRE(sd_ble_gattc_write(adapter, 0, &writeParams) == NRF_SUCCESS);
+        }
+
+        for (auto phase = 0; phase < SD_RPC_CMD_PHASE_COUNT; phase++)
+        {
+            sd_rpc_latency_t latency;
+            REQUIRE(sd_rpc_cmd_latency_get(adapter, SD_BLE_GATTC_WRITE,
+                                           static_cast<sd_rpc_cmd_phase_t>(phase),
+                                           &latency) == NRF_SUCCESS);
+            REQUIRE(latency.count == 10);
+            REQUIRE(latency.min_ns <= latency.p50_ns);
+            REQUIRE(latency.p50_ns <= latency.p999_ns);
+            REQUIRE(latency.p999_ns <= latency.max_ns);
+        }
+
+        sd_rpc_latency_t latency;
+        REQUIRE(sd_rpc_cmd_latency_get(adapter, SD_BLE_GATTC_READ, SD_RPC_CMD_PHASE_ENCODE,
+                                       &latency) == NRF_ERROR_NOT_FOUND);
+
+        std::array<sd_rpc_latency_bucket_t, LatencyHistogramBucketCount> buckets;
+        uint32_t bucketCount = 0;
+        REQUIRE(sd_rpc_cmd_latency_buckets_get(adapter, SD_BLE_GATTC_WRITE, SD_RPC_CMD_PHASE_WIRE,
+                                               buckets.data(),
+                                               &bucketCount) == NRF_ERROR_DATA_SIZE);
+        REQUIRE(bucketCount > 0);
+
+        bucketCount = static_cast<uint32_t>(buckets.size());
+        REQUIRE(sd_rpc_cmd_latency_buckets_get(adapter, SD_BLE_GATTC_WRITE, SD_RPC_CMD_PHASE_WIRE,
+                                               buckets.data(), &bucketCount) == NRF_SUCCESS);
+
+        uint64_t bucketsTotal = 0;
+
+        for (uint32_t i = 0; i < bucketCount; i++)
+        {
+            REQUIRE(buckets[i].lower_bound_ns <= buckets[i].upper_bound_ns);
+            bucketsTotal += buckets[i].count;
+        }
+
+        REQUIRE(bucketsTotal == 10);
+
+        REQUIRE(sd_rpc_cmd_latency_reset(adapter) == NRF_SUCCESS);
+        REQUIRE(sd_rpc_cmd_latency_get(adapter, SD_BLE_GATTC_WRITE, SD_RPC_CMD_PHASE_DECODE,
+                                       &latency) == NRF_SUCCESS);
+        REQUIRE(latency.count == 0);
+    }
+
+    REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+    sd_rpc_adapter_delete(adapter);
+}
+
+#endif // defined(__unix__) || defined(__APPLE__)
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <h5.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// SER_HAL_TRANSPORT_MAX_PKT_SIZE for SoftDevice API v3 and later
+constexpr size_t MaxPacketSize = 768;
+
+/**
+ * @brief The bitwise CRC16 implementation h5.cpp used before the table driven one.
+ */
+uint16_t bitwiseCrc16(const uint8_t *start, const uint8_t *end,
+                      uint16_t crc = H5_CRC16_INITIAL_VALUE)
+{
+    std::for_each(start, end, [&crc](const uint8_t data) {
+        crc = (crc >> 8) | (crc << 8);
+        crc ^= data;
+        crc ^= (crc & 0xFF) >> 4;
+        crc ^= crc << 12;
+        crc ^= (crc & 0xFF) << 5;
+    });
+
+    return crc;
+}
+
+std::vector<uint8_t> randomData(std::mt19937 &generator, const size_t length)
+{
+    std::vector<uint8_t> data(length);
+    std::generate(data.begin(), data.end(), [&] { return static_cast<uint8_t>(generator()); });
+    return data;
+}
+
+} // namespace
+
+TEST_CASE("CRC16")
+{
+    SECTION("Check value of CRC-16/CCITT-FALSE")
+    {
+        const std::string check = "123456789";
+        const auto data         = reinterpret_cast<const uint8_t *>(check.data());
+
+        REQUIRE(calculate_crc16_checksum(data, data + check.size()) == 0x29B1);
+    }
+
+    SECTION("Every byte from every CRC register value")
+    {
+        for (uint32_t crc = 0; crc <= 0xFFFF; crc++)
+        {
+            for (uint16_t value = 0; value <= 0xFF; value++)
+            {
+                const auto byte = static_cast<uint8_t>(value);
+
+                if (calculate_crc16_checksum(&byte, &byte + 1, static_cast<uint16_t>(crc)) !=
+                    bitwiseCrc16(&byte, &byte + 1, static_cast<uint16_t>(crc)))
+                {
+                    FAIL("CRC differs for byte " << value << " from register " << crc);
+                }
+            }
+        }
+    }
+
+    SECTION("Every length, alignment and split point up to the maximum packet size")
+    {
+        std::mt19937 generator(1);
+        const auto data = randomData(generator, MaxPacketSize + H5_HEADER_LENGTH + H5_CRC_LENGTH +
+                                                    sizeof(uint64_t));
+
+        for (size_t offset = 0; offset < sizeof(uint64_t); offset++)
+        {
+            const auto start = data.data() + offset;
+
+            for (size_t length = 0; length <= MaxPacketSize + H5_HEADER_LENGTH + H5_CRC_LENGTH;
+                 length++)
+            {
+                const auto expected = bitwiseCrc16(start, start + length);
+                REQUIRE(calculate_crc16_checksum(start, start + length) == expected);
+
+                // Incremental calculation, as done by the stream decoder
+                const auto split = generator() % (length + 1);
+                const auto first = calculate_crc16_checksum(start, start + split);
+                REQUIRE(calculate_crc16_checksum(start + split, start + length, first) ==
+                        expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("CRC16Performance", "[.benchmark]")
+{
+    std::mt19937 generator(2);
+    const auto data = randomData(generator, MaxPacketSize + H5_HEADER_LENGTH + H5_CRC_LENGTH);
+
+    for (const auto length : std::vector<size_t>{6, 32, 64, 256, data.size()})
+    {
+        const auto start = data.data();
+        const auto end   = start + length;
+
+        BENCHMARK("bitwise, " + std::to_string(length) + " bytes")
+        {
+            return bitwiseCrc16(start, end);
+        };
+
+        BENCHMARK("slice-by-8, " + std::to_string(length) + " bytes")
+        {
+            return calculate_crc16_checksum(start, end);
+        };
+    }
+}
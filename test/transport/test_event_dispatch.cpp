@@ -0,0 +1,964 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <h5.h>
+#include <h5_transport.h>
+#include <nrf_error.h>
+#include <serialization_transport.h>
+#include <slip.h>
+#include <uart_transport.h>
+
+#include <ble.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+/**
+ * @brief Connectivity device stand-in running on the master side of a pseudo terminal.
+ *
+ * Responds to link establishment and sends serialized events as reliable packets on request.
+ * Commands from the host are acknowledged and answered with a response carrying the opcode.
+ */
+class EventPeer
+{
+  public:
+    EventPeer()
+        : master(-1)
+        , stop(false)
+        , seqNum(0)
+        , expectedSeqNum(0)
+    {
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        REQUIRE(master >= 0);
+        REQUIRE(grantpt(master) == 0);
+        REQUIRE(unlockpt(master) == 0);
+
+        struct termios tio;
+        REQUIRE(tcgetattr(master, &tio) == 0);
+        cfmakeraw(&tio);
+        REQUIRE(tcsetattr(master, TCSANOW, &tio) == 0);
+
+        slaveName  = ptsname(master);
+        peerThread = std::thread([this] { run(); });
+    }
+
+    ~EventPeer()
+    {
+        stop = true;
+        peerThread.join();
+        close(master);
+    }
+
+    const std::string &portName() const
+    {
+        return slaveName;
+    }
+
+    /**
+     * @brief Sends a BLE_GAP_EVT_KEY_PRESSED event, value is passed in kp_not.
+     */
+    void sendEvent(const uint8_t value)
+    {
+        const std::vector<uint8_t> event = {SERIALIZATION_EVENT, BLE_GAP_EVT_KEY_PRESSED & 0xFF,
+                                            BLE_GAP_EVT_KEY_PRESSED >> 8, 0x00, 0x00, value};
+        std::lock_guard<std::mutex> lck(sendMutex);
+        sendPacket(event, VENDOR_SPECIFIC_PACKET, true);
+        seqNum = (seqNum + 1) & 0x07;
+    }
+
+    /**
+     * @brief Sends a BLE_GAP_EVT_ADV_REPORT without data in the SoftDevice API version 2 layout,
+     * value is the last byte of the peer address.
+     */
+    void sendAdvReport(const uint8_t value)
+    {
+        const std::vector<uint8_t> event = {
+            SERIALIZATION_EVENT, BLE_GAP_EVT_ADV_REPORT & 0xFF, BLE_GAP_EVT_ADV_REPORT >> 8,
+            0xFF, 0xFF, BLE_GAP_ADDR_TYPE_RANDOM_STATIC, 0x11, 0x22, 0x33, 0x44, 0x55, value,
+            static_cast<uint8_t>(-70), 0x00};
+        std::lock_guard<std::mutex> lck(sendMutex);
+        sendPacket(event, VENDOR_SPECIFIC_PACKET, true);
+        seqNum = (seqNum + 1) & 0x07;
+    }
+
+  private:
+    void run()
+    {
+        std::vector<uint8_t> frame;
+        uint8_t buffer[256];
+
+        while (!stop)
+        {
+            struct pollfd pfd = {master, POLLIN, 0};
+
+            if (poll(&pfd, 1, 1) > 0 && (pfd.revents & POLLIN))
+            {
+                const auto count = read(master, buffer, sizeof(buffer));
+
+                for (auto i = 0; i < count; i++)
+                {
+                    frame.push_back(buffer[i]);
+
+                    if (buffer[i] == 0xC0)
+                    {
+                        if (frame.size() > 2)
+                        {
+                            processFrame(frame);
+                        }
+
+                        frame.clear();
+                        frame.push_back(0xC0);
+                    }
+                }
+            }
+        }
+    }
+
+    void processFrame(const std::vector<uint8_t> &frame)
+    {
+        std::vector<uint8_t> slipDecoded;
+        std::vector<uint8_t> payload;
+        uint8_t hostSeqNum;
+        uint8_t ackNum;
+        bool reliable;
+        h5_pkt_type_t type;
+
+        if (slip_decode(frame, slipDecoded) != NRF_SUCCESS ||
+            h5_decode(slipDecoded, payload, &hostSeqNum, &ackNum, nullptr, nullptr, nullptr,
+                      &reliable, &type) != NRF_SUCCESS)
+        {
+            return;
+        }
+
+        if (type == LINK_CONTROL_PACKET && payload.size() >= 2)
+        {
+            std::lock_guard<std::mutex> lck(sendMutex);
+
+            if (payload[0] == 0x01 && payload[1] == 0x7E)
+            {
+                sendPacket({0x02, 0x7D}, LINK_CONTROL_PACKET, false);
+            }
+            else if (payload[0] == 0x03 && payload[1] == 0xFC)
+            {
+                sendPacket({0x04, 0x7B, H5Transport::syncConfigField(MinSlidingWindowSize)},
+                           LINK_CONTROL_PACKET, false);
+            }
+        }
+        else if (type == VENDOR_SPECIFIC_PACKET && reliable)
+        {
+            std::lock_guard<std::mutex> lck(sendMutex);
+
+            if (hostSeqNum == expectedSeqNum)
+            {
+                expectedSeqNum = (expectedSeqNum + 1) & 0x07;
+
+                // Packet type of the serialization layer is followed by the opcode
+                if (payload.size() >= 2 && payload[0] == SERIALIZATION_COMMAND)
+                {
+                    sendPacket({SERIALIZATION_RESPONSE, payload[1], 0x00, 0x00, 0x00, 0x00},
+                               VENDOR_SPECIFIC_PACKET, true);
+                    seqNum = (seqNum + 1) & 0x07;
+                }
+            }
+
+            sendPacket({}, ACK_PACKET, false);
+        }
+    }
+
+    void sendPacket(const std::vector<uint8_t> &payload, const h5_pkt_type_t type,
+                    const bool reliable)
+    {
+        std::vector<uint8_t> h5Packet;
+        std::vector<uint8_t> slipPacket;
+
+        h5_encode(payload, h5Packet, seqNum, expectedSeqNum, false, reliable, type);
+        slip_encode(h5Packet, slipPacket);
+
+        // Called from the peer thread, assertions are only made from the test thread
+        if (write(master, slipPacket.data(), slipPacket.size()) < 0)
+        {
+            return;
+        }
+    }
+
+    int master;
+    std::string slaveName;
+    std::thread peerThread;
+    std::atomic<bool> stop;
+    std::mutex sendMutex;
+    uint8_t seqNum;
+    uint8_t expectedSeqNum;
+};
+
+std::unique_ptr<SerializationTransport> createTransport(const std::string &portName)
+{
+    UartCommunicationParameters parameters = {portName.c_str(),    1000000,
+                                              UartFlowControlNone, UartParityNone,
+                                              UartStopBitsOne,     UartDataBitsEight};
+
+    return std::unique_ptr<SerializationTransport>(new SerializationTransport(
+        new H5Transport(new UartTransport(parameters), 250, MinSlidingWindowSize), 1000));
+}
+
+/**
+ * @brief Waits until count events are received, returns false after a second.
+ */
+bool waitForEvents(const std::atomic<uint32_t> &received, const uint32_t count)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+    while (received < count)
+    {
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+
+        std::this_thread::yield();
+    }
+
+    return true;
+}
+
+/**
+ * @brief Waits until depth events are queued, returns the queue depth reached within a second.
+ */
+uint32_t waitForQueueDepth(SerializationTransport &transport, const uint32_t depth)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    sd_rpc_stats_t stats;
+
+    do
+    {
+        transport.getStats(stats);
+    } while (stats.event_queue_depth < depth && std::chrono::steady_clock::now() < deadline);
+
+    return static_cast<uint32_t>(stats.event_queue_depth);
+}
+
+/**
+ * @brief Holds the first event callback until the test thread has seen the other events queued,
+ * so the callbacks after it take the events from a queue holding all of them.
+ */
+class FirstCallbackGate
+{
+  public:
+    FirstCallbackGate()
+        : firstCount(0)
+        , released(false)
+    {}
+
+    /**
+     * @brief Called by the first callback with the number of events it is passed, returns when
+     * the test thread calls ::release.
+     */
+    void hold(const uint32_t count)
+    {
+        firstCount = count;
+
+        while (!released)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * @brief Waits until the first callback is held and the other events of eventCount are
+     * queued or dropped, then lets the first callback return. The peer has sent all events
+     * already.
+     */
+    void release(SerializationTransport &transport, const uint32_t eventCount)
+    {
+        while (firstCount == 0)
+        {
+            std::this_thread::yield();
+        }
+
+        sd_rpc_stats_t stats;
+
+        do
+        {
+            transport.getStats(stats);
+        } while (stats.event_queue_depth + stats.event_queue_dropped < eventCount - firstCount);
+
+        released = true;
+    }
+
+  private:
+    std::atomic<uint32_t> firstCount;
+    std::atomic<bool> released;
+};
+
+const auto noopStatus = [](const sd_rpc_app_status_t, const std::string &) {};
+const auto noopLog    = [](const sd_rpc_log_severity_t, const std::string &) {};
+
+} // namespace
+
+TEST_CASE("EventDispatch")
+{
+    const uint32_t eventCount = 40;
+
+    EventPeer peer;
+    auto transport = createTransport(peer.portName());
+
+    std::atomic<uint32_t> received(0);
+    std::atomic<uint32_t> outOfOrder(0);
+
+    const auto checkOrder = [&](ble_evt_t *event, const uint32_t index) {
+        if (event->header.evt_id != BLE_GAP_EVT_KEY_PRESSED ||
+            event->evt.gap_evt.params.key_pressed.kp_not != index % 256)
+        {
+            outOfOrder++;
+        }
+    };
+
+    SECTION("Events are passed in order on the event thread")
+    {
+        const auto eventCallback = [&](ble_evt_t *event) {
+            checkOrder(event, received);
+            received++;
+        };
+
+        REQUIRE(transport->open(noopStatus, eventCallback, noopLog) == NRF_SUCCESS);
+
+        for (uint32_t i = 0; i < eventCount; i++)
+        {
+            peer.sendEvent(static_cast<uint8_t>(i));
+        }
+
+        REQUIRE(waitForEvents(received, eventCount));
+        REQUIRE(transport->close() == NRF_SUCCESS);
+        REQUIRE(outOfOrder == 0);
+    }
+
+    SECTION("Events discarded by the event filter are counted but not passed")
+    {
+        const auto eventCallback = [&](ble_evt_t *) { received++; };
+
+        REQUIRE(transport->eventFilter().setEventId(BLE_GAP_EVT_KEY_PRESSED, true) ==
+                NRF_SUCCESS);
+        REQUIRE(transport->open(noopStatus, eventCallback, noopLog) == NRF_SUCCESS);
+
+        for (uint32_t i = 0; i < eventCount; i++)
+        {
+            peer.sendEvent(static_cast<uint8_t>(i));
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        sd_rpc_stats_t stats;
+
+        do
+        {
+            transport->getStats(stats);
+        } while (stats.event_filtered < eventCount && std::chrono::steady_clock::now() < deadline);
+
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        // Only advertising reports of API version 6 are decoded when discarded
+        REQUIRE(stats.event_filtered == eventCount);
+        REQUIRE(stats.event_filtered_adv_reports == 0);
+        REQUIRE(received == 0);
+    }
+
+    SECTION("Events are passed in order on the H5Transport thread")
+    {
+        const auto testThread = std::this_thread::get_id();
+        std::atomic<uint32_t> sendErrorCode(NRF_SUCCESS);
+        std::atomic<bool> sendReturned(false);
+        std::atomic<uint32_t> otherThreadCallbacks(0);
+        std::thread::id callbackThread;
+
+        const auto eventCallback = [&](ble_evt_t *event) {
+            checkOrder(event, received);
+
+            if (received == 0)
+            {
+                callbackThread = std::this_thread::get_id();
+
+                // Sending from the H5Transport thread fails instead of waiting for the response
+                sendErrorCode = transport->send(std::vector<uint8_t>(4, 0x00),
+                                                std::make_shared<std::vector<uint8_t>>(32));
+                sendReturned  = true;
+            }
+            else if (callbackThread != std::this_thread::get_id())
+            {
+                otherThreadCallbacks++;
+            }
+
+            received++;
+        };
+
+        REQUIRE(transport->setEventDispatch(SD_RPC_EVT_DISPATCH_INLINE) == NRF_SUCCESS);
+        REQUIRE(transport->open(noopStatus, eventCallback, noopLog) == NRF_SUCCESS);
+        REQUIRE(transport->setEventDispatch(SD_RPC_EVT_DISPATCH_EVENT_THREAD) ==
+                NRF_ERROR_INVALID_STATE);
+
+        for (uint32_t i = 0; i < eventCount; i++)
+        {
+            peer.sendEvent(static_cast<uint8_t>(i));
+        }
+
+        // The response timeout is a second, a blocked send would not return before all events
+        // are received
+        REQUIRE(waitForEvents(received, eventCount));
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        REQUIRE(outOfOrder == 0);
+        REQUIRE(sendReturned);
+        REQUIRE(sendErrorCode == NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_INVALID_STATE);
+        REQUIRE(otherThreadCallbacks == 0);
+        REQUIRE(callbackThread != testThread);
+    }
+
+    SECTION("Commands sent from the event callback are answered while the event queue is full")
+    {
+        std::atomic<uint32_t> sendErrorCode(NRF_ERROR_INTERNAL);
+        std::atomic<uint32_t> queuedEvents(0);
+        FirstCallbackGate gate;
+
+        const auto eventCallback = [&](ble_evt_t *event) {
+            checkOrder(event, received);
+
+            if (received == 0)
+            {
+                // The other events overflow the queue while the callback waits
+                gate.hold(1);
+
+                sd_rpc_stats_t stats;
+                transport->getStats(stats);
+
+                queuedEvents  = stats.event_queue_depth;
+                sendErrorCode = transport->send(std::vector<uint8_t>(4, 0x00),
+                                                std::make_shared<std::vector<uint8_t>>(32));
+            }
+
+            received++;
+        };
+
+        REQUIRE(transport->setEventQueueConfig(4, SD_RPC_EVT_QUEUE_OVERFLOW_SPILL) ==
+                NRF_SUCCESS);
+        REQUIRE(transport->open(noopStatus, eventCallback, noopLog) == NRF_SUCCESS);
+
+        for (uint32_t i = 0; i < eventCount; i++)
+        {
+            peer.sendEvent(static_cast<uint8_t>(i));
+        }
+
+        gate.release(*transport, eventCount);
+
+        REQUIRE(waitForEvents(received, eventCount));
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        REQUIRE(queuedEvents == eventCount - 1);
+        REQUIRE(sendErrorCode == NRF_SUCCESS);
+        REQUIRE(outOfOrder == 0);
+    }
+
+    SECTION("No events are lost by default while the event queue and its reserve are full")
+    {
+        const auto queued =
+            static_cast<uint32_t>(EventQueueCapacity + EventQueueOverflowReserve);
+        const auto sentCount = queued + 20;
+        std::atomic<uint32_t> queuedWhileWaiting(0);
+
+        const auto eventCallback = [&](ble_evt_t *event) {
+            checkOrder(event, received);
+
+            if (received == 0)
+            {
+                // The other events fill the queue and the reserve while the callback waits
+                queuedWhileWaiting = waitForQueueDepth(*transport, queued);
+            }
+
+            received++;
+        };
+
+        REQUIRE(transport->open(noopStatus, eventCallback, noopLog) == NRF_SUCCESS);
+
+        for (uint32_t i = 0; i < sentCount; i++)
+        {
+            peer.sendEvent(static_cast<uint8_t>(i));
+        }
+
+        REQUIRE(waitForEvents(received, sentCount));
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        sd_rpc_stats_t stats;
+        transport->getStats(stats);
+
+        REQUIRE(queuedWhileWaiting == queued);
+        REQUIRE(stats.event_queue_dropped == 0);
+        REQUIRE(outOfOrder == 0);
+    }
+
+    SECTION("Commands sent from the event callback are answered during a flood of advertising "
+            "reports by default")
+    {
+        const auto sentCount =
+            static_cast<uint32_t>(EventQueueCapacity + EventQueueOverflowReserve + 64);
+        std::atomic<uint32_t> sendErrorCode(NRF_ERROR_INTERNAL);
+        FirstCallbackGate gate;
+
+        const auto eventCallback = [&](ble_evt_t *) {
+            if (received == 0)
+            {
+                // More reports are received while the callback waits than the queue and its
+                // reserve hold, the response follows them
+                gate.hold(1);
+                sendErrorCode = transport->send(std::vector<uint8_t>(4, 0x00),
+                                                std::make_shared<std::vector<uint8_t>>(32));
+            }
+
+            received++;
+        };
+
+        REQUIRE(transport->open(noopStatus, eventCallback, noopLog) == NRF_SUCCESS);
+
+        for (uint32_t i = 0; i < sentCount; i++)
+        {
+            peer.sendAdvReport(static_cast<uint8_t>(i));
+        }
+
+        gate.release(*transport, sentCount);
+
+        sd_rpc_stats_t stats;
+        transport->getStats(stats);
+        const auto dropped = stats.event_queue_dropped;
+
+        REQUIRE(waitForEvents(received, sentCount - dropped));
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        REQUIRE(sendErrorCode == NRF_SUCCESS);
+        REQUIRE(dropped == sentCount - 1 - EventQueueCapacity);
+    }
+
+    SECTION("Only advertising reports are dropped when the policy drops reports")
+    {
+        const auto capacity  = 4;
+        const auto queued    = static_cast<uint32_t>(capacity + EventQueueOverflowReserve);
+        const auto sentCount = queued + 20;
+        std::atomic<uint32_t> queuedWhileWaiting(0);
+
+        const auto eventCallback = [&](ble_evt_t *event) {
+            checkOrder(event, received);
+
+            if (received == 0)
+            {
+                queuedWhileWaiting = waitForQueueDepth(*transport, queued);
+            }
+
+            received++;
+        };
+
+        REQUIRE(transport->setEventQueueConfig(
+                    capacity, SD_RPC_EVT_QUEUE_OVERFLOW_DROP_OLDEST_ADV_REPORT) == NRF_SUCCESS);
+        REQUIRE(transport->open(noopStatus, eventCallback, noopLog) == NRF_SUCCESS);
+
+        for (uint32_t i = 0; i < sentCount; i++)
+        {
+            peer.sendEvent(static_cast<uint8_t>(i));
+        }
+
+        REQUIRE(waitForEvents(received, sentCount));
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        sd_rpc_stats_t stats;
+        transport->getStats(stats);
+
+        REQUIRE(queuedWhileWaiting == queued);
+        REQUIRE(stats.event_queue_dropped == 0);
+        REQUIRE(outOfOrder == 0);
+    }
+
+    SECTION("Commands are answered while pulled events fill the event queue")
+    {
+        REQUIRE(transport->setEventQueueConfig(4, SD_RPC_EVT_QUEUE_OVERFLOW_BLOCK) ==
+                NRF_SUCCESS);
+        REQUIRE(transport->setEventDispatch(SD_RPC_EVT_DISPATCH_PULL) ==
+                NRF_ERROR_INVALID_STATE);
+        REQUIRE(transport->setEventQueueConfig(4, SD_RPC_EVT_QUEUE_OVERFLOW_SPILL) ==
+                NRF_SUCCESS);
+        REQUIRE(transport->setEventDispatch(SD_RPC_EVT_DISPATCH_PULL) == NRF_SUCCESS);
+        REQUIRE(transport->setEventQueueConfig(4, SD_RPC_EVT_QUEUE_OVERFLOW_BLOCK) ==
+                NRF_ERROR_INVALID_STATE);
+
+        const auto eventCallback = [&](ble_evt_t *) { received++; };
+        REQUIRE(transport->open(noopStatus, eventCallback, noopLog) == NRF_SUCCESS);
+
+        for (uint32_t i = 0; i < eventCount; i++)
+        {
+            peer.sendEvent(static_cast<uint8_t>(i));
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        sd_rpc_stats_t stats;
+
+        do
+        {
+            transport->getStats(stats);
+        } while (stats.event_queue_depth < eventCount &&
+                 std::chrono::steady_clock::now() < deadline);
+
+        REQUIRE(stats.event_queue_depth == eventCount);
+        REQUIRE(transport->send(std::vector<uint8_t>(4, 0x00),
+                                std::make_shared<std::vector<uint8_t>>(32)) == NRF_SUCCESS);
+
+        std::vector<uint8_t> buffer(MaxPossibleEventLength);
+        const auto event = reinterpret_cast<ble_evt_t *>(buffer.data());
+
+        for (uint32_t i = 0; i < eventCount; i++)
+        {
+            auto length = static_cast<uint32_t>(buffer.size());
+            REQUIRE(transport->getEvent(event, length, std::chrono::milliseconds(0)) ==
+                    NRF_SUCCESS);
+            checkOrder(event, i);
+        }
+
+        REQUIRE(transport->close() == NRF_SUCCESS);
+        REQUIRE(outOfOrder == 0);
+        REQUIRE(received == 0);
+    }
+
+    SECTION("Events that find the pulled event queue full are lost without holding up commands")
+    {
+        const uint32_t capacity  = 4;
+        const uint32_t lostCount = 8;
+        const auto queued        = static_cast<uint32_t>(capacity + EventQueueOverflowReserve);
+        const auto sentCount     = queued + lostCount;
+        std::atomic<uint32_t> lostReports(0);
+
+        // Spilling into the reserve is reported as well, at most once a second
+        const auto statusCallback = [&](const sd_rpc_app_status_t code,
+                                        const std::string &message) {
+            if (code == EVENT_QUEUE_OVERFLOW && message.find(" lost") != std::string::npos)
+            {
+                lostReports++;
+            }
+        };
+
+        REQUIRE(transport->setEventQueueConfig(capacity, SD_RPC_EVT_QUEUE_OVERFLOW_SPILL) ==
+                NRF_SUCCESS);
+        REQUIRE(transport->setEventDispatch(SD_RPC_EVT_DISPATCH_PULL) == NRF_SUCCESS);
+        REQUIRE(transport->open(statusCallback, [](ble_evt_t *) {}, noopLog) == NRF_SUCCESS);
+
+        for (uint32_t i = 0; i < sentCount; i++)
+        {
+            peer.sendEvent(static_cast<uint8_t>(i));
+        }
+
+        sd_rpc_stats_t stats;
+
+        do
+        {
+            transport->getStats(stats);
+        } while (stats.event_queue_depth + stats.event_queue_lost < sentCount);
+
+        REQUIRE(transport->send(std::vector<uint8_t>(4, 0x00),
+                                std::make_shared<std::vector<uint8_t>>(32)) == NRF_SUCCESS);
+
+        transport->getStats(stats);
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        REQUIRE(stats.event_queue_depth == queued);
+        REQUIRE(stats.event_queue_lost == lostCount);
+        REQUIRE(stats.event_queue_dropped == lostCount);
+        REQUIRE(lostReports == lostCount);
+    }
+
+    SECTION("Events are passed in order in batches of up to max_count events")
+    {
+        const uint32_t maxCount = 8;
+        std::vector<uint32_t> batchSizes;
+        std::atomic<uint32_t> unbatched(0);
+        FirstCallbackGate gate;
+
+        const auto batchCallback = [&](ble_evt_t *const *events, const uint32_t count) {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                checkOrder(events[i], received + i);
+            }
+
+            // The other events are queued while the first batch is handled
+            if (batchSizes.empty())
+            {
+                gate.hold(count);
+            }
+
+            batchSizes.push_back(count);
+            received += count;
+        };
+
+        REQUIRE(transport->setEventBatchConfig(batchCallback, 0, std::chrono::seconds(1)) ==
+                NRF_ERROR_INVALID_PARAM);
+        REQUIRE(transport->setEventBatchConfig(batchCallback, maxCount, std::chrono::seconds(1)) ==
+                NRF_SUCCESS);
+        REQUIRE(transport->open(noopStatus, [&](ble_evt_t *) { unbatched++; }, noopLog) ==
+                NRF_SUCCESS);
+
+        for (uint32_t i = 0; i < eventCount; i++)
+        {
+            peer.sendEvent(static_cast<uint8_t>(i));
+        }
+
+        gate.release(*transport, eventCount);
+
+        REQUIRE(waitForEvents(received, eventCount));
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        REQUIRE(outOfOrder == 0);
+        REQUIRE(unbatched == 0);
+        REQUIRE(received == eventCount);
+
+        // All batches after the first are full, except the one taking the last events
+        REQUIRE(batchSizes.size() > 2);
+
+        for (size_t i = 1; i + 1 < batchSizes.size(); i++)
+        {
+            REQUIRE(batchSizes[i] == maxCount);
+        }
+
+        REQUIRE(batchSizes.back() <= maxCount);
+    }
+
+    SECTION("Decoding a batch stops when the time budget has passed")
+    {
+        std::vector<uint32_t> batchSizes;
+        FirstCallbackGate gate;
+
+        const auto batchCallback = [&](ble_evt_t *const *events, const uint32_t count) {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                checkOrder(events[i], received + i);
+            }
+
+            if (batchSizes.empty())
+            {
+                gate.hold(count);
+            }
+
+            batchSizes.push_back(count);
+            received += count;
+        };
+
+        // Without a time budget each batch ends after its first event, although events are queued
+        REQUIRE(transport->setEventBatchConfig(batchCallback, EventBatchMaxCount,
+                                               std::chrono::microseconds(0)) == NRF_SUCCESS);
+        REQUIRE(transport->open(noopStatus, [](ble_evt_t *) {}, noopLog) == NRF_SUCCESS);
+
+        for (uint32_t i = 0; i < eventCount; i++)
+        {
+            peer.sendEvent(static_cast<uint8_t>(i));
+        }
+
+        gate.release(*transport, eventCount);
+
+        REQUIRE(waitForEvents(received, eventCount));
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        REQUIRE(outOfOrder == 0);
+        REQUIRE(batchSizes == std::vector<uint32_t>(eventCount, 1));
+    }
+
+    SECTION("Events retained in the batch callback stay valid after it returns")
+    {
+        const ble_evt_t *retained = nullptr;
+        std::atomic<uint32_t> retainErrorCode(NRF_ERROR_INTERNAL);
+
+        const auto batchCallback = [&](ble_evt_t *const *events, const uint32_t count) {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                checkOrder(events[i], received + i + 1);
+            }
+
+            if (retained == nullptr)
+            {
+                retained        = events[0];
+                retainErrorCode = transport->retainEvent(retained);
+            }
+
+            received += count;
+        };
+
+        REQUIRE(transport->setEventBatchConfig(batchCallback, 4, std::chrono::seconds(1)) ==
+                NRF_SUCCESS);
+        REQUIRE(transport->open(noopStatus, [](ble_evt_t *) {}, noopLog) == NRF_SUCCESS);
+
+        // The buffers of the other events are reused many times over
+        for (uint32_t i = 0; i < eventCount; i++)
+        {
+            peer.sendEvent(static_cast<uint8_t>(i + 1));
+        }
+
+        REQUIRE(waitForEvents(received, eventCount));
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        REQUIRE(retainErrorCode == NRF_SUCCESS);
+        REQUIRE(retained->header.evt_id == BLE_GAP_EVT_KEY_PRESSED);
+        REQUIRE(retained->evt.gap_evt.params.key_pressed.kp_not == 1);
+
+        // Retained events keep the batch configuration until they are released
+        REQUIRE(transport->setEventBatchConfig(batchCallback, 4, std::chrono::seconds(1)) ==
+                NRF_ERROR_INVALID_STATE);
+        REQUIRE(transport->releaseEvent(retained) == NRF_SUCCESS);
+        REQUIRE(transport->releaseEvent(retained) == NRF_ERROR_INVALID_STATE);
+        REQUIRE(transport->setEventBatchConfig(batchCallback, 4, std::chrono::seconds(1)) ==
+                NRF_SUCCESS);
+    }
+
+    SECTION("Events are pulled when the descriptor is readable")
+    {
+        // Not called when events are pulled
+        const auto eventCallback = [&](ble_evt_t *) { received++; };
+
+        REQUIRE(transport->setEventDispatch(SD_RPC_EVT_DISPATCH_PULL) == NRF_SUCCESS);
+        REQUIRE(transport->open(noopStatus, eventCallback, noopLog) == NRF_SUCCESS);
+
+        int fd = -1;
+        REQUIRE(transport->getEventFd(fd) == NRF_SUCCESS);
+
+        const auto readable = [fd](const int timeout) {
+            struct pollfd pfd = {fd, POLLIN, 0};
+            return poll(&pfd, 1, timeout) > 0 && (pfd.revents & POLLIN);
+        };
+
+        std::vector<uint8_t> buffer(MaxPossibleEventLength);
+        const auto event  = reinterpret_cast<ble_evt_t *>(buffer.data());
+        uint32_t length   = 0;
+        uint32_t expected = 0;
+
+        REQUIRE_FALSE(readable(0));
+        REQUIRE(transport->getEvent(event, length, std::chrono::milliseconds(0)) ==
+                NRF_ERROR_DATA_SIZE);
+        REQUIRE(length == MaxPossibleEventLength);
+
+        for (uint32_t i = 0; i < eventCount; i++)
+        {
+            peer.sendEvent(static_cast<uint8_t>(i));
+        }
+
+        while (expected < eventCount && readable(1000))
+        {
+            for (;;)
+            {
+                length = static_cast<uint32_t>(buffer.size());
+                const auto errCode =
+                    transport->getEvent(event, length, std::chrono::milliseconds(0));
+
+                if (errCode != NRF_SUCCESS)
+                {
+                    REQUIRE(errCode == NRF_ERROR_NOT_FOUND);
+                    break;
+                }
+
+                checkOrder(event, expected);
+                expected++;
+            }
+        }
+
+        REQUIRE(expected == eventCount);
+        REQUIRE(outOfOrder == 0);
+        REQUIRE(received == 0);
+        REQUIRE_FALSE(readable(0));
+
+        // Waits for the next event
+        peer.sendEvent(0x55);
+        length = static_cast<uint32_t>(buffer.size());
+        REQUIRE(transport->getEvent(event, length, std::chrono::milliseconds(1000)) ==
+                NRF_SUCCESS);
+        REQUIRE(event->evt.gap_evt.params.key_pressed.kp_not == 0x55);
+
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        length = static_cast<uint32_t>(buffer.size());
+        REQUIRE(transport->getEvent(event, length, std::chrono::milliseconds(0)) ==
+                NRF_ERROR_INVALID_STATE);
+    }
+}
+
+TEST_CASE("EventDispatchLatency", "[.benchmark]")
+{
+    const auto measure = [](const char *name, const sd_rpc_evt_dispatch_t dispatch) {
+        EventPeer peer;
+        auto transport = createTransport(peer.portName());
+
+        std::atomic<uint32_t> received(0);
+        const auto eventCallback = [&](ble_evt_t *) { received++; };
+
+        REQUIRE(transport->setEventDispatch(dispatch) == NRF_SUCCESS);
+        REQUIRE(transport->open(noopStatus, eventCallback, noopLog) == NRF_SUCCESS);
+
+        // Time from writing an event to the UART until the event callback is invoked
+        BENCHMARK(name)
+        {
+            const uint32_t count = received + 1;
+            peer.sendEvent(static_cast<uint8_t>(count));
+            return waitForEvents(received, count);
+        };
+
+        REQUIRE(transport->close() == NRF_SUCCESS);
+    };
+
+    measure("Event thread, UART write to event callback", SD_RPC_EVT_DISPATCH_EVENT_THREAD);
+    measure("Inline, UART write to event callback", SD_RPC_EVT_DISPATCH_INLINE);
+}
+
+#endif // defined(__unix__) || defined(__APPLE__)
@@ -0,0 +1,651 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <event_ring.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr uint32_t EventCount = 100000;
+constexpr size_t EventLength  = 40;
+
+void writeEvent(std::vector<uint8_t> &event, const uint32_t sequenceNumber)
+{
+    event.assign(EventLength, static_cast<uint8_t>(sequenceNumber));
+    std::memcpy(event.data(), &sequenceNumber, sizeof(sequenceNumber));
+}
+
+uint32_t readEvent(const std::vector<uint8_t> &event)
+{
+    uint32_t sequenceNumber;
+    std::memcpy(&sequenceNumber, event.data(), sizeof(sequenceNumber));
+    return sequenceNumber;
+}
+
+/**
+ * @brief Queue as used by SerializationTransport before EventRing, for comparison.
+ */
+class LockedQueue
+{
+  public:
+    void push(const uint32_t sequenceNumber)
+    {
+        std::vector<uint8_t> event;
+        writeEvent(event, sequenceNumber);
+
+        std::lock_guard<std::mutex> lck(mutex);
+        queue.push(std::move(event));
+        condition.notify_one();
+    }
+
+    uint32_t pop()
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        condition.wait(lck, [&] { return !queue.empty(); });
+        const auto event = std::move(queue.front());
+        queue.pop();
+        lck.unlock();
+
+        return readEvent(event);
+    }
+
+  private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::queue<std::vector<uint8_t>> queue;
+};
+
+uint32_t transferThroughRing(EventRing &ring, const uint32_t count)
+{
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const auto event = ring.beginPush();
+            writeEvent(*event, i);
+            ring.endPush();
+        }
+    });
+
+    uint32_t outOfOrder = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const auto event = ring.beginPop();
+
+        if (readEvent(*event) != i || event->size() != EventLength)
+        {
+            outOfOrder++;
+        }
+
+        ring.endPop();
+    }
+
+    producer.join();
+    return outOfOrder;
+}
+} // namespace
+
+TEST_CASE("EventRing")
+{
+    SECTION("Capacity limits the number of queued events")
+    {
+        EventRing ring(3);
+        REQUIRE(ring.capacity() == 3);
+
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            REQUIRE_FALSE(ring.full());
+            writeEvent(*ring.beginPush(), i);
+            ring.endPush();
+        }
+
+        REQUIRE(ring.full());
+    }
+
+    SECTION("Events are passed between threads in order")
+    {
+        // A small ring makes both sides wait for each other
+        EventRing ring(4);
+
+        REQUIRE(transferThroughRing(ring, EventCount) == 0);
+        REQUIRE(ring.size() == 0);
+        REQUIRE(ring.highWaterMark() <= 4);
+        REQUIRE(ring.highWaterMark() > 0);
+    }
+
+    SECTION("Depth and high water mark")
+    {
+        EventRing ring(8);
+
+        for (uint32_t i = 0; i < 5; i++)
+        {
+            writeEvent(*ring.beginPush(), i);
+            ring.endPush();
+        }
+
+        REQUIRE(ring.size() == 5);
+
+        ring.beginPop();
+        ring.endPop();
+
+        REQUIRE(ring.size() == 4);
+        REQUIRE(ring.highWaterMark() == 5);
+
+        ring.clear();
+
+        REQUIRE(ring.size() == 0);
+        REQUIRE(ring.highWaterMark() == 5);
+    }
+
+    SECTION("Taking an event without waiting")
+    {
+        EventRing ring(4);
+        REQUIRE(ring.tryBeginPop() == nullptr);
+
+        writeEvent(*ring.beginPush(), 7);
+        ring.endPush();
+
+        const auto event = ring.tryBeginPop();
+        REQUIRE(event != nullptr);
+        REQUIRE(readEvent(*event) == 7);
+        ring.endPop();
+
+        REQUIRE(ring.tryBeginPop() == nullptr);
+    }
+
+    SECTION("Stop wakes up waiting consumer and producer")
+    {
+        EventRing ring(1);
+        std::vector<uint8_t> dummy;
+        std::atomic<bool> consumerReturned(false);
+
+        std::vector<uint8_t> *popped = &dummy;
+
+        std::thread consumer([&] {
+            popped           = ring.beginPop();
+            consumerReturned = true;
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        REQUIRE_FALSE(consumerReturned);
+
+        ring.stop();
+        consumer.join();
+        REQUIRE(popped == nullptr);
+
+        ring.start();
+        writeEvent(*ring.beginPush(), 0);
+        ring.endPush();
+
+        // Full, the producer waits until the ring is stopped
+        std::vector<uint8_t> *pushed = &dummy;
+        std::thread producer([&] { pushed = ring.beginPush(); });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ring.stop();
+        producer.join();
+        REQUIRE(pushed == nullptr);
+    }
+}
+
+TEST_CASE("EventRing_overflow")
+{
+    EventRing ring(4);
+
+    const auto push = [&](const uint32_t sequenceNumber) {
+        writeEvent(*ring.beginPush(), sequenceNumber);
+        ring.endPush();
+    };
+
+    const auto pop = [&] {
+        const auto sequenceNumber = readEvent(*ring.beginPop());
+        ring.endPop();
+        return sequenceNumber;
+    };
+
+    const auto isOdd = [](const std::vector<uint8_t> &event) { return readEvent(event) % 2 == 1; };
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        push(i);
+    }
+
+    SECTION("Dropped events make room and are skipped by the consumer")
+    {
+        REQUIRE(ring.dropOldest(isOdd));
+        REQUIRE(ring.size() == 3);
+        REQUIRE_FALSE(ring.full());
+
+        push(4);
+        REQUIRE(ring.dropOldest(isOdd));
+        push(5);
+
+        REQUIRE(ring.size() == 4);
+        REQUIRE(pop() == 0);
+        REQUIRE(pop() == 2);
+        REQUIRE(pop() == 4);
+        REQUIRE(pop() == 5);
+        REQUIRE(ring.size() == 0);
+    }
+
+    SECTION("Dropped events occupy slots until the consumer passes them")
+    {
+        uint32_t next = 4;
+
+        // Twice the capacity in slots, dropping events makes room for as many new events
+        while (ring.dropOldest([](const std::vector<uint8_t> &) { return true; }) && !ring.full())
+        {
+            push(next++);
+        }
+
+        REQUIRE(next == 8);
+        REQUIRE(ring.full());
+        REQUIRE(ring.size() == 3);
+
+        REQUIRE(pop() == 5);
+        REQUIRE_FALSE(ring.full());
+    }
+
+    SECTION("Events taken by the consumer are not dropped")
+    {
+        ring.beginPop();
+
+        REQUIRE_FALSE(ring.dropOldest([](const std::vector<uint8_t> &event) {
+            return readEvent(event) == 0;
+        }));
+
+        ring.endPop();
+    }
+
+    SECTION("Newest matching event is rewritten in place")
+    {
+        const auto rewrite = [](std::vector<uint8_t> &event) { writeEvent(event, 7); };
+
+        REQUIRE(ring.rewriteNewest(isOdd, rewrite));
+        REQUIRE_FALSE(ring.rewriteNewest([](const std::vector<uint8_t> &) { return false; },
+                                         [](std::vector<uint8_t> &) {}));
+
+        REQUIRE(ring.size() == 4);
+        REQUIRE(pop() == 0);
+        REQUIRE(pop() == 1);
+        REQUIRE(pop() == 2);
+        REQUIRE(pop() == 7);
+    }
+
+    SECTION("Flagged events stay queued and are passed with their flags")
+    {
+        REQUIRE(ring.flagOldest(isOdd, 0x01));
+        REQUIRE(ring.flagNewest(isOdd, 0x02));
+        REQUIRE(ring.flagOldest(isOdd, 0x01));
+        REQUIRE_FALSE(ring.flagOldest(isOdd, 0x01));
+
+        REQUIRE(ring.size() == 4);
+        REQUIRE(ring.full());
+
+        const uint8_t expectedFlags[] = {0x00, 0x01, 0x00, 0x03};
+
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            REQUIRE(readEvent(*ring.beginPop()) == i);
+            REQUIRE(ring.flags() == expectedFlags[i]);
+            ring.endPop();
+        }
+    }
+
+    SECTION("Clear skips dropped events")
+    {
+        REQUIRE(ring.dropOldest(isOdd));
+        ring.clear();
+
+        REQUIRE(ring.size() == 0);
+        push(8);
+        REQUIRE(pop() == 8);
+    }
+}
+
+TEST_CASE("EventRing_reserve")
+{
+    EventRing ring(4, 1, 2);
+    REQUIRE(ring.reserve() == 2);
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        writeEvent(*ring.tryBeginPush(), i);
+        ring.endPush();
+    }
+
+    SECTION("Events are pushed to the reserve of a full lane in order")
+    {
+        REQUIRE(ring.full());
+        REQUIRE(ring.tryBeginPush() == nullptr);
+
+        for (uint32_t i = 4; i < 6; i++)
+        {
+            const auto event = ring.tryBeginPush(0, true);
+            REQUIRE(event != nullptr);
+            writeEvent(*event, i);
+            ring.endPush();
+        }
+
+        REQUIRE(ring.tryBeginPush(0, true) == nullptr);
+        REQUIRE(ring.size() == 6);
+        REQUIRE(ring.highWaterMark() == 6);
+
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            REQUIRE(readEvent(*ring.beginPop()) == i);
+            ring.endPop();
+            REQUIRE(ring.full() == (i < 2));
+        }
+    }
+
+    SECTION("Dropped events make room in the reserve")
+    {
+        for (uint32_t i = 4; i < 6; i++)
+        {
+            writeEvent(*ring.tryBeginPush(0, true), i);
+            ring.endPush();
+        }
+
+        REQUIRE(ring.dropOldest([](const std::vector<uint8_t> &) { return true; }));
+        REQUIRE(ring.tryBeginPush(0, true) != nullptr);
+    }
+
+    SECTION("Pushing to a full reserve waits until the consumer makes room")
+    {
+        for (uint32_t i = 4; i < 6; i++)
+        {
+            writeEvent(*ring.beginPush(0, true), i);
+            ring.endPush();
+        }
+
+        std::atomic<bool> pushed(false);
+
+        std::thread producer([&] {
+            writeEvent(*ring.beginPush(0, true), 6);
+            ring.endPush();
+            pushed = true;
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        REQUIRE_FALSE(pushed);
+
+        for (uint32_t i = 0; i < 7; i++)
+        {
+            REQUIRE(readEvent(*ring.beginPop()) == i);
+            ring.endPop();
+        }
+
+        producer.join();
+        REQUIRE(pushed);
+    }
+}
+
+TEST_CASE("EventRing_overflow_concurrent")
+{
+    // The producer drops odd events while the consumer takes events, each event must be delivered
+    // once and in order, or dropped
+    EventRing ring(8);
+    std::atomic<uint32_t> dropped(0);
+
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < EventCount; i++)
+        {
+            if (ring.full() && ring.dropOldest([](const std::vector<uint8_t> &event) {
+                    return readEvent(event) % 2 == 1;
+                }))
+            {
+                dropped++;
+            }
+
+            writeEvent(*ring.beginPush(), i);
+            ring.endPush();
+        }
+    });
+
+    uint32_t delivered = 0;
+    uint32_t previous  = 0;
+    bool ordered       = true;
+
+    // The last event is never dropped, all drops are counted when it is delivered
+    while (delivered + dropped < EventCount)
+    {
+        const auto sequenceNumber = readEvent(*ring.beginPop());
+        ring.endPop();
+
+        ordered  = ordered && (delivered == 0 || sequenceNumber > previous);
+        previous = sequenceNumber;
+        delivered++;
+    }
+
+    producer.join();
+
+    REQUIRE(ordered);
+    REQUIRE(delivered + dropped == EventCount);
+    REQUIRE(ring.size() == 0);
+}
+
+TEST_CASE("EventRing_lanes")
+{
+    constexpr size_t High   = 0;
+    constexpr size_t Normal = 1;
+
+    EventRing ring(4, 2);
+
+    const auto push = [&](const size_t lane, const uint32_t sequenceNumber,
+                          const uint32_t orderingKey) {
+        writeEvent(*ring.beginPush(lane), sequenceNumber);
+        ring.endPush(orderingKey);
+    };
+
+    const auto pop = [&](size_t *lane = nullptr) {
+        const auto sequenceNumber = readEvent(*ring.beginPop(lane));
+        ring.endPop();
+        return sequenceNumber;
+    };
+
+    SECTION("Events of the high priority lane are taken first")
+    {
+        push(Normal, 0, EventRing::Unordered);
+        push(Normal, 1, EventRing::Unordered);
+        push(High, 2, 0);
+
+        size_t lane = Normal;
+        REQUIRE(pop(&lane) == 2);
+        REQUIRE(lane == High);
+        REQUIRE(pop(&lane) == 0);
+        REQUIRE(lane == Normal);
+        REQUIRE(pop() == 1);
+        REQUIRE(ring.size() == 0);
+    }
+
+    SECTION("Lanes are full independently")
+    {
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            push(Normal, i, EventRing::Unordered);
+        }
+
+        REQUIRE(ring.full(Normal));
+        REQUIRE_FALSE(ring.full(High));
+        REQUIRE(ring.highWaterMark() == 4);
+
+        push(High, 4, EventRing::Unordered);
+        REQUIRE(ring.size() == 5);
+        REQUIRE(ring.highWaterMark() == 5);
+    }
+
+    SECTION("Older events with the same ordering key are taken before high priority events")
+    {
+        push(Normal, 0, EventRing::Unordered);
+        push(Normal, 1, 7);
+        push(Normal, 2, EventRing::Unordered);
+        push(Normal, 3, 7);
+        push(High, 4, 7);
+
+        REQUIRE(pop() == 1);
+        REQUIRE(pop() == 3);
+        REQUIRE(pop() == 4);
+
+        push(Normal, 5, 7);
+
+        REQUIRE(pop() == 0);
+        REQUIRE(pop() == 2);
+        REQUIRE(pop() == 5);
+        REQUIRE(ring.size() == 0);
+    }
+
+    SECTION("Slots of events taken out of order are reused")
+    {
+        push(Normal, 0, EventRing::Unordered);
+
+        // The slots stay in use until the consumer takes event 0 and passes them
+        for (uint32_t round = 1; round < 7; round++)
+        {
+            push(Normal, round, round);
+            push(High, 100 + round, round);
+
+            REQUIRE(pop() == round);
+            REQUIRE(pop() == 100 + round);
+        }
+
+        REQUIRE(ring.size() == 1);
+        REQUIRE(pop() == 0);
+
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            REQUIRE_FALSE(ring.full(Normal));
+            push(Normal, i, EventRing::Unordered);
+        }
+
+        REQUIRE(ring.full(Normal));
+    }
+
+    SECTION("Clear discards events of all lanes")
+    {
+        push(Normal, 0, 1);
+        push(High, 1, 2);
+        ring.clear();
+
+        REQUIRE(ring.size() == 0);
+        push(Normal, 2, EventRing::Unordered);
+        REQUIRE(pop() == 2);
+    }
+}
+
+TEST_CASE("EventRing_lanes_concurrent")
+{
+    // Every fourth event is pushed to the high priority lane. Events with the same ordering key
+    // must be taken in the order they are pushed.
+    constexpr uint32_t KeyCount = 3;
+
+    EventRing ring(8, 2);
+
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < EventCount; i++)
+        {
+            writeEvent(*ring.beginPush(i % 4 == 0 ? 0 : 1), i);
+            ring.endPush(i % KeyCount);
+        }
+    });
+
+    uint32_t previous[KeyCount] = {};
+    bool seen[KeyCount]         = {};
+    bool ordered                = true;
+
+    for (uint32_t delivered = 0; delivered < EventCount; delivered++)
+    {
+        const auto sequenceNumber = readEvent(*ring.beginPop());
+        ring.endPop();
+
+        const auto key = sequenceNumber % KeyCount;
+        ordered        = ordered && (!seen[key] || sequenceNumber > previous[key]);
+        previous[key]  = sequenceNumber;
+        seen[key]      = true;
+    }
+
+    producer.join();
+
+    REQUIRE(ordered);
+    REQUIRE(ring.size() == 0);
+}
+
+TEST_CASE("EventRing_benchmark", "[.benchmark]")
+{
+    BENCHMARK("mutex, condition variable and std::queue, 100000 events")
+    {
+        LockedQueue queue;
+        std::thread producer([&] {
+            for (uint32_t i = 0; i < EventCount; i++)
+            {
+                queue.push(i);
+            }
+        });
+
+        uint32_t last = 0;
+
+        for (uint32_t i = 0; i < EventCount; i++)
+        {
+            last = queue.pop();
+        }
+
+        producer.join();
+        return last;
+    };
+
+    BENCHMARK("EventRing, 100000 events")
+    {
+        EventRing ring(1024);
+        return transferThroughRing(ring, EventCount);
+    };
+}
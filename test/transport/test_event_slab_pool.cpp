@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <event_slab_pool.h>
+#include <nrf_error.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+constexpr size_t SlabCount = 4;
+constexpr size_t SlabSize  = 700;
+
+bool isCleared(const uint8_t *slab, const size_t size)
+{
+    return std::all_of(slab, slab + size, [](const uint8_t value) { return value == 0; });
+}
+} // namespace
+
+TEST_CASE("EventSlabPool")
+{
+    EventSlabPool pool(SlabCount, SlabSize);
+
+    SECTION("Slabs are aligned and cleared")
+    {
+        REQUIRE(pool.slabSize() >= SlabSize);
+        REQUIRE(pool.slabSize() % alignof(std::max_align_t) == 0);
+
+        std::set<uint8_t *> slabs;
+
+        for (size_t i = 0; i < SlabCount; i++)
+        {
+            const auto slab = pool.take();
+            REQUIRE(slab != nullptr);
+            REQUIRE(reinterpret_cast<uintptr_t>(slab) % alignof(std::max_align_t) == 0);
+            REQUIRE(isCleared(slab, pool.slabSize()));
+            slabs.insert(slab);
+        }
+
+        REQUIRE(slabs.size() == SlabCount);
+        REQUIRE(pool.take() == nullptr);
+    }
+
+    SECTION("Written part of a slab is cleared before reuse")
+    {
+        for (const size_t written : {size_t{40}, SlabSize, size_t{1}})
+        {
+            const auto slab = pool.take();
+            REQUIRE(isCleared(slab, pool.slabSize()));
+
+            std::memset(slab, 0xAB, written);
+            pool.put(slab, written);
+
+            // The most recently returned slab is reused first
+            REQUIRE(pool.take() == slab);
+            REQUIRE(isCleared(slab, pool.slabSize()));
+            pool.put(slab, 0);
+        }
+    }
+
+    SECTION("Retained slabs are not reused until released")
+    {
+        const auto slab = pool.take();
+        slab[0]         = 0x55;
+
+        REQUIRE(pool.retain(slab) == NRF_SUCCESS);
+        REQUIRE(pool.retain(slab) == NRF_ERROR_INVALID_STATE);
+        pool.put(slab, 1);
+
+        REQUIRE(pool.retained() == 1);
+
+        for (size_t i = 0; i < 10; i++)
+        {
+            const auto other = pool.take();
+            REQUIRE(other != slab);
+            pool.put(other, 0);
+        }
+
+        REQUIRE(slab[0] == 0x55);
+
+        // Released from another thread than the one that retained it
+        uint32_t errCode = NRF_ERROR_INTERNAL;
+        std::thread([&] { errCode = pool.release(slab); }).join();
+
+        REQUIRE(errCode == NRF_SUCCESS);
+        REQUIRE(pool.retained() == 0);
+        REQUIRE(pool.release(slab) == NRF_ERROR_INVALID_STATE);
+
+        REQUIRE(pool.take() == slab);
+        REQUIRE(isCleared(slab, pool.slabSize()));
+    }
+
+    SECTION("Released before put")
+    {
+        const auto slab = pool.take();
+
+        REQUIRE(pool.retain(slab) == NRF_SUCCESS);
+        REQUIRE(pool.release(slab) == NRF_SUCCESS);
+        pool.put(slab, 0);
+
+        REQUIRE(pool.take() == slab);
+    }
+
+    SECTION("One slab is kept free for decoding")
+    {
+        for (size_t i = 0; i < SlabCount - 1; i++)
+        {
+            const auto slab = pool.take();
+            REQUIRE(pool.retain(slab) == NRF_SUCCESS);
+            pool.put(slab, 0);
+        }
+
+        const auto last = pool.take();
+        REQUIRE(last != nullptr);
+        REQUIRE(pool.retain(last) == NRF_ERROR_NO_MEM);
+        pool.put(last, 0);
+
+        REQUIRE(pool.take() == last);
+    }
+
+    SECTION("Only slabs of the pool are accepted")
+    {
+        const auto slab = pool.take();
+        uint8_t other[16];
+
+        REQUIRE(pool.retain(other) == NRF_ERROR_INVALID_PARAM);
+        REQUIRE(pool.retain(slab + 1) == NRF_ERROR_INVALID_PARAM);
+        REQUIRE(pool.release(other) == NRF_ERROR_INVALID_PARAM);
+
+        // Not taken
+        REQUIRE(pool.retain(slab + pool.slabSize()) == NRF_ERROR_INVALID_STATE);
+    }
+}
@@ -0,0 +1,419 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <h5_peer.h>
+#include <h5_transport.h>
+#include <nrf_error.h>
+#include <serialization_transport.h>
+#include <tx_buffer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Sends packets from several threads and returns the time used until all are acknowledged.
+ */
+std::chrono::milliseconds sendPackets(H5Transport &transport, const uint32_t packetCount,
+                                      const uint32_t threadCount)
+{
+    std::atomic<uint32_t> failures(0);
+    std::vector<std::thread> senders;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        senders.emplace_back([&] {
+            const std::vector<uint8_t> packet(20, 0x55);
+
+            for (uint32_t j = 0; j < packetCount / threadCount; j++)
+            {
+                if (transport.send(packet) != NRF_SUCCESS)
+                {
+                    failures++;
+                }
+            }
+        });
+    }
+
+    for (auto &sender : senders)
+    {
+        sender.join();
+    }
+
+    REQUIRE(failures == 0);
+
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                 start);
+}
+
+} // namespace
+
+TEST_CASE("H5SlidingWindow")
+{
+    const auto ackDelay        = std::chrono::milliseconds(5);
+    const uint32_t packetCount = 140;
+    const uint32_t threadCount = 7;
+
+    const auto noopStatus = [](const sd_rpc_app_status_t, const std::string &) {};
+    const auto noopData   = [](const uint8_t *, const size_t) {};
+    const auto noopLog    = [](const sd_rpc_log_severity_t, const std::string &) {};
+
+    SECTION("Window size is negotiated down to what the peer supports")
+    {
+        H5Peer peer(MinSlidingWindowSize, ackDelay);
+        const auto transport = createTransport(peer.portName(), MaxSlidingWindowSize);
+
+        REQUIRE(transport->open(noopStatus, noopData, noopLog) == NRF_SUCCESS);
+        REQUIRE(transport->slidingWindowSize() == MinSlidingWindowSize);
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        delete transport;
+    }
+
+    SECTION("A SYNC_CONFIG of the peer is answered with the negotiated window size")
+    {
+        constexpr uint8_t peerWindowSize = 2;
+        H5Peer peer(peerWindowSize, ackDelay, true);
+        const auto transport = createTransport(peer.portName(), MaxSlidingWindowSize);
+
+        REQUIRE(transport->open(noopStatus, noopData, noopLog) == NRF_SUCCESS);
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+        while (peer.syncConfigResponse() < 0 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        REQUIRE(peer.syncConfigResponse() == H5Transport::syncConfigField(peerWindowSize));
+        REQUIRE(transport->slidingWindowSize() == peerWindowSize);
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        delete transport;
+    }
+
+    SECTION("Commands sent with sendAsync are outstanding at the same time and complete in order")
+    {
+        constexpr uint8_t commandCount = 4;
+
+        // Long enough for all commands to be sent before the first is acknowledged
+        H5Peer peer(MaxSlidingWindowSize, std::chrono::milliseconds(200), false, true);
+        SerializationTransport transport(createTransport(peer.portName(), MaxSlidingWindowSize),
+                                         1000);
+
+        const auto noopEvent = [](ble_evt_t *) {};
+        REQUIRE(transport.open(noopStatus, noopEvent, noopLog) == NRF_SUCCESS);
+
+        std::mutex completionMutex;
+        std::vector<uint8_t> completedOpcodes;
+        std::vector<std::shared_ptr<std::vector<uint8_t>>> responses;
+
+        for (uint8_t opcode = 0x10; opcode < 0x10 + commandCount; opcode++)
+        {
+            const auto response = std::make_shared<std::vector<uint8_t>>(16);
+            responses.push_back(response);
+
+            REQUIRE(transport.sendAsync(
+                        std::vector<uint8_t>{opcode}, response,
+                        [&, opcode](const uint32_t errorCode) {
+                            std::lock_guard<std::mutex> completionGuard(completionMutex);
+                            completedOpcodes.push_back(errorCode == NRF_SUCCESS ? opcode : 0);
+                        }) == NRF_SUCCESS);
+        }
+
+        // All commands reach the peer before any of them is acknowledged or answered
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+        while (peer.received() < commandCount && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        REQUIRE(peer.received() == commandCount);
+
+        {
+            std::lock_guard<std::mutex> completionGuard(completionMutex);
+            REQUIRE(completedOpcodes.empty());
+        }
+
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+
+        for (;;)
+        {
+            {
+                std::lock_guard<std::mutex> completionGuard(completionMutex);
+
+                if (completedOpcodes.size() == commandCount ||
+                    std::chrono::steady_clock::now() >= deadline)
+                {
+                    break;
+                }
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        REQUIRE(transport.close() == NRF_SUCCESS);
+        REQUIRE(completedOpcodes == std::vector<uint8_t>{0x10, 0x11, 0x12, 0x13});
+
+        // Each response is matched to its command
+        for (uint8_t i = 0; i < commandCount; i++)
+        {
+            REQUIRE(!responses[i]->empty());
+            REQUIRE(responses[i]->front() == 0x10 + i);
+        }
+    }
+
+    SECTION("A sent callback may send the next packet when the window is empty")
+    {
+        H5Peer peer(MinSlidingWindowSize, ackDelay);
+        const auto transport = createTransport(peer.portName(), MinSlidingWindowSize);
+
+        REQUIRE(transport->open(noopStatus, noopData, noopLog) == NRF_SUCCESS);
+
+        const auto packet = [] {
+            const auto buffer = std::make_shared<TxBuffer>(20);
+            std::fill(buffer->payload(), buffer->payload() + 20, 0x55);
+            buffer->setPayloadLength(20);
+            return buffer;
+        };
+
+        constexpr uint32_t chainLength = 5;
+        std::atomic<uint32_t> sentCount(0);
+        std::atomic<uint32_t> failures(0);
+        std::function<void(const uint32_t)> sentCallback;
+
+        // Each acknowledgement empties the window, the callback sends the next packet from the
+        // thread receiving the acknowledgement
+        sentCallback = [&](const uint32_t errorCode) {
+            if (errorCode != NRF_SUCCESS)
+            {
+                failures++;
+                return;
+            }
+
+            if (++sentCount < chainLength &&
+                transport->sendAsync(packet(), sentCallback) != NRF_SUCCESS)
+            {
+                failures++;
+            }
+        };
+
+        REQUIRE(transport->sendAsync(packet(), sentCallback) == NRF_SUCCESS);
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+
+        while (sentCount < chainLength && failures == 0 &&
+               std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        REQUIRE(sentCount == chainLength);
+        REQUIRE(failures == 0);
+        REQUIRE(peer.received() == chainLength);
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        delete transport;
+    }
+
+    SECTION("Sliding window increases throughput")
+    {
+        std::chrono::milliseconds stopAndWait;
+        std::chrono::milliseconds sliding;
+
+        {
+            H5Peer peer(MaxSlidingWindowSize, ackDelay);
+            const auto transport = createTransport(peer.portName(), MinSlidingWindowSize);
+
+            REQUIRE(transport->open(noopStatus, noopData, noopLog) == NRF_SUCCESS);
+            REQUIRE(transport->slidingWindowSize() == MinSlidingWindowSize);
+            stopAndWait = sendPackets(*transport, packetCount, threadCount);
+            REQUIRE(peer.received() == packetCount);
+            REQUIRE(transport->close() == NRF_SUCCESS);
+
+            delete transport;
+        }
+
+        {
+            H5Peer peer(MaxSlidingWindowSize, ackDelay);
+            const auto transport = createTransport(peer.portName(), MaxSlidingWindowSize);
+
+            REQUIRE(transport->open(noopStatus, noopData, noopLog) == NRF_SUCCESS);
+            REQUIRE(transport->slidingWindowSize() == MaxSlidingWindowSize);
+            sliding = sendPackets(*transport, packetCount, threadCount);
+            REQUIRE(peer.received() == packetCount);
+            REQUIRE(transport->close() == NRF_SUCCESS);
+
+            delete transport;
+        }
+
+        INFO("Window size 1: " << stopAndWait.count() << "ms, window size "
+                               << static_cast<uint32_t>(MaxSlidingWindowSize) << ": "
+                               << sliding.count() << "ms");
+        REQUIRE(sliding * 3 < stopAndWait);
+    }
+
+    SECTION("Retransmission timeout follows the measured round trip time")
+    {
+        H5Peer peer(MinSlidingWindowSize, ackDelay);
+        const auto transport = createTransport(peer.portName(), MinSlidingWindowSize);
+
+        REQUIRE(transport->open(noopStatus, noopData, noopLog) == NRF_SUCCESS);
+        sendPackets(*transport, 20, 1);
+
+        sd_rpc_stats_t stats = {};
+        transport->getStats(stats);
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        INFO("RTT: " << stats.h5_rtt_smoothed_us << "us, RTO: " << stats.h5_rto_us << "us");
+        REQUIRE(stats.h5_rtt_smoothed_us >= 5000);
+        REQUIRE(stats.h5_rto_us < 250000);
+
+        delete transport;
+    }
+
+    SECTION("Link statistics count packets, bytes and acknowledgement round trips")
+    {
+        H5Peer peer(MinSlidingWindowSize, ackDelay);
+        const auto transport = createTransport(peer.portName(), MinSlidingWindowSize);
+
+        REQUIRE(transport->open(noopStatus, noopData, noopLog) == NRF_SUCCESS);
+        sendPackets(*transport, 20, 1);
+
+        sd_rpc_stats_t stats = {};
+        transport->getStats(stats);
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        // Link control packets are counted too
+        REQUIRE(stats.h5_tx_packets >= 20);
+        REQUIRE(stats.h5_rx_packets >= 20);
+        REQUIRE(stats.tx_bytes > stats.h5_tx_packets * 6);
+        REQUIRE(stats.rx_bytes > stats.h5_rx_packets * 6);
+        REQUIRE(stats.h5_retransmissions == 0);
+        REQUIRE(stats.h5_slip_errors + stats.h5_header_errors + stats.h5_crc_errors == 0);
+
+        REQUIRE(stats.h5_ack_rtt_min_us >= 5000);
+        REQUIRE(stats.h5_ack_rtt_min_us <= stats.h5_ack_rtt_avg_us);
+        REQUIRE(stats.h5_ack_rtt_avg_us <= stats.h5_ack_rtt_max_us);
+
+        delete transport;
+    }
+
+    SECTION("Packets are not logged below the log severity filter")
+    {
+        std::atomic<uint32_t> debugMessages(0);
+        const auto countingLog = [&](const sd_rpc_log_severity_t severity, const std::string &) {
+            if (severity == SD_RPC_LOG_DEBUG)
+            {
+                debugMessages++;
+            }
+        };
+
+        H5Peer peer(MinSlidingWindowSize, std::chrono::milliseconds(0));
+        const auto transport = createTransport(peer.portName(), MinSlidingWindowSize);
+
+        REQUIRE(transport->open(noopStatus, noopData, countingLog) == NRF_SUCCESS);
+
+        transport->setLogSeverityFilter(SD_RPC_LOG_INFO);
+        debugMessages = 0;
+        sendPackets(*transport, 10, 1);
+        REQUIRE(debugMessages == 0);
+
+        transport->setLogSeverityFilter(SD_RPC_LOG_DEBUG);
+        sendPackets(*transport, 10, 1);
+        REQUIRE(debugMessages >= 20);
+
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        delete transport;
+    }
+}
+
+TEST_CASE("H5PacketLogging", "[.benchmark]")
+{
+    const auto noopStatus = [](const sd_rpc_app_status_t, const std::string &) {};
+    const auto noopData   = [](const uint8_t *, const size_t) {};
+    const auto noopLog    = [](const sd_rpc_log_severity_t, const std::string &) {};
+
+    const auto benchmarkSend = [&](const char *name, const sd_rpc_log_severity_t filter) {
+        H5Peer peer(MinSlidingWindowSize, std::chrono::milliseconds(0));
+        const auto transport = createTransport(peer.portName(), MinSlidingWindowSize);
+
+        REQUIRE(transport->open(noopStatus, noopData, noopLog) == NRF_SUCCESS);
+        transport->setLogSeverityFilter(filter);
+
+        // Each packet sent is logged, and so is the acknowledgement received for it
+        const std::vector<uint8_t> packet(20, 0x55);
+
+        BENCHMARK(name)
+        {
+            return transport->send(packet);
+        };
+
+        REQUIRE(transport->close() == NRF_SUCCESS);
+
+        delete transport;
+    };
+
+    benchmarkSend("send, DEBUG logged", SD_RPC_LOG_DEBUG);
+    benchmarkSend("send, DEBUG filtered", SD_RPC_LOG_INFO);
+}
+
+#endif // defined(__unix__) || defined(__APPLE__)
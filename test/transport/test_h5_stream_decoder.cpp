@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <h5.h>
+#include <h5_stream_decoder.h>
+#include <nrf_error.h>
+#include <sd_rpc_types.h>
+#include <slip.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct DecodedPacket
+{
+    uint32_t errorCode;
+    uint8_t seqNum;
+    uint8_t ackNum;
+    bool reliable;
+    h5_pkt_type_t type;
+    std::vector<uint8_t> payload;
+
+    bool operator==(const DecodedPacket &other) const
+    {
+        if (errorCode != other.errorCode)
+        {
+            return false;
+        }
+
+        if (errorCode != NRF_SUCCESS)
+        {
+            return true;
+        }
+
+        return seqNum == other.seqNum && ackNum == other.ackNum && reliable == other.reliable &&
+               type == other.type && payload == other.payload;
+    }
+};
+
+std::ostream &operator<<(std::ostream &os, const DecodedPacket &packet)
+{
+    return os << "{err: 0x" << std::hex << packet.errorCode << " seq: " << +packet.seqNum
+              << " ack: " << +packet.ackNum << " length: " << std::dec << packet.payload.size()
+              << "}";
+}
+
+/**
+ * @brief Reference decoder, frames the stream the way H5Transport::dataHandler did before the
+ * stream decoder and decodes each frame with slip_decode and h5_decode.
+ */
+class ReferenceDecoder
+{
+  public:
+    std::vector<DecodedPacket> decode(const std::vector<uint8_t> &data)
+    {
+        std::vector<DecodedPacket> decoded;
+        std::vector<uint8_t> packet(unprocessedData);
+
+        for (const auto byte : data)
+        {
+            packet.push_back(byte);
+
+            if (byte == 0xC0)
+            {
+                if (c0Found)
+                {
+                    if (packet.size() == 2)
+                    {
+                        packet.clear();
+                        packet.push_back(0xC0);
+                        continue;
+                    }
+
+                    decoded.push_back(decodePacket(packet));
+                    packet.clear();
+                    unprocessedData.clear();
+                    c0Found = false;
+                }
+                else
+                {
+                    c0Found = true;
+                    packet.clear();
+                    packet.push_back(0xC0);
+                }
+            }
+        }
+
+        unprocessedData = packet;
+        return decoded;
+    }
+
+  private:
+    static DecodedPacket decodePacket(const std::vector<uint8_t> &packet)
+    {
+        DecodedPacket decoded = {};
+        std::vector<uint8_t> slipPayload;
+
+        decoded.errorCode = slip_decode(packet, slipPayload);
+
+        if (decoded.errorCode == NRF_SUCCESS)
+        {
+            decoded.errorCode =
+                h5_decode(slipPayload, decoded.payload, &decoded.seqNum, &decoded.ackNum, nullptr,
+                          nullptr, nullptr, &decoded.reliable, &decoded.type);
+        }
+
+        return decoded;
+    }
+
+    std::vector<uint8_t> unprocessedData;
+    bool c0Found = false;
+};
+
+/**
+ * @brief Stream of encoded H5 packets, some of them corrupted, with noise between packets.
+ */
+std::vector<uint8_t> randomStream(std::mt19937 &generator, const size_t packetCount)
+{
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<size_t> payloadLength(0, 300);
+    std::vector<uint8_t> stream;
+
+    const auto randomByte = [&] {
+        // Skew the distribution towards bytes with special meaning in SLIP
+        const auto value = percent(generator);
+        return value < 5 ? 0xC0
+                         : value < 10 ? 0xDB
+                                      : value < 12 ? 0xDC
+                                                   : static_cast<uint8_t>(generator());
+    };
+
+    for (size_t i = 0; i < packetCount; i++)
+    {
+        std::vector<uint8_t> payload(payloadLength(generator));
+        std::generate(payload.begin(), payload.end(), randomByte);
+
+        std::vector<uint8_t> h5Packet;
+        h5_encode(payload, h5Packet, generator() & 0x07, generator() & 0x07,
+                  percent(generator) < 80, percent(generator) < 50,
+                  percent(generator) < 80 ? VENDOR_SPECIFIC_PACKET : ACK_PACKET);
+
+        std::vector<uint8_t> slipPacket;
+        slip_encode(h5Packet, slipPacket);
+
+        const auto corruption = percent(generator);
+
+        if (corruption < 10)
+        {
+            // Flip a bit
+            std::uniform_int_distribution<size_t> position(0, slipPacket.size() - 1);
+            slipPacket[position(generator)] ^= 1 << (generator() & 0x07);
+        }
+        else if (corruption < 15)
+        {
+            // Drop a byte
+            std::uniform_int_distribution<size_t> position(0, slipPacket.size() - 1);
+            slipPacket.erase(slipPacket.begin() + position(generator));
+        }
+        else if (corruption < 20)
+        {
+            // Insert a random byte
+            std::uniform_int_distribution<size_t> position(0, slipPacket.size());
+            slipPacket.insert(slipPacket.begin() + position(generator), randomByte());
+        }
+
+        stream.insert(stream.end(), slipPacket.begin(), slipPacket.end());
+
+        if (percent(generator) < 10)
+        {
+            // Noise between packets
+            std::vector<uint8_t> noise(percent(generator) % 8);
+            std::generate(noise.begin(), noise.end(), randomByte);
+            stream.insert(stream.end(), noise.begin(), noise.end());
+        }
+    }
+
+    return stream;
+}
+
+/**
+ * @brief Split data into chunks of random size, as delivered by the UART.
+ */
+std::vector<std::vector<uint8_t>> randomChunks(std::mt19937 &generator,
+                                               const std::vector<uint8_t> &data,
+                                               const size_t maxChunkSize)
+{
+    std::uniform_int_distribution<size_t> chunkSize(1, maxChunkSize);
+    std::vector<std::vector<uint8_t>> chunks;
+
+    for (auto it = data.begin(); it != data.end();)
+    {
+        const auto size = std::min(chunkSize(generator), static_cast<size_t>(data.end() - it));
+        chunks.emplace_back(it, it + size);
+        it += size;
+    }
+
+    return chunks;
+}
+
+} // namespace
+
+TEST_CASE("H5StreamDecoder")
+{
+    std::vector<DecodedPacket> decoded;
+
+    H5StreamDecoder decoder([&decoded](const H5Frame &frame) {
+        DecodedPacket packet = {frame.errorCode, frame.seqNum, frame.ackNum, frame.reliable,
+                                frame.type, std::vector<uint8_t>()};
+
+        if (frame.errorCode == NRF_SUCCESS)
+        {
+            packet.payload.assign(frame.payload, frame.payload + frame.payloadLength);
+        }
+
+        decoded.push_back(packet);
+    });
+
+    SECTION("Produces the same packets as slip_decode and h5_decode for any chunking")
+    {
+        std::mt19937 generator(1);
+
+        for (auto iteration = 0; iteration < 200; iteration++)
+        {
+            const auto stream = randomStream(generator, 50);
+            const auto chunks = randomChunks(generator, stream, iteration % 2 ? 16 : 1100);
+
+            ReferenceDecoder reference;
+            std::vector<DecodedPacket> expected;
+
+            decoded.clear();
+            decoder.reset();
+
+            for (const auto &chunk : chunks)
+            {
+                const auto referencePackets = reference.decode(chunk);
+                expected.insert(expected.end(), referencePackets.begin(), referencePackets.end());
+                decoder.decode(chunk.data(), chunk.size());
+            }
+
+            REQUIRE(decoded == expected);
+        }
+    }
+
+    SECTION("Byte by byte and in one chunk gives the same packets")
+    {
+        std::mt19937 generator(2);
+        const auto stream = randomStream(generator, 100);
+
+        decoder.decode(stream.data(), stream.size());
+        const auto inOneChunk = decoded;
+
+        decoded.clear();
+        decoder.reset();
+
+        for (const auto byte : stream)
+        {
+            decoder.decode(&byte, 1);
+        }
+
+        REQUIRE(decoded == inOneChunk);
+    }
+
+    SECTION("Packets longer than the maximum H5 packet length are rejected")
+    {
+        std::vector<uint8_t> packet(H5_MAX_PACKET_LENGTH * 2, 0x55);
+        packet.front() = 0xC0;
+        packet.back()  = 0xC0;
+
+        decoder.decode(packet.data(), packet.size());
+
+        REQUIRE(decoded.size() == 1);
+        REQUIRE(decoded[0].errorCode == NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_CALCULATED_PAYLOAD_SIZE);
+    }
+}
+
+TEST_CASE("H5StreamDecoderPerformance", "[.benchmark]")
+{
+    std::mt19937 generator(3);
+
+    // Advertising report sized packets without corruption, read in UART sized chunks
+    std::vector<uint8_t> stream;
+
+    for (auto i = 0; i < 1000; i++)
+    {
+        std::vector<uint8_t> payload(48);
+        std::generate(payload.begin(), payload.end(), [&] { return generator(); });
+
+        std::vector<uint8_t> h5Packet;
+        std::vector<uint8_t> slipPacket;
+        h5_encode(payload, h5Packet, i & 0x07, 0, true, true, VENDOR_SPECIFIC_PACKET);
+        slip_encode(h5Packet, slipPacket);
+        stream.insert(stream.end(), slipPacket.begin(), slipPacket.end());
+    }
+
+    const auto chunks = randomChunks(generator, stream, 64);
+    size_t payloadBytes = 0;
+
+    H5StreamDecoder decoder([&payloadBytes](const H5Frame &frame) {
+        payloadBytes += frame.payloadLength;
+    });
+
+    BENCHMARK("slip_decode and h5_decode")
+    {
+        ReferenceDecoder reference;
+        size_t count = 0;
+
+        for (const auto &chunk : chunks)
+        {
+            count += reference.decode(chunk).size();
+        }
+
+        return count;
+    };
+
+    BENCHMARK("H5StreamDecoder")
+    {
+        for (const auto &chunk : chunks)
+        {
+            decoder.decode(chunk.data(), chunk.size());
+        }
+
+        return payloadBytes;
+    };
+}
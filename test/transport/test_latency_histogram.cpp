@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <latency_histogram.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using std::chrono::microseconds;
+
+TEST_CASE("LatencyHistogram")
+{
+    LatencyHistogram histogram;
+
+    SECTION("Is empty when created")
+    {
+        REQUIRE(histogram.count() == 0);
+        REQUIRE(histogram.min() == microseconds::zero());
+        REQUIRE(histogram.max() == microseconds::zero());
+        REQUIRE(histogram.percentile(50) == microseconds::zero());
+    }
+
+    SECTION("Buckets cover all values and are at most 12.5% wide")
+    {
+        for (uint64_t value = 1; value < (uint64_t(1) << LatencyHistogramMagnitudes); value *= 3)
+        {
+            const auto index = LatencyHistogram::bucketIndex(value);
+
+            REQUIRE(index < LatencyHistogramBucketCount);
+            REQUIRE(LatencyHistogram::bucketUpperBound(index) >= value);
+            REQUIRE(LatencyHistogram::bucketUpperBound(index) <= value + value / 8);
+
+            if (index > 0)
+            {
+                REQUIRE(LatencyHistogram::bucketUpperBound(index - 1) < value);
+            }
+        }
+
+        REQUIRE(LatencyHistogram::bucketIndex(uint64_t(1) << 50) ==
+                LatencyHistogramBucketCount - 1);
+    }
+
+    SECTION("Percentiles are within the resolution of the buckets")
+    {
+        for (auto value = 1; value <= 1000; value++)
+        {
+            histogram.record(microseconds(value));
+        }
+
+        REQUIRE(histogram.count() == 1000);
+        REQUIRE(histogram.min() == microseconds(1));
+        REQUIRE(histogram.max() == microseconds(1000));
+        REQUIRE(histogram.mean() == std::chrono::nanoseconds(500500));
+
+        REQUIRE(histogram.percentile(50) >= microseconds(500));
+        REQUIRE(histogram.percentile(50) <= microseconds(500 + 500 / 8));
+        REQUIRE(histogram.percentile(99) >= microseconds(990));
+        REQUIRE(histogram.percentile(99) <= microseconds(1000));
+        REQUIRE(histogram.percentile(100) == microseconds(1000));
+    }
+
+    SECTION("Samples of several threads are all counted")
+    {
+        const auto threadCount  = 4;
+        const auto samplesCount = 100000;
+        std::vector<std::thread> threads;
+
+        for (auto thread = 0; thread < threadCount; thread++)
+        {
+            threads.emplace_back([&histogram, thread] {
+                for (auto i = 0; i < samplesCount; i++)
+                {
+                    histogram.record(microseconds(thread * 100 + i % 100));
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        REQUIRE(histogram.count() == threadCount * samplesCount);
+        REQUIRE(histogram.min() == microseconds(0));
+        REQUIRE(histogram.max() == microseconds(399));
+    }
+
+    SECTION("Reset forgets all samples")
+    {
+        histogram.record(microseconds(250));
+        histogram.reset();
+
+        REQUIRE(histogram.count() == 0);
+        REQUIRE(histogram.max() == microseconds::zero());
+        REQUIRE(histogram.percentile(99) == microseconds::zero());
+    }
+}
@@ -0,0 +1,535 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <log_ring.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <h5_peer.h>
+
+#include <adapter.h>
+#include <ble.h>
+#include <sd_rpc.h>
+#endif
+
+namespace {
+/**
+ * @brief Sink keeping the drained messages.
+ */
+class CollectingSink
+{
+  public:
+    log_ring_sink_t sink()
+    {
+        return [this](const LogRecord &record, const std::string &message) {
+            std::lock_guard<std::mutex> lck(mutex);
+            threads.push_back(record.thread);
+            messages.push_back(message);
+        };
+    }
+
+    std::vector<std::string> takeMessages()
+    {
+        std::lock_guard<std::mutex> lck(mutex);
+        return std::move(messages);
+    }
+
+    std::mutex mutex;
+    std::vector<uint32_t> threads;
+    std::vector<std::string> messages;
+};
+
+// Take the records in the ring and format them
+std::vector<std::string> popMessages(LogRing &ring)
+{
+    std::vector<std::string> messages;
+    LogRecord record;
+    std::string blob;
+
+    while (ring.pop(record, blob))
+    {
+        messages.push_back(LogRing::format(record, blob));
+    }
+
+    return messages;
+}
+} // namespace
+
+TEST_CASE("LogRing")
+{
+    SECTION("Records are formatted from their format and arguments")
+    {
+        LogRing ring(16);
+
+        const uint8_t bytes[] = {0xc0, 0x01, 0x7e};
+        const std::string text(100, 't');
+
+        REQUIRE(ring.push(1, SD_RPC_LOG_INFO,
+                          LOG_FORMAT_ID("signed {} unsigned {} hex 0x{x} string {}"), -5, 7u,
+                          0xbeefu, "literal"));
+        REQUIRE(ring.push(1, SD_RPC_LOG_INFO, LOG_FORMAT_ID("double {} bytes [{}]"), 0.5,
+                          LogBytes{bytes, sizeof(bytes)}));
+        REQUIRE(ring.pushText(1, SD_RPC_LOG_WARNING, text));
+        REQUIRE(ring.pushText(1, SD_RPC_LOG_WARNING, ""));
+
+        const std::vector<std::string> expected = {"signed -5 unsigned 7 hex 0xbeef string literal",
+                                                   "double 0.5 bytes [c0 01 7e ]", text, ""};
+        REQUIRE(popMessages(ring) == expected);
+
+        // Formatted the same without the ring
+        REQUIRE(LogRing::format(LOG_FORMAT_ID("{} of {}"), 1, 2) == "1 of 2");
+    }
+
+    SECTION("Records keep their time, thread and channel")
+    {
+        LogRing ring(16);
+
+        REQUIRE(ring.pushText(1, SD_RPC_LOG_INFO, "first"));
+        std::thread([&ring] { REQUIRE(ring.pushText(2, SD_RPC_LOG_DEBUG, "other thread")); })
+            .join();
+        REQUIRE(ring.pushText(1, SD_RPC_LOG_INFO, "second"));
+
+        LogRecord records[3];
+        std::string blob;
+
+        for (auto &record : records)
+        {
+            REQUIRE(ring.pop(record, blob));
+        }
+
+        REQUIRE(records[0].channel == 1);
+        REQUIRE(records[1].channel == 2);
+        REQUIRE(records[1].severity == SD_RPC_LOG_DEBUG);
+        REQUIRE(records[0].thread == records[2].thread);
+        REQUIRE(records[0].thread != records[1].thread);
+        REQUIRE(records[0].timestamp <= records[2].timestamp);
+    }
+
+    SECTION("Text longer than a slot is kept in the following slots, up to half the ring")
+    {
+        LogRing ring(16);
+
+        const std::string text(300, 'x');
+        const std::string tooLong(3000, 'y');
+
+        REQUIRE(ring.pushText(1, SD_RPC_LOG_INFO, text));
+        REQUIRE(ring.pushText(1, SD_RPC_LOG_INFO, tooLong));
+
+        const auto messages = popMessages(ring);
+        REQUIRE(messages.size() == 2);
+        REQUIRE(messages[0] == text);
+        REQUIRE(messages[1] == std::string(8 * sizeof(LogRecord), 'y') + "...");
+    }
+
+    SECTION("Records are dropped, not waited for, when the ring is full")
+    {
+        LogRing ring(8);
+
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            REQUIRE(ring.push(1, SD_RPC_LOG_DEBUG, LOG_FORMAT_ID("record {}"), i));
+        }
+
+        // Two slots are left, the text needs three
+        REQUIRE_FALSE(ring.pushText(1, SD_RPC_LOG_DEBUG, std::string(2 * sizeof(LogRecord), 'z')));
+        REQUIRE(ring.push(1, SD_RPC_LOG_DEBUG, LOG_FORMAT_ID("record {}"), 6u));
+        REQUIRE(ring.push(1, SD_RPC_LOG_DEBUG, LOG_FORMAT_ID("record {}"), 7u));
+        REQUIRE_FALSE(ring.push(1, SD_RPC_LOG_DEBUG, LOG_FORMAT_ID("record {}"), 8u));
+        REQUIRE(ring.dropped() == 2);
+
+        const auto messages = popMessages(ring);
+        REQUIRE(messages.size() == 8);
+        REQUIRE(messages.front() == "record 0");
+        REQUIRE(messages.back() == "record 7");
+
+        REQUIRE(ring.pushText(1, SD_RPC_LOG_DEBUG, std::string(2 * sizeof(LogRecord), 'z')));
+    }
+
+    SECTION("Records are passed to the sink of their channel")
+    {
+        LogRing ring(16);
+        CollectingSink first;
+        CollectingSink second;
+        uint32_t firstChannel  = 0;
+        uint32_t secondChannel = 0;
+
+        REQUIRE(ring.addSink(first.sink(), firstChannel) == NRF_SUCCESS);
+        REQUIRE(ring.addSink(second.sink(), secondChannel) == NRF_SUCCESS);
+        REQUIRE(firstChannel != secondChannel);
+
+        REQUIRE(ring.pushText(firstChannel, SD_RPC_LOG_INFO, "first 1"));
+        REQUIRE(ring.pushText(secondChannel, SD_RPC_LOG_INFO, "second 1"));
+        REQUIRE(ring.pushText(secondChannel + 1, SD_RPC_LOG_INFO, "no sink"));
+        REQUIRE(ring.pushText(firstChannel, SD_RPC_LOG_INFO, "first 2"));
+
+        // Removing a sink passes the records logged before to all sinks
+        ring.removeSink(firstChannel);
+        REQUIRE(first.takeMessages() == std::vector<std::string>{"first 1", "first 2"});
+        REQUIRE(second.takeMessages() == std::vector<std::string>{"second 1"});
+
+        REQUIRE(ring.pushText(firstChannel, SD_RPC_LOG_INFO, "removed"));
+        REQUIRE(ring.pushText(secondChannel, SD_RPC_LOG_INFO, "second 2"));
+        ring.flush();
+        REQUIRE(second.takeMessages() == std::vector<std::string>{"second 2"});
+
+        ring.removeSink(secondChannel);
+        REQUIRE(first.takeMessages().empty());
+    }
+
+    SECTION("Dropped records are reported to the sinks")
+    {
+        LogRing ring(8);
+        CollectingSink collector;
+
+        for (uint32_t i = 0; i < 10; i++)
+        {
+            ring.push(1, SD_RPC_LOG_DEBUG, LOG_FORMAT_ID("record {}"), i);
+        }
+
+        uint32_t channel = 0;
+        REQUIRE(ring.addSink(collector.sink(), channel) == NRF_SUCCESS);
+        REQUIRE(channel == 1);
+        ring.removeSink(channel);
+
+        const auto messages = collector.takeMessages();
+        REQUIRE(messages.size() == 9);
+        REQUIRE(messages.front() == "record 0");
+        REQUIRE(messages[7] == "record 7");
+        REQUIRE(messages.back() == "2 log records dropped");
+    }
+
+    SECTION("Records of each thread are drained in order")
+    {
+        constexpr uint32_t threadCount  = 4;
+        constexpr uint32_t recordsCount = 20000;
+
+        LogRing ring(1024);
+        std::vector<uint32_t> lastRecord(threadCount, 0);
+        std::vector<uint32_t> threadOfRecords(threadCount, 0);
+        auto outOfOrder  = 0;
+        uint32_t channel = 0;
+
+        REQUIRE(ring.addSink(
+                    [&](const LogRecord &record, const std::string &message) {
+                        uint32_t producer;
+                        uint32_t index;
+
+                        // Skip reports of dropped records
+                        if (std::sscanf(message.c_str(), "producer %u record %u", &producer,
+                                        &index) != 2)
+                        {
+                            return;
+                        }
+
+                        if (lastRecord[producer] == 0)
+                        {
+                            threadOfRecords[producer] = record.thread;
+                        }
+
+                        if (index != lastRecord[producer] + 1 ||
+                            record.thread != threadOfRecords[producer])
+                        {
+                            outOfOrder++;
+                        }
+
+                        lastRecord[producer] = index;
+                    },
+                    channel) == NRF_SUCCESS);
+
+        std::vector<std::thread> producers;
+        std::atomic<uint64_t> dropped(0);
+
+        for (uint32_t producer = 0; producer < threadCount; producer++)
+        {
+            producers.emplace_back([&, producer] {
+                // Records with a text argument take one to three slots
+                const std::string padding(producer * 50, '.');
+
+                for (uint32_t i = 1; i <= recordsCount; i++)
+                {
+                    // Log the record again until there is room for it
+                    while (!ring.push(channel, SD_RPC_LOG_TRACE,
+                                      LOG_FORMAT_ID("producer {} record {} {}"), producer, i,
+                                      LogText{padding.data(), padding.size()}))
+                    {
+                        dropped++;
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        for (auto &producer : producers)
+        {
+            producer.join();
+        }
+
+        ring.removeSink(channel);
+
+        REQUIRE(outOfOrder == 0);
+        REQUIRE(ring.dropped() == dropped);
+        REQUIRE(lastRecord == std::vector<uint32_t>(threadCount, recordsCount));
+    }
+
+    SECTION("Formats are registered once for each call site")
+    {
+        std::vector<uint16_t> ids;
+
+        for (auto i = 0; i < 2; i++)
+        {
+            ids.push_back(LOG_FORMAT_ID("call site {}"));
+        }
+
+        REQUIRE(ids[0] == ids[1]);
+        REQUIRE(ids[0] != LogFormatText);
+        REQUIRE(LOG_FORMAT_ID("call site {}") != ids[0]);
+    }
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+namespace {
+std::mutex logHandlerMutex;
+std::vector<std::thread::id> logHandlerThreads;
+std::map<void *, std::vector<std::string>> loggedMessages;
+std::atomic<uint64_t> loggedMessageCount(0);
+
+void collectingLog(adapter_t *adapter, sd_rpc_log_severity_t, const char *message)
+{
+    std::lock_guard<std::mutex> lck(logHandlerMutex);
+    logHandlerThreads.push_back(std::this_thread::get_id());
+    loggedMessages[adapter->internal].push_back(message);
+}
+
+void countingLog(adapter_t *, sd_rpc_log_severity_t, const char *)
+{
+    loggedMessageCount++;
+}
+
+uint32_t writeCommand(adapter_t *adapter)
+{
+    uint8_t value[20]      = {};
+    const auto writeParams = gattcWriteParams(value);
+    return sd_ble_gattc_write(adapter, 0, &writeParams);
+}
+
+/**
+ * @brief Adapters communicating with H5 peers that answer each command, debug messages are
+ * logged so the driver threads of each adapter log every packet.
+ */
+class LoggingAdapters
+{
+  public:
+    LoggingAdapters(const size_t count, const sd_rpc_log_handler_t logHandler,
+                    const sd_rpc_log_dispatch_t dispatch)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            peers.emplace_back(
+                new H5Peer(MaxSlidingWindowSize, std::chrono::milliseconds(0), false, true));
+            adapters.push_back(createAdapter(peers.back()->portName()));
+            REQUIRE(sd_rpc_log_handler_severity_filter_set(adapters.back(), SD_RPC_LOG_DEBUG) ==
+                    NRF_SUCCESS);
+            REQUIRE(sd_rpc_log_handler_dispatch_set(adapters.back(), dispatch) == NRF_SUCCESS);
+            REQUIRE(sd_rpc_open(adapters.back(), noopAdapterStatus, noopAdapterEvent, logHandler) ==
+                    NRF_SUCCESS);
+        }
+    }
+
+    ~LoggingAdapters()
+    {
+        for (const auto adapter : adapters)
+        {
+            sd_rpc_close(adapter);
+            sd_rpc_adapter_delete(adapter);
+        }
+    }
+
+    std::vector<std::unique_ptr<H5Peer>> peers;
+    std::vector<adapter_t *> adapters;
+};
+} // namespace
+
+TEST_CASE("LogRingAdapters")
+{
+    SECTION("Messages are passed to the log handler on the logging threads by default")
+    {
+        {
+            LoggingAdapters adapters(1, collectingLog, SD_RPC_LOG_DISPATCH_SYNC);
+            const auto adapter = adapters.adapters.front();
+
+            REQUIRE(writeCommand(adapter) == NRF_SUCCESS);
+            REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+
+            std::lock_guard<std::mutex> lck(logHandlerMutex);
+            REQUIRE(!loggedMessages[adapter->internal].empty());
+
+            // The driver threads and the thread sending the command log packets
+            std::vector<std::thread::id> threads(logHandlerThreads);
+            std::sort(threads.begin(), threads.end());
+            REQUIRE(std::unique(threads.begin(), threads.end()) - threads.begin() > 1);
+        }
+
+        loggedMessages.clear();
+        logHandlerThreads.clear();
+    }
+
+    SECTION("Messages of each adapter are passed to its log handler before it is closed")
+    {
+        {
+            LoggingAdapters adapters(2, collectingLog, SD_RPC_LOG_DISPATCH_ASYNC);
+
+            REQUIRE(sd_rpc_log_handler_dispatch_set(adapters.adapters.front(),
+                                                    SD_RPC_LOG_DISPATCH_SYNC) ==
+                    NRF_ERROR_INVALID_STATE);
+
+            for (const auto adapter : adapters.adapters)
+            {
+                REQUIRE(writeCommand(adapter) == NRF_SUCCESS);
+                REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+            }
+
+            std::lock_guard<std::mutex> lck(logHandlerMutex);
+
+            for (const auto adapter : adapters.adapters)
+            {
+                const auto &messages = loggedMessages[adapter->internal];
+                const auto packet    = [&messages](const std::string &direction) {
+                    return std::any_of(messages.begin(), messages.end(),
+                                       [&direction](const std::string &message) {
+                                           return message.find(direction) != std::string::npos &&
+                                                  message.find("VENDOR_SPECIFIC") !=
+                                                      std::string::npos;
+                                       });
+                };
+
+                // The command and its response
+                REQUIRE(packet(" -> "));
+                REQUIRE(packet(" <- "));
+            }
+
+            // The messages are passed by the drain thread of the log ring
+            REQUIRE(!logHandlerThreads.empty());
+            REQUIRE(std::all_of(logHandlerThreads.begin(), logHandlerThreads.end(),
+                                [](const std::thread::id &thread) {
+                                    return thread == logHandlerThreads.front() &&
+                                           thread != std::this_thread::get_id();
+                                }));
+        }
+
+        loggedMessages.clear();
+        logHandlerThreads.clear();
+    }
+}
+
+TEST_CASE("LogRingContention", "[.benchmark]")
+{
+    for (const auto adapterCount : {0u, 1u, 4u, 8u})
+    {
+        LoggingAdapters adapters(adapterCount, countingLog, SD_RPC_LOG_DISPATCH_ASYNC);
+
+        // Commands keep the I/O, state machine and command threads of each adapter logging
+        // packets while the benchmark logs on the same ring
+        std::atomic<bool> stop(false);
+        std::vector<std::thread> commandThreads;
+
+        for (const auto adapter : adapters.adapters)
+        {
+            commandThreads.emplace_back([&stop, adapter] {
+                while (!stop)
+                {
+                    writeCommand(adapter);
+                }
+            });
+        }
+
+        const uint8_t packet[24] = {};
+        uint32_t count           = 0;
+        uint32_t channel         = 0;
+        REQUIRE(LogRing::global().addSink([](const LogRecord &, const std::string &) {}, channel) ==
+                NRF_SUCCESS);
+
+        const auto droppedBefore = LogRing::global().dropped();
+        loggedMessageCount       = 0;
+
+        BENCHMARK_ADVANCED(std::to_string(adapterCount) + " adapters logging packets")
+        (Catch::Benchmark::Chronometer meter)
+        {
+            // Each sample starts with the records of the benchmark drained
+            LogRing::global().flush();
+
+            meter.measure([&] {
+                count++;
+                return LogRing::global().push(channel, SD_RPC_LOG_DEBUG,
+                                              LOG_FORMAT_ID("packet {} [{}]"), count,
+                                              LogBytes{packet, sizeof(packet)});
+            });
+        };
+
+        stop = true;
+
+        for (auto &commandThread : commandThreads)
+        {
+            commandThread.join();
+        }
+
+        LogRing::global().removeSink(channel);
+
+        WARN(loggedMessageCount << " adapter messages logged, "
+                                << LogRing::global().dropped() - droppedBefore
+                                << " records dropped");
+    }
+}
+#endif // defined(__unix__) || defined(__APPLE__)
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <adapter_internal.h>
+#include <metrics_exporter.h>
+#include <nrf_error.h>
+
+#include <adapter.h>
+#include <sd_rpc.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+// Adapters on serial ports that are never opened, all statistics are zero
+adapter_t *createAdapter(const char *portName)
+{
+    const auto physicalLayer =
+        sd_rpc_physical_layer_create_uart(portName, 1000000, SD_RPC_FLOW_CONTROL_NONE,
+                                          SD_RPC_PARITY_NONE);
+    const auto dataLinkLayer = sd_rpc_data_link_layer_create_bt_three_wire(physicalLayer, 250);
+    const auto transportLayer = sd_rpc_transport_layer_create(dataLinkLayer, 1500);
+    return sd_rpc_adapter_create(transportLayer);
+}
+
+std::string adapterLabels(adapter_t *adapter, const std::string &portName)
+{
+    const auto id = static_cast<AdapterInternal *>(adapter->internal)->id;
+    return "adapter=\"" + std::to_string(id) + "\",port=\"" + portName + "\"";
+}
+
+bool contains(const std::string &text, const std::string &line)
+{
+    return text.find(line + "\n") != std::string::npos;
+}
+
+std::string readFile(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+} // namespace
+
+TEST_CASE("metrics_exporter")
+{
+    const auto first  = createAdapter("/dev/ttyFAKE0");
+    const auto second = createAdapter("COM\"7\"");
+
+    const auto firstLabels  = adapterLabels(first, "/dev/ttyFAKE0");
+    const auto secondLabels = adapterLabels(second, "COM\\\"7\\\"");
+
+    std::vector<adapter_t *> adapters = {first, second};
+
+    SECTION("render")
+    {
+        const auto text = MetricsExporter::render(adapters);
+
+        REQUIRE(contains(text, "# TYPE pc_ble_driver_h5_retransmissions counter"));
+        REQUIRE(contains(text, "pc_ble_driver_h5_retransmissions_total{" + firstLabels + "} 0"));
+        REQUIRE(contains(text, "pc_ble_driver_h5_retransmissions_total{" + secondLabels + "} 0"));
+        REQUIRE(contains(text, "pc_ble_driver_uart_bytes_total{" + firstLabels +
+                                   ",direction=\"tx\"} 0"));
+        REQUIRE(contains(text, "pc_ble_driver_h5_errors_total{" + secondLabels +
+                                   ",type=\"crc\"} 0"));
+        REQUIRE(contains(text, "# TYPE pc_ble_driver_command_latency_seconds summary"));
+        REQUIRE(contains(text, "pc_ble_driver_command_latency_seconds_count{" + firstLabels +
+                                   "} 0"));
+
+        // No phase samples before a command is sent
+        REQUIRE(text.find("opcode=") == std::string::npos);
+
+        // Samples of a family are not interleaved with other families
+        const auto firstSample  = text.find("pc_ble_driver_h5_resyncs_total{" + firstLabels);
+        const auto secondSample = text.find("pc_ble_driver_h5_resyncs_total{" + secondLabels);
+        const auto nextFamily   = text.find("# TYPE", firstSample);
+        REQUIRE(firstSample < secondSample);
+        REQUIRE(secondSample < nextFamily);
+
+        REQUIRE(text.size() > 6);
+        REQUIRE(text.compare(text.size() - 6, 6, "# EOF\n") == 0);
+    }
+
+    SECTION("sd_rpc_metrics_write")
+    {
+        uint32_t length = 0;
+        char empty[1];
+
+        REQUIRE(sd_rpc_metrics_write(adapters.data(), 2, empty, &length) == NRF_ERROR_DATA_SIZE);
+        REQUIRE(length == MetricsExporter::render(adapters).size() + 1);
+
+        std::vector<char> buffer(length);
+        REQUIRE(sd_rpc_metrics_write(adapters.data(), 2, buffer.data(), &length) == NRF_SUCCESS);
+        REQUIRE(length == buffer.size());
+        REQUIRE(std::string(buffer.data()) == MetricsExporter::render(adapters));
+
+        adapter_t *invalid[] = {first, nullptr};
+        REQUIRE(sd_rpc_metrics_write(invalid, 2, buffer.data(), &length) ==
+                NRF_ERROR_INVALID_PARAM);
+    }
+
+    SECTION("sd_rpc_metrics_file_start")
+    {
+        const std::string path = "test_metrics_exporter.prom";
+        std::remove(path.c_str());
+
+        REQUIRE(sd_rpc_metrics_file_stop() == NRF_ERROR_INVALID_STATE);
+        REQUIRE(sd_rpc_metrics_file_start(adapters.data(), 2, path.c_str(), 100) == NRF_SUCCESS);
+        REQUIRE(sd_rpc_metrics_file_start(adapters.data(), 2, path.c_str(), 100) ==
+                NRF_ERROR_INVALID_STATE);
+
+        // Written at once
+        REQUIRE(readFile(path) == MetricsExporter::render(adapters));
+
+        // And replaced periodically
+        std::remove(path.c_str());
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        REQUIRE(readFile(path) == MetricsExporter::render(adapters));
+
+        REQUIRE(sd_rpc_metrics_file_stop() == NRF_SUCCESS);
+        std::remove(path.c_str());
+
+        REQUIRE(sd_rpc_metrics_file_start(adapters.data(), 2, "no/such/directory/metrics.prom",
+                                          100) == NRF_ERROR_INVALID_PARAM);
+        REQUIRE(sd_rpc_metrics_file_stop() == NRF_ERROR_INVALID_STATE);
+    }
+
+    sd_rpc_adapter_delete(first);
+    sd_rpc_adapter_delete(second);
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <rtt_estimator.h>
+
+#include <chrono>
+
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+TEST_CASE("RttEstimator")
+{
+    RttEstimator estimator(milliseconds(250), milliseconds(20), milliseconds(1000));
+
+    SECTION("Starts at the initial timeout")
+    {
+        REQUIRE_FALSE(estimator.hasSample());
+        REQUIRE(estimator.timeout() == milliseconds(250));
+        REQUIRE(estimator.smoothedRtt() == microseconds::zero());
+    }
+
+    SECTION("First sample sets the smoothed round trip time and half of it as variation")
+    {
+        estimator.addSample(milliseconds(40));
+
+        REQUIRE(estimator.hasSample());
+        REQUIRE(estimator.smoothedRtt() == milliseconds(40));
+        REQUIRE(estimator.rttVariation() == milliseconds(20));
+        REQUIRE(estimator.timeout() == milliseconds(40 + 4 * 20));
+    }
+
+    SECTION("Later samples are smoothed")
+    {
+        estimator.addSample(milliseconds(40));
+        estimator.addSample(milliseconds(80));
+
+        // RTTVAR = 3/4 * 20 + 1/4 * |40 - 80|, SRTT = 7/8 * 40 + 1/8 * 80
+        REQUIRE(estimator.rttVariation() == milliseconds(25));
+        REQUIRE(estimator.smoothedRtt() == milliseconds(45));
+        REQUIRE(estimator.timeout() == milliseconds(45 + 4 * 25));
+    }
+
+    SECTION("Timeout follows a stable link down to the minimum")
+    {
+        for (auto i = 0; i < 100; i++)
+        {
+            estimator.addSample(milliseconds(2));
+        }
+
+        REQUIRE(estimator.smoothedRtt() == milliseconds(2));
+        REQUIRE(estimator.timeout() == milliseconds(20));
+    }
+
+    SECTION("Timeout follows a slow link up to the maximum")
+    {
+        for (auto i = 0; i < 100; i++)
+        {
+            estimator.addSample(milliseconds(600));
+            estimator.addSample(milliseconds(900));
+        }
+
+        REQUIRE(estimator.timeout() == milliseconds(1000));
+    }
+
+    SECTION("Back off doubles the timeout until the maximum")
+    {
+        estimator.backOff();
+        REQUIRE(estimator.timeout() == milliseconds(500));
+        estimator.backOff();
+        REQUIRE(estimator.timeout() == milliseconds(1000));
+        estimator.backOff();
+        REQUIRE(estimator.timeout() == milliseconds(1000));
+
+        // A new sample replaces the backed off timeout
+        estimator.addSample(milliseconds(10));
+        REQUIRE(estimator.timeout() == milliseconds(10 + 4 * 5));
+    }
+
+    SECTION("Reset returns to the initial timeout")
+    {
+        estimator.addSample(milliseconds(10));
+        estimator.reset();
+
+        REQUIRE_FALSE(estimator.hasSample());
+        REQUIRE(estimator.timeout() == milliseconds(250));
+    }
+
+    SECTION("Initial timeout is clamped")
+    {
+        REQUIRE(RttEstimator(milliseconds(5), milliseconds(20), milliseconds(1000)).timeout() ==
+                milliseconds(20));
+        REQUIRE(RttEstimator(milliseconds(5000), milliseconds(20), milliseconds(1000)).timeout() ==
+                milliseconds(1000));
+    }
+}
@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <allocation_counter.h>
+#include <h5.h>
+#include <h5_transport.h>
+#include <nrf_error.h>
+#include <serialization_transport.h>
+#include <slip.h>
+#include <uart_transport.h>
+
+#include <ble.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Serial port stand-in, the test passes received data to the H5 transport on its own
+ * thread in reads of the size it chooses.
+ *
+ * Packets sent before the link is established are kept for the test to answer, later packets
+ * are only counted.
+ */
+class ScriptedUart : public UartTransport
+{
+  public:
+    ScriptedUart()
+        : UartTransport(parameters())
+        , keepSentPackets(true)
+        , sentPacketCount(0)
+    {}
+
+    uint32_t open(const status_cb_t &, const data_cb_t &data_callback,
+                  const log_cb_t &) noexcept override
+    {
+        dataCallback = data_callback;
+        return NRF_SUCCESS;
+    }
+
+    uint32_t close() noexcept override
+    {
+        return NRF_SUCCESS;
+    }
+
+    uint32_t send(const std::vector<uint8_t> &data) noexcept override
+    {
+        sentPacketCount++;
+
+        if (keepSentPackets)
+        {
+            std::lock_guard<std::mutex> lck(sentMutex);
+            sentPackets.push_back(data);
+            packetSent.notify_all();
+        }
+
+        return NRF_SUCCESS;
+    }
+
+    /**
+     * @brief Passes data to the H5 transport in reads of up to readSize bytes.
+     */
+    void receive(const std::vector<uint8_t> &data, const size_t readSize)
+    {
+        for (size_t offset = 0; offset < data.size(); offset += readSize)
+        {
+            dataCallback(data.data() + offset, std::min(readSize, data.size() - offset));
+        }
+    }
+
+    /**
+     * @brief Takes the oldest packet sent, returns false if none is sent within timeout.
+     */
+    bool takeSentPacket(std::vector<uint8_t> &packet, const std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lck(sentMutex);
+
+        if (!packetSent.wait_for(lck, timeout, [this] { return !sentPackets.empty(); }))
+        {
+            return false;
+        }
+
+        packet = std::move(sentPackets.front());
+        sentPackets.pop_front();
+        return true;
+    }
+
+    std::atomic<bool> keepSentPackets;
+    std::atomic<uint32_t> sentPacketCount;
+
+  private:
+    static UartCommunicationParameters parameters()
+    {
+        return {"scripted", 1000000, UartFlowControlNone, UartParityNone, UartStopBitsOne,
+                UartDataBitsEight};
+    }
+
+    data_cb_t dataCallback;
+    std::mutex sentMutex;
+    std::condition_variable packetSent;
+    std::deque<std::vector<uint8_t>> sentPackets;
+};
+
+std::vector<uint8_t> encodePacket(const std::vector<uint8_t> &payload, const uint8_t seqNum,
+                                  const uint8_t ackNum, const bool reliable,
+                                  const h5_pkt_type_t type)
+{
+    std::vector<uint8_t> h5Packet;
+    std::vector<uint8_t> slipPacket;
+
+    h5_encode(payload, h5Packet, seqNum, ackNum, false, reliable, type);
+    slip_encode(h5Packet, slipPacket);
+    return slipPacket;
+}
+
+/**
+ * @brief Reliable packet carrying a BLE_GAP_EVT_KEY_PRESSED event, value is passed in kp_not.
+ */
+std::vector<uint8_t> encodeEvent(const uint8_t seqNum, const uint8_t value)
+{
+    return encodePacket({SERIALIZATION_EVENT, BLE_GAP_EVT_KEY_PRESSED & 0xFF,
+                         BLE_GAP_EVT_KEY_PRESSED >> 8, 0x00, 0x00, value},
+                        seqNum, 0, true, VENDOR_SPECIFIC_PACKET);
+}
+
+/**
+ * @brief Opens transport, answering the link establishment packets sent to uart.
+ */
+uint32_t openLink(SerializationTransport &transport, ScriptedUart &uart,
+                  const evt_cb_t &eventCallback)
+{
+    std::atomic<uint32_t> openErrCode(NRF_ERROR_INTERNAL);
+    std::atomic<bool> opened(false);
+
+    std::thread opener([&] {
+        openErrCode = transport.open([](const sd_rpc_app_status_t, const std::string &) {},
+                                     eventCallback,
+                                     [](const sd_rpc_log_severity_t, const std::string &) {});
+        opened      = true;
+    });
+
+    std::vector<uint8_t> slipPacket;
+
+    while (!opened)
+    {
+        if (!uart.takeSentPacket(slipPacket, std::chrono::milliseconds(10)))
+        {
+            continue;
+        }
+
+        std::vector<uint8_t> h5Packet;
+        std::vector<uint8_t> payload;
+        uint8_t seqNum;
+        uint8_t ackNum;
+        bool reliable;
+        h5_pkt_type_t type;
+
+        if (slip_decode(slipPacket, h5Packet) != NRF_SUCCESS ||
+            h5_decode(h5Packet, payload, &seqNum, &ackNum, nullptr, nullptr, nullptr, &reliable,
+                      &type) != NRF_SUCCESS ||
+            type != LINK_CONTROL_PACKET)
+        {
+            continue;
+        }
+
+        if (H5Transport::isSyncPacket(payload))
+        {
+            uart.receive(encodePacket({0x02, 0x7D}, 0, 0, false, LINK_CONTROL_PACKET),
+                         slipPacket.size());
+        }
+        else if (H5Transport::isSyncConfigPacket(payload))
+        {
+            const std::vector<uint8_t> response = {
+                0x04, 0x7B, H5Transport::syncConfigField(MinSlidingWindowSize)};
+            uart.receive(encodePacket(response, 0, 0, false, LINK_CONTROL_PACKET),
+                         slipPacket.size());
+        }
+    }
+
+    opener.join();
+
+    // Only acknowledgements are sent from here on
+    uart.keepSentPackets = false;
+    return openErrCode;
+}
+
+/**
+ * @brief Waits until count events are received, returns false after a second.
+ */
+bool waitForEvents(const std::atomic<uint32_t> &received, const uint32_t count)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+    while (received < count)
+    {
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+
+        std::this_thread::yield();
+    }
+
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("RxPath")
+{
+    // The transports take ownership of the layers below them
+    const auto uart = new ScriptedUart();
+    SerializationTransport transport(new H5Transport(uart, 250, MinSlidingWindowSize), 1000);
+
+    // Packet logs are built only when debug messages are logged
+    transport.setLogSeverityFilter(SD_RPC_LOG_INFO);
+
+    std::atomic<uint32_t> received(0);
+    std::atomic<uint32_t> outOfOrder(0);
+
+    const auto eventCallback = [&](ble_evt_t *event) {
+        if (event->header.evt_id != BLE_GAP_EVT_KEY_PRESSED ||
+            event->evt.gap_evt.params.key_pressed.kp_not != received % 256)
+        {
+            outOfOrder++;
+        }
+
+        received++;
+    };
+
+    // Sequence number and value of the next event passed to the transport
+    uint8_t seqNum = 0;
+    uint32_t value = 0;
+
+    const auto receiveEvents = [&](const uint32_t count, const size_t readSize) {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uart->receive(encodeEvent(seqNum, static_cast<uint8_t>(value++)), readSize);
+            seqNum = (seqNum + 1) & 0x07;
+        }
+    };
+
+    SECTION("Frames split across UART reads are received in order")
+    {
+        REQUIRE(openLink(transport, *uart, eventCallback) == NRF_SUCCESS);
+
+        for (const size_t readSize : {1, 2, 3, 5, 7})
+        {
+            receiveEvents(10, readSize);
+            REQUIRE(waitForEvents(received, value));
+        }
+
+        // Several frames in each read, with frames ending anywhere in a read
+        std::vector<uint8_t> frames;
+
+        for (uint32_t i = 0; i < 24; i++)
+        {
+            const auto frame = encodeEvent(seqNum, static_cast<uint8_t>(value++));
+            frames.insert(frames.end(), frame.begin(), frame.end());
+            seqNum = (seqNum + 1) & 0x07;
+        }
+
+        uart->receive(frames, 37);
+        REQUIRE(waitForEvents(received, value));
+
+        REQUIRE(transport.close() == NRF_SUCCESS);
+        REQUIRE(received == 74);
+        REQUIRE(outOfOrder == 0);
+    }
+
+    SECTION("Receiving events only allocates for acknowledging them")
+    {
+        // Decoding events on this thread covers the whole receive path
+        REQUIRE(transport.setEventDispatch(SD_RPC_EVT_DISPATCH_INLINE) == NRF_SUCCESS);
+        REQUIRE(openLink(transport, *uart, eventCallback) == NRF_SUCCESS);
+
+        constexpr uint32_t eventCount = 100;
+
+        // The first events allocate the buffers reused by later events
+        receiveEvents(eventCount, 3);
+        REQUIRE(received == eventCount);
+
+        // Acknowledgements from the peer are decoded without allocating
+        const auto ack = encodePacket({}, 0, 0, false, ACK_PACKET);
+
+        AllocationCounter allocations;
+        uart->receive(ack, 1);
+        REQUIRE(allocations.allocations() == 0);
+
+        std::vector<std::vector<uint8_t>> events;
+
+        for (uint32_t i = 0; i < eventCount; i++)
+        {
+            events.push_back(encodeEvent(seqNum, static_cast<uint8_t>(value++)));
+            seqNum = (seqNum + 1) & 0x07;
+        }
+
+        allocations.reset();
+        auto sentPackets = uart->sentPacketCount.load();
+
+        for (const auto &event : events)
+        {
+            uart->receive(event, 3);
+        }
+
+        const auto eventAllocations = allocations.allocations();
+        const auto eventAcks        = uart->sentPacketCount - sentPackets;
+
+        // A retransmitted event is acknowledged again, but not passed on
+        const auto &lastEvent = events.back();
+
+        allocations.reset();
+        sentPackets = uart->sentPacketCount.load();
+
+        for (uint32_t i = 0; i < eventCount; i++)
+        {
+            uart->receive(lastEvent, 3);
+        }
+
+        const auto retransmissionAllocations = allocations.allocations();
+        const auto retransmissionAcks        = uart->sentPacketCount - sentPackets;
+
+        REQUIRE(transport.close() == NRF_SUCCESS);
+
+        REQUIRE(received == 2 * eventCount);
+        REQUIRE(outOfOrder == 0);
+        REQUIRE(eventAcks == eventCount);
+        REQUIRE(retransmissionAcks == eventCount);
+        REQUIRE(eventAllocations == retransmissionAllocations);
+    }
+}
@@ -68,6 +68,6 @@ TEST_CASE("SerialPortEnumeration")
         auto size = static_cast<uint32_t>(devices.capacity());
         REQUIRE(sd_rpc_serial_port_enum(devices.data(), &size) == NRF_SUCCESS);
         REQUIRE(size > 0);
-        NRF_LOG("Found " << size << " devices.");
+        NRF_LOG("Found {} devices.", size);
     }
 }
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <event_filter.h>
+#include <serialized_event.h>
+
+#include <ble.h>
+#include <internal/ble_common.h>
+#include <serialization_transport.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Event decoder of the serialization codecs, the codec headers are not available to tests
+extern "C" uint32_t ble_event_dec(uint8_t const *const p_buf, uint32_t packet_len,
+                                  ble_evt_t *const p_event, uint32_t *const p_event_len);
+
+namespace {
+/**
+ * @brief Serialized BLE_GAP_EVT_ADV_REPORT as sent by the connectivity firmware, see
+ * ble_gap_evt_adv_report_dec.
+ */
+std::vector<uint8_t> advReport(const uint8_t addressType, const uint8_t lastAddressByte,
+                               const int8_t rssi, const bool scanResponse)
+{
+    std::vector<uint8_t> event = {BLE_GAP_EVT_ADV_REPORT & 0xFF, BLE_GAP_EVT_ADV_REPORT >> 8,
+                                  0xFF, 0xFF};
+    const uint8_t address[] = {addressType, 0x11, 0x22, 0x33, 0x44, 0x55, lastAddressByte};
+
+#if NRF_SD_BLE_API_VERSION > 5
+    const uint8_t directAddress[sizeof(address)] = {};
+
+    event.push_back(scanResponse ? 0x08 : 0x03);
+    event.push_back(0x00);
+    event.insert(event.end(), address, address + sizeof(address));
+    event.insert(event.end(), directAddress, directAddress + sizeof(directAddress));
+    event.push_back(BLE_GAP_PHY_1MBPS);
+    event.push_back(BLE_GAP_PHY_NOT_SET);
+    event.push_back(0x7F); // TX power not available
+    event.push_back(static_cast<uint8_t>(rssi));
+    event.push_back(0x00); // Channel index
+    event.push_back(0x00); // Set ID
+    event.insert(event.end(), 2, 0x00); // Data ID
+    event.insert(event.end(), 4, 0x00); // Data buffer ID
+    event.insert(event.end(), 2, 0x00); // Data length
+    event.push_back(0x00);              // Data not present
+    event.insert(event.end(), 3, 0x00); // Aux pointer
+#elif NRF_SD_BLE_API_VERSION > 2
+    const uint8_t directAddress[sizeof(address)] = {};
+
+    event.insert(event.end(), address, address + sizeof(address));
+    event.insert(event.end(), directAddress, directAddress + sizeof(directAddress));
+    event.push_back(static_cast<uint8_t>(rssi));
+    event.push_back(scanResponse ? 0x01 : 0x00);
+    event.push_back(0x00); // Data length
+    event.push_back(0x00); // Data not present
+#else
+    event.insert(event.end(), address, address + sizeof(address));
+    event.push_back(static_cast<uint8_t>(rssi));
+    event.push_back(scanResponse ? 0x01 : 0x00);
+#endif
+
+    return event;
+}
+} // namespace
+
+TEST_CASE("SerializedEvent")
+{
+    SECTION("Event ID and connection handle")
+    {
+        const std::vector<uint8_t> event = {BLE_GAP_EVT_CONNECTED & 0xFF,
+                                            BLE_GAP_EVT_CONNECTED >> 8, 0x34, 0x12};
+        uint16_t connHandle = 0;
+
+        REQUIRE(serialized_event_id(event.data(), event.size()) == BLE_GAP_EVT_CONNECTED);
+        REQUIRE(serialized_event_conn_handle(event.data(), event.size(), &connHandle));
+        REQUIRE(connHandle == 0x1234);
+        REQUIRE_FALSE(serialized_event_is_adv_report(event.data(), event.size()));
+
+        REQUIRE(serialized_event_id(event.data(), 1) == 0);
+        REQUIRE_FALSE(serialized_event_conn_handle(event.data(), 3, &connHandle));
+    }
+
+    SECTION("Advertising report peer address and RSSI")
+    {
+        const auto event = advReport(BLE_GAP_ADDR_TYPE_RANDOM_STATIC << 1, 0x66, -70, false);
+        const uint8_t *address = nullptr;
+        int8_t rssi            = 0;
+
+        REQUIRE(serialized_event_is_adv_report(event.data(), event.size()));
+        REQUIRE(serialized_adv_report_peer(event.data(), event.size(), &address, &rssi));
+        REQUIRE(rssi == -70);
+        REQUIRE(address[0] == BLE_GAP_ADDR_TYPE_RANDOM_STATIC << 1);
+        REQUIRE(address[SerializedAdvReportAddressLength - 1] == 0x66);
+
+        // Truncated
+        REQUIRE_FALSE(serialized_adv_report_peer(event.data(), 8, &address, &rssi));
+    }
+
+    SECTION("Advertising report fields match the decoder")
+    {
+        const auto event = advReport(BLE_GAP_ADDR_TYPE_RANDOM_STATIC << 1, 0x66, -70, true);
+        std::vector<uint8_t> decoded(MaxPossibleEventLength);
+        auto decodedLength = static_cast<uint32_t>(decoded.size());
+
+        int adapterId = 0;
+        EventCodecContext context(&adapterId);
+
+        const auto decodedEvent = reinterpret_cast<ble_evt_t *>(decoded.data());
+        REQUIRE(ble_event_dec(event.data(), static_cast<uint32_t>(event.size()), decodedEvent,
+                              &decodedLength) == NRF_SUCCESS);
+
+        const auto &report = decodedEvent->evt.gap_evt.params.adv_report;
+        REQUIRE(report.rssi == -70);
+        REQUIRE(report.peer_addr.addr[BLE_GAP_ADDR_LEN - 1] == 0x66);
+
+        ble_gap_addr_t peerAddr = {};
+        int8_t rssi             = 0;
+
+        REQUIRE(serialized_adv_report_peer_addr(event.data(), event.size(), &peerAddr, &rssi));
+        REQUIRE(rssi == report.rssi);
+        REQUIRE(peerAddr.addr_type == report.peer_addr.addr_type);
+        REQUIRE(std::memcmp(peerAddr.addr, report.peer_addr.addr, BLE_GAP_ADDR_LEN) == 0);
+    }
+
+    SECTION("Reports of the same type from the same peer supersede each other")
+    {
+        const auto report        = advReport(0, 0x66, -70, false);
+        const auto laterReport   = advReport(0, 0x66, -50, false);
+        const auto scanResponse  = advReport(0, 0x66, -70, true);
+        const auto otherPeer     = advReport(0, 0x67, -70, false);
+        const auto otherAddrType = advReport(1 << 1, 0x66, -70, false);
+
+        const auto sameSource = [](const std::vector<uint8_t> &a, const std::vector<uint8_t> &b) {
+            return serialized_adv_report_same_source(a.data(), a.size(), b.data(), b.size());
+        };
+
+        REQUIRE(sameSource(report, laterReport));
+        REQUIRE_FALSE(sameSource(report, scanResponse));
+        REQUIRE_FALSE(sameSource(report, otherPeer));
+        REQUIRE_FALSE(sameSource(report, otherAddrType));
+    }
+}
+
+TEST_CASE("EventFilter")
+{
+    EventFilter filter;
+
+    const std::vector<uint8_t> connected    = {BLE_GAP_EVT_CONNECTED & 0xFF,
+                                            BLE_GAP_EVT_CONNECTED >> 8, 0x01, 0x00};
+    const std::vector<uint8_t> disconnected = {BLE_GAP_EVT_DISCONNECTED & 0xFF,
+                                               BLE_GAP_EVT_DISCONNECTED >> 8, 0x02, 0x00};
+    const auto nearReport                   = advReport(0, 0x66, -40, false);
+    const auto farReport                    = advReport(0, 0x67, -90, false);
+
+    const auto pass = [&](const std::vector<uint8_t> &event) {
+        return filter.pass(event.data(), event.size());
+    };
+
+    SECTION("All events pass without a filter")
+    {
+        REQUIRE(pass(connected));
+        REQUIRE(pass(nearReport));
+        REQUIRE(pass({}));
+    }
+
+    SECTION("By event ID")
+    {
+        REQUIRE(filter.setEventId(BLE_GAP_EVT_CONNECTED, true) == NRF_SUCCESS);
+        REQUIRE_FALSE(pass(connected));
+        REQUIRE(pass(disconnected));
+
+        REQUIRE(filter.setEventId(BLE_GAP_EVT_CONNECTED, false) == NRF_SUCCESS);
+        REQUIRE(pass(connected));
+
+        REQUIRE(filter.setEventId(EventFilter::EventIdCount, true) == NRF_ERROR_INVALID_PARAM);
+    }
+
+    SECTION("By connection handle")
+    {
+        REQUIRE(filter.setConnHandle(2, true) == NRF_SUCCESS);
+        REQUIRE(pass(connected));
+        REQUIRE_FALSE(pass(disconnected));
+
+        // Advertising reports have an invalid connection handle
+        REQUIRE(pass(nearReport));
+        REQUIRE(filter.setConnHandle(BLE_CONN_HANDLE_INVALID, true) == NRF_ERROR_INVALID_PARAM);
+    }
+
+    SECTION("By advertising report peer and RSSI")
+    {
+        struct Context
+        {
+            uint8_t lastAddressByte;
+            uint32_t calls;
+        } context = {0, 0};
+
+        REQUIRE(filter.setEventId(BLE_GAP_EVT_CONNECTED, true) == NRF_SUCCESS);
+
+        filter.setAdvReportFilter(
+            [](const ble_gap_addr_t *p_peer_addr, int8_t rssi, void *p_context) -> uint8_t {
+                const auto context       = static_cast<Context *>(p_context);
+                context->lastAddressByte = p_peer_addr->addr[BLE_GAP_ADDR_LEN - 1];
+                context->calls++;
+                return rssi > -80;
+            },
+            &context);
+
+        REQUIRE(pass(nearReport));
+        REQUIRE(context.lastAddressByte == 0x66);
+        REQUIRE_FALSE(pass(farReport));
+        REQUIRE(context.lastAddressByte == 0x67);
+
+        // Other filters still apply, other events are not passed to the report filter
+        REQUIRE_FALSE(pass(connected));
+        REQUIRE(pass(disconnected));
+        REQUIRE(context.calls == 2);
+
+        filter.setAdvReportFilter(nullptr, nullptr);
+        REQUIRE(pass(farReport));
+        REQUIRE(context.calls == 2);
+    }
+}
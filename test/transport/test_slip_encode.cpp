@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <nrf_error.h>
+#include <slip.h>
+#include <tx_buffer.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief The byte by byte SLIP encoder slip.cpp used before the vectorized one.
+ */
+void referenceSlipEncode(const std::vector<uint8_t> &in_packet, std::vector<uint8_t> &out_packet)
+{
+    out_packet.push_back(0xC0);
+
+    for (auto i : in_packet)
+    {
+        if (i == 0xC0)
+        {
+            out_packet.push_back(0xDB);
+            out_packet.push_back(0xDC);
+        }
+        else if (i == 0xDB)
+        {
+            out_packet.push_back(0xDB);
+            out_packet.push_back(0xDD);
+        }
+        else
+        {
+            out_packet.push_back(i);
+        }
+    }
+
+    out_packet.push_back(0xC0);
+}
+
+/**
+ * @brief Random data where roughly escapePercent percent of the bytes must be escaped.
+ */
+std::vector<uint8_t> randomData(std::mt19937 &generator, const size_t length,
+                                const int escapePercent)
+{
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::vector<uint8_t> data(length);
+
+    std::generate(data.begin(), data.end(), [&] {
+        if (percent(generator) < escapePercent)
+        {
+            return static_cast<uint8_t>(generator() & 1 ? 0xC0 : 0xDB);
+        }
+
+        uint8_t byte;
+
+        do
+        {
+            byte = static_cast<uint8_t>(generator());
+        } while (byte == 0xC0 || byte == 0xDB);
+
+        return byte;
+    });
+
+    return data;
+}
+
+} // namespace
+
+TEST_CASE("SlipEncode")
+{
+    std::mt19937 generator(1);
+
+    SECTION("Vector, pointer and in place encoding is equal to the byte by byte encoder")
+    {
+        for (const auto escapePercent : {0, 1, 10, 50, 100})
+        {
+            for (size_t length = 0; length <= 1100; length++)
+            {
+                const auto packet = randomData(generator, length, escapePercent);
+
+                std::vector<uint8_t> expected;
+                referenceSlipEncode(packet, expected);
+
+                std::vector<uint8_t> encoded;
+                slip_encode(packet, encoded);
+                REQUIRE(encoded == expected);
+
+                REQUIRE(slip_encoded_length(packet.data(), packet.size()) == expected.size());
+
+                // Unaligned input and output
+                std::vector<uint8_t> unalignedIn(packet.size() + 1);
+                std::copy(packet.begin(), packet.end(), unalignedIn.begin() + 1);
+                std::vector<uint8_t> unalignedOut(expected.size() + 3);
+                const auto end =
+                    slip_encode(unalignedIn.data() + 1, packet.size(), unalignedOut.data() + 3);
+
+                REQUIRE(end == unalignedOut.data() + unalignedOut.size());
+                REQUIRE(std::equal(expected.begin(), expected.end(), unalignedOut.begin() + 3));
+
+                {
+                    TxBuffer buffer(packet.size());
+                    std::copy(packet.begin(), packet.end(), buffer.payload());
+                    buffer.setPayloadLength(packet.size());
+                    slip_encode(buffer);
+
+                    REQUIRE(std::vector<uint8_t>(buffer.data(), buffer.data() + buffer.size()) ==
+                            expected);
+                }
+            }
+        }
+    }
+
+    SECTION("Encoding appends to the output vector")
+    {
+        const std::vector<uint8_t> packet = {0x01, 0xC0, 0x02, 0xDB, 0x03};
+        std::vector<uint8_t> encoded      = {0xAA, 0xBB};
+
+        slip_encode(packet, encoded);
+
+        REQUIRE(encoded == std::vector<uint8_t>{0xAA, 0xBB, 0xC0, 0x01, 0xDB, 0xDC, 0x02, 0xDB,
+                                                0xDD, 0x03, 0xC0});
+    }
+
+    SECTION("Encoded packets decode to the original packet")
+    {
+        for (size_t length = 0; length <= 1100; length += 7)
+        {
+            const auto packet = randomData(generator, length, 5);
+
+            std::vector<uint8_t> encoded;
+            slip_encode(packet, encoded);
+
+            std::vector<uint8_t> decoded;
+            REQUIRE(slip_decode(encoded, decoded) == NRF_SUCCESS);
+            REQUIRE(decoded == packet);
+        }
+    }
+}
+
+TEST_CASE("SlipEncodePerformance", "[.benchmark]")
+{
+    std::mt19937 generator(2);
+
+    for (const auto length : std::vector<size_t>{20, 64, 256, 512, 768})
+    {
+        for (const auto escapePercent : {0, 1})
+        {
+            const auto packet = randomData(generator, length, escapePercent);
+            const auto name   = std::to_string(length) + " bytes, " +
+                              std::to_string(escapePercent) + "% escaped";
+
+            BENCHMARK("byte by byte, " + name)
+            {
+                std::vector<uint8_t> encoded;
+                referenceSlipEncode(packet, encoded);
+                return encoded;
+            };
+
+            BENCHMARK("vectorized, " + name)
+            {
+                std::vector<uint8_t> encoded;
+                slip_encode(packet, encoded);
+                return encoded;
+            };
+
+            BENCHMARK("memcpy, " + name)
+            {
+                std::vector<uint8_t> copy(packet.size() + 2);
+                std::memcpy(copy.data() + 1, packet.data(), packet.size());
+                return copy;
+            };
+        }
+    }
+}
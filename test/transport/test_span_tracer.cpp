@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <nrf_error.h>
+#include <sd_rpc.h>
+#include <span_tracer.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <h5_peer.h>
+
+#include <adapter.h>
+#include <ble.h>
+
+#include <chrono>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+std::string readTrace(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    const std::string trace((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+    file.close();
+    std::remove(path.c_str());
+    return trace;
+}
+
+size_t countOf(const std::string &text, const std::string &pattern)
+{
+    size_t count = 0;
+
+    for (auto position = text.find(pattern); position != std::string::npos;
+         position      = text.find(pattern, position + pattern.size()))
+    {
+        count++;
+    }
+
+    return count;
+}
+} // namespace
+
+TEST_CASE("span_tracer")
+{
+    auto &tracer           = SpanTracer::global();
+    const std::string path = "test_span_tracer.trace.json";
+
+    SECTION("Spans are only recorded while tracing")
+    {
+        {
+            TraceSpan span("before", 0);
+        }
+
+        REQUIRE(sd_rpc_trace_stop() == NRF_ERROR_INVALID_STATE);
+        REQUIRE(sd_rpc_trace_start(path.c_str()) == NRF_SUCCESS);
+        REQUIRE(sd_rpc_trace_start(path.c_str()) == NRF_ERROR_INVALID_STATE);
+
+        {
+            TraceSpan span("h5_send", 3);
+            span.seqNum(5);
+            span.ackNum(2);
+        }
+
+        {
+            TraceSpan span("event_callback", 1);
+            span.eventId(0x10);
+        }
+
+        REQUIRE(sd_rpc_trace_stop() == NRF_SUCCESS);
+
+        {
+            TraceSpan span("after", 0);
+        }
+
+        const auto trace = readTrace(path);
+
+        const std::string header = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        REQUIRE(trace.compare(0, header.size(), header) == 0);
+        REQUIRE(trace.find("\"before\"") == std::string::npos);
+        REQUIRE(trace.find("\"after\"") == std::string::npos);
+        REQUIRE(trace.find("\"name\":\"h5_send\",\"cat\":\"pc-ble-driver\",\"ph\":\"X\"") !=
+                std::string::npos);
+        REQUIRE(trace.find("\"args\":{\"adapter\":3,\"seq_num\":5,\"ack_num\":2}}") !=
+                std::string::npos);
+        REQUIRE(trace.find("\"args\":{\"adapter\":1,\"event_id\":\"0x10\"}}") !=
+                std::string::npos);
+        REQUIRE(trace.compare(trace.size() - 3, 3, "}}\n") == 0);
+
+        REQUIRE(sd_rpc_trace_start("no/such/directory/trace.json") == NRF_ERROR_INVALID_PARAM);
+    }
+
+    SECTION("Spans of all threads are written or counted as dropped")
+    {
+        constexpr auto threadCount = 4;
+        constexpr auto spanCount   = 10000;
+
+        const auto droppedBefore = tracer.dropped();
+        REQUIRE(tracer.start(path) == NRF_SUCCESS);
+
+        std::vector<std::thread> threads;
+
+        for (auto i = 0; i < threadCount; i++)
+        {
+            threads.emplace_back([] {
+                for (auto j = 0; j < spanCount; j++)
+                {
+                    TraceSpan span("work", 0);
+                    span.opcode(static_cast<uint8_t>(j));
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        REQUIRE(tracer.stop() == NRF_SUCCESS);
+
+        const auto trace   = readTrace(path);
+        const auto written = countOf(trace, "\"name\":\"work\"");
+        REQUIRE(written + (tracer.dropped() - droppedBefore) == threadCount * spanCount);
+        REQUIRE(written >= SpanRingCapacity);
+    }
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+TEST_CASE("span_tracer_commands")
+{
+    H5Peer peer(MaxSlidingWindowSize, std::chrono::milliseconds(0), false, true);
+
+    const auto adapter = createAdapter(peer.portName());
+    REQUIRE(sd_rpc_open(adapter, noopAdapterStatus, noopAdapterEvent, noopAdapterLog) ==
+            NRF_SUCCESS);
+
+    uint8_t value[20]      = {};
+    const auto writeParams = gattcWriteParams(value);
+
+    SECTION("Commands are traced as spans tagged with the opcode")
+    {
+        const std::string path = "test_span_tracer_commands.trace.json";
+        REQUIRE(sd_rpc_trace_start(path.c_str()) == NRF_SUCCESS);
+
+        for (auto i = 0; i < 10; i++)
+        {
+            REQUIRE(sd_ble_gattc_write(adapter, 0, &writeParams) == NRF_SUCCESS);
+        }
+
+        REQUIRE(sd_rpc_trace_stop() == NRF_SUCCESS);
+
+        const auto trace = readTrace(path);
+
+        std::stringstream opcode;
+        opcode << "\"opcode\":\"0x" << std::hex << SD_BLE_GATTC_WRITE << '"';
+
+        for (const auto name : {"encode", "response_wait", "decode"})
+        {
+            const auto span = trace.find(std::string("{\"name\":\"") + name + '"');
+            REQUIRE(span != std::string::npos);
+            REQUIRE(trace.find(opcode.str(), span) < trace.find('\n', span));
+        }
+    }
+
+    REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+    sd_rpc_adapter_delete(adapter);
+}
+
+#endif // defined(__unix__) || defined(__APPLE__)
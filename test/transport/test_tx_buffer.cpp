@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <allocation_counter.h>
+#include <h5.h>
+#include <slip.h>
+#include <tx_buffer.h>
+
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr size_t MaxPacketSize = 512;
+
+// Encoded sd_ble_gattc_write command with 20 bytes of data
+const std::vector<uint8_t> gattcWriteCommand = {0x75, 0x00, 0x00, 0x01, 0x01, 0x00, 0x00, 0x10,
+                                                0x00, 0x00, 0x00, 0x14, 0x00, 0x01, 0xC0, 0x01,
+                                                0x02, 0x03, 0x04, 0xDB, 0x06, 0x07, 0x08, 0x09,
+                                                0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11};
+
+struct TxPathCost
+{
+    size_t allocations;
+    size_t bytesCopied;
+};
+
+/**
+ * @brief The TX path before TxBuffer, each layer copies the packet into a new vector.
+ */
+TxPathCost vectorTxPath(std::deque<uint8_t> &writeQueue, std::vector<uint8_t> &writeBufferVector)
+{
+    const AllocationCounter allocations;
+    size_t bytesCopied           = 0;
+
+    // encode_decode
+    std::vector<uint8_t> txBuffer(MaxPacketSize);
+    std::copy(gattcWriteCommand.begin(), gattcWriteCommand.end(), txBuffer.begin());
+    txBuffer.resize(gattcWriteCommand.size());
+
+    // SerializationTransport
+    std::vector<uint8_t> commandBuffer(txBuffer.size() + 1);
+    commandBuffer[0] = 0;
+    std::copy(txBuffer.begin(), txBuffer.end(), commandBuffer.begin() + 1);
+    bytesCopied += txBuffer.size();
+
+    // H5Transport
+    std::vector<uint8_t> h5Packet;
+    h5_encode(commandBuffer, h5Packet, 0, 0, true, true, VENDOR_SPECIFIC_PACKET);
+    bytesCopied += commandBuffer.size();
+
+    std::vector<uint8_t> slipPacket;
+    slip_encode(h5Packet, slipPacket);
+    bytesCopied += h5Packet.size();
+
+    // UartTransport
+    writeQueue.insert(writeQueue.end(), slipPacket.begin(), slipPacket.end());
+    bytesCopied += slipPacket.size();
+
+    writeBufferVector.clear();
+    writeBufferVector.insert(writeBufferVector.begin(), writeQueue.begin(), writeQueue.end());
+    writeQueue.clear();
+    bytesCopied += slipPacket.size();
+
+    return {allocations.allocations(), bytesCopied};
+}
+
+/**
+ * @brief The TX path with TxBuffer, the layers add headers and escaping in place.
+ */
+TxPathCost txBufferTxPath(std::deque<std::shared_ptr<TxBuffer>> &writeQueue)
+{
+    const AllocationCounter allocations;
+    size_t bytesCopied           = 0;
+
+    // encode_decode
+    const auto txBuffer = std::make_shared<TxBuffer>(MaxPacketSize);
+    std::copy(gattcWriteCommand.begin(), gattcWriteCommand.end(), txBuffer->payload());
+    txBuffer->setPayloadLength(gattcWriteCommand.size());
+
+    // SerializationTransport
+    *txBuffer->prepend(1) = 0;
+
+    // H5Transport
+    h5_encode(*txBuffer, 0, 0, true, true, VENDOR_SPECIFIC_PACKET);
+    const auto h5PacketSize = txBuffer->size();
+    slip_encode(*txBuffer);
+    bytesCopied += h5PacketSize;
+
+    // UartTransport, the buffer is written as is
+    writeQueue.push_back(txBuffer);
+    writeQueue.pop_front();
+
+    return {allocations.allocations(), bytesCopied};
+}
+
+std::vector<uint8_t> randomPacket(std::mt19937 &generator, const size_t length)
+{
+    // Skew the distribution towards bytes that must be escaped
+    std::uniform_int_distribution<int> distribution(0, 7);
+    std::vector<uint8_t> packet(length);
+
+    for (auto &byte : packet)
+    {
+        const auto value = distribution(generator);
+        byte = value == 0 ? 0xC0 : value == 1 ? 0xDB : static_cast<uint8_t>(generator());
+    }
+
+    return packet;
+}
+} // namespace
+
+TEST_CASE("TxBuffer")
+{
+    std::mt19937 generator(42);
+
+    SECTION("Headers and trailers are limited to headroom and tailroom")
+    {
+        TxBuffer buffer(16);
+        buffer.setPayloadLength(16);
+
+        REQUIRE(buffer.size() == 16);
+        REQUIRE(buffer.data() == buffer.payload());
+        REQUIRE_THROWS_AS(buffer.prepend(TxBufferHeadroom + 1), std::length_error);
+        REQUIRE_THROWS_AS(buffer.append(buffer.tailroom() + 1), std::length_error);
+        REQUIRE_THROWS_AS(buffer.setPayloadLength(17), std::length_error);
+
+        buffer.prepend(TxBufferHeadroom);
+        REQUIRE(buffer.headroom() == 0);
+        REQUIRE(buffer.size() == 16 + TxBufferHeadroom);
+    }
+
+    SECTION("In place H5 and SLIP encoding is equal to encoding into vectors")
+    {
+        for (size_t length = 0; length <= MaxPacketSize; length++)
+        {
+            const auto packet = randomPacket(generator, length);
+
+            std::vector<uint8_t> h5Packet;
+            std::vector<uint8_t> slipPacket;
+            h5_encode(packet, h5Packet, length & 0x07, (length >> 3) & 0x07, true, true,
+                      VENDOR_SPECIFIC_PACKET);
+            slip_encode(h5Packet, slipPacket);
+
+            TxBuffer buffer(length);
+            std::copy(packet.begin(), packet.end(), buffer.payload());
+            buffer.setPayloadLength(length);
+            h5_encode(buffer, length & 0x07, (length >> 3) & 0x07, true, true,
+                      VENDOR_SPECIFIC_PACKET);
+
+            REQUIRE(std::vector<uint8_t>(buffer.data(), buffer.data() + buffer.size()) ==
+                    h5Packet);
+
+            slip_encode(buffer);
+
+            REQUIRE(std::vector<uint8_t>(buffer.data(), buffer.data() + buffer.size()) ==
+                    slipPacket);
+        }
+    }
+
+    SECTION("Packets where every byte is escaped fit in the buffer")
+    {
+        const std::vector<uint8_t> packet(MaxPacketSize, 0xC0);
+
+        TxBuffer buffer(packet.size());
+        std::copy(packet.begin(), packet.end(), buffer.payload());
+        buffer.setPayloadLength(packet.size());
+        *buffer.prepend(1) = 0xDB;
+        h5_encode(buffer, 0, 0, true, true, VENDOR_SPECIFIC_PACKET);
+        REQUIRE_NOTHROW(slip_encode(buffer));
+    }
+}
+
+TEST_CASE("TxPathCost", "[.benchmark]")
+{
+    std::deque<uint8_t> writeQueue;
+    std::vector<uint8_t> writeBufferVector;
+    std::deque<std::shared_ptr<TxBuffer>> txBufferQueue;
+
+    // Warm up containers reused between commands
+    vectorTxPath(writeQueue, writeBufferVector);
+    txBufferTxPath(txBufferQueue);
+
+    const auto vectorCost   = vectorTxPath(writeQueue, writeBufferVector);
+    const auto txBufferCost = txBufferTxPath(txBufferQueue);
+
+    std::cout << "Per command, vectors:  " << vectorCost.allocations << " allocations, "
+              << vectorCost.bytesCopied << " bytes copied" << std::endl;
+    std::cout << "Per command, TxBuffer: " << txBufferCost.allocations << " allocations, "
+              << txBufferCost.bytesCopied << " bytes copied" << std::endl;
+
+    REQUIRE(txBufferCost.allocations < vectorCost.allocations);
+    REQUIRE(txBufferCost.bytesCopied < vectorCost.bytesCopied);
+
+    BENCHMARK("Vectors")
+    {
+        return vectorTxPath(writeQueue, writeBufferVector);
+    };
+
+    BENCHMARK("TxBuffer")
+    {
+        return txBufferTxPath(txBufferQueue);
+    };
+}
@@ -0,0 +1,409 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <h5_peer.h>
+#include <h5_transport.h>
+#include <nrf_error.h>
+#include <sd_rpc_types.h>
+#include <uart_transport.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <dirent.h>
+#endif
+
+namespace {
+
+/**
+ * @brief Pseudo terminal where the test plays the device on the master side.
+ */
+class PseudoTerminal
+{
+  public:
+    PseudoTerminal()
+    {
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        REQUIRE(master >= 0);
+        REQUIRE(grantpt(master) == 0);
+        REQUIRE(unlockpt(master) == 0);
+
+        struct termios tio;
+        REQUIRE(tcgetattr(master, &tio) == 0);
+        cfmakeraw(&tio);
+        REQUIRE(tcsetattr(master, TCSANOW, &tio) == 0);
+
+        slaveName = ptsname(master);
+    }
+
+    ~PseudoTerminal()
+    {
+        close(master);
+    }
+
+    const std::string &portName() const
+    {
+        return slaveName;
+    }
+
+    void write(const std::vector<uint8_t> &data) const
+    {
+        REQUIRE(::write(master, data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+    }
+
+    std::vector<uint8_t> read(const size_t length) const
+    {
+        std::vector<uint8_t> data;
+        uint8_t buffer[64];
+
+        while (data.size() < length)
+        {
+            struct pollfd pfd = {master, POLLIN, 0};
+            REQUIRE(poll(&pfd, 1, 1000) > 0);
+
+            const auto count = ::read(master, buffer, sizeof(buffer));
+            REQUIRE(count > 0);
+            data.insert(data.end(), buffer, buffer + count);
+        }
+
+        return data;
+    }
+
+  private:
+    int master;
+    std::string slaveName;
+};
+
+/**
+ * @brief Collects the bytes one transport has received.
+ */
+struct Receiver
+{
+    std::mutex mutex;
+    std::condition_variable received;
+    std::vector<uint8_t> data;
+
+    bool waitFor(const size_t length)
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        return received.wait_for(lck, std::chrono::seconds(2),
+                                 [&] { return data.size() >= length; });
+    }
+};
+
+size_t threadCount()
+{
+#if defined(__linux__)
+    size_t count = 0;
+    const auto dir = opendir("/proc/self/task");
+
+    while (const auto entry = readdir(dir))
+    {
+        if (entry->d_name[0] != '.')
+        {
+            count++;
+        }
+    }
+
+    closedir(dir);
+    return count;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Opens one transport per pseudo terminal, exchanges data in both directions and returns
+ * the number of threads the process had while all transports were open.
+ */
+size_t exchangeData(const size_t portCount)
+{
+    std::vector<std::unique_ptr<PseudoTerminal>> terminals;
+    std::vector<std::unique_ptr<UartTransport>> transports;
+    std::vector<std::unique_ptr<Receiver>> receivers;
+
+    for (size_t i = 0; i < portCount; i++)
+    {
+        terminals.emplace_back(new PseudoTerminal());
+        receivers.emplace_back(new Receiver());
+
+        const UartCommunicationParameters parameters = {
+            terminals.back()->portName().c_str(), 1000000, UartFlowControlNone, UartParityNone,
+            UartStopBitsOne, UartDataBitsEight};
+        transports.emplace_back(new UartTransport(parameters));
+
+        auto &receiver = *receivers.back();
+        REQUIRE(transports.back()->open(
+                    [](const sd_rpc_app_status_t, const std::string &) {},
+                    [&receiver](const uint8_t *data, const size_t length) {
+                        std::lock_guard<std::mutex> lck(receiver.mutex);
+                        receiver.data.insert(receiver.data.end(), data, data + length);
+                        receiver.received.notify_all();
+                    },
+                    [](const sd_rpc_log_severity_t, const std::string &) {}) == NRF_SUCCESS);
+    }
+
+    const auto threads = threadCount();
+
+    for (size_t i = 0; i < portCount; i++)
+    {
+        const std::vector<uint8_t> toTransport(100, static_cast<uint8_t>(i));
+        const std::vector<uint8_t> toDevice(100, static_cast<uint8_t>(0x80 + i));
+
+        terminals[i]->write(toTransport);
+        REQUIRE(transports[i]->send(toDevice) == NRF_SUCCESS);
+
+        REQUIRE(receivers[i]->waitFor(toTransport.size()));
+        REQUIRE(receivers[i]->data == toTransport);
+        REQUIRE(terminals[i]->read(toDevice.size()) == toDevice);
+    }
+
+    for (auto &transport : transports)
+    {
+        REQUIRE(transport->close() == NRF_SUCCESS);
+    }
+
+    return threads;
+}
+
+/**
+ * @brief Opens one H5 transport per peer, sends a packet on each and returns the number of
+ * threads the process had while all transports were open. The peers acknowledge after the
+ * retransmission timeout, each packet is retransmitted before it is acknowledged.
+ */
+size_t exchangePackets(const size_t peerCount)
+{
+    std::vector<std::unique_ptr<H5Peer>> peers;
+    std::vector<std::unique_ptr<H5Transport>> transports;
+
+    for (size_t i = 0; i < peerCount; i++)
+    {
+        peers.emplace_back(new H5Peer(MinSlidingWindowSize, std::chrono::milliseconds(300)));
+    }
+
+    const auto before = threadCount();
+
+    for (auto &peer : peers)
+    {
+        transports.emplace_back(createTransport(peer->portName(), MinSlidingWindowSize));
+        REQUIRE(transports.back()->open([](const sd_rpc_app_status_t, const std::string &) {},
+                                        [](const uint8_t *, const size_t) {},
+                                        [](const sd_rpc_log_severity_t, const std::string &) {}) ==
+                NRF_SUCCESS);
+    }
+
+    const auto threads = threadCount() - before;
+
+    for (auto &transport : transports)
+    {
+        REQUIRE(transport->send(std::vector<uint8_t>(20, 0x55)) == NRF_SUCCESS);
+
+        sd_rpc_stats_t stats = {};
+        transport->getStats(stats);
+        REQUIRE(stats.h5_retransmissions > 0);
+    }
+
+    for (auto &transport : transports)
+    {
+        REQUIRE(transport->close() == NRF_SUCCESS);
+    }
+
+    return threads;
+}
+
+} // namespace
+
+TEST_CASE("UartTransportSharedIo")
+{
+    constexpr size_t portCount = 4;
+
+    SECTION("one I/O thread per transport by default")
+    {
+        const auto before = threadCount();
+        const auto during = exchangeData(portCount);
+
+#if defined(__linux__)
+        REQUIRE(during == before + portCount);
+#else
+        (void)before;
+        (void)during;
+#endif
+    }
+
+    SECTION("transports share the I/O threads when enabled")
+    {
+        REQUIRE(UartTransport::setSharedIoThreadCount(2) == NRF_SUCCESS);
+
+        const auto before = threadCount();
+        const auto during = exchangeData(portCount);
+
+#if defined(__linux__)
+        REQUIRE(during == before);
+#else
+        (void)before;
+        (void)during;
+#endif
+
+        // Transports can be opened again on the same shared context
+        exchangeData(1);
+
+        REQUIRE(UartTransport::setSharedIoThreadCount(0) == NRF_SUCCESS);
+    }
+
+    SECTION("the last transport on the shared I/O threads can be closed from its handler")
+    {
+        const auto before = threadCount();
+        REQUIRE(UartTransport::setSharedIoThreadCount(2) == NRF_SUCCESS);
+
+        PseudoTerminal terminal;
+        const UartCommunicationParameters parameters = {
+            terminal.portName().c_str(), 1000000,         UartFlowControlNone,
+            UartParityNone,              UartStopBitsOne, UartDataBitsEight};
+        UartTransport transport(parameters);
+
+        Receiver closed;
+        uint32_t closeErrorCode = NRF_ERROR_INTERNAL;
+
+        REQUIRE(transport.open([](const sd_rpc_app_status_t, const std::string &) {},
+                               [&](const uint8_t *, const size_t) {
+                                   const auto errorCode = transport.close();
+                                   std::lock_guard<std::mutex> lck(closed.mutex);
+                                   closeErrorCode = errorCode;
+                                   closed.data.push_back(0x00);
+                                   closed.received.notify_all();
+                               },
+                               [](const sd_rpc_log_severity_t, const std::string &) {}) ==
+                NRF_SUCCESS);
+
+        // The transport holds the last reference to the shared io_context, which is released on
+        // one of its threads
+        REQUIRE(UartTransport::setSharedIoThreadCount(0) == NRF_SUCCESS);
+
+        terminal.write({0x01});
+        REQUIRE(closed.waitFor(1));
+
+        {
+            std::lock_guard<std::mutex> lck(closed.mutex);
+            REQUIRE(closeErrorCode == NRF_SUCCESS);
+        }
+
+#if defined(__linux__)
+        // The thread releasing the io_context leaves shortly after
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+
+        while (threadCount() != before && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        REQUIRE(threadCount() == before);
+#else
+        (void)before;
+#endif
+
+        // Opened again on an I/O thread of its own
+        Receiver receiver;
+        REQUIRE(transport.open(
+                    [](const sd_rpc_app_status_t, const std::string &) {},
+                    [&receiver](const uint8_t *data, const size_t length) {
+                        std::lock_guard<std::mutex> lck(receiver.mutex);
+                        receiver.data.insert(receiver.data.end(), data, data + length);
+                        receiver.received.notify_all();
+                    },
+                    [](const sd_rpc_log_severity_t, const std::string &) {}) == NRF_SUCCESS);
+
+        terminal.write({0x02});
+        REQUIRE(receiver.waitFor(1));
+        REQUIRE(transport.close() == NRF_SUCCESS);
+    }
+}
+
+TEST_CASE("H5TransportSharedIo")
+{
+    constexpr size_t peerCount = 4;
+
+    SECTION("a state machine and an I/O thread per transport by default")
+    {
+        const auto threads = exchangePackets(peerCount);
+
+#if defined(__linux__)
+        REQUIRE(threads == 2 * peerCount);
+#else
+        (void)threads;
+#endif
+    }
+
+    SECTION("state machines and retransmission timers run on the shared I/O threads when enabled")
+    {
+        REQUIRE(UartTransport::setSharedIoThreadCount(2) == NRF_SUCCESS);
+
+        const auto threads = exchangePackets(peerCount);
+
+#if defined(__linux__)
+        REQUIRE(threads == 0);
+#else
+        (void)threads;
+#endif
+
+        REQUIRE(UartTransport::setSharedIoThreadCount(0) == NRF_SUCCESS);
+    }
+}
+
+#endif // defined(__unix__) || defined(__APPLE__)
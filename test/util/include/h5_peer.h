@@ -0,0 +1,335 @@
+/*
+ * Copyright (c) 2016 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef H5_PEER_H
+#define H5_PEER_H
+
+// Only on platforms with pseudo terminals
+#if defined(__unix__) || defined(__APPLE__)
+
+#include "catch2/catch.hpp"
+
+#include <adapter.h>
+#include <ble.h>
+#include <h5.h>
+#include <h5_transport.h>
+#include <nrf_error.h>
+#include <sd_rpc.h>
+#include <serialization_transport.h>
+#include <slip.h>
+#include <uart_transport.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+/**
+ * @brief Connectivity device stand-in running on the master side of a pseudo terminal.
+ *
+ * Responds to link establishment with the given sliding window size and acknowledges reliable
+ * packets after a fixed delay. The delay emulates the UART and device turnaround, the
+ * acknowledgement is cumulative as in the H5 specification. With offerConfig the peer also sends
+ * a SYNC_CONFIG of its own offering the window size, after responding to the one of the host.
+ * With respond the peer answers each acknowledged command with a serialization response carrying
+ * the opcode of the command.
+ */
+class H5Peer
+{
+  public:
+    H5Peer(const uint8_t windowSize, const std::chrono::milliseconds ackDelay,
+           const bool offerConfig = false, const bool respond = false)
+        : windowSize(windowSize)
+        , ackDelay(ackDelay)
+        , offerConfig(offerConfig)
+        , respond(respond)
+        , master(-1)
+        , stop(false)
+        , receivedPackets(0)
+        , syncConfigResponseField(-1)
+        , expectedSeqNum(0)
+        , peerSeqNum(0)
+        , ackPending(false)
+    {
+        master = posix_openpt(O_RDWR | O_NOCTTY);
+        REQUIRE(master >= 0);
+        REQUIRE(grantpt(master) == 0);
+        REQUIRE(unlockpt(master) == 0);
+
+        struct termios tio;
+        REQUIRE(tcgetattr(master, &tio) == 0);
+        cfmakeraw(&tio);
+        REQUIRE(tcsetattr(master, TCSANOW, &tio) == 0);
+
+        slaveName = ptsname(master);
+        peerThread = std::thread([this] { run(); });
+    }
+
+    ~H5Peer()
+    {
+        stop = true;
+        peerThread.join();
+        close(master);
+    }
+
+    const std::string &portName() const
+    {
+        return slaveName;
+    }
+
+    uint32_t received() const
+    {
+        return receivedPackets;
+    }
+
+    // Configuration field of the SYNC_CONFIG_RESPONSE of the host, -1 until received
+    int syncConfigResponse() const
+    {
+        return syncConfigResponseField;
+    }
+
+  private:
+    void run()
+    {
+        std::vector<uint8_t> frame;
+        uint8_t buffer[256];
+
+        while (!stop)
+        {
+            struct pollfd pfd = {master, POLLIN, 0};
+
+            if (poll(&pfd, 1, 1) > 0 && (pfd.revents & POLLIN))
+            {
+                const auto count = read(master, buffer, sizeof(buffer));
+
+                for (auto i = 0; i < count; i++)
+                {
+                    frame.push_back(buffer[i]);
+
+                    if (buffer[i] == 0xC0)
+                    {
+                        if (frame.size() > 2)
+                        {
+                            processFrame(frame);
+                            frame.clear();
+                        }
+
+                        frame.clear();
+                        frame.push_back(0xC0);
+                    }
+                }
+            }
+
+            if (ackPending && std::chrono::steady_clock::now() >= ackDeadline)
+            {
+                ackPending = false;
+                sendPacket({}, ACK_PACKET, false);
+
+                for (const auto opcode : unansweredCommands)
+                {
+                    sendResponse(opcode);
+                }
+
+                unansweredCommands.clear();
+            }
+        }
+    }
+
+    void processFrame(const std::vector<uint8_t> &frame)
+    {
+        std::vector<uint8_t> slipDecoded;
+        std::vector<uint8_t> payload;
+        uint8_t seqNum;
+        uint8_t ackNum;
+        bool reliable;
+        h5_pkt_type_t type;
+
+        if (slip_decode(frame, slipDecoded) != NRF_SUCCESS ||
+            h5_decode(slipDecoded, payload, &seqNum, &ackNum, nullptr, nullptr, nullptr, &reliable,
+                      &type) != NRF_SUCCESS)
+        {
+            return;
+        }
+
+        if (type == LINK_CONTROL_PACKET && payload.size() >= 2)
+        {
+            if (payload[0] == 0x01 && payload[1] == 0x7E)
+            {
+                sendPacket({0x02, 0x7D}, LINK_CONTROL_PACKET, false);
+            }
+            else if (payload[0] == 0x03 && payload[1] == 0xFC)
+            {
+                sendPacket({0x04, 0x7B, H5Transport::syncConfigField(windowSize)},
+                           LINK_CONTROL_PACKET, false);
+
+                if (offerConfig)
+                {
+                    sendPacket({0x03, 0xFC, H5Transport::syncConfigField(windowSize)},
+                               LINK_CONTROL_PACKET, false);
+                }
+            }
+            else if (payload[0] == 0x04 && payload[1] == 0x7B && payload.size() > 2)
+            {
+                syncConfigResponseField = payload[2];
+            }
+        }
+        else if (type == VENDOR_SPECIFIC_PACKET && reliable)
+        {
+            if (seqNum == expectedSeqNum)
+            {
+                expectedSeqNum = (expectedSeqNum + 1) & 0x07;
+                receivedPackets++;
+
+                // Packet type of the serialization layer is followed by the opcode
+                if (respond && payload.size() >= 2 && payload[0] == SERIALIZATION_COMMAND)
+                {
+                    unansweredCommands.push_back(payload[1]);
+                }
+            }
+
+            if (!ackPending)
+            {
+                ackPending  = true;
+                ackDeadline = std::chrono::steady_clock::now() + ackDelay;
+            }
+        }
+    }
+
+    void sendPacket(const std::vector<uint8_t> &payload, const h5_pkt_type_t type,
+                    const bool reliable)
+    {
+        std::vector<uint8_t> h5Packet;
+        std::vector<uint8_t> slipPacket;
+
+        h5_encode(payload, h5Packet, 0, expectedSeqNum, false, reliable, type);
+        slip_encode(h5Packet, slipPacket);
+
+        // Called from the peer thread, assertions are only made from the test thread
+        if (write(master, slipPacket.data(), slipPacket.size()) < 0)
+        {
+            return;
+        }
+    }
+
+    void sendResponse(const uint8_t opcode)
+    {
+        const std::vector<uint8_t> response = {SERIALIZATION_RESPONSE, opcode, 0x00, 0x00, 0x00,
+                                               0x00};
+        std::vector<uint8_t> h5Packet;
+        std::vector<uint8_t> slipPacket;
+
+        h5_encode(response, h5Packet, peerSeqNum, expectedSeqNum, false, true,
+                  VENDOR_SPECIFIC_PACKET);
+        slip_encode(h5Packet, slipPacket);
+        peerSeqNum = (peerSeqNum + 1) & 0x07;
+
+        if (write(master, slipPacket.data(), slipPacket.size()) < 0)
+        {
+            return;
+        }
+    }
+
+    const uint8_t windowSize;
+    const std::chrono::milliseconds ackDelay;
+    const bool offerConfig;
+    const bool respond;
+    int master;
+    std::string slaveName;
+    std::thread peerThread;
+    std::atomic<bool> stop;
+    std::atomic<uint32_t> receivedPackets;
+    std::atomic<int> syncConfigResponseField;
+    uint8_t expectedSeqNum;
+    uint8_t peerSeqNum;
+    std::vector<uint8_t> unansweredCommands;
+    bool ackPending;
+    std::chrono::steady_clock::time_point ackDeadline;
+};
+
+inline H5Transport *createTransport(const std::string &portName, const uint8_t windowSize)
+{
+    UartCommunicationParameters parameters = {portName.c_str(),    1000000,
+                                              UartFlowControlNone, UartParityNone,
+                                              UartStopBitsOne,     UartDataBitsEight};
+
+    return new H5Transport(new UartTransport(parameters), 250, windowSize);
+}
+
+/**
+ * @brief Creates an adapter communicating with the peer on portName through the serialization,
+ * H5 and UART transports. Debug messages are filtered out, packets are then not formatted.
+ */
+inline adapter_t *createAdapter(const std::string &portName)
+{
+    transport_layer_t transportLayer;
+    transportLayer.internal =
+        new SerializationTransport(createTransport(portName, MaxSlidingWindowSize), 1000);
+
+    const auto adapter = sd_rpc_adapter_create(&transportLayer);
+    REQUIRE(sd_rpc_log_handler_severity_filter_set(adapter, SD_RPC_LOG_INFO) == NRF_SUCCESS);
+    return adapter;
+}
+
+inline void noopAdapterStatus(adapter_t *, sd_rpc_app_status_t, const char *) {}
+inline void noopAdapterEvent(adapter_t *, ble_evt_t *) {}
+inline void noopAdapterLog(adapter_t *, sd_rpc_log_severity_t, const char *) {}
+
+/**
+ * @brief Parameters of a write without response of value to handle 0x0010, the peer answers it
+ * as any other command. value must outlive the parameters.
+ */
+template <size_t N> ble_gattc_write_params_t gattcWriteParams(uint8_t (&value)[N])
+{
+    ble_gattc_write_params_t writeParams = {};
+    writeParams.write_op                 = BLE_GATT_OP_WRITE_CMD;
+    writeParams.handle                   = 0x0010;
+    writeParams.len                      = N;
+    writeParams.p_value                  = value;
+    return writeParams;
+}
+
+#endif // defined(__unix__) || defined(__APPLE__)
+
+#endif // H5_PEER_H
@@ -921,6 +921,8 @@ std::string asText(const sd_rpc_app_status_t &status)
             return "RESET_PERFORMED";
         case CONNECTION_ACTIVE:
             return "CONNECTION_ACTIVE";
+        case EVENT_QUEUE_OVERFLOW:
+            return "EVENT_QUEUE_OVERFLOW";
         default:
             return "UNKNOWN";
     }